@@ -0,0 +1,322 @@
+/** @file
+  Implementacja trybu wsadowego kalkulatora wielomianów rzadkich wielu zmiennych
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#include "batch.h"
+#include <dirent.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <time.h>
+
+/**
+ * Rozszerzenie plików wejściowych.
+ */
+#define BATCH_INPUT_SUFFIX ".in"
+
+/**
+ * Długość @ref BATCH_INPUT_SUFFIX.
+ */
+#define BATCH_INPUT_SUFFIX_LEN (sizeof(BATCH_INPUT_SUFFIX) - 1)
+
+/**
+ * Plik wejściowy do wykonania wraz z wynikiem wykonania.
+ */
+typedef struct BatchJob {
+    char *path;          ///< Ścieżka pliku wejściowego
+    bool ok;             ///< Czy udało się otworzyć pliki wejścia i wyjścia
+    double millis;       ///< Czas wykonania w milisekundach
+    size_t peakMemory;   ///< Największa pamięć zajęta przez wielomiany na stosie
+} BatchJob;
+
+/**
+ * Stan trybu wsadowego współdzielony przez wątki.
+ */
+typedef struct Batch {
+    BatchJob *jobs;      ///< Pliki do wykonania
+    size_t count;        ///< Liczba plików
+    atomic_size_t next;  ///< Indeks kolejnego pliku do wzięcia przez wątek
+} Batch;
+
+
+
+/**
+ * Porównuje ścieżki (dla qsort()).
+ *
+ * @param[in] a : wskaźnik na ścieżkę
+ * @param[in] b : wskaźnik na ścieżkę
+ *
+ * @return : wynik strcmp() dla ścieżek
+ */
+static int BatchComparePaths(const void *a, const void *b);
+
+/**
+ * Zwraca kopię napisu @p a z dopisanymi napisami @p b i @p c.
+ *
+ * @param[in] a : początek
+ * @param[in] a_len : długość początku
+ * @param[in] b : środek
+ * @param[in] c : koniec
+ *
+ * @return : nowy napis (do zwolnienia przez free())
+ */
+static char *BatchConcat(const char *a, size_t a_len, const char *b, const char *c);
+
+/**
+ * Dopisuje do wektora ścieżki wszystkich plików `*.in` z katalogu.
+ *
+ * @param[in, out] paths : wektor ścieżek
+ * @param[in] dir : katalog
+ *
+ * @return : czy udało się odczytać katalog
+ */
+static bool BatchListDirectory(vector_t *paths, const char *dir);
+
+/**
+ * Dopisuje do wektora niepuste linie pliku z listą ścieżek.
+ *
+ * @param[in, out] paths : wektor ścieżek
+ * @param[in] list : plik z listą
+ *
+ * @return : czy udało się odczytać plik
+ */
+static bool BatchListFile(vector_t *paths, const char *list);
+
+/**
+ * Wykonuje jeden plik wejściowy na nowym kalkulatorze.
+ *
+ * @param[in, out] job : plik wraz z miejscem na wynik wykonania
+ */
+static void BatchRunJob(BatchJob *job);
+
+/**
+ * Pętla wątku: wykonuje kolejne niewzięte jeszcze pliki.
+ *
+ * @param[in, out] arg : stan trybu wsadowego
+ *
+ * @return : NULL
+ */
+static void *BatchWorker(void *arg);
+
+/**
+ * Wypisuje podsumowanie wykonania wszystkich plików.
+ *
+ * @param[in] batch : stan trybu wsadowego
+ * @param[in] millis : łączny czas wykonania w milisekundach
+ */
+static void BatchPrintSummary(const Batch *batch, double millis);
+
+
+
+static int BatchComparePaths(const void *a, const void *b)
+{
+    return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
+static char *BatchConcat(const char *a, size_t a_len, const char *b, const char *c)
+{
+    size_t b_len = strlen(b), c_len = strlen(c);
+    char *res = safeMalloc(a_len + b_len + c_len + 1);
+
+    memcpy(res, a, a_len);
+    memcpy(res + a_len, b, b_len);
+    memcpy(res + a_len + b_len, c, c_len + 1);
+    return res;
+}
+
+static bool BatchListDirectory(vector_t *paths, const char *dir)
+{
+    DIR *d = opendir(dir);
+    struct dirent *entry;
+
+    if (d == NULL) {
+        return false;
+    }
+    while ((entry = readdir(d)) != NULL) {
+        size_t len = strlen(entry->d_name);
+
+        if (len > BATCH_INPUT_SUFFIX_LEN
+            && strcmp(entry->d_name + len - BATCH_INPUT_SUFFIX_LEN, BATCH_INPUT_SUFFIX) == 0) {
+            char *path = BatchConcat(dir, strlen(dir), "/", entry->d_name);
+            if (VectorPush(paths, &path) != VECT_OK) {
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+    closedir(d);
+    qsort(paths->items, paths->size, sizeof(char *), BatchComparePaths);    // readdir() nie ustala kolejności
+    return true;
+}
+
+static bool BatchListFile(vector_t *paths, const char *list)
+{
+    FILE *file = fopen(list, "r");
+    char *lineptr = NULL;
+    size_t cap = 0;
+    ssize_t nread;
+
+    if (file == NULL) {
+        return false;
+    }
+    while ((nread = getline(&lineptr, &cap, file)) != -1) {
+        size_t len = (size_t) nread;
+
+        while (len > 0 && (lineptr[len - 1] == '\n' || lineptr[len - 1] == '\r')) {
+            len--;
+        }
+        if (len > 0) {
+            char *path = BatchConcat(lineptr, len, "", "");
+            if (VectorPush(paths, &path) != VECT_OK) {
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+    free(lineptr);
+    fclose(file);
+    return true;
+}
+
+static void BatchRunJob(BatchJob *job)
+{
+    size_t len = strlen(job->path);
+    bool has_suffix = len > BATCH_INPUT_SUFFIX_LEN
+                      && strcmp(job->path + len - BATCH_INPUT_SUFFIX_LEN, BATCH_INPUT_SUFFIX) == 0;
+    size_t base_len = has_suffix ? len - BATCH_INPUT_SUFFIX_LEN : len;
+    char *out_path = BatchConcat(job->path, base_len, ".out", "");
+    char *err_path = BatchConcat(job->path, base_len, ".err", "");
+    Menu menu = { .firstLine = 1 };
+    struct timespec start, end;
+    FILE *out = NULL, *err = NULL;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    job->ok = InputOpenFile(&menu.input, job->path);
+    if (job->ok) {
+        out = fopen(out_path, "w");
+        err = fopen(err_path, "w");
+        job->ok = out != NULL && err != NULL;
+    }
+
+    if (job->ok) {
+        CalcInit(&menu.calc);
+        menu.calc.out = out;
+        menu.calc.err = err;
+        menu.calc.trackMemory = true;
+        runInput(&menu);
+        job->peakMemory = menu.calc.peakMemory;
+        CalcDestroy(&menu.calc);
+    }
+    if (out != NULL && fclose(out) != 0) {
+        job->ok = false;
+    }
+    if (err != NULL && fclose(err) != 0) {
+        job->ok = false;
+    }
+    InputClose(&menu.input);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    job->millis = (double) (end.tv_sec - start.tv_sec) * 1e3 + (double) (end.tv_nsec - start.tv_nsec) / 1e6;
+    free(out_path);
+    free(err_path);
+}
+
+static void *BatchWorker(void *arg)
+{
+    Batch *batch = arg;
+
+    while (true) {
+        size_t i = atomic_fetch_add_explicit(&batch->next, 1, memory_order_relaxed);
+
+        if (i >= batch->count) {
+            return NULL;
+        }
+        BatchRunJob(&batch->jobs[i]);
+    }
+}
+
+static void BatchPrintSummary(const Batch *batch, double millis)
+{
+    struct rusage usage;
+    int width = (int) strlen("FILE");
+
+    for (size_t i = 0; i < batch->count; i++) {
+        int len = (int) strlen(batch->jobs[i].path);
+        if (len > width) {
+            width = len;
+        }
+    }
+
+    printf("%-*s %12s %14s\n", width, "FILE", "TIME [ms]", "PEAK [B]");
+    for (size_t i = 0; i < batch->count; i++) {
+        const BatchJob *job = &batch->jobs[i];
+
+        if (job->ok) {
+            printf("%-*s %12.3f %14zu\n", width, job->path, job->millis, job->peakMemory);
+        }
+        else {
+            printf("%-*s %12s\n", width, job->path, "FAILED");
+        }
+    }
+    getrusage(RUSAGE_SELF, &usage);
+    printf("%zu files in %.3f ms, process peak RSS %ld KiB\n", batch->count, millis, usage.ru_maxrss);
+}
+
+
+
+bool runBatch(const char *source, size_t workers, size_t *failed)
+{
+    vector_t *paths = VectorNew(sizeof(char *), INIT_CAP);
+    struct stat st;
+    bool listed;
+
+    CHECK_POINTER(paths);
+    if (stat(source, &st) == 0 && S_ISDIR(st.st_mode)) {
+        listed = BatchListDirectory(paths, source);
+    }
+    else {
+        listed = BatchListFile(paths, source);
+    }
+    if (!listed) {
+        for (size_t i = 0; i < paths->size; i++) {
+            free(*GET_ITEM(char *, paths, i));
+        }
+        VectorDestroy(paths);
+        return false;
+    }
+
+    Batch batch = { .jobs = safeCalloc(paths->size + 1, sizeof(BatchJob)), .count = paths->size };
+    size_t threads_count = (workers < batch.count) ? workers : batch.count;
+    pthread_t threads[threads_count + 1];
+    struct timespec start, end;
+
+    atomic_init(&batch.next, 0);
+    for (size_t i = 0; i < batch.count; i++) {
+        batch.jobs[i].path = *GET_ITEM(char *, paths, i);
+    }
+    VectorDestroy(paths);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i = 0; i < threads_count; i++) {
+        if (pthread_create(&threads[i], NULL, BatchWorker, &batch) != 0) {
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (size_t i = 0; i < threads_count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    BatchPrintSummary(&batch, (double) (end.tv_sec - start.tv_sec) * 1e3
+                              + (double) (end.tv_nsec - start.tv_nsec) / 1e6);
+    *failed = 0;
+    for (size_t i = 0; i < batch.count; i++) {
+        *failed += !batch.jobs[i].ok;
+        free(batch.jobs[i].path);
+    }
+    free(batch.jobs);
+    return true;
+}
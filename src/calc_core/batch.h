@@ -0,0 +1,35 @@
+/** @file
+  Interfejs trybu wsadowego kalkulatora wielomianów rzadkich wielu zmiennych
+
+  W trybie wsadowym kalkulator wykonuje wiele niezależnych plików wejściowych
+  jednocześnie, każdy na osobnym kalkulatorze. Wyniki i błędy pliku
+  `nazwa.in` trafiają do plików `nazwa.out` i `nazwa.err` obok niego
+  (dla pliku bez rozszerzenia `.in` - do `nazwa.in.out` i `nazwa.in.err`).
+  Na koniec na standardowe wyjście wypisywane jest podsumowanie z czasem
+  wykonania i największą pamięcią zajętą przez wielomiany na stosie
+  dla każdego pliku.
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#ifndef __BATCH_H__
+#define __BATCH_H__
+
+#include "calc.h"
+
+/**
+ * Wykonuje pliki wejściowe z katalogu (wszystkie pliki `*.in`,
+ * w kolejności nazw) lub z listy (jedna ścieżka w linii)
+ * na @p workers wątkach i wypisuje podsumowanie.
+ *
+ * @param[in] source : katalog lub plik z listą ścieżek
+ * @param[in] workers : liczba wątków
+ * @param[out] failed : liczba plików, których nie udało się otworzyć lub zapisać
+ *
+ * @return : czy udało się odczytać listę plików
+ */
+bool runBatch(const char *source, size_t workers, size_t *failed);
+
+#endif //__BATCH_H__
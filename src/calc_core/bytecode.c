@@ -0,0 +1,513 @@
+/** @file
+  Implementacja kompilacji skryptów kalkulatora wielomianów rzadkich wielu zmiennych do kodu bajtowego
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#include "bytecode.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Długość nagłówka: sygnatura i bajt wersji.
+ */
+#define PROGRAM_HEADER_LEN 5
+
+
+
+/**
+ * Sprawdza, czy argumentem komendy jest napis z puli - ścieżka pliku
+ * (lub dwie ścieżki - EVAL_FILE).
+ *
+ * @param[in] cmd : kod komendy
+ *
+ * @return : czy komenda przyjmuje napis
+ */
+static bool CommandTakesPath(CommandCode cmd);
+
+/**
+ * Sprawdza, czy komenda oprócz argumentu liczbowego przyjmuje
+ * ograniczenie stopnia (zapisywane w polu `len` instrukcji).
+ *
+ * @param[in] cmd : kod komendy
+ *
+ * @return : czy komenda przyjmuje ograniczenie stopnia
+ */
+static bool CommandTakesDegree(CommandCode cmd);
+
+/**
+ * Dopisuje instrukcję do programu.
+ *
+ * @param[in, out] prog : program
+ * @param[in] ins : instrukcja
+ */
+static void ProgramEmit(Program *prog, Instruction ins);
+
+/**
+ * Zapisuje liczbę do pliku w kodowaniu varint.
+ *
+ * @param[in, out] file : plik
+ * @param[in] val : liczba
+ *
+ * @return : czy zapis się powiódł
+ */
+static bool WriteVarint(FILE *file, uint64_t val);
+
+/**
+ * Wczytuje liczbę w kodowaniu varint z bufora.
+ *
+ * @param[in] data : bufor
+ * @param[in] size : długość bufora
+ * @param[in, out] pos : pozycja w buforze
+ * @param[out] val : liczba
+ *
+ * @return : czy liczba mieści się w buforze i w 64 bitach
+ */
+static bool ReadVarint(const uint8_t *data, size_t size, size_t *pos, uint64_t *val);
+
+/**
+ * Zapisuje instrukcję do pliku.
+ *
+ * @param[in, out] file : plik
+ * @param[in] ins : instrukcja
+ * @param[in] prev_line : indeks linii poprzedniej instrukcji
+ *
+ * @return : czy zapis się powiódł
+ */
+static bool WriteInstruction(FILE *file, const Instruction *ins, uint64_t prev_line);
+
+/**
+ * Wczytuje instrukcję z bufora.
+ *
+ * @param[in] data : bufor
+ * @param[in] size : długość bufora
+ * @param[in, out] pos : pozycja w buforze
+ * @param[out] ins : instrukcja
+ * @param[in] prev_line : indeks linii poprzedniej instrukcji
+ *
+ * @return : czy instrukcja mieści się w buforze
+ */
+static bool ReadInstruction(const uint8_t *data, size_t size, size_t *pos, Instruction *ins, uint64_t prev_line);
+
+/**
+ * Sprawdza, czy instrukcja odwołuje się wyłącznie do istniejących
+ * stałych, napisów i komend.
+ *
+ * @param[in] prog : program (ze wczytanymi stałymi i napisami)
+ * @param[in] ins : instrukcja
+ *
+ * @return : czy instrukcja jest poprawna
+ */
+static bool InstructionIsValid(const Program *prog, const Instruction *ins);
+
+/**
+ * Odtwarza program z zawartości pliku.
+ *
+ * @param[out] prog : program (pusty)
+ * @param[in] data : zawartość pliku
+ * @param[in] size : długość zawartości
+ *
+ * @return : czy zawartość jest poprawna
+ */
+static bool ProgramDecode(Program *prog, const uint8_t *data, size_t size);
+
+/**
+ * Tworzy pusty program.
+ *
+ * @param[out] prog : program
+ */
+static void ProgramInit(Program *prog);
+
+
+
+static bool CommandTakesPath(CommandCode cmd)
+{
+    return cmd == SAVE || cmd == LOAD || cmd == SNAPSHOT || cmd == MAP || cmd == CHECKPOINT || cmd == RESTORE
+           || cmd == EVAL_FILE;
+}
+
+static bool CommandTakesDegree(CommandCode cmd)
+{
+    return cmd == COMPOSE_TRUNC;
+}
+
+static void ProgramEmit(Program *prog, Instruction ins)
+{
+    if (VectorPush(prog->code, &ins) != VECT_OK) {
+        exit(EXIT_FAILURE);
+    }
+}
+
+static bool WriteVarint(FILE *file, uint64_t val)
+{
+    while (val >= 0x80) {
+        if (putc((int) ((val & 0x7f) | 0x80), file) == EOF) {
+            return false;
+        }
+        val >>= 7;
+    }
+    return putc((int) val, file) != EOF;
+}
+
+static bool ReadVarint(const uint8_t *data, size_t size, size_t *pos, uint64_t *val)
+{
+    uint64_t res = 0;
+
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (*pos >= size) {
+            return false;
+        }
+        uint8_t byte = data[(*pos)++];
+
+        if (shift == 63 && byte > 1) {
+            return false;    // liczba nie mieści się w 64 bitach
+        }
+        res |= (uint64_t) (byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            *val = res;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool WriteInstruction(FILE *file, const Instruction *ins, uint64_t prev_line)
+{
+    bool ok = putc((int) ins->op, file) != EOF;
+
+    if (ins->op == OP_COMMAND || ins->op == OP_COMMAND_PATH || ins->op == OP_COMMAND_VALUES) {
+        ok = ok && putc((int) ins->cmd, file) != EOF;
+    }
+    ok = ok && WriteVarint(file, ins->line - prev_line) && WriteVarint(file, ins->arg);
+    if (ins->op == OP_ERROR || ins->op == OP_COMMAND_PATH || ins->op == OP_COMMAND_VALUES
+        || (ins->op == OP_COMMAND && CommandTakesDegree(ins->cmd))) {
+        ok = ok && WriteVarint(file, ins->len);
+    }
+    return ok;
+}
+
+static bool ReadInstruction(const uint8_t *data, size_t size, size_t *pos, Instruction *ins, uint64_t prev_line)
+{
+    uint64_t delta;
+
+    *ins = (Instruction) { .op = 0 };
+    if (*pos >= size) {
+        return false;
+    }
+    ins->op = data[(*pos)++];
+    if (ins->op == OP_COMMAND || ins->op == OP_COMMAND_PATH || ins->op == OP_COMMAND_VALUES) {
+        if (*pos >= size) {
+            return false;
+        }
+        ins->cmd = data[(*pos)++];
+    }
+    if (!ReadVarint(data, size, pos, &delta) || !ReadVarint(data, size, pos, &ins->arg)) {
+        return false;
+    }
+    ins->line = prev_line + delta;
+    bool has_len = ins->op == OP_ERROR || ins->op == OP_COMMAND_PATH || ins->op == OP_COMMAND_VALUES
+                   || (ins->op == OP_COMMAND && CommandTakesDegree(ins->cmd));
+    return !has_len || ReadVarint(data, size, pos, &ins->len);
+}
+
+static bool InstructionIsValid(const Program *prog, const Instruction *ins)
+{
+    bool in_strings = ins->arg <= prog->stringsLen && ins->len <= prog->stringsLen - ins->arg;
+
+    switch (ins->op) {
+        case OP_PUSH:
+            return ins->arg < prog->consts->size;
+        case OP_ERROR:
+            return in_strings;
+        case OP_COMMAND:
+            return ins->cmd < COMMAND_COUNT && !CommandTakesPath(ins->cmd) && ins->cmd != EVAL
+                   && ins->len <= MAX_TRUNC_DEG;
+        case OP_COMMAND_PATH:
+            return ins->cmd < COMMAND_COUNT && CommandTakesPath(ins->cmd)
+                   && in_strings && ins->len > 0 && ins->len < FILENAME_MAX;
+        case OP_COMMAND_VALUES:
+            return ins->cmd == EVAL && ins->arg <= prog->values->size
+                   && ins->len > 0 && ins->len <= prog->values->size - ins->arg;
+        default:
+            return false;
+    }
+}
+
+static bool ProgramDecode(Program *prog, const uint8_t *data, size_t size)
+{
+    size_t pos = PROGRAM_HEADER_LEN;
+    uint64_t count, len;
+
+    if (size < PROGRAM_HEADER_LEN || memcmp(data, PROGRAM_MAGIC, PROGRAM_HEADER_LEN - 1) != 0
+        || data[PROGRAM_HEADER_LEN - 1] != PROGRAM_VERSION || !ReadVarint(data, size, &pos, &count)) {
+        return false;
+    }
+    for (uint64_t i = 0; i < count; i++) {
+        Poly p;
+
+        if (!ReadVarint(data, size, &pos, &len) || len > size - pos || !PolyDeserialize(&p, data + pos, len)) {
+            return false;
+        }
+        pos += len;
+        if (VectorPush(prog->consts, &p) != VECT_OK) {
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (!ReadVarint(data, size, &pos, &len) || len > size - pos) {
+        return false;
+    }
+    prog->strings = safeMalloc(len > 0 ? len : 1);
+    prog->stringsLen = len;
+    memcpy(prog->strings, data + pos, len);
+    pos += len;
+
+    if (!ReadVarint(data, size, &pos, &count) || count > size - pos) {
+        return false;    // każda wartość zajmuje co najmniej bajt
+    }
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t val;
+
+        if (!ReadVarint(data, size, &pos, &val)) {
+            return false;
+        }
+        poly_coeff_t value = (poly_coeff_t) val;
+        if (VectorPush(prog->values, &value) != VECT_OK) {
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (!ReadVarint(data, size, &pos, &count) || count > size - pos) {
+        return false;    // każda instrukcja zajmuje co najmniej bajt
+    }
+    uint64_t line = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        Instruction ins;
+
+        if (!ReadInstruction(data, size, &pos, &ins, line) || !InstructionIsValid(prog, &ins)) {
+            return false;
+        }
+        line = ins.line;
+        ProgramEmit(prog, ins);
+    }
+    return pos == size;
+}
+
+static void ProgramInit(Program *prog)
+{
+    prog->code = VectorNew(sizeof(Instruction), INIT_CAP);
+    prog->consts = VectorNew(sizeof(Poly), INIT_CAP);
+    prog->values = VectorNew(sizeof(poly_coeff_t), INIT_CAP);
+    CHECK_POINTER(prog->code);
+    CHECK_POINTER(prog->consts);
+    CHECK_POINTER(prog->values);
+    prog->strings = NULL;
+    prog->stringsLen = 0;
+}
+
+
+
+void ProgramCompile(Program *prog, InputSource *input)
+{
+    size_t line_index = 1, cap = 0;
+    char *lineptr = NULL;
+    StrView str;
+
+    ProgramInit(prog);
+    FILE *pool = open_memstream(&prog->strings, &prog->stringsLen);
+    CHECK_POINTER(pool);
+    Calculator scratch = { .err = pool };    // komunikaty o błędach trafiają wprost do puli napisów
+
+    while (InputNextLine(input, &lineptr, &cap, &str)) {
+        Line line;
+        Instruction ins = { .line = line_index };
+        long start = ftell(pool);
+
+        parseLine(&line, line_index++, str);
+        switch (line.type) {
+            case IGNORED:
+                continue;
+            case WRONG_CMD_LINE:
+                fprintf(pool, "ERROR %zu WRONG COMMAND\n", line.index);
+                ins.op = OP_ERROR;
+                break;
+            case WRONG_POLY_LINE:
+                fprintf(pool, "ERROR %zu WRONG POLY\n", line.index);
+                ins.op = OP_ERROR;
+                break;
+            case POLY_LINE:
+                ins.op = OP_PUSH;
+                ins.arg = prog->consts->size;
+                if (VectorPush(prog->consts, &line.contents.poly) != VECT_OK) {
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case CMD_LINE:
+                if (!parseCommand(&scratch, &line)) {
+                    ins.op = OP_ERROR;
+                }
+                else if (line.contents.cmd == EVAL) {
+                    ins.op = OP_COMMAND_VALUES;
+                    ins.cmd = line.contents.cmd;
+                    ins.arg = prog->values->size;
+                    ins.len = scratch.arg.point.count;
+                    for (size_t i = 0; i < scratch.arg.point.count; i++) {
+                        if (VectorPush(prog->values, &scratch.arg.point.values[i]) != VECT_OK) {
+                            exit(EXIT_FAILURE);
+                        }
+                    }
+                }
+                else if (CommandTakesPath(line.contents.cmd)) {
+                    fwrite(scratch.arg.path.ptr, 1, scratch.arg.path.len, pool);
+                    ins.op = OP_COMMAND_PATH;
+                    ins.cmd = line.contents.cmd;
+                }
+                else {
+                    ins.op = OP_COMMAND;
+                    ins.cmd = line.contents.cmd;
+                    ins.arg = scratch.arg.y;    // pole x dzieli z y te same bajty
+                    if (CommandTakesDegree(line.contents.cmd)) {
+                        ins.len = (uint64_t) scratch.arg.deg;
+                    }
+                }
+                break;
+        }
+        if (ins.op == OP_ERROR || ins.op == OP_COMMAND_PATH) {
+            ins.arg = (uint64_t) start;
+            ins.len = (uint64_t) (ftell(pool) - start);
+        }
+        ProgramEmit(prog, ins);
+    }
+    if (lineptr != NULL) {
+        free(lineptr);
+    }
+    if (scratch.values != NULL) {
+        VectorDestroy(scratch.values);
+    }
+    if (fclose(pool) != 0) {
+        exit(EXIT_FAILURE);
+    }
+}
+
+void ProgramRun(const Program *prog, Calculator *calc)
+{
+    const Instruction *code = prog->code->items;
+    const Poly *consts = prog->consts->items;
+    const poly_coeff_t *values = prog->values->items;
+
+    for (size_t i = 0; i < prog->code->size; i++) {
+        const Instruction *ins = &code[i];
+        Line line = { .index = ins->line, .type = CMD_LINE, .contents.cmd = (CommandCode) ins->cmd };
+
+        calc->lineIndex = ins->line;
+        switch (ins->op) {
+            case OP_PUSH:
+                CalcPushPoly(calc, PolyClone(&consts[ins->arg]));
+                break;
+            case OP_ERROR:
+                fwrite(prog->strings + ins->arg, 1, ins->len, calc->err);
+                break;
+            case OP_COMMAND:
+                calc->arg.y = ins->arg;
+                calc->arg.deg = (poly_exp_t) ins->len;
+                execCommand(calc, line);
+                break;
+            case OP_COMMAND_PATH:
+                calc->arg.path = StrViewMake(prog->strings + ins->arg, ins->len);
+                execCommand(calc, line);
+                break;
+            case OP_COMMAND_VALUES:
+                calc->arg.point.values = values + ins->arg;
+                calc->arg.point.count = ins->len;
+                execCommand(calc, line);
+                break;
+        }
+    }
+}
+
+void ProgramDestroy(Program *prog)
+{
+    for (size_t i = 0; i < prog->consts->size; i++) {
+        PolyDestroy(GET_ITEM(Poly, prog->consts, i));
+    }
+    VectorDestroy(prog->consts);
+    VectorDestroy(prog->values);
+    VectorDestroy(prog->code);
+    free(prog->strings);
+}
+
+bool ProgramWrite(const Program *prog, const char *path)
+{
+    FILE *file = fopen(path, "wb");
+
+    if (file == NULL) {
+        return false;
+    }
+    bool ok = fwrite(PROGRAM_MAGIC, 1, PROGRAM_HEADER_LEN - 1, file) == PROGRAM_HEADER_LEN - 1
+              && fputc(PROGRAM_VERSION, file) != EOF && WriteVarint(file, prog->consts->size);
+
+    for (size_t i = 0; ok && i < prog->consts->size; i++) {
+        size_t size;
+        uint8_t *data = PolySerialize(GET_ITEM(Poly, prog->consts, i), &size);
+
+        ok = WriteVarint(file, size) && fwrite(data, 1, size, file) == size;
+        free(data);
+    }
+    ok = ok && WriteVarint(file, prog->stringsLen)
+         && fwrite(prog->strings, 1, prog->stringsLen, file) == prog->stringsLen
+         && WriteVarint(file, prog->values->size);
+
+    const poly_coeff_t *values = prog->values->items;
+    for (size_t i = 0; ok && i < prog->values->size; i++) {
+        ok = WriteVarint(file, (uint64_t) values[i]);
+    }
+    ok = ok && WriteVarint(file, prog->code->size);
+
+    const Instruction *code = prog->code->items;
+    for (size_t i = 0; ok && i < prog->code->size; i++) {
+        ok = WriteInstruction(file, &code[i], i > 0 ? code[i - 1].line : 0);
+    }
+
+    if (fclose(file) != 0) {
+        ok = false;
+    }
+    return ok;
+}
+
+cmd_errcode_t ProgramRead(Program *prog, const char *path)
+{
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+
+    if (fd == -1) {
+        return CMD_FILE_ERROR;
+    }
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        return CMD_FILE_ERROR;
+    }
+    size_t size = (size_t) st.st_size;
+    if (size < PROGRAM_HEADER_LEN) {
+        close(fd);
+        return CMD_FORMAT_ERROR;
+    }
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED) {
+        return CMD_FILE_ERROR;
+    }
+    ProgramInit(prog);
+    bool ok = ProgramDecode(prog, map, size);
+    munmap(map, size);
+
+    if (!ok) {
+        ProgramDestroy(prog);
+        return CMD_FORMAT_ERROR;
+    }
+    return CMD_OK;
+}
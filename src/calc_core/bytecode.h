@@ -0,0 +1,120 @@
+/** @file
+  Interfejs kompilacji skryptów kalkulatora wielomianów rzadkich wielu zmiennych do kodu bajtowego
+
+  Skrypt kompilowany jest jednokrotnie: wielomiany z jego linii trafiają
+  do puli stałych, komendy - wraz z przetworzonymi już argumentami - stają
+  się instrukcjami, a linie błędne instrukcjami wypisującymi gotowy
+  komunikat o błędzie. Każda instrukcja pamięta indeks swojej linii,
+  więc wykonanie programu daje dokładnie takie samo wyjście jak
+  wykonanie skryptu, bez ponownego przetwarzania tekstu.
+
+  Plik programu zawiera nagłówek (@ref PROGRAM_MAGIC i bajt wersji),
+  liczbę stałych, stałe zapisane przez PolySerialize() (każdą poprzedzoną
+  długością), pulę napisów poprzedzoną długością, pulę wartości
+  poprzedzoną ich liczbą, liczbę instrukcji i same instrukcje. Instrukcja
+  to bajt kodu operacji, bajt kodu komendy (tylko dla komend), przyrost
+  indeksu linii względem poprzedniej instrukcji, argument i długość napisu
+  lub listy wartości (tylko dla OP_ERROR, OP_COMMAND_PATH
+  i OP_COMMAND_VALUES) albo ograniczenie stopnia (tylko dla COMPOSE_TRUNC).
+  Wszystkie liczby zapisane są w kodowaniu varint,
+  tak jak w PolySerialize().
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#ifndef __BYTECODE_H__
+#define __BYTECODE_H__
+
+#include "calc.h"
+
+/**
+ * Sygnatura rozpoczynająca plik programu.
+ */
+#define PROGRAM_MAGIC "PLYP"
+
+/**
+ * Wersja formatu zapisywana w nagłówku.
+ */
+#define PROGRAM_VERSION 3
+
+/**
+ * Kod operacji instrukcji.
+ */
+typedef enum OpCode {
+    OP_PUSH,          ///< Wstawia na stos kopię stałej o indeksie `arg`
+    OP_ERROR,         ///< Wypisuje komunikat o błędzie - napis z puli od `arg` o długości `len`
+    OP_COMMAND,       ///< Wykonuje komendę `cmd` z argumentem liczbowym `arg` (i ograniczeniem stopnia `len` dla COMPOSE_TRUNC)
+    OP_COMMAND_PATH,  ///< Wykonuje komendę `cmd` ze ścieżką - napisem z puli od `arg` o długości `len`
+    OP_COMMAND_VALUES ///< Wykonuje komendę `cmd` z listą wartości - z puli wartości od `arg` o długości `len`
+} OpCode;
+
+/**
+ * Instrukcja programu.
+ */
+typedef struct Instruction {
+    uint32_t op;      ///< Kod operacji (OpCode)
+    uint32_t cmd;     ///< Kod komendy (CommandCode) dla OP_COMMAND, OP_COMMAND_PATH i OP_COMMAND_VALUES
+    uint64_t line;    ///< Indeks linii skryptu, z której pochodzi instrukcja
+    uint64_t arg;     ///< Argument (znaczenie zależy od kodu operacji)
+    uint64_t len;     ///< Długość napisu dla OP_ERROR i OP_COMMAND_PATH, listy dla OP_COMMAND_VALUES lub ograniczenie stopnia dla COMPOSE_TRUNC
+} Instruction;
+
+/**
+ * Skompilowany skrypt.
+ */
+typedef struct Program {
+    vector_t *code;     ///< Instrukcje (Instruction)
+    vector_t *consts;   ///< Pula stałych (Poly)
+    char *strings;      ///< Pula napisów: ścieżek i komunikatów o błędach
+    size_t stringsLen;  ///< Długość puli napisów
+    vector_t *values;   ///< Pula wartości argumentów EVAL (poly_coeff_t)
+} Program;
+
+/**
+ * Kompiluje wszystkie linie wejścia do programu.
+ *
+ * @param[out] prog : program
+ * @param[in, out] input : źródło linii skryptu
+ */
+void ProgramCompile(Program *prog, InputSource *input);
+
+/**
+ * Wykonuje program na kalkulatorze. Stałe programu są kopiowane,
+ * więc można go wykonywać wielokrotnie.
+ *
+ * @param[in] prog : program
+ * @param[in, out] calc : kalkulator
+ */
+void ProgramRun(const Program *prog, Calculator *calc);
+
+/**
+ * Zwalnia pamięć programu.
+ *
+ * @param[in, out] prog : program
+ */
+void ProgramDestroy(Program *prog);
+
+/**
+ * Zapisuje program do pliku.
+ *
+ * @param[in] prog : program
+ * @param[in] path : ścieżka pliku
+ *
+ * @return : czy zapis się powiódł
+ */
+bool ProgramWrite(const Program *prog, const char *path);
+
+/**
+ * Wczytuje program zapisany przez ProgramWrite(), sprawdzając
+ * poprawność wszystkich stałych i instrukcji.
+ *
+ * @param[out] prog : program
+ * @param[in] path : ścieżka pliku
+ *
+ * @return : CMD_OK, CMD_FILE_ERROR lub CMD_FORMAT_ERROR
+ */
+cmd_errcode_t ProgramRead(Program *prog, const char *path);
+
+#endif //__BYTECODE_H__
@@ -7,11 +7,15 @@
 */
 
 #include "calc.h"
+#include "server.h"
+#include "batch.h"
+#include "bytecode.h"
+#include <unistd.h>
 
 /**
  * Tablica asocjacyjna komend z ich kodami.
  */
-static command_pair_t commandList[] = {
+static const command_pair_t commandList[] = {
         {"ZERO", CalcZero},
         {"IS_COEFF", CalcIsCoeff},
         {"IS_ZERO", CalcIsZero},
@@ -27,158 +31,515 @@ static command_pair_t commandList[] = {
         {"PRINT", CalcPrint},
         {"POP", CalcPop},
         {"COMPOSE", CalcCompose},
+        {"SAVE", CalcSave},
+        {"LOAD", CalcLoad},
+        {"SNAPSHOT", CalcSnapshot},
+        {"MAP", CalcMap},
+        {"CHECKPOINT", CalcCheckpoint},
+        {"RESTORE", CalcRestore},
+        {"EVAL", CalcEval},
+        {"EVAL_FILE", CalcEvalFile},
+        {"COMPILE", CalcCompile},
+        {"MUL_TRUNC", CalcMulTrunc},
+        {"COMPOSE_TRUNC", CalcComposeTrunc},
+        {"POW", CalcPow},
+        {"FMA", CalcFma},
+        {"DOT", CalcDot},
     };
 
 /**
- * Wykonuje komendę zadaną kodem w linii i w przypadku błędu,
- * wypisuje go na wyjście diagnostyczne wraz z indeksem linii.
+ * Liczba bitów skrótu nazwy komendy.
+ */
+#define COMMAND_HASH_BITS 6
+
+/**
+ * Rozmiar tablicy @ref commandHashTable.
+ */
+#define COMMAND_HASH_SIZE (1u << COMMAND_HASH_BITS)
+
+/**
+ * Ziarno funkcji skrótu commandHash(), dobrane tak, by była ona doskonała
+ * (bez kolizji) na nazwach z @ref commandList.
+ */
+#define COMMAND_HASH_SEED 760u
+
+/**
+ * Doskonała tablica skrótów nazw komend: pod indeksem commandHash(nazwa)
+ * znajduje się kod komendy powiększony o 1 (0 oznacza brak komendy).
+ * Przy zmianie listy komend trzeba ją przeliczyć (i ewentualnie dobrać
+ * nowe @ref COMMAND_HASH_SEED), a także dobrać na nowo błędne nazwy w teście
+ * command_hash, tak by trafiały w pozycje zajęte przez inne komendy.
+ */
+static const unsigned char commandHashTable[COMMAND_HASH_SIZE] = {
+        [3] = SNAPSHOT + 1,
+        [4] = RESTORE + 1,
+        [5] = ADD + 1,
+        [6] = MUL + 1,
+        [7] = CLONE + 1,
+        [9] = SUB + 1,
+        [10] = SAVE + 1,
+        [12] = MUL_TRUNC + 1,
+        [16] = IS_COEFF + 1,
+        [18] = FMA + 1,
+        [19] = DEG + 1,
+        [22] = DEG_BY + 1,
+        [23] = DOT + 1,
+        [24] = IS_EQ + 1,
+        [25] = COMPOSE_TRUNC + 1,
+        [27] = MAP + 1,
+        [28] = IS_ZERO + 1,
+        [29] = PRINT + 1,
+        [32] = NEG + 1,
+        [38] = POW + 1,
+        [39] = POP + 1,
+        [43] = EVAL_FILE + 1,
+        [44] = AT + 1,
+        [45] = COMPILE + 1,
+        [49] = COMPOSE + 1,
+        [50] = ZERO + 1,
+        [53] = EVAL + 1,
+        [57] = LOAD + 1,
+        [60] = CHECKPOINT + 1,
+    };
+
+/**
+ * Funkcja skrótu nazwy komendy (FNV-1a z ziarnem @ref COMMAND_HASH_SEED).
+ *
+ * @param[in] name : nazwa komendy
  *
- * @param[in, out] calc : kalkulator
- * @param[in] line : linia
+ * @return : indeks w tablicy @ref commandHashTable
  */
-static void execCommand(Calculator *calc, const Line line);
+static inline unsigned commandHash(StrView name);
 
 /**
- * Znajduje w menu komend kod, jakiemu odpowiada komenda
+ * Znajduje w tablicy skrótów kod, jakiemu odpowiada komenda
  * reprezentowana przez @p cmd. W przypadku błędnej komendy,
- * wypisuje błąd na wyjście diagnostyczne wraz z indeksem linii.
+ * wypisuje błąd na wyjście diagnostyczne kalkulatora wraz z indeksem linii.
  *
- * @param[in] cmd : komenda jako string
+ * @param[in] calc : kalkulator
+ * @param[in] cmd : nazwa komendy (widok na początek linii)
  * @param[in, out] line : linia
  *
  * @return : kod komendy
  */
-static cmd_errcode_t getCommandCode(const char *cmd, Line *line);
+static cmd_errcode_t getCommandCode(const Calculator *calc, StrView cmd, Line *line);
 
 /**
- * Przetwarza linię zawierającą tekstową reprezentację wielomianu.
- * Jeśli wielomian utworzono pomyślnie, dodaje go do stosu kalkulatora,
- * w przeciwnym wypadku wypisuje błąd na standardowe wyjście diagnostyczne.
+ * Dodaje do stosu kalkulatora wielomian sparsowany z linii.
  *
  * @param[in, out] menu : menu kalkulatora, z dostępem do stosu wielomianów
- * @param[in] line : struktura linii, wraz z jej indeksem
- * @param[in] str : linia przed obróbką, reprezentująca wielomian
+ * @param[in] line : struktura linii, wraz z jej wielomianem
  */
-static void parseAndPushPoly(Menu *menu, Line line, const char *str);
+static void pushPoly(Menu *menu, Line line);
 
 /**
  * Przetwarza linię zawierającą tekstową reprezentację komendy.
  * Jeśli wpisano prawidłowo komendę, przekazuje ją do kalkulatora wraz
  * z jej argumentem, i wykonuję ją. W wypadku błędnych danych,
- * wypisuje błąd na standardowe wyjście diagnostyczne.
+ * wypisuje błąd na wyjście diagnostyczne kalkulatora.
  *
  * @param[in, out] menu : menu kalkulatora, z dostępem do aktualnego argumentu
- * @param[in] line : struktura linii, wraz z jej indeksem
- * @param[in] str : linia przed obróbką, reprezentująca komendę
+ * @param[in] line : struktura linii, wraz z jej indeksem i treścią
  */
-static void parseAndExecCommand(Menu *menu, Line line, const char *str);
+static void parseAndExecCommand(Menu *menu, Line line);
 
 
-void run(Menu* menu)
+bool run(Menu* menu)
 {
-    size_t line_index = 1, len;
+    size_t line_index = 1, len = 0, restored_lines = 0;
     char *lineptr = NULL;
-    long long nread;
+    StrView str;
 
     CalcInit(&menu->calc);
 
-    while ( (nread = getline(&lineptr, &len, stdin)) != -1 ) {
-        CHECK_POINTER(lineptr);
-        Line line;
-
-        detectLineType(&line, line_index++, lineptr, nread);
-
-        if (line.type == IGNORED) {
-            continue;
+    if (menu->restorePath != NULL) {
+        if (CheckpointRead(&menu->calc, &restored_lines, menu->restorePath) != CMD_OK) {
+            CalcDestroy(&menu->calc);
+            return false;
         }
-        else if (line.type == POLY_LINE) {
-            parseAndPushPoly(menu, line, lineptr);
-        }
-        else if (line.type == CMD_LINE) {
-            parseAndExecCommand(menu, line, lineptr);
+        while (line_index <= restored_lines && InputNextLine(&menu->input, &lineptr, &len, &str)) {
+            line_index++;    // linie przetworzone przed zapisem punktu kontrolnego
         }
     }
     if (lineptr != NULL) {
         free(lineptr);
     }
+    menu->firstLine = line_index;
+
+    runInput(menu);
 
+    if (menu->memoStats) {
+        CalcPrintMemoStats(&menu->calc, stderr);
+    }
     CalcDestroy(&menu->calc);
+    return true;
 }
 
+void runInput(Menu *menu)
+{
+    size_t line_index = menu->firstLine, len = 0;
+    char *lineptr = NULL;
+    StrView str;
 
+    if (menu->pipelineWorkers > 0) {
+        runPipelined(menu, menu->pipelineWorkers);
+        return;
+    }
+    while (InputNextLine(&menu->input, &lineptr, &len, &str)) {
+        Line line;
 
-static cmd_errcode_t getCommandCode(const char *cmd, Line *line)
-{
-    for (size_t i = 0; i < COMMAND_COUNT; i++) {
-        if (strcmp(commandList[i].name, cmd) == 0) {
-            line->contents.cmd = (CommandCode)i;
-            return CMD_OK;
-        }
+        parseLine(&line, line_index++, str);
+        processLine(menu, line);
+    }
+    if (lineptr != NULL) {
+        free(lineptr);
     }
-    fprintf(stderr, "ERROR %zu WRONG COMMAND\n", line->index);
-    return CMD_WRONG_COMMAND;
 }
 
-static void parseAndPushPoly(Menu *menu, Line line, const char *str)
+void processLine(Menu *menu, Line line)
 {
-    if (parsePoly(&line.contents.poly, str, line) != POLY_ERR) {
-        if (VectorPush(menu->calc.polyStack, &line.contents.poly) != VECT_OK) {
-            exit(EXIT_FAILURE);
-        }
+    menu->calc.lineIndex = line.index;
+
+    switch (line.type) {
+        case IGNORED:
+            break;
+        case WRONG_CMD_LINE:
+            fprintf(menu->calc.err, "ERROR %zu WRONG COMMAND\n", line.index);
+            break;
+        case WRONG_POLY_LINE:
+            fprintf(menu->calc.err, "ERROR %zu WRONG POLY\n", line.index);
+            break;
+        case POLY_LINE:
+            pushPoly(menu, line);
+            break;
+        case CMD_LINE:
+            parseAndExecCommand(menu, line);
+            break;
+    }
+
+    if (menu->checkpointEvery > 0 && line.index % menu->checkpointEvery == 0
+        && !CheckpointWrite(&menu->calc, line.index, menu->checkpointPath)) {
+        fprintf(menu->calc.err, "ERROR %zu CHECKPOINT WRONG FILE\n", line.index);
     }
 }
 
-static void parseAndExecCommand(Menu *menu, Line line, const char *str)
+bool parseCommand(Calculator *calc, Line *line)
 {
-    size_t lineptr_len = strlen(str);
-    char *cmd_name = NULL, *arg = NULL;
+    const char *str = line->text.ptr;
+    size_t lineptr_len = line->text.len;
+    StrView arg = StrViewNone();
 
-    int separator_index = -1;    // znalezienie pierwszego wystąpienia nie-litery
-    for (int i = 0; i < (int)lineptr_len; i++) {
+    size_t separator_index = lineptr_len;    // znalezienie pierwszego wystąpienia nie-litery
+    for (size_t i = 0; i < lineptr_len; i++) {
         if (isspace(str[i])) {
             separator_index = i;
             break;
         }
     }
 
-    if (separator_index == -1) {
-        cmd_name = safeCalloc(lineptr_len + 1, sizeof(char));
-        memcpy(cmd_name, str, lineptr_len * sizeof(char)); // nazwa komendy - cała linia, argument - nic
+    StrView cmd_name = StrViewMake(str, separator_index); // nazwa komendy - linia aż do separator_index
+    if (separator_index < lineptr_len) {
+        arg = StrViewMake(str + separator_index, lineptr_len - separator_index); // argument - reszta linii
     }
-    else {
-        cmd_name = safeCalloc(separator_index + 1, sizeof(char));
-        arg = safeCalloc(lineptr_len - separator_index + 1, sizeof(char));
-        memcpy(cmd_name, str, separator_index * sizeof(char)); // nazwa komendy - linia aż do separator_index
-        memcpy(arg, str + separator_index, (lineptr_len - separator_index + 1) * sizeof(char)); // argument - reszta linii
+
+    return getCommandCode(calc, cmd_name, line) != CMD_WRONG_COMMAND
+           && CalcParseArg(calc, *line, arg) != CMD_INVALID_ARG;
+}
+
+void execCommand(Calculator *calc, const Line line)
+{
+    cmd_errcode_t res = (*commandList[line.contents.cmd].func)(calc);
+
+    if (res == CMD_STACK_UNDERFLOW) {
+        fprintf(calc->err, "ERROR %zu STACK UNDERFLOW\n", line.index);
     }
+    else if (res == CMD_FILE_ERROR) {
+        fprintf(calc->err, "ERROR %zu %s WRONG FILE\n", line.index, commandList[line.contents.cmd].name);
+    }
+    else if (res == CMD_FORMAT_ERROR) {
+        fprintf(calc->err, "ERROR %zu %s WRONG FORMAT\n", line.index, commandList[line.contents.cmd].name);
+    }
+}
 
-    if (getCommandCode(cmd_name, &line) != CMD_WRONG_COMMAND) {
-        if (CalcParseArg(&menu->calc, line, arg) != CMD_INVALID_ARG) {
-            execCommand(&menu->calc, line);
-        }
+
+
+static inline unsigned commandHash(StrView name)
+{
+    uint32_t hash = COMMAND_HASH_SEED;
+
+    for (size_t i = 0; i < name.len; i++) {
+        hash = (hash ^ (unsigned char) name.ptr[i]) * 16777619u;
     }
-    free(cmd_name);
-    free(arg);
+    return hash >> (32 - COMMAND_HASH_BITS);    // najstarsze bity są najlepiej wymieszane
 }
 
-static void execCommand(Calculator *calc, const Line line)
+static cmd_errcode_t getCommandCode(const Calculator *calc, StrView cmd, Line *line)
 {
-    if ((*commandList[line.contents.cmd].func)(calc) == CMD_STACK_UNDERFLOW) {
-        fprintf(stderr, "ERROR %zu STACK UNDERFLOW\n", line.index);
+    unsigned slot = commandHashTable[commandHash(cmd)];
+
+    if (slot != 0 && StrViewEquals(cmd, commandList[slot - 1].name)) {
+        line->contents.cmd = (CommandCode)(slot - 1);
+        return CMD_OK;
     }
+    fprintf(calc->err, "ERROR %zu WRONG COMMAND\n", line->index);
+    return CMD_WRONG_COMMAND;
 }
 
+static void pushPoly(Menu *menu, Line line)
+{
+    CalcPushPoly(&menu->calc, line.contents.poly);
+}
+
+static void parseAndExecCommand(Menu *menu, Line line)
+{
+    if (parseCommand(&menu->calc, &line)) {
+        execCommand(&menu->calc, line);
+    }
+}
+
+
+/**
+ * Przetwarza opcje wywołania programu:
+ * - `--deferred-free` : zwalnianie zdejmowanych ze stosu wielomianów w osobnym wątku,
+ * - `--lazy` : leniwe obliczanie wyników ADD, SUB, MUL i NEG (zob. lazy.h),
+ * - `--intern N` : współdzielenie identycznych poddrzew wielomianów na stosie,
+ *   z tablicą mieszczącą co najwyżej N poddrzew (zob. poly_intern.h),
+ * - `--memo BYTES` : zapamiętywanie wyników MUL, AT i COMPOSE w pamięci
+ *   podręcznej o budżecie BYTES bajtów (zob. op_cache.h),
+ * - `--memo-stats` : wypisanie na koniec statystyk pamięci podręcznej
+ *   wyników na standardowe wyjście diagnostyczne,
+ * - `--mod P` : obliczenia na współczynnikach modulo nieparzysta liczba P
+ *   (zob. poly_mod.h); wyniki wypisywane są jako reszty z przedziału [0, P),
+ * - `--pipeline N` : potokowe przetwarzanie wejścia z N wątkami parsującymi,
+ * - `--input FILE` : czytanie wejścia z pliku odwzorowanego w pamięci zamiast
+ *   ze standardowego wejścia,
+ * - `--restore FILE` : wznowienie pracy od punktu kontrolnego zapisanego
+ *   przez komendę CHECKPOINT lub okresowo,
+ * - `--checkpoint FILE --checkpoint-every N` : zapisywanie punktu kontrolnego
+ *   do pliku FILE co N linii wejścia,
+ * - `--server SOCKET` : praca jako serwer sesji na gnieździe SOCKET zamiast
+ *   przetwarzania standardowego wejścia,
+ * - `--batch DIR_OR_LIST` : wykonanie wszystkich plików `*.in` z katalogu
+ *   lub plików z listy, każdego na osobnym kalkulatorze, zamiast
+ *   przetwarzania standardowego wejścia,
+ * - `-j N` : liczba wątków obsługujących sesje serwera lub pliki trybu
+ *   wsadowego, a w pozostałych trybach - wartościujących punkty komendy
+ *   EVAL_FILE (domyślnie liczba procesorów),
+ * - `--compile FILE` : skompilowanie wejścia do programu w pliku FILE
+ *   zamiast jego wykonania,
+ * - `--exec FILE` : wykonanie programu skompilowanego przez `--compile`
+ *   zamiast przetwarzania standardowego wejścia.
+ *
+ * @param[in, out] menu : menu kalkulatora
+ * @param[in] argc : liczba argumentów
+ * @param[in] argv : argumenty
+ *
+ * @return : czy podano wyłącznie poprawne opcje
+ */
+static bool parseOptions(Menu *menu, int argc, char *argv[])
+{
+    menu->pipelineWorkers = 0;
+    menu->restorePath = NULL;
+    menu->checkpointPath = NULL;
+    menu->checkpointEvery = 0;
+    menu->serverPath = NULL;
+    menu->batchPath = NULL;
+    menu->compilePath = NULL;
+    menu->execPath = NULL;
+    menu->memoStats = false;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    menu->jobs = (cpus > 0) ? (size_t) cpus : 1;
+    InputOpenStream(&menu->input, stdin);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--deferred-free") == 0) {
+            PolyReclaimerStart();
+        }
+        else if (strcmp(argv[i], "--lazy") == 0) {
+            CalcEnableLazyMode();
+        }
+        else if (strcmp(argv[i], "--intern") == 0 && i + 1 < argc) {
+            char *endptr = NULL;
+            unsigned long limit = strtoul(argv[++i], &endptr, 10);
+
+            if (*endptr != '\0' || limit == 0) {
+                fprintf(stderr, "%s: wrong intern table limit\n", argv[0]);
+                return false;
+            }
+            CalcEnableInterning(limit);
+        }
+        else if (strcmp(argv[i], "--memo") == 0 && i + 1 < argc) {
+            char *endptr = NULL;
+            unsigned long budget = strtoul(argv[++i], &endptr, 10);
+
+            if (*endptr != '\0' || budget == 0) {
+                fprintf(stderr, "%s: wrong memo budget\n", argv[0]);
+                return false;
+            }
+            CalcEnableMemo(budget);
+        }
+        else if (strcmp(argv[i], "--memo-stats") == 0) {
+            menu->memoStats = true;
+        }
+        else if (strcmp(argv[i], "--mod") == 0 && i + 1 < argc) {
+            char *endptr = NULL;
+            unsigned long modulus = strtoul(argv[++i], &endptr, 10);
+
+            if (*endptr != '\0' || !PolySetModulus(modulus)) {
+                fprintf(stderr, "%s: wrong modulus\n", argv[0]);
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--pipeline") == 0 && i + 1 < argc) {
+            char *endptr = NULL;
+            unsigned long workers = strtoul(argv[++i], &endptr, 10);
+
+            if (*endptr != '\0' || workers == 0 || workers > PIPELINE_MAX_WORKERS) {
+                fprintf(stderr, "%s: wrong number of parsing threads\n", argv[0]);
+                return false;
+            }
+            menu->pipelineWorkers = workers;
+        }
+        else if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+            if (!InputOpenFile(&menu->input, argv[++i])) {
+                fprintf(stderr, "%s: cannot map input file %s\n", argv[0], argv[i]);
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--restore") == 0 && i + 1 < argc) {
+            menu->restorePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+            menu->checkpointPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--checkpoint-every") == 0 && i + 1 < argc) {
+            char *endptr = NULL;
+            unsigned long every = strtoul(argv[++i], &endptr, 10);
+
+            if (*endptr != '\0' || every == 0) {
+                fprintf(stderr, "%s: wrong checkpoint interval\n", argv[0]);
+                return false;
+            }
+            menu->checkpointEvery = every;
+        }
+        else if (strcmp(argv[i], "--server") == 0 && i + 1 < argc) {
+            menu->serverPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            menu->batchPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--compile") == 0 && i + 1 < argc) {
+            menu->compilePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--exec") == 0 && i + 1 < argc) {
+            menu->execPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            char *endptr = NULL;
+            unsigned long jobs = strtoul(argv[++i], &endptr, 10);
+
+            if (*endptr != '\0' || jobs == 0 || jobs > SERVER_MAX_WORKERS) {
+                fprintf(stderr, "%s: wrong number of jobs\n", argv[0]);
+                return false;
+            }
+            menu->jobs = jobs;
+        }
+        else {
+            fprintf(stderr, "Usage: %s [--deferred-free] [--lazy] [--intern N] [--memo BYTES [--memo-stats]] [--mod P] [--pipeline N] [--input FILE]"
+                            " [--restore FILE] [--checkpoint FILE --checkpoint-every N]"
+                            " [--server SOCKET | --batch DIR_OR_LIST] [-j N]"
+                            " [--compile FILE | --exec FILE]\n", argv[0]);
+            return false;
+        }
+    }
+    int modes = (menu->serverPath != NULL) + (menu->batchPath != NULL)
+                + (menu->compilePath != NULL) + (menu->execPath != NULL);
+    bool stdin_options = menu->pipelineWorkers > 0 || menu->restorePath != NULL || menu->checkpointPath != NULL;
+    bool input_file = menu->input.stream == NULL;    // dopuszczalne tylko przy kompilacji
+
+    if (modes > 1 || (modes == 1 && (stdin_options || (input_file && menu->compilePath == NULL)))) {
+        fprintf(stderr, "%s: --server, --batch, --compile and --exec cannot be combined with other modes\n", argv[0]);
+        return false;
+    }
+    if ((menu->checkpointEvery > 0) != (menu->checkpointPath != NULL)) {
+        fprintf(stderr, "%s: --checkpoint and --checkpoint-every must be given together\n", argv[0]);
+        return false;
+    }
+    return true;
+}
 
 /**
  * Inicjalizuje kalkulator poprzez menu, wczytuje wielomiany i komendy,
  * na bieżąco zwracając żądany output lub wypisując błędy w przypadku
  * nieprawidłowych danych.
  *
+ * @param[in] argc : liczba argumentów
+ * @param[in] argv : argumenty
+ *
  * @return : program zakończony pomyślnie
  */
-int main() {
+int main(int argc, char *argv[]) {
     Menu menu;
-    run(&menu);
+
+    if (!parseOptions(&menu, argc, argv)) {
+        exit(EXIT_FAILURE);
+    }
+    if (menu.serverPath != NULL) {
+        if (!runServer(menu.serverPath, menu.jobs)) {
+            fprintf(stderr, "%s: cannot listen on %s\n", argv[0], menu.serverPath);
+            exit(EXIT_FAILURE);
+        }
+        PolyReclaimerStop();
+        exit(EXIT_SUCCESS);
+    }
+    if (menu.compilePath != NULL) {
+        Program prog;
+
+        ProgramCompile(&prog, &menu.input);
+        bool ok = ProgramWrite(&prog, menu.compilePath);
+        ProgramDestroy(&prog);
+        InputClose(&menu.input);
+        if (!ok) {
+            fprintf(stderr, "%s: cannot write program %s\n", argv[0], menu.compilePath);
+            exit(EXIT_FAILURE);
+        }
+        exit(EXIT_SUCCESS);
+    }
+    if (menu.execPath != NULL) {
+        Program prog;
+
+        if (ProgramRead(&prog, menu.execPath) != CMD_OK) {
+            fprintf(stderr, "%s: cannot load program %s\n", argv[0], menu.execPath);
+            exit(EXIT_FAILURE);
+        }
+        PolyEvalSetThreads(menu.jobs);
+        CalcInit(&menu.calc);
+        ProgramRun(&prog, &menu.calc);
+        if (menu.memoStats) {
+            CalcPrintMemoStats(&menu.calc, stderr);
+        }
+        CalcDestroy(&menu.calc);
+        ProgramDestroy(&prog);
+        PolyReclaimerStop();
+        exit(EXIT_SUCCESS);
+    }
+    if (menu.batchPath != NULL) {
+        size_t failed;
+
+        if (!runBatch(menu.batchPath, menu.jobs, &failed)) {
+            fprintf(stderr, "%s: cannot read batch %s\n", argv[0], menu.batchPath);
+            exit(EXIT_FAILURE);
+        }
+        PolyReclaimerStop();
+        exit(failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    PolyEvalSetThreads(menu.jobs);
+    if (!run(&menu)) {
+        fprintf(stderr, "%s: cannot restore checkpoint %s\n", argv[0], menu.restorePath);
+        exit(EXIT_FAILURE);
+    }
+    InputClose(&menu.input);
+    PolyReclaimerStop();
 
     exit(EXIT_SUCCESS);
 }
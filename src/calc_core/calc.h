@@ -14,20 +14,98 @@
 
 #include "calc_engine.h"
 #include "parsing.h"
+#include "input.h"
+#include "checkpoint.h"
+
+/**
+ * Maksymalna liczba wątków parsujących w trybie potokowym.
+ */
+#define PIPELINE_MAX_WORKERS 256
 
 /**
  * Struktura stanowiąca warstwę abstrakcji do obsługi kalkulatora.
  */
 typedef struct Menu {
-    Calculator calc; ///< Kalkulator
+    Calculator calc;         ///< Kalkulator
+    InputSource input;       ///< Źródło linii wejściowych
+    size_t pipelineWorkers;  ///< Liczba wątków parsujących (0 - przetwarzanie sekwencyjne)
+    const char *restorePath; ///< Punkt kontrolny, od którego należy wznowić pracę (lub NULL)
+    const char *checkpointPath; ///< Plik okresowych punktów kontrolnych (lub NULL)
+    size_t checkpointEvery;  ///< Co ile linii zapisywać punkt kontrolny (0 - nigdy)
+    size_t firstLine;        ///< Indeks pierwszej przetwarzanej linii wejścia
+    const char *serverPath;  ///< Gniazdo trybu serwera (lub NULL)
+    const char *batchPath;   ///< Katalog lub lista plików trybu wsadowego (lub NULL)
+    const char *compilePath; ///< Plik, do którego należy skompilować wejście (lub NULL)
+    const char *execPath;    ///< Skompilowany program do wykonania (lub NULL)
+    size_t jobs;             ///< Liczba wątków w trybie serwera lub wsadowym
+    bool memoStats;          ///< Czy wypisać na koniec statystyki pamięci podręcznej wyników
 } Menu;
 
 /**
  * Uruchamia działanie kalkulatora wraz z przetwarzaniem danych
- * i wypisywaniem błędów.
+ * i wypisywaniem błędów. Jeśli podano @p menu->restorePath, najpierw
+ * odtwarza stan z punktu kontrolnego i pomija linie wejścia
+ * przetworzone przed jego zapisem.
  *
  * @param[in] menu : interfejs kalkulatora
+ *
+ * @return : czy udało się odtworzyć punkt kontrolny (jeśli go podano)
+ */
+bool run(Menu* menu);
+
+/**
+ * Przetwarza pozostałe linie wejścia @p menu->input, numerując je
+ * od @p menu->firstLine, na zainicjalizowanym już kalkulatorze -
+ * sekwencyjnie lub potokowo.
+ *
+ * @param[in, out] menu : menu kalkulatora
+ */
+void runInput(Menu *menu);
+
+/**
+ * Wykonuje linię rozpoznaną (i ewentualnie sparsowaną) przez parseLine():
+ * dodaje wielomian na stos, wykonuje komendę lub wypisuje błąd
+ * na wyjście diagnostyczne kalkulatora. Co @p menu->checkpointEvery
+ * linii zapisuje punkt kontrolny.
+ * @see parseLine()
+ *
+ * @param[in, out] menu : menu kalkulatora
+ * @param[in] line : struktura linii, wraz z jej indeksem, treścią i zawartością
+ */
+void processLine(Menu *menu, Line line);
+
+/**
+ * Rozpoznaje komendę w linii typu CMD_LINE i przetwarza jej argument:
+ * zapisuje kod komendy w @p line->contents.cmd, a argument w @p calc->arg.
+ * W przypadku błędnej komendy lub argumentu wypisuje błąd na wyjście
+ * diagnostyczne kalkulatora.
+ *
+ * @param[in, out] calc : kalkulator
+ * @param[in, out] line : linia z komendą
+ *
+ * @return : czy komenda i jej argument są poprawne
+ */
+bool parseCommand(Calculator *calc, Line *line);
+
+/**
+ * Wykonuje komendę zadaną kodem w linii (z argumentem w @p calc->arg)
+ * i w przypadku błędu wypisuje go na wyjście diagnostyczne kalkulatora
+ * wraz z indeksem linii.
+ *
+ * @param[in, out] calc : kalkulator
+ * @param[in] line : linia
+ */
+void execCommand(Calculator *calc, const Line line);
+
+/**
+ * Przetwarza wejście @p menu->input potokowo: wątek czytający dzieli je na linie,
+ * @p workers wątków parsujących rozpoznaje je i buduje wielomiany, a bieżący
+ * wątek wykonuje linie w kolejności wejścia. Wyjście jest identyczne
+ * z przetwarzaniem sekwencyjnym.
+ *
+ * @param[in, out] menu : menu kalkulatora
+ * @param[in] workers : liczba wątków parsujących
  */
-void run(Menu* menu);
+void runPipelined(Menu *menu, size_t workers);
 
 #endif //__MENU_H__
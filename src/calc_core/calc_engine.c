@@ -6,36 +6,71 @@
   @date 2021
 */
 
-#include <ctype.h>
 #include "calc_engine.h"
 #include "line_structures.h"
+#include "checkpoint.h"
 
 /**
- * Funkcja drukująca wielomian, wrapper dla PolyPrintRecursive().
- * @see PolyPrintRecursive()
- *
- * @param[in, out] stream : strumień wyjścia
- * @param[in] p : wielomian
+ * Czy kalkulatory inicjalizowane przez CalcInit() pracują w trybie leniwym.
+ * @see CalcEnableLazyMode()
  */
-static void PolyPrint(FILE *stream, const Poly *p);
+static bool lazyMode = false;
+
+/**
+ * Limit tablicy współdzielonych poddrzew kalkulatorów inicjalizowanych
+ * przez CalcInit() (0 - bez tablicy).
+ * @see CalcEnableInterning()
+ */
+static size_t internLimit = 0;
+
+/**
+ * Budżet pamięci podręcznej wyników kalkulatorów inicjalizowanych
+ * przez CalcInit() (0 - bez pamięci podręcznej).
+ * @see CalcEnableMemo()
+ */
+static size_t memoBudget = 0;
+
+/**
+ * Rozmiar porcji punktów wczytywanych naraz przez komendę EVAL_FILE (w bajtach).
+ * @see CalcEvalFile()
+ */
+#define EVAL_FILE_CHUNK_BYTES ((size_t) 1 << 22)
+
+/**
+ * Ramka stosu używanego przy wypisywaniu wielomianu.
+ */
+typedef struct PrintFrame {
+    const Poly *p;  ///< wypisywany wielomian
+    size_t left;    ///< liczba jednomianów @p p, których jeszcze nie zaczęto wypisywać
+} PrintFrame;
 
 /**
- * Funkcja rekurencyjnie wypisująca wielomian
- * do wybranego strumienia wyjścia.
+ * Ramka stosu używanego przy wypisywaniu wielomianu ze snapshotu.
+ */
+typedef struct SnapPrintFrame {
+    const PolySnapMono *monos;  ///< jednomiany wypisywanego wielomianu
+    size_t size;                ///< liczba jednomianów
+    size_t left;                ///< liczba jednomianów, których jeszcze nie zaczęto wypisywać
+} SnapPrintFrame;
+
+/**
+ * Funkcja drukująca wielomian, wrapper dla PolyPrintIterative().
+ * @see PolyPrintIterative()
  *
  * @param[in, out] stream : strumień wyjścia
  * @param[in] p : wielomian
  */
-static void PolyPrintRecursive(FILE *stream, const Poly *p);
+static void PolyPrint(FILE *stream, const Poly *p);
 
 /**
- * Funkcja rekurencyjnie wypisująca jednomian
- * do wybranego strumienia wyjścia.
+ * Funkcja wypisująca wielomian do wybranego strumienia wyjścia.
+ * Przechodzi drzewo wielomianu przy pomocy jawnego stosu,
+ * więc głębokość zagnieżdżenia ogranicza jedynie dostępna pamięć.
  *
  * @param[in, out] stream : strumień wyjścia
- * @param[in] m : jednomian
+ * @param[in] p : wielomian
  */
-static void MonoPrint(FILE *stream, const Mono *m);
+static void PolyPrintIterative(FILE *stream, const Poly *p);
 
 /**
  * Przetwarza argument dla komendy AT. Zwraca rezultat operacji,
@@ -47,7 +82,7 @@ static void MonoPrint(FILE *stream, const Mono *m);
  *
  * @return : czy wprowadzono poprawny argument
  */
-static cmd_errcode_t CalcParseAtArg(Calculator *calc, const Line line, const char *str);
+static cmd_errcode_t CalcParseAtArg(Calculator *calc, const Line line, StrView str);
 
 /**
  * Przetwarza argument dla komendy DEG_BY. Zwraca rezultat operacji,
@@ -59,7 +94,44 @@ static cmd_errcode_t CalcParseAtArg(Calculator *calc, const Line line, const cha
  *
  * @return : czy wprowadzono poprawny argument
  */
-static cmd_errcode_t CalcParseDegByArg(Calculator *calc, const Line line, const char *str);
+static cmd_errcode_t CalcParseDegByArg(Calculator *calc, const Line line, StrView str);
+
+/**
+ * Wczytuje liczbę nieujemną zajmującą całą resztę argumentu od pozycji @p start.
+ *
+ * @param[in] str : argument
+ * @param[in] start : pozycja pierwszej cyfry
+ * @param[in] max : największa dopuszczalna wartość
+ * @param[out] res : wczytana liczba
+ *
+ * @return : czy reszta argumentu to niepusty ciąg cyfr o wartości nie większej niż @p max
+ */
+static bool CalcParseUnsigned(StrView str, size_t start, unsigned long long max, unsigned long long *res);
+
+/**
+ * Wczytuje listę liczb całkowitych z zakresu współczynników, z których
+ * każda poprzedzona jest pojedynczą spacją, zajmującą cały argument.
+ *
+ * @param[in] str : argument
+ * @param[in, out] values : wektor (poly_coeff_t), do którego dopisywane są wczytane liczby
+ *
+ * @return : czy argument jest niepustą listą poprawnych liczb
+ */
+static bool CalcParseValues(StrView str, vector_t *values);
+
+/**
+ * Przetwarza argument dla komendy EVAL - listę wartości zmiennych.
+ * Wartości wczytywane są do bufora kalkulatora (tworzonego przy pierwszym
+ * użyciu), na który wskazuje @p calc->arg. Zwraca rezultat operacji,
+ * wypisuje ewentualne błędy na wyjście diagnostyczne.
+ *
+ * @param[in, out] calc : kalkulator
+ * @param[in] line : linia, wraz z indeksem
+ * @param[in] str : argument przed obróbką
+ *
+ * @return : czy wprowadzono poprawny argument
+ */
+static cmd_errcode_t CalcParseEvalArg(Calculator *calc, const Line line, StrView str);
 
 /**
  * Przetwarza argument dla komendy COMPOSE. Zwraca rezultat operacji,
@@ -71,137 +143,974 @@ static cmd_errcode_t CalcParseDegByArg(Calculator *calc, const Line line, const
  *
  * @return : czy wprowadzono poprawny argument
  */
-static cmd_errcode_t CalcParseComposeArg(Calculator *calc, const Line line, const char *str);
+static cmd_errcode_t CalcParseComposeArg(Calculator *calc, const Line line, StrView str);
+
+/**
+ * Przetwarza argument dla komendy MUL_TRUNC - ograniczenie stopnia.
+ * Zwraca rezultat operacji, wypisuje ewentualne błędy w konwersji
+ * na wyjście diagnostyczne.
+ *
+ * @param[in, out] calc : kalkulator
+ * @param[in] line : linia, wraz z indeksem
+ * @param[in] str : argument przed obróbką
+ *
+ * @return : czy wprowadzono poprawny argument
+ */
+static cmd_errcode_t CalcParseMulTruncArg(Calculator *calc, const Line line, StrView str);
+
+/**
+ * Przetwarza argument dla komendy POW - wykładnik. Zwraca rezultat
+ * operacji, wypisuje ewentualne błędy w konwersji na wyjście diagnostyczne.
+ *
+ * @param[in, out] calc : kalkulator
+ * @param[in] line : linia, wraz z indeksem
+ * @param[in] str : argument przed obróbką
+ *
+ * @return : czy wprowadzono poprawny argument
+ */
+static cmd_errcode_t CalcParsePowArg(Calculator *calc, const Line line, StrView str);
+
+/**
+ * Przetwarza argument dla komendy DOT - długość wektorów. Zwraca rezultat
+ * operacji, wypisuje ewentualne błędy w konwersji na wyjście diagnostyczne.
+ *
+ * @param[in, out] calc : kalkulator
+ * @param[in] line : linia, wraz z indeksem
+ * @param[in] str : argument przed obróbką
+ *
+ * @return : czy wprowadzono poprawny argument
+ */
+static cmd_errcode_t CalcParseDotArg(Calculator *calc, const Line line, StrView str);
+
+/**
+ * Przetwarza argument dla komendy COMPOSE_TRUNC - liczbę wielomianów
+ * i ograniczenie stopnia, każde poprzedzone pojedynczą spacją. Zwraca
+ * rezultat operacji, wypisuje ewentualne błędy w konwersji na wyjście
+ * diagnostyczne.
+ *
+ * @param[in, out] calc : kalkulator
+ * @param[in] line : linia, wraz z indeksem
+ * @param[in] str : argument przed obróbką
+ *
+ * @return : czy wprowadzono poprawny argument
+ */
+static cmd_errcode_t CalcParseComposeTruncArg(Calculator *calc, const Line line, StrView str);
+
+/**
+ * Przetwarza argument dla komend SAVE i LOAD - ścieżkę pliku,
+ * zajmującą całą resztę linii po spacji. Zwraca rezultat operacji,
+ * wypisuje ewentualne błędy na wyjście diagnostyczne.
+ *
+ * @param[in, out] calc : kalkulator
+ * @param[in] line : linia, wraz z indeksem
+ * @param[in] str : argument przed obróbką
+ * @param[in] name : nazwa komendy (do komunikatu o błędzie)
+ *
+ * @return : czy wprowadzono poprawny argument
+ */
+static cmd_errcode_t CalcParseFileArg(Calculator *calc, const Line line, StrView str, const char *name);
+
+/**
+ * Przetwarza argument dla komendy EVAL_FILE - dwie ścieżki plików
+ * oddzielone spacją. Zwraca rezultat operacji, wypisuje ewentualne
+ * błędy na wyjście diagnostyczne.
+ *
+ * @param[in, out] calc : kalkulator
+ * @param[in] line : linia, wraz z indeksem
+ * @param[in] str : argument przed obróbką
+ *
+ * @return : czy wprowadzono poprawny argument
+ */
+static cmd_errcode_t CalcParseEvalFileArg(Calculator *calc, const Line line, StrView str);
+
+/**
+ * Dzieli argument kalkulatora na dwie niepuste ścieżki plików (rozdzielone
+ * pierwszą spacją) i kopiuje je do buforów, kończąc je znakiem '\0'.
+ *
+ * @param[in] calc : kalkulator
+ * @param[out] first : bufor na pierwszą ścieżkę (lub NULL)
+ * @param[out] second : bufor na drugą ścieżkę (lub NULL)
+ *
+ * @return : czy argument składa się z dwóch niepustych ścieżek
+ */
+static bool CalcSplitPaths(const Calculator *calc, char first[FILENAME_MAX], char second[FILENAME_MAX]);
+
+/**
+ * Wartościuje wielomian we wszystkich punktach pliku wejściowego
+ * (zob. CalcEvalFile()), przetwarzając go porcjami po
+ * @ref EVAL_FILE_CHUNK_BYTES bajtów, i zapisuje wyniki do pliku wyjściowego.
+ *
+ * @param[in] p : wielomian
+ * @param[in] in_path : ścieżka pliku z punktami
+ * @param[in] out_path : ścieżka pliku na wartości
+ *
+ * @return : wynik (sukces, błąd pliku lub błąd formatu)
+ */
+static cmd_errcode_t CalcEvalStream(const Poly *p, const char *in_path, const char *out_path);
+
+/**
+ * Kopiuje ścieżkę pliku z argumentu kalkulatora do bufora,
+ * kończąc ją znakiem '\0'.
+ *
+ * @param[in] calc : kalkulator
+ * @param[out] path : bufor na ścieżkę
+ */
+static void CalcCopyPath(const Calculator *calc, char path[FILENAME_MAX]);
+
+/**
+ * Wczytuje całą zawartość pliku do nowo zaalokowanego bufora.
+ *
+ * @param[in] path : ścieżka pliku
+ * @param[out] size : długość zawartości w bajtach
+ *
+ * @return : bufor (do zwolnienia przez free()) lub NULL w przypadku błędu
+ */
+static uint8_t *CalcReadFile(const char *path, size_t *size);
+
+/**
+ * Zapisuje bufor do pliku, zastępując jego poprzednią zawartość.
+ *
+ * @param[in] path : ścieżka pliku
+ * @param[in] data : bufor
+ * @param[in] size : długość bufora w bajtach
+ *
+ * @return : czy zapis się powiódł
+ */
+static bool CalcWriteFile(const char *path, const uint8_t *data, size_t size);
+
+/**
+ * Odtwarza w pamięci odwzorowane snapshoty i oblicza wyrażenia spośród
+ * @p count elementów z wierzchołka stosu, aby można było je modyfikować.
+ *
+ * @param[in, out] calc : kalkulator
+ * @param[in] count : liczba elementów (nie większa niż rozmiar stosu)
+ */
+static void CalcMaterialize(Calculator *calc, size_t count);
+
+/**
+ * Oblicza wyrażenia spośród @p count elementów z wierzchołka stosu,
+ * pozostawiając odwzorowane snapshoty bez zmian.
+ *
+ * @param[in, out] calc : kalkulator
+ * @param[in] count : liczba elementów (nie większa niż rozmiar stosu)
+ */
+static void CalcForce(Calculator *calc, size_t count);
+
+/**
+ * Zdejmuje element z wierzchołka stosu (który nie może być pusty)
+ * jako wyrażenie. Odwzorowany snapshot odtwarzany jest w pamięci.
+ *
+ * @param[in, out] calc : kalkulator
+ * @param[in, out] bytes : pamięć, do której dolicza się pamięć elementu
+ * @param[out] fingerprint : odcisk elementu
+ *
+ * @return : wyrażenie (przejmowane na własność)
+ */
+static LazyNode *CalcPopNode(Calculator *calc, size_t *bytes, PolyFingerprint *fingerprint);
+
+/**
+ * Wstawia na stos wyrażenie, przejmując je na własność.
+ * Do czasu obliczenia wyrażenia za zajmowaną przez nie pamięć
+ * uznaje się pamięć jego argumentów.
+ *
+ * @param[in, out] calc : kalkulator
+ * @param[in] node : wyrażenie
+ * @param[in] bytes : pamięć argumentów wyrażenia
+ * @param[in] fingerprint : odcisk wyrażenia
+ */
+static void CalcPushNode(Calculator *calc, LazyNode *node, size_t bytes, PolyFingerprint fingerprint);
+
+/**
+ * Wstawia na stos wynik działania o znanym już odcisku,
+ * przejmując wynik na własność.
+ *
+ * @param[in, out] calc : kalkulator
+ * @param[in] p : wielomian
+ * @param[in] fingerprint : odcisk @p p
+ */
+static void CalcPushResult(Calculator *calc, Poly p, PolyFingerprint fingerprint);
+
+/**
+ * Łączy odciski dwóch elementów z wierzchołka stosu (które nie są
+ * odwzorowanymi snapshotami) tak, jak działanie łączy ich wielomiany.
+ *
+ * @param[in] calc : kalkulator
+ * @param[in] op : działanie na odciskach, którego pierwszym argumentem jest wierzchołek
+ *
+ * @return : odcisk wyniku
+ */
+static PolyFingerprint CalcTopFingerprints(const Calculator *calc,
+                                           PolyFingerprint (*op)(PolyFingerprint, PolyFingerprint));
+
+/**
+ * Zlicza pamięć zajmowaną przez tablice jednomianów wielomianu.
+ *
+ * @param[in] p : wielomian
+ *
+ * @return : liczba bajtów
+ */
+static size_t CalcPolyBytes(const Poly *p);
+
+/**
+ * Uwzględnia w pamięci kalkulatora element wstawiany na stos,
+ * o ile kalkulator ją zlicza. Odwzorowane snapshoty nie zajmują
+ * pamięci kalkulatora, a wyrażenia mają ustaloną już pamięć.
+ * Program dołączony przez COMPILE liczony jest w każdym elemencie,
+ * który go współdzieli.
+ *
+ * @param[in, out] calc : kalkulator
+ * @param[in, out] item : element stosu
+ */
+static void CalcTrackItem(Calculator *calc, StackItem *item);
+
+/**
+ * Zdejmuje element z wierzchołka stosu (który nie może być pusty),
+ * odejmując go od pamięci kalkulatora.
+ *
+ * @param[in, out] calc : kalkulator
+ *
+ * @return : zdjęty element, ważny do kolejnej zmiany stosu
+ */
+static StackItem *CalcPopItem(Calculator *calc);
+
+/**
+ * Odłącza od elementu stosu jego program (jeśli go ma),
+ * odejmując go od pamięci kalkulatora.
+ *
+ * @param[in, out] calc : kalkulator
+ * @param[in, out] item : element stosu
+ */
+static void CalcDropProgram(Calculator *calc, StackItem *item);
+
+/**
+ * Usuwa element zdjęty ze stosu: zwalnia wielomian, snapshot lub wyrażenie.
+ *
+ * @param[in, out] calc : kalkulator
+ * @param[in, out] item : element stosu
+ */
+static void CalcItemDestroy(Calculator *calc, StackItem *item);
+
+/**
+ * Szuka w pamięci podręcznej kalkulatora wyniku działania na elementach
+ * stosu. Elementy odwzorowane i leniwe nie są wyszukiwane.
+ *
+ * @param[in, out] calc : kalkulator
+ * @param[in] op : kod komendy
+ * @param[in] arg : argument komendy
+ * @param[in] count : liczba argumentów-elementów
+ * @param[in] items : argumenty-elementy
+ * @param[out] res : wynik (gdy został znaleziony)
+ *
+ * @return : czy wynik był w pamięci podręcznej
+ */
+static bool CalcMemoLookup(Calculator *calc, CommandCode op, uint64_t arg, size_t count,
+                           const StackItem *const items[], Poly *res);
+
+/**
+ * Zapamiętuje wynik działania na elementach stosu, wyszukanego
+ * wcześniej bez powodzenia przez CalcMemoLookup().
+ *
+ * @param[in, out] calc : kalkulator
+ * @param[in] op : kod komendy
+ * @param[in] arg : argument komendy
+ * @param[in] count : liczba argumentów-elementów
+ * @param[in] items : argumenty-elementy
+ * @param[in] res : wynik
+ */
+static void CalcMemoStore(Calculator *calc, CommandCode op, uint64_t arg, size_t count,
+                          const StackItem *const items[], const Poly *res);
+
+/**
+ * Zwalnia wszystkie elementy stosu kalkulatora wraz z samym stosem.
+ *
+ * @param[in, out] calc : kalkulator
+ */
+static void CalcStackDestroy(Calculator *calc);
+
+/**
+ * Funkcja wypisująca wielomian ze snapshotu do wybranego strumienia wyjścia,
+ * w takiej samej postaci, jak PolyPrintIterative().
+ *
+ * @param[in, out] stream : strumień wyjścia
+ * @param[in] snap : snapshot
+ */
+static void SnapshotPrintIterative(FILE *stream, const PolySnapshot *snap);
 
 
 
 static void PolyPrint(FILE *stream, const Poly *p)
 {
-    PolyPrintRecursive(stream, p);
+    PolyPrintIterative(stream, p);
     fprintf(stream,"\n");
 }
 
-static void PolyPrintRecursive(FILE *stream, const Poly *p)
+static void PolyPrintIterative(FILE *stream, const Poly *p)
 {
     if (PolyIsCoeff(p)) {
         fprintf(stream, "%ld", p->coeff);
+        return;
+    }
+    vector_t *stack = VectorNew(sizeof(PrintFrame), INIT_CAP);
+    CHECK_POINTER(stack);
+    PrintFrame root = { .p = p, .left = p->size };
+    if (VectorPush(stack, &root) != VECT_OK) {
+        exit(EXIT_FAILURE);
+    }
+
+    while (!VectorIsEmpty(stack)) {
+        PrintFrame *top = (PrintFrame *) VectorPeek(stack);
+
+        if (top->left > 0) {    // jednomiany wypisywane są od najniższego wykładnika
+            if (top->left != top->p->size) {
+                fprintf(stream, "+");
+            }
+            fprintf(stream, "(");
+            const Poly *coeff = &top->p->arr[--top->left].p;
+
+            if (PolyIsCoeff(coeff)) {
+                fprintf(stream, "%ld,%d)", coeff->coeff, MonoGetExp(&top->p->arr[top->left]));
+            }
+            else {
+                PrintFrame child = { .p = coeff, .left = coeff->size };
+                if (VectorPush(stack, &child) != VECT_OK) {
+                    exit(EXIT_FAILURE);
+                }
+            }
+        }
+        else {
+            VectorPop(stack);    // zamknięcie jednomianu, którego współczynnikiem był zdjęty wielomian
+            if (!VectorIsEmpty(stack)) {
+                PrintFrame *parent = (PrintFrame *) VectorPeek(stack);
+                fprintf(stream, ",%d)", MonoGetExp(&parent->p->arr[parent->left]));
+            }
+        }
+    }
+    VectorDestroy(stack);
+}
+
+static bool CalcParseUnsigned(StrView str, size_t start, unsigned long long max, unsigned long long *res)
+{
+    size_t pos = start;
+    return StrViewParseDigits(str, &pos, max, res) && pos == str.len;
+}
+
+static cmd_errcode_t CalcParseDegByArg(Calculator *calc, const Line line, StrView str)
+{
+    unsigned long long res_ull;
+
+    if (str.ptr == NULL || str.len < 2 || str.ptr[0] != ' ' || !CalcParseUnsigned(str, 1, MAX_IDX, &res_ull)) {
+        fprintf(calc->err, "ERROR %zu DEG BY WRONG VARIABLE\n", line.index);
+        return CMD_INVALID_ARG;    // input nie reprezentuje liczby lub overflow
+    }
+    calc->arg.y = res_ull;
+    return CMD_OK;
+}
+
+static cmd_errcode_t CalcParseAtArg(Calculator *calc, const Line line, StrView str)
+{
+    unsigned long long res_ull;
+    bool negative = str.len > 1 && str.ptr[1] == '-';
+    unsigned long long max = negative ? (unsigned long long)MAX_COEFF + 1 : MAX_COEFF;    // dopuszczalne jest LONG_MIN
+
+    if (str.ptr == NULL || str.len < 2 || str.ptr[0] != ' '
+        || !CalcParseUnsigned(str, negative ? 2 : 1, max, &res_ull)) {
+        fprintf(calc->err, "ERROR %zu AT WRONG VALUE\n", line.index);
+        return CMD_INVALID_ARG;    // input nie reprezentuje liczby lub overflow/underflow
+    }
+    calc->arg.x = negative ? (poly_coeff_t)(0 - res_ull) : (poly_coeff_t)res_ull;
+    return CMD_OK;
+}
+
+static bool CalcParseValues(StrView str, vector_t *values)
+{
+    size_t pos = 0;
+
+    if (str.ptr == NULL) {
+        return false;
+    }
+    while (pos < str.len) {
+        unsigned long long res_ull;
+
+        if (str.ptr[pos++] != ' ') {
+            return false;
+        }
+        bool negative = pos < str.len && str.ptr[pos] == '-';
+        unsigned long long max = negative ? (unsigned long long)MAX_COEFF + 1 : MAX_COEFF;    // dopuszczalne jest LONG_MIN
+
+        pos += negative;
+        if (!StrViewParseDigits(str, &pos, max, &res_ull)) {
+            return false;    // brak cyfr lub overflow/underflow
+        }
+        poly_coeff_t value = negative ? (poly_coeff_t)(0 - res_ull) : (poly_coeff_t)res_ull;
+        if (VectorPush(values, &value) != VECT_OK) {
+            exit(EXIT_FAILURE);
+        }
+    }
+    return values->size > 0;
+}
+
+static cmd_errcode_t CalcParseEvalArg(Calculator *calc, const Line line, StrView str)
+{
+    if (calc->values == NULL) {
+        calc->values = VectorNew(sizeof(poly_coeff_t), INIT_CAP);
+        CHECK_POINTER(calc->values);
+    }
+    VectorClear(calc->values);
+    if (!CalcParseValues(str, calc->values)) {
+        fprintf(calc->err, "ERROR %zu EVAL WRONG VALUE\n", line.index);
+        return CMD_INVALID_ARG;
+    }
+    calc->arg.point.values = calc->values->items;
+    calc->arg.point.count = calc->values->size;
+    return CMD_OK;
+}
+
+static cmd_errcode_t CalcParseComposeArg(Calculator *calc, const Line line, StrView str)
+{
+    unsigned long long res_ull;
+
+    if (str.ptr == NULL || str.len < 2 || str.ptr[0] != ' ' || !CalcParseUnsigned(str, 1, MAX_COMPOSE_ARG, &res_ull)) {
+        fprintf(calc->err, "ERROR %zu COMPOSE WRONG PARAMETER\n", line.index);
+        return CMD_INVALID_ARG;    // input nie reprezentuje liczby lub overflow
+    }
+    calc->arg.y = res_ull;
+    return CMD_OK;
+}
+
+static cmd_errcode_t CalcParseMulTruncArg(Calculator *calc, const Line line, StrView str)
+{
+    unsigned long long res_ull;
+
+    if (str.ptr == NULL || str.len < 2 || str.ptr[0] != ' ' || !CalcParseUnsigned(str, 1, MAX_TRUNC_DEG, &res_ull)) {
+        fprintf(calc->err, "ERROR %zu MUL_TRUNC WRONG DEGREE\n", line.index);
+        return CMD_INVALID_ARG;
+    }
+    calc->arg.y = res_ull;
+    return CMD_OK;
+}
+
+static cmd_errcode_t CalcParsePowArg(Calculator *calc, const Line line, StrView str)
+{
+    unsigned long long res_ull;
+
+    if (str.ptr == NULL || str.len < 2 || str.ptr[0] != ' ' || !CalcParseUnsigned(str, 1, MAX_EXP, &res_ull)) {
+        fprintf(calc->err, "ERROR %zu POW WRONG EXPONENT\n", line.index);
+        return CMD_INVALID_ARG;
+    }
+    calc->arg.y = res_ull;
+    return CMD_OK;
+}
+
+static cmd_errcode_t CalcParseDotArg(Calculator *calc, const Line line, StrView str)
+{
+    unsigned long long res_ull;
+
+    if (str.ptr == NULL || str.len < 2 || str.ptr[0] != ' ' || !CalcParseUnsigned(str, 1, MAX_IDX, &res_ull)) {
+        fprintf(calc->err, "ERROR %zu DOT WRONG PARAMETER\n", line.index);
+        return CMD_INVALID_ARG;
+    }
+    calc->arg.y = res_ull;
+    return CMD_OK;
+}
+
+static cmd_errcode_t CalcParseComposeTruncArg(Calculator *calc, const Line line, StrView str)
+{
+    size_t pos = 1;
+    unsigned long long k_ull, d_ull;
+
+    if (str.ptr == NULL || str.len < 2 || str.ptr[0] != ' '
+        || !StrViewParseDigits(str, &pos, MAX_COMPOSE_ARG, &k_ull)
+        || pos >= str.len || str.ptr[pos] != ' '
+        || !CalcParseUnsigned(str, pos + 1, MAX_TRUNC_DEG, &d_ull)) {
+        fprintf(calc->err, "ERROR %zu COMPOSE_TRUNC WRONG PARAMETER\n", line.index);
+        return CMD_INVALID_ARG;
+    }
+    calc->arg.y = k_ull;
+    calc->arg.deg = (poly_exp_t) d_ull;
+    return CMD_OK;
+}
+
+static cmd_errcode_t CalcParseFileArg(Calculator *calc, const Line line, StrView str, const char *name)
+{
+    if (str.ptr == NULL || str.len < 2 || str.ptr[0] != ' ' || str.len - 1 >= FILENAME_MAX) {
+        fprintf(calc->err, "ERROR %zu %s WRONG FILE\n", line.index, name);
+        return CMD_INVALID_ARG;
+    }
+    calc->arg.path = StrViewMake(str.ptr + 1, str.len - 1);
+    return CMD_OK;
+}
+
+static cmd_errcode_t CalcParseEvalFileArg(Calculator *calc, const Line line, StrView str)
+{
+    if (CalcParseFileArg(calc, line, str, "EVAL_FILE") != CMD_OK) {
+        return CMD_INVALID_ARG;
+    }
+    if (!CalcSplitPaths(calc, NULL, NULL)) {
+        fprintf(calc->err, "ERROR %zu EVAL_FILE WRONG FILE\n", line.index);
+        return CMD_INVALID_ARG;
+    }
+    return CMD_OK;
+}
+
+static bool CalcSplitPaths(const Calculator *calc, char first[FILENAME_MAX], char second[FILENAME_MAX])
+{
+    const char *sep = memchr(calc->arg.path.ptr, ' ', calc->arg.path.len);
+
+    if (sep == NULL || sep == calc->arg.path.ptr || sep + 1 == calc->arg.path.ptr + calc->arg.path.len) {
+        return false;
+    }
+    size_t first_len = (size_t) (sep - calc->arg.path.ptr);
+    size_t second_len = calc->arg.path.len - first_len - 1;
+
+    if (first != NULL) {
+        memcpy(first, calc->arg.path.ptr, first_len);
+        first[first_len] = '\0';
+    }
+    if (second != NULL) {
+        memcpy(second, sep + 1, second_len);
+        second[second_len] = '\0';
+    }
+    return true;
+}
+
+static cmd_errcode_t CalcEvalStream(const Poly *p, const char *in_path, const char *out_path)
+{
+    FILE *in = fopen(in_path, "rb");
+    uint64_t nvars;
+    long len;
+
+    if (in == NULL) {
+        return CMD_FILE_ERROR;
+    }
+    if (fseek(in, 0, SEEK_END) != 0 || (len = ftell(in)) < 0 || fseek(in, 0, SEEK_SET) != 0) {
+        fclose(in);
+        return CMD_FILE_ERROR;
+    }
+    size_t data_len = (size_t) len - sizeof(nvars);
+
+    if ((size_t) len < sizeof(nvars) || fread(&nvars, sizeof(nvars), 1, in) != 1
+        || nvars == 0 || nvars > (uint64_t) len || data_len % (nvars * sizeof(poly_coeff_t)) != 0) {
+        fclose(in);
+        return CMD_FORMAT_ERROR;    // nvars <= len, więc rozmiar punktu się nie przekręca
+    }
+    FILE *out = fopen(out_path, "wb");
+
+    if (out == NULL) {
+        fclose(in);
+        return CMD_FILE_ERROR;
+    }
+    size_t point_size = nvars * sizeof(poly_coeff_t);
+    size_t left = data_len / point_size;
+    size_t chunk = (EVAL_FILE_CHUNK_BYTES > point_size) ? EVAL_FILE_CHUNK_BYTES / point_size : 1;
+    poly_coeff_t *points = safeMalloc((left < chunk ? left + 1 : chunk) * point_size);
+    poly_coeff_t *values = safeMalloc((left < chunk ? left + 1 : chunk) * sizeof(poly_coeff_t));
+    bool ok = true;
+
+    while (ok && left > 0) {
+        size_t count = (left < chunk) ? left : chunk;
+
+        ok = fread(points, point_size, count, in) == count;
+        if (ok) {
+            PolyEvalBatch(p, nvars, count, points, values);
+            ok = fwrite(values, sizeof(poly_coeff_t), count, out) == count;
+        }
+        left -= count;
+    }
+    free(points);
+    free(values);
+    fclose(in);
+    ok &= fclose(out) == 0;
+
+    return ok ? CMD_OK : CMD_FILE_ERROR;
+}
+
+static void CalcCopyPath(const Calculator *calc, char path[FILENAME_MAX])
+{
+    memcpy(path, calc->arg.path.ptr, calc->arg.path.len);
+    path[calc->arg.path.len] = '\0';
+}
+
+static uint8_t *CalcReadFile(const char *path, size_t *size)
+{
+    FILE *file = fopen(path, "rb");
+    uint8_t *data = NULL;
+    long len;
+
+    if (file == NULL) {
+        return NULL;
+    }
+    if (fseek(file, 0, SEEK_END) == 0 && (len = ftell(file)) >= 0 && fseek(file, 0, SEEK_SET) == 0) {
+        data = safeMalloc(len > 0 ? (size_t) len : 1);
+        if (fread(data, 1, (size_t) len, file) != (size_t) len) {
+            free(data);
+            data = NULL;
+        }
+        *size = (size_t) len;
+    }
+    fclose(file);
+    return data;
+}
+
+static bool CalcWriteFile(const char *path, const uint8_t *data, size_t size)
+{
+    FILE *file = fopen(path, "wb");
+    bool ok = file != NULL && fwrite(data, 1, size, file) == size;
+
+    if (file != NULL && fclose(file) != 0) {
+        ok = false;
+    }
+    return ok;
+}
+
+static void CalcMaterialize(Calculator *calc, size_t count)
+{
+    CalcForce(calc, count);
+    for (size_t i = calc->polyStack->size - count; i < calc->polyStack->size; i++) {
+        StackItem *item = GET_ITEM(StackItem, calc->polyStack, i);
+
+        if (item->mapped != NULL) {
+            PolySnapshot *snap = item->mapped;
+            item->poly = PolySnapshotToPoly(snap);
+            item->fingerprint = PolyFingerprintOf(&item->poly);
+            item->mapped = NULL;
+            PolySnapshotRelease(snap);
+            CalcTrackItem(calc, item);
+        }
+    }
+}
+
+static void CalcForce(Calculator *calc, size_t count)
+{
+    for (size_t i = calc->polyStack->size - count; i < calc->polyStack->size; i++) {
+        StackItem *item = GET_ITEM(StackItem, calc->polyStack, i);
+
+        if (item->lazy != NULL) {
+            item->poly = LazyTake(item->lazy);
+            item->lazy = NULL;
+            calc->memory -= item->bytes;
+            CalcTrackItem(calc, item);
+        }
+    }
+}
+
+static LazyNode *CalcPopNode(Calculator *calc, size_t *bytes, PolyFingerprint *fingerprint)
+{
+    StackItem *item = CalcPopItem(calc);
+
+    if (item->mapped != NULL) {
+        Poly p = PolySnapshotToPoly(item->mapped);
+        PolySnapshotRelease(item->mapped);
+        *bytes += calc->trackMemory ? CalcPolyBytes(&p) : 0;
+        *fingerprint = PolyFingerprintOf(&p);
+        return LazyLeaf(p);
+    }
+    if (item->interned) {    // liść przejmuje wielomian na własność
+        Poly p = PolyClone(&item->poly);
+        PolyInternRelease(calc->intern, &item->poly);
+        *bytes += calc->trackMemory ? CalcPolyBytes(&p) : 0;
+        *fingerprint = item->fingerprint;
+        return LazyLeaf(p);
+    }
+    *bytes += item->bytes;
+    *fingerprint = item->fingerprint;
+    return (item->lazy != NULL) ? item->lazy : LazyLeaf(item->poly);
+}
+
+static void CalcPushNode(Calculator *calc, LazyNode *node, size_t bytes, PolyFingerprint fingerprint)
+{
+    StackItem item = { .mapped = NULL, .lazy = node, .bytes = bytes, .fingerprint = fingerprint };
+
+    CalcTrackItem(calc, &item);
+    if (VectorPush(calc->polyStack, &item) != VECT_OK) {
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void CalcPushResult(Calculator *calc, Poly p, PolyFingerprint fingerprint)
+{
+    bool interned = calc->intern != NULL && PolyIntern(calc->intern, &p);
+    StackItem item = { .poly = p, .mapped = NULL, .fingerprint = fingerprint, .interned = interned };
+
+    CalcTrackItem(calc, &item);
+    if (VectorPush(calc->polyStack, &item) != VECT_OK) {
+        exit(EXIT_FAILURE);
+    }
+}
+
+static PolyFingerprint CalcTopFingerprints(const Calculator *calc,
+                                           PolyFingerprint (*op)(PolyFingerprint, PolyFingerprint))
+{
+    const StackItem *first = GET_ITEM(StackItem, calc->polyStack, calc->polyStack->size - 1);
+    const StackItem *second = GET_ITEM(StackItem, calc->polyStack, calc->polyStack->size - 2);
+
+    return op(first->fingerprint, second->fingerprint);
+}
+
+static size_t CalcPolyBytes(const Poly *p)
+{
+    size_t bytes = 0;
+
+    if (PolyIsCoeff(p)) {
+        return 0;
+    }
+    vector_t *stack = VectorNew(sizeof(const Poly *), INIT_CAP);
+    CHECK_POINTER(stack);
+    if (VectorPush(stack, &p) != VECT_OK) {
+        exit(EXIT_FAILURE);
+    }
+
+    while (!VectorIsEmpty(stack)) {
+        const Poly *top = *(const Poly **) VectorPop(stack);
+
+        bytes += top->size * sizeof(Mono);
+        for (size_t i = 0; i < top->size; i++) {
+            const Poly *child = &top->arr[i].p;
+            if (!PolyIsCoeff(child) && VectorPush(stack, &child) != VECT_OK) {
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+    VectorDestroy(stack);
+    return bytes;
+}
+
+static void CalcTrackItem(Calculator *calc, StackItem *item)
+{
+    if (calc->trackMemory) {
+        if (item->lazy == NULL) {    // współdzielone wielomiany liczone są w pamięci tablicy
+            item->bytes = (item->mapped != NULL || item->interned) ? 0 : CalcPolyBytes(&item->poly);
+            item->bytes += (item->program != NULL) ? PolyProgramBytes(item->program) : 0;
+        }
+        calc->memory += item->bytes;
+        size_t total = calc->memory + ((calc->intern != NULL) ? calc->intern->bytes : 0);
+        if (total > calc->peakMemory) {
+            calc->peakMemory = total;
+        }
+    }
+}
+
+static StackItem *CalcPopItem(Calculator *calc)
+{
+    StackItem *item = (StackItem *) VectorPop(calc->polyStack);
+
+    CalcDropProgram(calc, item);    // zdjęty wielomian jest zwalniany lub zmieniany
+    calc->memory -= item->bytes;
+    return item;
+}
+
+static void CalcDropProgram(Calculator *calc, StackItem *item)
+{
+    if (item->program != NULL) {
+        if (calc->trackMemory) {
+            size_t bytes = PolyProgramBytes(item->program);
+            item->bytes -= bytes;
+            calc->memory -= bytes;
+        }
+        PolyProgramRelease(item->program);
+        item->program = NULL;
+    }
+}
+
+static void CalcItemDestroy(Calculator *calc, StackItem *item)
+{
+    if (item->lazy != NULL) {
+        LazyRelease(item->lazy);
+    }
+    else if (item->mapped != NULL) {
+        PolySnapshotRelease(item->mapped);
+    }
+    else if (item->interned) {
+        PolyInternRelease(calc->intern, &item->poly);
     }
     else {
-        for (size_t i = p->size; i > 0; i--) {
-            if (i != p->size) {
+        PolyDestroyDeferred(&item->poly);
+    }
+}
+
+static bool CalcMemoLookup(Calculator *calc, CommandCode op, uint64_t arg, size_t count,
+                           const StackItem *const items[], Poly *res)
+{
+    if (calc->memo == NULL) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (items[i]->lazy != NULL || items[i]->mapped != NULL) {
+            return false;
+        }
+    }
+    const Poly **operands = safeMalloc(count * sizeof(Poly *));
+    PolyFingerprint *fingerprints = safeMalloc(count * sizeof(PolyFingerprint));
+    for (size_t i = 0; i < count; i++) {
+        operands[i] = &items[i]->poly;
+        fingerprints[i] = items[i]->fingerprint;
+    }
+    bool found = OpCacheLookup(calc->memo, op, arg, count, operands, fingerprints, res);
+    free(operands);
+    free(fingerprints);
+    return found;
+}
+
+static void CalcMemoStore(Calculator *calc, CommandCode op, uint64_t arg, size_t count,
+                          const StackItem *const items[], const Poly *res)
+{
+    if (calc->memo == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (items[i]->lazy != NULL || items[i]->mapped != NULL) {
+            return;
+        }
+    }
+    const Poly **operands = safeMalloc(count * sizeof(Poly *));
+    PolyFingerprint *fingerprints = safeMalloc(count * sizeof(PolyFingerprint));
+    size_t bytes = CalcPolyBytes(res);
+    for (size_t i = 0; i < count; i++) {
+        operands[i] = &items[i]->poly;
+        fingerprints[i] = items[i]->fingerprint;
+        bytes += CalcPolyBytes(operands[i]);
+    }
+    OpCacheStore(calc->memo, op, arg, count, operands, fingerprints, res, bytes);
+    free(operands);
+    free(fingerprints);
+}
+
+static void CalcStackDestroy(Calculator *calc)
+{
+    for (size_t i = 0; i < calc->polyStack->size; i++) {
+        StackItem *item = GET_ITEM(StackItem, calc->polyStack, i);
+
+        if (item->lazy != NULL) {
+            LazyRelease(item->lazy);
+        }
+        else if (item->mapped != NULL) {
+            PolySnapshotRelease(item->mapped);
+        }
+        else if (item->interned) {
+            PolyInternRelease(calc->intern, &item->poly);
+        }
+        else {
+            PolyDestroy(&item->poly);
+        }
+        PolyProgramRelease(item->program);
+    }
+    VectorDestroy(calc->polyStack);
+}
+
+static void SnapshotPrintIterative(FILE *stream, const PolySnapshot *snap)
+{
+    const PolySnapNode *root = PolySnapshotRoot(snap);
+
+    if (root->size == 0) {
+        fprintf(stream, "%ld", (poly_coeff_t) root->coeff);
+        return;
+    }
+    vector_t *stack = VectorNew(sizeof(SnapPrintFrame), INIT_CAP);
+    CHECK_POINTER(stack);
+    SnapPrintFrame frame = { .monos = PolySnapshotMonos(snap, root), .size = root->size, .left = root->size };
+    if (VectorPush(stack, &frame) != VECT_OK) {
+        exit(EXIT_FAILURE);
+    }
+
+    while (!VectorIsEmpty(stack)) {
+        SnapPrintFrame *top = (SnapPrintFrame *) VectorPeek(stack);
+
+        if (top->left > 0) {    // jednomiany wypisywane są od najniższego wykładnika
+            if (top->left != top->size) {
                 fprintf(stream, "+");
             }
-            MonoPrint(stream, &p->arr[i - 1]);
+            fprintf(stream, "(");
+            const PolySnapMono *m = &top->monos[--top->left];
+
+            if (m->p.size == 0) {
+                fprintf(stream, "%ld,%d)", (poly_coeff_t) m->p.coeff, (poly_exp_t) m->exp);
+            }
+            else {
+                SnapPrintFrame child = { .monos = PolySnapshotMonos(snap, &m->p), .size = m->p.size, .left = m->p.size };
+                if (VectorPush(stack, &child) != VECT_OK) {
+                    exit(EXIT_FAILURE);
+                }
+            }
+        }
+        else {
+            VectorPop(stack);    // zamknięcie jednomianu, którego współczynnikiem był zdjęty wielomian
+            if (!VectorIsEmpty(stack)) {
+                SnapPrintFrame *parent = (SnapPrintFrame *) VectorPeek(stack);
+                fprintf(stream, ",%d)", (poly_exp_t) parent->monos[parent->left].exp);
+            }
         }
     }
+    VectorDestroy(stack);
 }
 
-static void MonoPrint(FILE *stream, const Mono *m)
+
+
+void CalcInit(Calculator *calc)
 {
-    fprintf(stream, "(");
-    PolyPrintRecursive(stream, &m->p);
-    fprintf(stream, ",%d", MonoGetExp(m));
-    fprintf(stream, ")");
+    calc->polyStack = VectorNew(sizeof(StackItem), INIT_CAP);
+    calc->lineIndex = 0;
+    calc->out = stdout;
+    calc->err = stderr;
+    calc->lazy = lazyMode;
+    calc->trackMemory = false;
+    calc->memory = 0;
+    calc->peakMemory = 0;
+    calc->intern = (internLimit > 0) ? PolyInternTableNew(internLimit) : NULL;
+    calc->memo = (memoBudget > 0) ? OpCacheNew(memoBudget) : NULL;
+    calc->values = NULL;
 }
 
-static cmd_errcode_t CalcParseDegByArg(Calculator *calc, const Line line, const char *str)
+void CalcEnableLazyMode(void)
 {
-    char *endptr = NULL;
-
-    if (str == NULL || strlen(str) == 0 || str[0] != ' ' || strcmp(str, " ") == 0) {
-        fprintf(stderr, "ERROR %zu DEG BY WRONG VARIABLE\n", line.index);
-        return CMD_INVALID_ARG;
-    }
-    for (size_t i = 1; i < strlen(str); i++) {
-        if (!isdigit(str[i])) {    //sprawdzenie czy w stringu są same cyfry
-            fprintf(stderr, "ERROR %zu DEG BY WRONG VARIABLE\n", line.index);
-            return CMD_INVALID_ARG;
-        }
-    }
-    errno = 0;    // konwersja współczynnika
-    long long unsigned res_ull = strtoull(str, &endptr, 10);
-
-    if ((res_ull == 0 && (errno != 0 || endptr == str)) || !IS_VALID_IDX(res_ull)) {
-        fprintf(stderr, "ERROR %zu DEG BY WRONG VARIABLE\n", line.index);
-        return CMD_INVALID_ARG;    // input nie reprezentuje liczby lub overflow
-    }
-    else {
-        calc->arg.y = res_ull;
-        return CMD_OK;
-    }
+    lazyMode = true;
 }
 
-static cmd_errcode_t CalcParseAtArg(Calculator *calc, const Line line, const char *str)
+void CalcEnableInterning(size_t limit)
 {
-    char *endptr = NULL;
+    internLimit = limit;
+}
 
-    if (str == NULL || strlen(str) == 0 || str[0] != ' ' || strcmp(str, " ") == 0 || strcmp(str, " -") == 0) {
-        fprintf(stderr, "ERROR %zu AT WRONG VALUE\n", line.index);
-        return CMD_INVALID_ARG;
-    }
-    for (size_t i = (str[1]=='-')? 2 : 1; i < strlen(str); i++) {
-        if (!isdigit(str[i])) {    //sprawdzenie czy w stringu są same cyfry (i ewentualny minus na początku)
-            fprintf(stderr, "ERROR %zu AT WRONG VALUE\n", line.index);
-            return CMD_INVALID_ARG;
-        }
-    }
-    errno = 0;
-    long res_l = strtol(str, &endptr, 10);
+void CalcEnableMemo(size_t budget)
+{
+    memoBudget = budget;
+}
 
-    if ((res_l == 0 && (errno != 0 || endptr == str)) || !IS_VALID_COEFF(res_l)) {
-        fprintf(stderr, "ERROR %zu AT WRONG VALUE\n", line.index);
-        return CMD_INVALID_ARG;    // input nie reprezentuje liczby lub overflow/underflow
-    }
-    else {
-        calc->arg.x = res_l;
-        return CMD_OK;
+void CalcPrintMemoStats(const Calculator *calc, FILE *stream)
+{
+    if (calc->memo != NULL) {
+        fprintf(stream, "memo: %zu hits, %zu misses, %zu evictions, %zu entries, %zu bytes\n",
+                calc->memo->hits, calc->memo->misses, calc->memo->evictions,
+                calc->memo->count, calc->memo->bytes);
     }
 }
 
-static cmd_errcode_t CalcParseComposeArg(Calculator *calc, const Line line, const char *str)
+void CalcDestroy(Calculator *calc)
 {
-    char *endptr = NULL;
-
-    if (str == NULL || strlen(str) == 0 || str[0] != ' ' || strcmp(str, " ") == 0) {
-        fprintf(stderr, "ERROR %zu COMPOSE WRONG PARAMETER\n", line.index);
-        return CMD_INVALID_ARG;
+    CalcStackDestroy(calc);
+    if (calc->intern != NULL) {
+        PolyInternTableDestroy(calc->intern);
     }
-    for (size_t i = 1; i < strlen(str); i++) {
-        if (!isdigit(str[i])) {    //sprawdzenie czy w stringu są same cyfry
-            fprintf(stderr, "ERROR %zu COMPOSE WRONG PARAMETER\n", line.index);
-            return CMD_INVALID_ARG;
-        }
-    }
-    errno = 0;    // konwersja współczynnika
-    long long unsigned res_ull = strtoull(str, &endptr, 10);
-
-    if ((res_ull == 0 && (errno != 0 || endptr == str)) || !IS_VALID_COMPOSE_ARG(res_ull)) {
-        fprintf(stderr, "ERROR %zu COMPOSE WRONG PARAMETER\n", line.index);
-        return CMD_INVALID_ARG;    // input nie reprezentuje liczby lub overflow
+    if (calc->memo != NULL) {
+        OpCacheDestroy(calc->memo);
     }
-    else {
-        calc->arg.y = res_ull;
-        return CMD_OK;
+    if (calc->values != NULL) {
+        VectorDestroy(calc->values);
     }
+    PolyWorkspaceFree();
 }
 
-
-
-void CalcInit(Calculator *calc)
+void CalcReplaceStack(Calculator *calc, poly_stack_t *stack)
 {
-    calc->polyStack = VectorNew(sizeof(Poly), INIT_CAP);
+    CalcStackDestroy(calc);
+    calc->polyStack = stack;
 }
 
-void CalcDestroy(Calculator *calc)
+void CalcPushPoly(Calculator *calc, Poly p)
 {
-    for (size_t i = 0; i < calc->polyStack->size; i++) {
-        Poly *p = GET_ITEM(Poly, calc->polyStack, i);
-        PolyDestroy(p);
-    }
-    VectorDestroy(calc->polyStack);
+    PolyReduceCoeffs(&p);    // wejście, stałe programu i wczytane pliki mogą mieć dowolne współczynniki
+    CalcPushResult(calc, p, PolyFingerprintOf(&p));
 }
 
-cmd_errcode_t CalcParseArg(Calculator *calc, const Line line, const char *str)
+cmd_errcode_t CalcParseArg(Calculator *calc, const Line line, StrView str)
 {
     if (line.contents.cmd == DEG_BY) {
         return CalcParseDegByArg(calc, line, str);
@@ -212,8 +1121,44 @@ cmd_errcode_t CalcParseArg(Calculator *calc, const Line line, const char *str)
     else if (line.contents.cmd == COMPOSE) {
         return CalcParseComposeArg(calc, line, str);
     }
-    else if (str != NULL) {
-        fprintf(stderr, "ERROR %zu WRONG COMMAND\n", line.index);
+    else if (line.contents.cmd == SAVE) {
+        return CalcParseFileArg(calc, line, str, "SAVE");
+    }
+    else if (line.contents.cmd == LOAD) {
+        return CalcParseFileArg(calc, line, str, "LOAD");
+    }
+    else if (line.contents.cmd == SNAPSHOT) {
+        return CalcParseFileArg(calc, line, str, "SNAPSHOT");
+    }
+    else if (line.contents.cmd == MAP) {
+        return CalcParseFileArg(calc, line, str, "MAP");
+    }
+    else if (line.contents.cmd == CHECKPOINT) {
+        return CalcParseFileArg(calc, line, str, "CHECKPOINT");
+    }
+    else if (line.contents.cmd == RESTORE) {
+        return CalcParseFileArg(calc, line, str, "RESTORE");
+    }
+    else if (line.contents.cmd == EVAL) {
+        return CalcParseEvalArg(calc, line, str);
+    }
+    else if (line.contents.cmd == EVAL_FILE) {
+        return CalcParseEvalFileArg(calc, line, str);
+    }
+    else if (line.contents.cmd == MUL_TRUNC) {
+        return CalcParseMulTruncArg(calc, line, str);
+    }
+    else if (line.contents.cmd == COMPOSE_TRUNC) {
+        return CalcParseComposeTruncArg(calc, line, str);
+    }
+    else if (line.contents.cmd == POW) {
+        return CalcParsePowArg(calc, line, str);
+    }
+    else if (line.contents.cmd == DOT) {
+        return CalcParseDotArg(calc, line, str);
+    }
+    else if (str.ptr != NULL) {
+        fprintf(calc->err, "ERROR %zu WRONG COMMAND\n", line.index);
         return CMD_INVALID_ARG;    // wprowadzono argument dla funkcji, która go nie wymaga
     }
     return CMD_OK;
@@ -223,51 +1168,70 @@ cmd_errcode_t CalcParseArg(Calculator *calc, const Line line, const char *str)
 
 cmd_errcode_t CalcZero(Calculator *calc)
 {
-    Poly zero = PolyZero();
-    if (VectorPush(calc->polyStack, &zero) != VECT_OK) {
-        exit(EXIT_FAILURE);
-    }
+    CalcPushPoly(calc, PolyZero());
     return CMD_OK;
 }
 
 cmd_errcode_t CalcIsCoeff(Calculator *calc)
 {
-    Poly *top = NULL;
+    StackItem *top = NULL;
 
     if (VectorIsEmpty(calc->polyStack)) {
         return CMD_STACK_UNDERFLOW;
     }
 
-    top = (Poly *) VectorPeek(calc->polyStack);
-    fprintf(stdout, "%d\n", PolyIsCoeff(top));
+    CalcForce(calc, 1);
+    top = (StackItem *) VectorPeek(calc->polyStack);
+    fprintf(calc->out, "%d\n", top->mapped ? PolySnapshotIsCoeff(top->mapped) : PolyIsCoeff(&top->poly));
 
     return CMD_OK;
 }
 
 cmd_errcode_t CalcIsZero(Calculator *calc)
 {
-    Poly *top = NULL;
+    StackItem *top = NULL;
 
     if (VectorIsEmpty(calc->polyStack)) {
         return CMD_STACK_UNDERFLOW;
     }
 
-    top = (Poly *) VectorPeek(calc->polyStack);
-    fprintf(stdout, "%d\n", PolyIsZero(top));
+    top = (StackItem *) VectorPeek(calc->polyStack);
+    if (top->mapped == NULL && !PolyFingerprintIsZero(top->fingerprint)) {
+        fprintf(calc->out, "0\n");
+        return CMD_OK;
+    }
+
+    CalcForce(calc, 1);
+    top = (StackItem *) VectorPeek(calc->polyStack);
+    fprintf(calc->out, "%d\n", top->mapped ? PolySnapshotIsZero(top->mapped) : PolyIsZero(&top->poly));
 
     return CMD_OK;
 }
 
 cmd_errcode_t CalcClone(Calculator *calc)
 {
-    Poly *top = NULL, clone;
+    StackItem *top = NULL, clone;
 
     if (VectorIsEmpty(calc->polyStack)) {
         return CMD_STACK_UNDERFLOW;
     }
 
-    top = (Poly *) VectorPeek(calc->polyStack);
-    clone = PolyClone(top);
+    top = (StackItem *) VectorPeek(calc->polyStack);
+    if (top->lazy != NULL) {
+        clone = (StackItem) { .lazy = LazyRetain(top->lazy), .bytes = top->bytes, .fingerprint = top->fingerprint };    // kopia współdzieli wyrażenie
+    }
+    else if (top->mapped != NULL) {
+        clone = (StackItem) { .mapped = PolySnapshotRetain(top->mapped) };    // kopia współdzieli odwzorowanie
+    }
+    else if (top->interned) {
+        clone = (StackItem) { .poly = PolyInternRetain(&top->poly), .fingerprint = top->fingerprint, .interned = true,
+                              .program = PolyProgramRetain(top->program) };
+    }
+    else {
+        clone = (StackItem) { .poly = PolyClone(&top->poly), .mapped = NULL, .fingerprint = top->fingerprint,
+                              .program = PolyProgramRetain(top->program) };    // kopia współdzieli program
+    }
+    CalcTrackItem(calc, &clone);
 
     if (VectorPush(calc->polyStack, &clone) != VECT_OK) {
         exit(EXIT_FAILURE);
@@ -278,193 +1242,645 @@ cmd_errcode_t CalcClone(Calculator *calc)
 
 cmd_errcode_t CalcAdd(Calculator *calc)
 {
-    Poly *first = NULL, *second = NULL, res;
+    StackItem *first = NULL, *second = NULL;
+    Poly res;
 
     if (VectorIsEmpty(calc->polyStack) || calc->polyStack->size < 2) {
         return CMD_STACK_UNDERFLOW;
     }
+    if (calc->lazy) {
+        size_t bytes = 0;
+        PolyFingerprint first_fp, second_fp;
+        LazyNode *first_node = CalcPopNode(calc, &bytes, &first_fp);
+        LazyNode *second_node = CalcPopNode(calc, &bytes, &second_fp);
+
+        CalcPushNode(calc, LazyAdd(first_node, second_node), bytes, PolyFingerprintAdd(first_fp, second_fp));
+        return CMD_OK;
+    }
 
-    first = (Poly *) VectorPop(calc->polyStack);
-    second = (Poly *) VectorPop(calc->polyStack);
+    CalcMaterialize(calc, 2);
+    PolyFingerprint fp = CalcTopFingerprints(calc, PolyFingerprintAdd);
+    first = CalcPopItem(calc);
+    second = CalcPopItem(calc);
 
-    res = PolyAdd(first, second);
-    PolyDestroy(first);
-    PolyDestroy(second);
+    if (first->interned || second->interned) {
+        res = PolyAdd(&first->poly, &second->poly);
+    }
+    else {    // argumenty zdjęte ze stosu - ich jednomiany przechodzą do wyniku
+        res = PolyAddOwned(&first->poly, &second->poly);
+    }
+    CalcItemDestroy(calc, first);
+    CalcItemDestroy(calc, second);
 
-    VectorPush(calc->polyStack, &res);
+    CalcPushResult(calc, res, fp);
 
     return CMD_OK;
 }
 
 cmd_errcode_t CalcMul(Calculator *calc)
 {
-    Poly *first = NULL, *second = NULL, res;
+    StackItem *first = NULL, *second = NULL;
+    Poly res;
 
     if (VectorIsEmpty(calc->polyStack) || calc->polyStack->size < 2) {
         return CMD_STACK_UNDERFLOW;
     }
+    if (calc->lazy) {
+        size_t bytes = 0;
+        PolyFingerprint first_fp, second_fp;
+        LazyNode *first_node = CalcPopNode(calc, &bytes, &first_fp);
+        LazyNode *second_node = CalcPopNode(calc, &bytes, &second_fp);
 
-    first = (Poly *) VectorPop(calc->polyStack);
-    second = (Poly *) VectorPop(calc->polyStack);
+        CalcPushNode(calc, LazyMul(first_node, second_node), bytes, PolyFingerprintMul(first_fp, second_fp));
+        return CMD_OK;
+    }
 
-    res = PolyMul(first, second);
-    PolyDestroy(first);
-    PolyDestroy(second);
+    CalcMaterialize(calc, 2);
+    PolyFingerprint fp = CalcTopFingerprints(calc, PolyFingerprintMul);
+    first = CalcPopItem(calc);
+    second = CalcPopItem(calc);
+
+    const StackItem *operands[] = { first, second };
+    if (!CalcMemoLookup(calc, MUL, 0, 2, operands, &res)) {
+        res = PolyMul(&first->poly, &second->poly);
+        CalcMemoStore(calc, MUL, 0, 2, operands, &res);
+    }
+    CalcItemDestroy(calc, first);
+    CalcItemDestroy(calc, second);
 
-    VectorPush(calc->polyStack, &res);
+    CalcPushResult(calc, res, fp);
 
     return CMD_OK;
 }
 
 cmd_errcode_t CalcNeg(Calculator *calc)
 {
-    Poly *top = NULL;
+    StackItem *top = NULL;
 
     if (VectorIsEmpty(calc->polyStack)) {
         return CMD_STACK_UNDERFLOW;
     }
+    if (calc->lazy) {
+        size_t bytes = 0;
+        PolyFingerprint fp;
+        LazyNode *node = CalcPopNode(calc, &bytes, &fp);
 
-    top = (Poly *) VectorPeek(calc->polyStack);
-    PolyNegateCoeffs(top);
+        CalcPushNode(calc, LazyNeg(node), bytes, PolyFingerprintNeg(fp));
+        return CMD_OK;
+    }
+
+    CalcMaterialize(calc, 1);
+    top = (StackItem *) VectorPeek(calc->polyStack);
+    if (top->interned) {    // współdzielonego wielomianu nie można zmieniać w miejscu
+        top = CalcPopItem(calc);
+        Poly neg = PolyClone(&top->poly);
+        PolyNegateCoeffs(&neg);
+        PolyFingerprint fp = PolyFingerprintNeg(top->fingerprint);
+        CalcItemDestroy(calc, top);
+        CalcPushResult(calc, neg, fp);
+        return CMD_OK;
+    }
+    PolyNegateCoeffs(&top->poly);
+    top->fingerprint = PolyFingerprintNeg(top->fingerprint);
+    CalcDropProgram(calc, top);
 
     return CMD_OK;
 }
 
 cmd_errcode_t CalcSub(Calculator *calc)
 {
-    Poly *first = NULL, *second = NULL, res;
+    StackItem *first = NULL, *second = NULL;
+    Poly res;
 
     if (VectorIsEmpty(calc->polyStack) || calc->polyStack->size < 2) {
         return CMD_STACK_UNDERFLOW;
     }
+    if (calc->lazy) {
+        size_t bytes = 0;
+        PolyFingerprint first_fp, second_fp;
+        LazyNode *first_node = CalcPopNode(calc, &bytes, &first_fp);
+        LazyNode *second_node = CalcPopNode(calc, &bytes, &second_fp);
+
+        CalcPushNode(calc, LazyAdd(first_node, LazyNeg(second_node)), bytes, PolyFingerprintSub(first_fp, second_fp));
+        return CMD_OK;
+    }
 
-    first = (Poly *) VectorPop(calc->polyStack);
-    second = (Poly *) VectorPop(calc->polyStack);
+    CalcMaterialize(calc, 2);
+    PolyFingerprint fp = CalcTopFingerprints(calc, PolyFingerprintSub);
+    first = CalcPopItem(calc);
+    second = CalcPopItem(calc);
 
-    res = PolySub(first, second);
-    PolyDestroy(first);
-    PolyDestroy(second);
+    if (first->interned || second->interned) {
+        res = PolySub(&first->poly, &second->poly);
+    }
+    else {    // argumenty zdjęte ze stosu - ich jednomiany przechodzą do wyniku
+        res = PolySubOwned(&first->poly, &second->poly);
+    }
+    CalcItemDestroy(calc, first);
+    CalcItemDestroy(calc, second);
 
-    VectorPush(calc->polyStack, &res);
+    CalcPushResult(calc, res, fp);
 
     return CMD_OK;
 }
 
 cmd_errcode_t CalcIsEq(Calculator *calc)
 {
-    Poly *first = NULL, *second = NULL;
+    StackItem *first = NULL, *second = NULL;
+    bool eq;
 
     if (VectorIsEmpty(calc->polyStack) || calc->polyStack->size < 2) {
         return CMD_STACK_UNDERFLOW;
     }
 
-    first = (Poly *) VectorPeek(calc->polyStack);
-    second = (Poly *) VectorAt(calc->polyStack, calc->polyStack->size - 2);
+    first = (StackItem *) VectorPeek(calc->polyStack);
+    second = (StackItem *) VectorAt(calc->polyStack, calc->polyStack->size - 2);
+    if (first->mapped == NULL && second->mapped == NULL
+        && !PolyFingerprintEq(first->fingerprint, second->fingerprint)) {    // różne odciski - nie trzeba niczego obliczać
+        fprintf(calc->out, "0\n");
+        return CMD_OK;
+    }
+
+    CalcForce(calc, 2);
+    first = (StackItem *) VectorPeek(calc->polyStack);
+    second = (StackItem *) VectorAt(calc->polyStack, calc->polyStack->size - 2);
 
-    fprintf(stdout, "%d\n", PolyIsEq(first, second));
+    if (first->mapped != NULL && second->mapped != NULL) {
+        eq = PolySnapshotIsEq(first->mapped, second->mapped);
+    }
+    else if (first->mapped != NULL) {
+        eq = PolySnapshotIsEqPoly(first->mapped, &second->poly);
+    }
+    else if (second->mapped != NULL) {
+        eq = PolySnapshotIsEqPoly(second->mapped, &first->poly);
+    }
+    else if (first->interned && second->interned) {
+        eq = PolyInternIsEq(&first->poly, &second->poly);
+    }
+    else {
+        eq = PolyIsEq(&first->poly, &second->poly);
+    }
+    fprintf(calc->out, "%d\n", eq);
 
     return CMD_OK;
 }
 
 cmd_errcode_t CalcDeg(Calculator *calc)
 {
-    Poly *top = NULL;
+    StackItem *top = NULL;
 
     if (VectorIsEmpty(calc->polyStack)) {
         return CMD_STACK_UNDERFLOW;
     }
 
-    top = (Poly *) VectorPeek(calc->polyStack);
+    CalcForce(calc, 1);
+    top = (StackItem *) VectorPeek(calc->polyStack);
 
-    fprintf(stdout, "%d\n", PolyDeg(top));
+    fprintf(calc->out, "%d\n", top->mapped ? PolySnapshotDeg(top->mapped) : PolyDeg(&top->poly));
 
     return CMD_OK;
 }
 
 cmd_errcode_t CalcDegBy(Calculator *calc)
 {
-    Poly *top = NULL;
+    StackItem *top = NULL;
 
     if (VectorIsEmpty(calc->polyStack)) {
         return CMD_STACK_UNDERFLOW;
     }
 
-    top = (Poly *) VectorPeek(calc->polyStack);
+    CalcForce(calc, 1);
+    top = (StackItem *) VectorPeek(calc->polyStack);
 
-    fprintf(stdout, "%d\n", PolyDegBy(top, calc->arg.y));
+    fprintf(calc->out, "%d\n", top->mapped ? PolySnapshotDegBy(top->mapped, calc->arg.y) : PolyDegBy(&top->poly, calc->arg.y));
 
     return CMD_OK;
 }
 
 cmd_errcode_t CalcAt(Calculator *calc)
 {
-    Poly *top = NULL, res;
+    StackItem *top = NULL;
+    Poly res;
 
     if (VectorIsEmpty(calc->polyStack)) {
         return CMD_STACK_UNDERFLOW;
     }
 
-    top = (Poly *) VectorPop(calc->polyStack);
-    res = PolyAt(top, calc->arg.x);
+    top = CalcPopItem(calc);
+    if (top->lazy != NULL) {
+        res = LazyAt(top->lazy, calc->arg.x);    // wartości czynników zamiast wartości iloczynu
+    }
+    else if (top->mapped != NULL) {
+        res = PolySnapshotAt(top->mapped, calc->arg.x);
+    }
+    else {
+        const StackItem *operands[] = { top };
+        if (!CalcMemoLookup(calc, AT, (uint64_t) calc->arg.x, 1, operands, &res)) {
+            res = PolyAt(&top->poly, calc->arg.x);
+            CalcMemoStore(calc, AT, (uint64_t) calc->arg.x, 1, operands, &res);
+        }
+    }
 
-    PolyDestroy(top);
-    VectorPush(calc->polyStack, &res);
+    CalcItemDestroy(calc, top);
+    CalcPushPoly(calc, res);    // AT przesuwa indeksy zmiennych - odcisk wyniku nie wynika z odcisku argumentu
 
     return CMD_OK;
 }
 
 cmd_errcode_t CalcPrint(Calculator *calc)
 {
-    Poly *top = NULL;
+    StackItem *top = NULL;
 
     if (VectorIsEmpty(calc->polyStack)) {
         return CMD_STACK_UNDERFLOW;
     }
 
-    top = (Poly *) VectorPeek(calc->polyStack);
+    CalcForce(calc, 1);
+    top = (StackItem *) VectorPeek(calc->polyStack);
 
-    PolyPrint(stdout, top);
+    if (top->mapped != NULL) {
+        SnapshotPrintIterative(calc->out, top->mapped);
+        fprintf(calc->out, "\n");
+    }
+    else {
+        PolyPrint(calc->out, &top->poly);
+    }
 
     return CMD_OK;
 }
 
 cmd_errcode_t CalcPop(Calculator *calc)
 {
-    Poly *top = NULL;
+    StackItem *top = NULL;
 
     if (VectorIsEmpty(calc->polyStack)) {
         return CMD_STACK_UNDERFLOW;
     }
 
-    top = (Poly *) VectorPop(calc->polyStack);
+    top = CalcPopItem(calc);
 
-    PolyDestroy(top);
+    CalcItemDestroy(calc, top);
 
     return CMD_OK;
 }
 
 cmd_errcode_t CalcCompose(Calculator *calc)
 {
-    Poly *top = NULL;
+    StackItem *top = NULL;
 
     if (VectorIsEmpty(calc->polyStack) || calc->polyStack->size < calc->arg.y + 1 || calc->arg.y == ULLONG_MAX) {
         return CMD_STACK_UNDERFLOW;
     }
+    CalcMaterialize(calc, calc->arg.y + 1);
+    StackItem *args = safeMalloc(calc->arg.y * sizeof(StackItem));
     Poly *q = safeMalloc(calc->arg.y * sizeof(Mono));
-    top = (Poly *) VectorPop(calc->polyStack);
+    top = CalcPopItem(calc);
 
     for (size_t i = calc->arg.y; i > 0; i--) {
-        q[i - 1] = *(Poly *)VectorPop(calc->polyStack);
+        args[i - 1] = *CalcPopItem(calc);
+        q[i - 1] = args[i - 1].poly;
     }
 
-    Poly res = PolyCompose(top, calc->arg.y, q);
-    PolyDestroy(top);
-    VectorPush(calc->polyStack, &res);
+    const StackItem **operands = safeMalloc((calc->arg.y + 1) * sizeof(StackItem *));
+    operands[0] = top;
+    for (size_t i = 0; i < calc->arg.y; i++) {
+        operands[i + 1] = args + i;
+    }
+    Poly res;
+    if (!CalcMemoLookup(calc, COMPOSE, calc->arg.y, calc->arg.y + 1, operands, &res)) {
+        res = PolyCompose(&top->poly, calc->arg.y, q);
+        CalcMemoStore(calc, COMPOSE, calc->arg.y, calc->arg.y + 1, operands, &res);
+    }
+    PolyFingerprint *fingerprints = safeMalloc(calc->arg.y * sizeof(PolyFingerprint));
+    for (size_t i = 0; i < calc->arg.y; i++) {
+        fingerprints[i] = args[i].fingerprint;
+    }
+    PolyFingerprint fp = PolyFingerprintCompose(&top->poly, calc->arg.y, fingerprints);
+    free(fingerprints);
+    free(operands);
+    CalcItemDestroy(calc, top);
+    CalcPushResult(calc, res, fp);
 
     for (size_t i = 0; i < calc->arg.y; i++) {
-        PolyDestroy(q + i);
+        CalcItemDestroy(calc, args + i);
+    }
+    free(args);
+    free(q);
+
+    return CMD_OK;
+}
+
+cmd_errcode_t CalcSave(Calculator *calc)
+{
+    char path[FILENAME_MAX];
+    size_t size;
+    uint8_t *data;
+
+    if (VectorIsEmpty(calc->polyStack)) {
+        return CMD_STACK_UNDERFLOW;
+    }
+
+    CalcForce(calc, 1);
+    CalcCopyPath(calc, path);
+    StackItem *top = (StackItem *) VectorPeek(calc->polyStack);
+    if (top->mapped != NULL) {
+        Poly p = PolySnapshotToPoly(top->mapped);
+        data = PolySerialize(&p, &size);
+        PolyDestroy(&p);
+    }
+    else {
+        data = PolySerialize(&top->poly, &size);
+    }
+    bool ok = CalcWriteFile(path, data, size);
+    free(data);
+
+    return ok ? CMD_OK : CMD_FILE_ERROR;
+}
+
+cmd_errcode_t CalcLoad(Calculator *calc)
+{
+    char path[FILENAME_MAX];
+    size_t size;
+    Poly p;
+
+    CalcCopyPath(calc, path);
+    uint8_t *data = CalcReadFile(path, &size);
+
+    if (data == NULL) {
+        return CMD_FILE_ERROR;
+    }
+    bool ok = PolyDeserialize(&p, data, size);
+    free(data);
+
+    if (!ok) {
+        return CMD_FORMAT_ERROR;
+    }
+    CalcPushPoly(calc, p);
+
+    return CMD_OK;
+}
+
+cmd_errcode_t CalcSnapshot(Calculator *calc)
+{
+    char path[FILENAME_MAX];
+    bool ok;
+
+    if (VectorIsEmpty(calc->polyStack)) {
+        return CMD_STACK_UNDERFLOW;
+    }
+
+    CalcForce(calc, 1);
+    CalcCopyPath(calc, path);
+    StackItem *top = (StackItem *) VectorPeek(calc->polyStack);
+    if (top->mapped != NULL) {
+        ok = CalcWriteFile(path, top->mapped->base, top->mapped->length);    // snapshot zapisuje się bez zmian
+    }
+    else {
+        size_t size;
+        uint8_t *data = PolySnapshotEncode(&top->poly, &size);
+        ok = CalcWriteFile(path, data, size);
+        free(data);
+    }
+
+    return ok ? CMD_OK : CMD_FILE_ERROR;
+}
+
+cmd_errcode_t CalcMap(Calculator *calc)
+{
+    char path[FILENAME_MAX];
+    StackItem item = { .mapped = NULL };
+
+    CalcCopyPath(calc, path);
+    PolySnapStatus status = PolySnapshotOpen(&item.mapped, path);
+
+    if (status == SNAPSHOT_FILE_ERROR) {
+        return CMD_FILE_ERROR;
+    }
+    if (status == SNAPSHOT_FORMAT_ERROR) {
+        return CMD_FORMAT_ERROR;
+    }
+    if (polyModulus.m != 0) {    // współczynniki w pliku nie muszą być resztami
+        CalcPushPoly(calc, PolySnapshotToPoly(item.mapped));
+        PolySnapshotRelease(item.mapped);
+        return CMD_OK;
+    }
+    if (VectorPush(calc->polyStack, &item) != VECT_OK) {
+        exit(EXIT_FAILURE);
+    }
+
+    return CMD_OK;
+}
+
+cmd_errcode_t CalcEval(Calculator *calc)
+{
+    size_t count = calc->arg.point.count;
+    const poly_coeff_t *values = calc->arg.point.values;
+
+    if (VectorIsEmpty(calc->polyStack)) {
+        return CMD_STACK_UNDERFLOW;
+    }
+    const StackItem *compiled = (const StackItem *) VectorPeek(calc->polyStack);
+    poly_coeff_t value;
+    if (compiled->program != NULL) {
+        value = PolyProgramEval(compiled->program, count, values);
+    }
+    else {
+        CalcMaterialize(calc, 1);
+        const StackItem *top = (const StackItem *) VectorPeek(calc->polyStack);
+        value = PolyEvalPoint(&top->poly, count, values);
+    }
+    CalcItemDestroy(calc, CalcPopItem(calc));
+    CalcPushPoly(calc, PolyFromCoeff(value));
+
+    return CMD_OK;
+}
+
+cmd_errcode_t CalcEvalFile(Calculator *calc)
+{
+    char in_path[FILENAME_MAX], out_path[FILENAME_MAX];
+
+    if (VectorIsEmpty(calc->polyStack)) {
+        return CMD_STACK_UNDERFLOW;
+    }
+    if (!CalcSplitPaths(calc, in_path, out_path)) {    // możliwe tylko dla uszkodzonego programu
+        return CMD_FILE_ERROR;
+    }
+
+    CalcForce(calc, 1);
+    StackItem *top = (StackItem *) VectorPeek(calc->polyStack);
+    cmd_errcode_t res;
+    if (top->mapped != NULL) {
+        Poly p = PolySnapshotToPoly(top->mapped);
+        res = CalcEvalStream(&p, in_path, out_path);
+        PolyDestroy(&p);
+    }
+    else {
+        res = CalcEvalStream(&top->poly, in_path, out_path);
+    }
+
+    return res;
+}
+
+cmd_errcode_t CalcCompile(Calculator *calc)
+{
+    if (VectorIsEmpty(calc->polyStack)) {
+        return CMD_STACK_UNDERFLOW;
+    }
+
+    CalcMaterialize(calc, 1);
+    StackItem *top = (StackItem *) VectorPeek(calc->polyStack);
+    if (top->program == NULL) {
+        top->program = PolyCompile(&top->poly);
+        calc->memory -= top->bytes;
+        CalcTrackItem(calc, top);
+    }
+
+    return CMD_OK;
+}
+
+cmd_errcode_t CalcMulTrunc(Calculator *calc)
+{
+    StackItem *first = NULL, *second = NULL;
+
+    if (VectorIsEmpty(calc->polyStack) || calc->polyStack->size < 2) {
+        return CMD_STACK_UNDERFLOW;
+    }
+
+    CalcMaterialize(calc, 2);
+    first = CalcPopItem(calc);
+    second = CalcPopItem(calc);
+    Poly res = PolyMulTrunc(&first->poly, &second->poly, (poly_exp_t) calc->arg.y);
+    CalcItemDestroy(calc, first);
+    CalcItemDestroy(calc, second);
+
+    CalcPushPoly(calc, res);    // obcięcie nie jest homomorfizmem - odcisk liczony od nowa
+
+    return CMD_OK;
+}
+
+cmd_errcode_t CalcPow(Calculator *calc)
+{
+    if (VectorIsEmpty(calc->polyStack)) {
+        return CMD_STACK_UNDERFLOW;
+    }
+
+    CalcMaterialize(calc, 1);
+    StackItem *top = CalcPopItem(calc);
+    Poly res = PolyPower(&top->poly, (poly_exp_t) calc->arg.y);
+    PolyFingerprint fp = PolyFingerprintPow(top->fingerprint, (poly_exp_t) calc->arg.y);
+    CalcItemDestroy(calc, top);
+
+    CalcPushResult(calc, res, fp);
+
+    return CMD_OK;
+}
+
+cmd_errcode_t CalcFma(Calculator *calc)
+{
+    if (VectorIsEmpty(calc->polyStack) || calc->polyStack->size < 3) {
+        return CMD_STACK_UNDERFLOW;
+    }
+
+    CalcMaterialize(calc, 3);
+    StackItem operands[3];
+    for (size_t i = 0; i < 3; i++) {
+        operands[i] = *CalcPopItem(calc);
+    }
+    Poly res = PolyFma(&operands[0].poly, &operands[1].poly, &operands[2].poly);
+    PolyFingerprint fp = PolyFingerprintAdd(PolyFingerprintMul(operands[0].fingerprint, operands[1].fingerprint),
+                                            operands[2].fingerprint);
+    for (size_t i = 0; i < 3; i++) {
+        CalcItemDestroy(calc, operands + i);
+    }
+
+    CalcPushResult(calc, res, fp);
+
+    return CMD_OK;
+}
+
+cmd_errcode_t CalcDot(Calculator *calc)
+{
+    size_t k = calc->arg.y;
+
+    if (k > calc->polyStack->size / 2) {
+        return CMD_STACK_UNDERFLOW;
+    }
+
+    CalcMaterialize(calc, 2 * k);
+    StackItem *args = safeMalloc((2 * k + 1) * sizeof(StackItem));
+    Poly *vectors = safeMalloc((2 * k + 1) * sizeof(Poly));    // a_0, ..., a_{k-1}, b_0, ..., b_{k-1}
+
+    for (size_t i = 2 * k; i > 0; i--) {
+        args[i - 1] = *CalcPopItem(calc);
+        vectors[i - 1] = args[i - 1].poly;
+    }
+    Poly res = PolyDot(k, vectors, vectors + k);
+    PolyFingerprint fp = { .v = { 0 } };
+    for (size_t i = 0; i < k; i++) {
+        fp = PolyFingerprintAdd(fp, PolyFingerprintMul(args[i].fingerprint, args[k + i].fingerprint));
+    }
+    for (size_t i = 0; i < 2 * k; i++) {
+        CalcItemDestroy(calc, args + i);
+    }
+    free(args);
+    free(vectors);
+
+    CalcPushResult(calc, res, fp);
+
+    return CMD_OK;
+}
+
+cmd_errcode_t CalcComposeTrunc(Calculator *calc)
+{
+    size_t k = calc->arg.y;
+    poly_exp_t d = calc->arg.deg;
+
+    if (VectorIsEmpty(calc->polyStack) || calc->polyStack->size < k + 1 || k == ULLONG_MAX) {
+        return CMD_STACK_UNDERFLOW;
+    }
+    CalcMaterialize(calc, k + 1);
+    StackItem *top = CalcPopItem(calc);
+    StackItem *args = safeMalloc(k * sizeof(StackItem));
+    Poly *q = safeMalloc(k * sizeof(Poly));
+
+    for (size_t i = k; i > 0; i--) {
+        args[i - 1] = *CalcPopItem(calc);
+        q[i - 1] = args[i - 1].poly;
+    }
+    Poly res = PolyComposeTrunc(&top->poly, k, q, d);
+    CalcItemDestroy(calc, top);
+    CalcPushPoly(calc, res);    // obcięcie nie jest homomorfizmem - odcisk liczony od nowa
+
+    for (size_t i = 0; i < k; i++) {
+        CalcItemDestroy(calc, args + i);
     }
+    free(args);
     free(q);
 
     return CMD_OK;
-}
\ No newline at end of file
+}
+
+cmd_errcode_t CalcCheckpoint(Calculator *calc)
+{
+    char path[FILENAME_MAX];
+
+    CalcCopyPath(calc, path);
+    return CheckpointWrite(calc, calc->lineIndex, path) ? CMD_OK : CMD_FILE_ERROR;
+}
+
+cmd_errcode_t CalcRestore(Calculator *calc)
+{
+    char path[FILENAME_MAX];
+    size_t lines;
+
+    CalcCopyPath(calc, path);
+    cmd_errcode_t res = CheckpointRead(calc, &lines, path);    // numeracja linii wejścia pozostaje bez zmian
+
+    if (res == CMD_OK) {
+        calc->memory = 0;
+        for (size_t i = 0; i < calc->polyStack->size; i++) {
+            CalcTrackItem(calc, GET_ITEM(StackItem, calc->polyStack, i));
+        }
+    }
+    return res;
+}
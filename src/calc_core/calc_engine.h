@@ -12,47 +12,50 @@
 #include <limits.h>
 #include <errno.h>
 #include "../poly_core/poly.h"
+#include "../poly_core/poly_reclaimer.h"
+#include "../poly_core/poly_serialize.h"
+#include "../poly_core/poly_snapshot.h"
+#include "../poly_core/poly_fingerprint.h"
+#include "../poly_core/poly_intern.h"
+#include "../poly_core/poly_mod.h"
+#include "../poly_core/poly_eval.h"
+#include "../poly_core/poly_program.h"
+#include "../poly_core/poly_dot.h"
+#include "op_cache.h"
 #include "../utils/vector.h"
 #include "line_structures.h"
+#include "lazy.h"
 
 /**
- * Makro sprawdzające poprawność wprowadzanego współczynnika (dla komendy CalcAt i parsowania wielomianów)
- * @see CalcAt(), parsePoly()
- *
- * @param[in] x : współczynnik
- *
- * @return : czy współczynnik spełnia warunki zadania
+ * Największa wartość bezwzględna współczynnika (dla parsowania wielomianów).
+ * Argument komendy AT może być dodatkowo równy LONG_MIN.
+ * @see CalcParseAtArg(), parseCoeff()
  */
-#define IS_VALID_COEFF(x) (!((x == LONG_MAX || x == LONG_MIN) && errno == ERANGE))
+#define MAX_COEFF LONG_MAX
 
 /**
- * Makro sprawdzające poprawność wprowadzanego wykładnika (dla parsowania jednomianów)
- * @see parseMonoRecursive()
- *
- * @param[in] y : wykładnik jednomianu
- *
- * @return : czy wykładnik spełnia warunki zadania
+ * Największy dopuszczalny wykładnik (dla parsowania jednomianów).
+ * @see parseExp()
  */
-#define IS_VALID_EXP(y) (y >= 0  && y <= 2147483647)
+#define MAX_EXP INT_MAX
 
 /**
- * Makro sprawdzające poprawność wprowadzanego indeksu zmiennej (dla komendy CalcDegBy)
+ * Największy dopuszczalny indeks zmiennej (dla komendy CalcDegBy).
  * @see CalcDegBy()
- *
- * @param[in] y : indeks zmiennej
- *
- * @return : czy indeks zmiennej spełnia warunki zadania
  */
-#define IS_VALID_IDX(y) (y <= ULLONG_MAX && !(y == ULLONG_MAX && errno == ERANGE))
+#define MAX_IDX ULLONG_MAX
 
 /**
- * Makro sprawdzające poprawność argumentu dla funkcji Compose
+ * Największy dopuszczalny argument dla funkcji Compose.
  * @see CalcCompose()
- * @param[in] y : liczba podstawianych wielomianów
- *
- * @return : czy liczba wielomianów spełnia warunki zadania
  */
-#define IS_VALID_COMPOSE_ARG(y) IS_VALID_IDX(y)
+#define MAX_COMPOSE_ARG MAX_IDX
+
+/**
+ * Największe dopuszczalne ograniczenie stopnia (dla MUL_TRUNC i COMPOSE_TRUNC).
+ * @see CalcMulTrunc(), CalcComposeTrunc()
+ */
+#define MAX_TRUNC_DEG MAX_EXP
 
 /**
  * Kody stanu zwracane przez niektóre funkcje.
@@ -62,7 +65,9 @@ typedef enum cmd_errcode_t
     CMD_OK,              ///< Generyczny sukces, w tym komenda wykonana pomyślnie
     CMD_WRONG_COMMAND,   ///< Błąd - niewłaściwa komenda
     CMD_STACK_UNDERFLOW, ///< Błąd - komenda korzysta ze zbyt małego stosu
-    CMD_INVALID_ARG      ///< Błąd - podano nieprawidłowy argument do komendy
+    CMD_INVALID_ARG,     ///< Błąd - podano nieprawidłowy argument do komendy
+    CMD_FILE_ERROR,      ///< Błąd - nie udało się otworzyć, odczytać lub zapisać pliku
+    CMD_FORMAT_ERROR     ///< Błąd - plik nie zawiera poprawnie zapisanego wielomianu
 } cmd_errcode_t;
 
 /**
@@ -71,11 +76,47 @@ typedef enum cmd_errcode_t
  */
 typedef union cmd_arg {
     poly_coeff_t x; ///< Argument dla CalcAt()
-    size_t y;       ///< Argument dla CalcDegBy() i PolyCompose()
+    /**
+     * Argument liczbowy wraz z ograniczeniem stopnia
+     */
+    struct {
+        size_t y;       ///< Argument dla CalcDegBy(), PolyCompose(), CalcMulTrunc(), CalcComposeTrunc(), CalcPow() i CalcDot()
+        poly_exp_t deg; ///< Ograniczenie stopnia dla CalcComposeTrunc()
+    };
+    StrView path;   ///< Argument dla komend operujących na plikach (widok na linię wejścia)
+    /**
+     * Argument dla CalcEval() - wartości zmiennych
+     */
+    struct {
+        const poly_coeff_t *values; ///< Wartości (w buforze kalkulatora lub w pamięci programu)
+        size_t count;               ///< Liczba wartości
+    } point;
 } cmd_arg;
 
 /**
- * Stos wielomianów.
+ * Element stosu kalkulatora: wielomian w pamięci, odwzorowany
+ * snapshot, odtwarzany w pamięci dopiero przez komendy modyfikujące,
+ * lub (w trybie leniwym) wyrażenie, obliczane dopiero przez komendy
+ * potrzebujące struktury wielomianu.
+ * Pole @p poly jest pierwsze, więc wskaźnik na element odtworzony
+ * można traktować jako wskaźnik na wielomian.
+ * Każdy element poza odwzorowanym snapshotem zna odcisk swojego
+ * wielomianu, co pozwala IS_EQ i IS_ZERO od razu rozpoznać różne wielomiany.
+ * Gdy kalkulator ma tablicę współdzielonych poddrzew, wstawiane wielomiany
+ * są w niej umieszczane (o ile pozwala na to jej limit).
+ */
+typedef struct StackItem {
+    Poly poly;                   ///< Wielomian (gdy `mapped == NULL` i `lazy == NULL`)
+    PolySnapshot *mapped;        ///< Odwzorowany snapshot wielomianu lub NULL
+    LazyNode *lazy;              ///< Wyrażenie lub NULL
+    size_t bytes;                ///< Pamięć zajmowana przez wielomian (gdy kalkulator ją zlicza)
+    PolyFingerprint fingerprint; ///< Odcisk wielomianu (gdy `mapped == NULL`)
+    bool interned;               ///< Czy @p poly należy do tablicy `intern` kalkulatora
+    PolyProgram *program;        ///< Program wartościujący wielomian (po komendzie COMPILE) lub NULL
+} StackItem;
+
+/**
+ * Stos wielomianów (elementów StackItem).
  */
 typedef vector_t poly_stack_t;
 
@@ -85,6 +126,16 @@ typedef vector_t poly_stack_t;
 typedef struct Calculator {
     cmd_arg arg;              ///< Aktualnie rozpatrywany argument dla CalcAt/CalcDegBy/CalcCompose
     poly_stack_t *polyStack;   ///< Stos wielomianów
+    size_t lineIndex;         ///< Indeks aktualnie wykonywanej linii wejścia (dla CalcCheckpoint())
+    FILE *out;                ///< Strumień wyników komend (domyślnie stdout)
+    FILE *err;                ///< Strumień komunikatów o błędach (domyślnie stderr)
+    bool lazy;                ///< Czy ADD, SUB, MUL i NEG wstawiają na stos wyrażenia zamiast wyników
+    bool trackMemory;         ///< Czy zliczać pamięć zajmowaną przez wielomiany na stosie
+    size_t memory;            ///< Pamięć zajmowana przez wielomiany na stosie (gdy jest zliczana)
+    size_t peakMemory;        ///< Największa dotychczasowa wartość @p memory (wraz z pamięcią @p intern)
+    PolyInternTable *intern;  ///< Tablica współdzielonych poddrzew wielomianów lub NULL
+    OpCache *memo;            ///< Pamięć podręczna wyników MUL, AT i COMPOSE lub NULL
+    vector_t *values;         ///< Bufor wartości wczytanych z argumentu EVAL (poly_coeff_t) lub NULL
 } Calculator;
 
 /**
@@ -105,12 +156,53 @@ typedef struct command_pair_t {
 
 
 /**
- * Konstruktor dla kalkulatora - inicjalizuje go.
+ * Konstruktor dla kalkulatora - inicjalizuje go. Wyniki i błędy
+ * wypisywane są na standardowe wyjście i wyjście diagnostyczne,
+ * chyba że później zmieni się @p calc->out i @p calc->err.
  *
  * @param[in, out] calc : kalkulator
  */
 void CalcInit(Calculator *calc);
 
+/**
+ * Włącza tryb leniwy w kalkulatorach inicjalizowanych
+ * od tej pory przez CalcInit(). Należy ją wywołać przed
+ * utworzeniem wątków korzystających z kalkulatorów.
+ * @see lazy.h
+ */
+void CalcEnableLazyMode(void);
+
+/**
+ * Włącza współdzielenie identycznych poddrzew wielomianów w kalkulatorach
+ * inicjalizowanych od tej pory przez CalcInit() - każdy z nich dostaje
+ * własną tablicę. Należy ją wywołać przed utworzeniem wątków
+ * korzystających z kalkulatorów.
+ * @see poly_intern.h
+ *
+ * @param[in] limit : największa liczba poddrzew w tablicy kalkulatora
+ */
+void CalcEnableInterning(size_t limit);
+
+/**
+ * Włącza zapamiętywanie wyników MUL, AT i COMPOSE w kalkulatorach
+ * inicjalizowanych od tej pory przez CalcInit() - każdy z nich dostaje
+ * własną pamięć podręczną. Należy ją wywołać przed utworzeniem wątków
+ * korzystających z kalkulatorów.
+ * @see op_cache.h
+ *
+ * @param[in] budget : największa pamięć wpisów kalkulatora w bajtach
+ */
+void CalcEnableMemo(size_t budget);
+
+/**
+ * Wypisuje statystyki pamięci podręcznej wyników kalkulatora
+ * (jeśli kalkulator ją ma).
+ *
+ * @param[in] calc : kalkulator
+ * @param[in, out] stream : strumień wyjścia
+ */
+void CalcPrintMemoStats(const Calculator *calc, FILE *stream);
+
 /**
  * Destruktor dla kalkulatora - zwalnia jego pamięć.
  *
@@ -118,17 +210,34 @@ void CalcInit(Calculator *calc);
  */
 void CalcDestroy(Calculator *calc);
 
+/**
+ * Zastępuje stos kalkulatora, zwalniając elementy dotychczasowego.
+ *
+ * @param[in, out] calc : kalkulator
+ * @param[in] stack : nowy stos (przejmowany na własność)
+ */
+void CalcReplaceStack(Calculator *calc, poly_stack_t *stack);
+
+/**
+ * Wstawia na stos kalkulatora wielomian, przejmując go na własność,
+ * i oblicza jego odcisk.
+ *
+ * @param[in, out] calc : kalkulator
+ * @param[in] p : wielomian
+ */
+void CalcPushPoly(Calculator *calc, Poly p);
+
 /**
  * Funkcja parsująca argument jako drugi token linii wejściowej
  * i przechowująca go w @p calc->arg
  *
  * @param[in, out] calc : kalkulator
  * @param[in] line : linia, znająca swój indeks
- * @param[in] str : argument przed obróbką
+ * @param[in] str : argument przed obróbką (`str.ptr == NULL` jeśli go nie podano)
  *
  * @return : czy wprowadzono poprawny argument
  */
-cmd_errcode_t CalcParseArg(Calculator *calc, const Line line, const char *str);
+cmd_errcode_t CalcParseArg(Calculator *calc, const Line line, StrView str);
 
 /**
  * Funkcja odpowiedzialna za wykonanie polecenia ZERO przez kalkulator.
@@ -265,5 +374,175 @@ cmd_errcode_t CalcPop(Calculator *calc);
  */
 cmd_errcode_t CalcCompose(Calculator *calc);
 
+/**
+ * Funkcja odpowiedzialna za wykonanie polecenia SAVE plik przez kalkulator.
+ * Zapisuje wielomian z wierzchołka stosu do pliku w formacie binarnym.
+ * @see PolySerialize()
+ *
+ * @param[in] calc : kalkulator
+ *
+ * @return : wynik wykonania komendy (sukces/błąd)
+ */
+cmd_errcode_t CalcSave(Calculator *calc);
+
+/**
+ * Funkcja odpowiedzialna za wykonanie polecenia LOAD plik przez kalkulator.
+ * Wstawia na stos wielomian odczytany z pliku zapisanego przez CalcSave().
+ * @see PolyDeserialize()
+ *
+ * @param[in, out] calc : kalkulator
+ *
+ * @return : wynik wykonania komendy (sukces/błąd)
+ */
+cmd_errcode_t CalcLoad(Calculator *calc);
+
+/**
+ * Funkcja odpowiedzialna za wykonanie polecenia SNAPSHOT plik przez kalkulator.
+ * Zapisuje wielomian z wierzchołka stosu do pliku w formacie snapshotu.
+ * @see PolySnapshotEncode()
+ *
+ * @param[in] calc : kalkulator
+ *
+ * @return : wynik wykonania komendy (sukces/błąd)
+ */
+cmd_errcode_t CalcSnapshot(Calculator *calc);
+
+/**
+ * Funkcja odpowiedzialna za wykonanie polecenia MAP plik przez kalkulator.
+ * Odwzorowuje w pamięci plik zapisany przez CalcSnapshot() i wstawia go
+ * na stos bez odtwarzania wielomianu. Komendy jedynie odczytujące
+ * wielomian (IS_COEFF, IS_ZERO, CLONE, IS_EQ, DEG, DEG_BY, AT, PRINT,
+ * SNAPSHOT) działają bezpośrednio na odwzorowanym pliku, a pozostałe
+ * najpierw odtwarzają wielomian w pamięci.
+ * @see PolySnapshotOpen()
+ *
+ * @param[in, out] calc : kalkulator
+ *
+ * @return : wynik wykonania komendy (sukces/błąd)
+ */
+cmd_errcode_t CalcMap(Calculator *calc);
+
+/**
+ * Funkcja odpowiedzialna za wykonanie polecenia CHECKPOINT plik przez kalkulator.
+ * Zapisuje atomowo cały stos wraz z indeksem bieżącej linii.
+ * @see CheckpointWrite()
+ *
+ * @param[in] calc : kalkulator
+ *
+ * @return : wynik wykonania komendy (sukces/błąd)
+ */
+cmd_errcode_t CalcCheckpoint(Calculator *calc);
+
+/**
+ * Funkcja odpowiedzialna za wykonanie polecenia RESTORE plik przez kalkulator.
+ * Zastępuje cały stos stosem zapisanym przez CalcCheckpoint().
+ * @see CheckpointRead()
+ *
+ * @param[in, out] calc : kalkulator
+ *
+ * @return : wynik wykonania komendy (sukces/błąd)
+ */
+cmd_errcode_t CalcRestore(Calculator *calc);
+
+/**
+ * Funkcja odpowiedzialna za wykonanie polecenia EVAL x0 x1 ... xn przez
+ * kalkulator. Zastępuje wielomian na szczycie stosu jego wartością
+ * w punkcie (pozostałe zmienne mają wartość 0), wyliczoną przez
+ * PolyEvalPoint() bez tworzenia wielomianów pośrednich lub - dla
+ * wielomianu skompilowanego przez COMPILE - przez PolyProgramEval().
+ *
+ * @param[in, out] calc : kalkulator
+ *
+ * @return : wynik wykonania komendy (sukces/błąd)
+ */
+cmd_errcode_t CalcEval(Calculator *calc);
+
+/**
+ * Funkcja odpowiedzialna za wykonanie polecenia EVAL_FILE wejście wyjście
+ * przez kalkulator. Wartościuje wielomian na szczycie stosu (bez zdejmowania
+ * go) we wszystkich punktach z pliku wejściowego przez PolyEvalBatch()
+ * i zapisuje wartości do pliku wyjściowego. Plik wejściowy zawiera liczbę
+ * współrzędnych punktu @f$n > 0@f$ (uint64_t), a po niej kolejne punkty,
+ * każdy jako @f$n@f$ liczb int64_t; plik wyjściowy - po jednej liczbie
+ * int64_t na punkt. Liczby zapisane są w kolejności bajtów bieżącej maszyny.
+ *
+ * @param[in, out] calc : kalkulator
+ *
+ * @return : wynik wykonania komendy (sukces/błąd)
+ */
+cmd_errcode_t CalcEvalFile(Calculator *calc);
+
+/**
+ * Funkcja odpowiedzialna za wykonanie polecenia COMPILE przez kalkulator.
+ * Kompiluje wielomian na szczycie stosu do programu (zob. poly_program.h),
+ * z którego korzystają kolejne polecenia EVAL, dopóki wielomian nie
+ * zostanie zdjęty ze stosu lub zmieniony. Kopie tworzone przez CLONE
+ * współdzielą program.
+ *
+ * @param[in, out] calc : kalkulator
+ *
+ * @return : wynik wykonania komendy (sukces/błąd)
+ */
+cmd_errcode_t CalcCompile(Calculator *calc);
+
+/**
+ * Funkcja odpowiedzialna za wykonanie polecenia MUL_TRUNC d przez kalkulator.
+ * Działa jak MUL, ale pomija jednomiany iloczynu stopnia większego niż d.
+ * @see PolyMulTrunc()
+ *
+ * @param[in, out] calc : kalkulator
+ *
+ * @return : wynik wykonania komendy (sukces/błąd)
+ */
+cmd_errcode_t CalcMulTrunc(Calculator *calc);
+
+/**
+ * Funkcja odpowiedzialna za wykonanie polecenia COMPOSE_TRUNC k d przez
+ * kalkulator. Działa jak COMPOSE k, ale pomija jednomiany wyniku stopnia
+ * większego niż d.
+ * @see PolyComposeTrunc()
+ *
+ * @param[in, out] calc : kalkulator
+ *
+ * @return : wynik wykonania komendy (sukces/błąd)
+ */
+cmd_errcode_t CalcComposeTrunc(Calculator *calc);
+
+/**
+ * Funkcja odpowiedzialna za wykonanie polecenia POW e przez kalkulator.
+ * Zastępuje wielomian na szczycie stosu jego e-tą potęgą.
+ * @see PolyPower()
+ *
+ * @param[in, out] calc : kalkulator
+ *
+ * @return : wynik wykonania komendy (sukces/błąd)
+ */
+cmd_errcode_t CalcPow(Calculator *calc);
+
+/**
+ * Funkcja odpowiedzialna za wykonanie polecenia FMA przez kalkulator.
+ * Zdejmuje ze stosu wielomiany @f$a@f$ (wierzchołek), @f$b@f$ i @f$c@f$
+ * i wstawia @f$a * b + c@f$, nie tworząc iloczynu.
+ * @see PolyFma()
+ *
+ * @param[in, out] calc : kalkulator
+ *
+ * @return : wynik wykonania komendy (sukces/błąd)
+ */
+cmd_errcode_t CalcFma(Calculator *calc);
+
+/**
+ * Funkcja odpowiedzialna za wykonanie polecenia DOT k przez kalkulator.
+ * Zdejmuje ze stosu @f$2k@f$ wielomianów - wektor @f$b_0, \ldots, b_{k-1}@f$
+ * (@f$b_{k-1}@f$ na wierzchołku), a pod nim wektor @f$a_0, \ldots, a_{k-1}@f$ -
+ * i wstawia @f$\sum_i a_i b_i@f$, nie tworząc iloczynów.
+ * @see PolyDot()
+ *
+ * @param[in, out] calc : kalkulator
+ *
+ * @return : wynik wykonania komendy (sukces/błąd)
+ */
+cmd_errcode_t CalcDot(Calculator *calc);
+
 
 #endif //__CALC_H__
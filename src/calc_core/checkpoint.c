@@ -0,0 +1,222 @@
+/** @file
+  Implementacja punktów kontrolnych stanu kalkulatora wielomianów rzadkich wielu zmiennych
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+/** Makro zdefiniowane, aby korzystać z fsync() i mmap(). */
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "checkpoint.h"
+
+/**
+ * Długość nagłówka: sygnatura i bajt wersji.
+ */
+#define CHECKPOINT_HEADER_LEN 5
+
+/**
+ * Przyrostek nazwy pliku tymczasowego.
+ */
+#define CHECKPOINT_TMP_SUFFIX ".tmp"
+
+
+
+/**
+ * Zapisuje liczbę 64-bitową do pliku.
+ *
+ * @param[in, out] file : plik
+ * @param[in] val : liczba
+ *
+ * @return : czy zapis się powiódł
+ */
+static bool WriteU64(FILE *file, uint64_t val);
+
+/**
+ * Zapisuje stos kalkulatora do otwartego pliku.
+ *
+ * @param[in, out] file : plik
+ * @param[in] calc : kalkulator
+ * @param[in] lines : liczba przetworzonych linii wejścia
+ *
+ * @return : czy zapis się powiódł
+ */
+static bool WriteState(FILE *file, const Calculator *calc, size_t lines);
+
+/**
+ * Wczytuje liczbę 64-bitową z bufora.
+ *
+ * @param[in] data : bufor
+ * @param[in] size : długość bufora
+ * @param[in, out] pos : pozycja w buforze
+ * @param[out] val : liczba
+ *
+ * @return : czy liczba mieści się w buforze
+ */
+static bool ReadU64(const uint8_t *data, size_t size, size_t *pos, uint64_t *val);
+
+/**
+ * Odtwarza stos z zawartości punktu kontrolnego.
+ *
+ * @param[in] data : zawartość pliku
+ * @param[in] size : długość zawartości
+ * @param[out] lines : liczba przetworzonych linii wejścia
+ *
+ * @return : nowy stos lub NULL, jeśli zawartość jest niepoprawna
+ */
+static poly_stack_t *ReadState(const uint8_t *data, size_t size, size_t *lines);
+
+
+
+static bool WriteU64(FILE *file, uint64_t val)
+{
+    return fwrite(&val, sizeof(val), 1, file) == 1;
+}
+
+static bool WriteState(FILE *file, const Calculator *calc, size_t lines)
+{
+    bool ok = fwrite(CHECKPOINT_MAGIC, 1, CHECKPOINT_HEADER_LEN - 1, file) == CHECKPOINT_HEADER_LEN - 1
+              && fputc(CHECKPOINT_VERSION, file) != EOF
+              && WriteU64(file, lines) && WriteU64(file, calc->polyStack->size);
+
+    for (size_t i = 0; ok && i < calc->polyStack->size; i++) {
+        const StackItem *item = GET_ITEM(StackItem, calc->polyStack, i);
+        size_t size;
+        uint8_t *data;
+
+        if (item->lazy != NULL) {
+            data = PolySerialize(LazyValue(item->lazy), &size);    // obliczone wyrażenie pozostaje na stosie
+        }
+        else if (item->mapped != NULL) {
+            Poly p = PolySnapshotToPoly(item->mapped);
+            data = PolySerialize(&p, &size);
+            PolyDestroy(&p);
+        }
+        else {
+            data = PolySerialize(&item->poly, &size);
+        }
+        ok = WriteU64(file, size) && fwrite(data, 1, size, file) == size;
+        free(data);
+    }
+    return ok;
+}
+
+static bool ReadU64(const uint8_t *data, size_t size, size_t *pos, uint64_t *val)
+{
+    if (size - *pos < sizeof(*val)) {
+        return false;
+    }
+    memcpy(val, data + *pos, sizeof(*val));
+    *pos += sizeof(*val);
+    return true;
+}
+
+static poly_stack_t *ReadState(const uint8_t *data, size_t size, size_t *lines)
+{
+    size_t pos = CHECKPOINT_HEADER_LEN;
+    uint64_t read_lines, count;
+
+    if (size < CHECKPOINT_HEADER_LEN || memcmp(data, CHECKPOINT_MAGIC, CHECKPOINT_HEADER_LEN - 1) != 0
+        || data[CHECKPOINT_HEADER_LEN - 1] != CHECKPOINT_VERSION
+        || !ReadU64(data, size, &pos, &read_lines) || !ReadU64(data, size, &pos, &count)
+        || count > (size - pos) / sizeof(uint64_t)) {
+        return NULL;    // każdy wielomian poprzedzony jest co najmniej swoją długością
+    }
+
+    poly_stack_t *stack = VectorNew(sizeof(StackItem), count > 0 ? count : INIT_CAP);
+    CHECK_POINTER(stack);
+    bool ok = true;
+
+    for (uint64_t i = 0; ok && i < count; i++) {
+        uint64_t len;
+        StackItem item = { .mapped = NULL };
+
+        ok = ReadU64(data, size, &pos, &len) && len <= size - pos
+             && PolyDeserialize(&item.poly, data + pos, len);
+        if (ok) {
+            pos += len;
+            PolyReduceCoeffs(&item.poly);
+            item.fingerprint = PolyFingerprintOf(&item.poly);
+            if (VectorPush(stack, &item) != VECT_OK) {
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+
+    if (!ok || pos != size) {
+        for (size_t i = 0; i < stack->size; i++) {
+            PolyDestroy(&(GET_ITEM(StackItem, stack, i))->poly);
+        }
+        VectorDestroy(stack);
+        return NULL;
+    }
+    *lines = read_lines;
+    return stack;
+}
+
+
+
+bool CheckpointWrite(const Calculator *calc, size_t lines, const char *path)
+{
+    char tmp_path[FILENAME_MAX];
+    size_t path_len = strlen(path);
+
+    if (path_len + sizeof(CHECKPOINT_TMP_SUFFIX) > FILENAME_MAX) {
+        return false;
+    }
+    memcpy(tmp_path, path, path_len);
+    memcpy(tmp_path + path_len, CHECKPOINT_TMP_SUFFIX, sizeof(CHECKPOINT_TMP_SUFFIX));
+
+    FILE *file = fopen(tmp_path, "wb");
+    if (file == NULL) {
+        return false;
+    }
+    bool ok = WriteState(file, calc, lines) && fflush(file) == 0 && fsync(fileno(file)) == 0;
+
+    if (fclose(file) != 0) {
+        ok = false;
+    }
+    if (ok && rename(tmp_path, path) == 0) {    // podmiana pliku docelowego jest atomowa
+        return true;
+    }
+    remove(tmp_path);
+    return false;
+}
+
+cmd_errcode_t CheckpointRead(Calculator *calc, size_t *lines, const char *path)
+{
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+
+    if (fd == -1) {
+        return CMD_FILE_ERROR;
+    }
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        return CMD_FILE_ERROR;
+    }
+    size_t size = (size_t) st.st_size;
+    if (size < CHECKPOINT_HEADER_LEN) {
+        close(fd);
+        return CMD_FORMAT_ERROR;
+    }
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED) {
+        return CMD_FILE_ERROR;
+    }
+    poly_stack_t *stack = ReadState(map, size, lines);
+    munmap(map, size);
+
+    if (stack == NULL) {
+        return CMD_FORMAT_ERROR;
+    }
+    CalcReplaceStack(calc, stack);
+    return CMD_OK;
+}
@@ -0,0 +1,57 @@
+/** @file
+  Interfejs punktów kontrolnych stanu kalkulatora wielomianów rzadkich wielu zmiennych
+
+  Punkt kontrolny zawiera nagłówek (@ref CHECKPOINT_MAGIC i bajt wersji),
+  liczbę przetworzonych linii wejścia, liczbę wielomianów na stosie,
+  a następnie wielomiany od dna stosu, każdy poprzedzony długością
+  i zapisany przez PolySerialize(). Liczby zapisane są jako 64-bitowe,
+  w kolejności bajtów bieżącej maszyny.
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#ifndef __CHECKPOINT_H__
+#define __CHECKPOINT_H__
+
+#include "calc_engine.h"
+
+/**
+ * Sygnatura rozpoczynająca plik punktu kontrolnego.
+ */
+#define CHECKPOINT_MAGIC "PLYC"
+
+/**
+ * Wersja formatu zapisywana w nagłówku.
+ */
+#define CHECKPOINT_VERSION 1
+
+/**
+ * Zapisuje stan kalkulatora do pliku w sposób atomowy: zapisuje
+ * plik tymczasowy obok docelowego, utrwala go na dysku przez fsync()
+ * i dopiero wtedy podmienia nim plik docelowy. Po awarii w pliku
+ * docelowym pozostaje więc poprzedni lub nowy, kompletny punkt kontrolny.
+ *
+ * @param[in] calc : kalkulator
+ * @param[in] lines : liczba przetworzonych dotąd linii wejścia
+ * @param[in] path : ścieżka pliku
+ *
+ * @return : czy zapis się powiódł
+ */
+bool CheckpointWrite(const Calculator *calc, size_t lines, const char *path);
+
+/**
+ * Odtwarza stan kalkulatora z punktu kontrolnego zapisanego przez
+ * CheckpointWrite(). Jeśli plik jest poprawny, zastępuje nim cały stos
+ * kalkulatora, w przeciwnym wypadku nie zmienia kalkulatora.
+ *
+ * @param[in, out] calc : kalkulator
+ * @param[out] lines : liczba linii wejścia przetworzonych przed zapisem
+ * @param[in] path : ścieżka pliku
+ *
+ * @return : CMD_OK, CMD_FILE_ERROR lub CMD_FORMAT_ERROR
+ */
+cmd_errcode_t CheckpointRead(Calculator *calc, size_t *lines, const char *path);
+
+#endif //__CHECKPOINT_H__
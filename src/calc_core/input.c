@@ -0,0 +1,91 @@
+/** @file
+  Implementacja źródeł danych wejściowych dla kalkulatora wielomianów rzadkich wielu zmiennych
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+/** Makro zdefiniowane, aby korzystać z getline() i madvise(). */
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "input.h"
+#include "../utils/safe_allocations.h"
+
+
+
+void InputOpenStream(InputSource *in, FILE *stream)
+{
+    in->stream = stream;
+    in->map = NULL;
+    in->mapLen = 0;
+    in->pos = 0;
+}
+
+bool InputOpenFile(InputSource *in, const char *path)
+{
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+
+    if (fd == -1) {
+        return false;
+    }
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        return false;
+    }
+    in->stream = NULL;
+    in->map = NULL;
+    in->mapLen = (size_t)st.st_size;
+    in->pos = 0;
+
+    if (in->mapLen > 0) {    // pliku pustego nie da się odwzorować
+        void *map = mmap(NULL, in->mapLen, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (map == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+        madvise(map, in->mapLen, MADV_SEQUENTIAL);
+        in->map = map;
+    }
+    close(fd);
+    return true;
+}
+
+bool InputNextLine(InputSource *in, char **buf, size_t *cap, StrView *line)
+{
+    if (in->stream != NULL) {
+        ssize_t nread = getline(buf, cap, in->stream);
+
+        if (nread == -1) {
+            return false;
+        }
+        CHECK_POINTER(*buf);
+        *line = StrViewMake(*buf, (size_t)nread);
+        return true;
+    }
+    if (in->pos >= in->mapLen) {
+        return false;
+    }
+    const char *start = in->map + in->pos;
+    size_t left = in->mapLen - in->pos;
+    const char *newline = memchr(start, '\n', left);    // wektoryzowane wyszukiwanie w glibc
+    size_t len = (newline == NULL) ? left : (size_t)(newline - start) + 1;
+
+    *line = StrViewMake(start, len);
+    in->pos += len;
+    return true;
+}
+
+void InputClose(InputSource *in)
+{
+    if (in->map != NULL) {
+        munmap((void *)in->map, in->mapLen);
+        in->map = NULL;
+    }
+}
@@ -0,0 +1,68 @@
+/** @file
+  Interfejs źródeł danych wejściowych dla kalkulatora wielomianów rzadkich wielu zmiennych
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#ifndef __INPUT_H__
+#define __INPUT_H__
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "../utils/str_view.h"
+
+/**
+ * Źródło linii wejściowych: strumień czytany funkcją getline()
+ * albo plik odwzorowany w pamięci, dzielony na linie bez kopiowania.
+ */
+typedef struct InputSource {
+    FILE *stream;     ///< Czytany strumień (NULL w trybie odwzorowania pliku)
+    const char *map;  ///< Początek odwzorowanego pliku
+    size_t mapLen;    ///< Rozmiar odwzorowanego pliku
+    size_t pos;       ///< Pozycja początku następnej linii w odwzorowaniu
+} InputSource;
+
+/**
+ * Tworzy źródło czytające linie ze strumienia.
+ *
+ * @param[out] in : źródło
+ * @param[in] stream : strumień
+ */
+void InputOpenStream(InputSource *in, FILE *stream);
+
+/**
+ * Tworzy źródło z pliku odwzorowanego w pamięci tylko do odczytu.
+ *
+ * @param[out] in : źródło
+ * @param[in] path : ścieżka do pliku
+ *
+ * @return : czy udało się otworzyć i odwzorować plik
+ */
+bool InputOpenFile(InputSource *in, const char *path);
+
+/**
+ * Daje następną linię wejścia (wraz z kończącym ją znakiem '\n', jeśli jest).
+ * W trybie strumieniowym linia jest wczytywana do bufora @p *buf o rozmiarze
+ * @p *cap (jak w getline()), w trybie odwzorowania pliku jest widokiem
+ * na odwzorowaną pamięć, a bufor nie jest używany.
+ *
+ * @param[in, out] in : źródło
+ * @param[in, out] buf : bufor linii
+ * @param[in, out] cap : rozmiar bufora
+ * @param[out] line : widok na linię
+ *
+ * @return : czy wczytano linię (false na końcu wejścia)
+ */
+bool InputNextLine(InputSource *in, char **buf, size_t *cap, StrView *line);
+
+/**
+ * Zwalnia zasoby źródła (nie zamyka strumienia przekazanego
+ * do InputOpenStream()).
+ *
+ * @param[in, out] in : źródło
+ */
+void InputClose(InputSource *in);
+
+#endif //__INPUT_H__
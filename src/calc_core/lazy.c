@@ -0,0 +1,420 @@
+/** @file
+  Implementacja leniwych wyrażeń na wielomianach rzadkich wielu zmiennych
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#include <string.h>
+#include "lazy.h"
+#include "../poly_core/poly_reclaimer.h"
+#include "../utils/safe_allocations.h"
+
+/**
+ * Ramka stosu używanego przy obliczaniu wyrażenia.
+ */
+typedef struct LazyFrame {
+    LazyNode *node;  ///< obliczany węzeł
+    size_t next;     ///< indeks kolejnego argumentu do sprawdzenia
+} LazyFrame;
+
+
+
+/**
+ * Tworzy węzeł bez argumentów z jedną referencją.
+ *
+ * @param[in] kind : rodzaj węzła
+ *
+ * @return : węzeł
+ */
+static LazyNode *LazyNew(LazyKind kind);
+
+/**
+ * Dopisuje argument do węzła, przejmując referencję na niego.
+ *
+ * @param[in, out] node : węzeł
+ * @param[in] arg : argument
+ */
+static void LazyPushArg(LazyNode *node, LazyNode *arg);
+
+/**
+ * Dopisuje składnik do sumy, przejmując referencję na niego.
+ * Składnik będący sumą bez innych referencji rozkładany jest na swoje składniki.
+ *
+ * @param[in, out] sum : suma
+ * @param[in] term : składnik
+ */
+static void LazyAppendTerm(LazyNode *sum, LazyNode *term);
+
+/**
+ * Zwraca węzeł, którego wartość jest potrzebna do obliczenia @p i-tego
+ * argumentu. Negacja bez innych referencji będąca składnikiem sumy jest
+ * pomijana - znaki zmieniane są dopiero przy scalaniu.
+ *
+ * @param[in] node : węzeł
+ * @param[in] i : indeks argumentu
+ * @param[out] negate : czy wartość trzeba zanegować
+ *
+ * @return : węzeł
+ */
+static LazyNode *LazyOperand(const LazyNode *node, size_t i, bool *negate);
+
+/**
+ * Zwraca wartość obliczonego argumentu na własność: przenosi ją,
+ * jeśli argument nie ma innych referencji, a w przeciwnym wypadku kopiuje.
+ *
+ * @param[in, out] operand : argument
+ * @param[in] at : czy chodzi o wartość w punkcie
+ *
+ * @return : wartość
+ */
+static Poly LazyOperandTake(LazyNode *operand, bool at);
+
+/**
+ * Oblicza sumę jednym scalaniem jednomianów wszystkich składników.
+ *
+ * @param[in] node : suma o obliczonych argumentach
+ * @param[in] at : czy obliczać wartość w punkcie
+ *
+ * @return : wynik
+ */
+static Poly LazySum(LazyNode *node, bool at);
+
+/**
+ * Oblicza węzeł o obliczonych argumentach.
+ *
+ * @param[in] node : węzeł
+ * @param[in] at : czy obliczać wartość w punkcie
+ *
+ * @return : wynik
+ */
+static Poly LazyCompute(LazyNode *node, bool at);
+
+/**
+ * Zastępuje węzeł liściem z wynikiem, zwalniając referencje na argumenty.
+ *
+ * @param[in, out] node : węzeł
+ * @param[in] res : wynik
+ */
+static void LazyBecomeLeaf(LazyNode *node, Poly res);
+
+/**
+ * Oblicza wyrażenie od liści przy pomocy jawnego stosu. Przy obliczaniu
+ * całego wyrażenia węzły zastępowane są liśćmi, a przy obliczaniu wartości
+ * w punkcie wynik pamiętany jest w @p atValue odwiedzonych węzłów.
+ *
+ * @param[in, out] root : węzeł, który nie jest liściem
+ * @param[in] at : czy obliczać wartość w punkcie
+ * @param[in] x : punkt (gdy @p at)
+ * @param[in, out] visited : węzły z obliczoną wartością w punkcie (gdy @p at)
+ */
+static void LazyEvaluate(LazyNode *root, bool at, poly_coeff_t x, vector_t *visited);
+
+
+
+static LazyNode *LazyNew(LazyKind kind)
+{
+    LazyNode *node = safeMalloc(sizeof(LazyNode));
+
+    *node = (LazyNode) { .kind = kind, .refs = 1, .value = PolyZero(), .atValue = PolyZero(), .atReady = false };
+    if (kind != LAZY_LEAF) {
+        node->args = VectorNew(sizeof(LazyNode *), INIT_CAP);
+        CHECK_POINTER(node->args);
+    }
+    return node;
+}
+
+static void LazyPushArg(LazyNode *node, LazyNode *arg)
+{
+    if (VectorPush(node->args, &arg) != VECT_OK) {
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void LazyAppendTerm(LazyNode *sum, LazyNode *term)
+{
+    if (term->kind == LAZY_SUM && term->refs == 1) {
+        for (size_t i = 0; i < term->args->size; i++) {
+            LazyPushArg(sum, *GET_ITEM(LazyNode *, term->args, i));
+        }
+        VectorDestroy(term->args);
+        free(term);
+    }
+    else {
+        LazyPushArg(sum, term);
+    }
+}
+
+static LazyNode *LazyOperand(const LazyNode *node, size_t i, bool *negate)
+{
+    LazyNode *arg = *GET_ITEM(LazyNode *, node->args, i);
+
+    *negate = node->kind == LAZY_SUM && arg->kind == LAZY_NEG && arg->refs == 1;
+    return *negate ? *GET_ITEM(LazyNode *, arg->args, 0) : arg;
+}
+
+static Poly LazyOperandTake(LazyNode *operand, bool at)
+{
+    Poly *src = at ? &operand->atValue : &operand->value;
+
+    if (operand->refs == 1) {    // jedynym użytkownikiem wartości jest obliczany węzeł
+        Poly res = *src;
+        *src = PolyZero();
+        return res;
+    }
+    return PolyClone(src);
+}
+
+static Poly LazySum(LazyNode *node, bool at)
+{
+    size_t count = node->args->size, total = 0, k = 0;
+    Poly *terms = safeMalloc(count * sizeof(Poly));
+
+    for (size_t i = 0; i < count; i++) {
+        bool negate;
+        terms[i] = LazyOperandTake(LazyOperand(node, i, &negate), at);
+
+        if (negate) {
+            PolyNegateCoeffs(&terms[i]);    // własna kopia - odejmowanie bez osobnego wielomianu przeciwnego
+        }
+        total += PolyIsCoeff(&terms[i]) ? 1 : terms[i].size;
+    }
+
+    Mono *monos = safeMalloc(total * sizeof(Mono));
+    for (size_t i = 0; i < count; i++) {
+        if (PolyIsCoeff(&terms[i])) {
+            if (!PolyIsZero(&terms[i])) {
+                monos[k++] = MonoFromPoly(&terms[i], 0);
+            }
+        }
+        else {
+            memcpy(monos + k, terms[i].arr, terms[i].size * sizeof(Mono));
+            k += terms[i].size;
+            free(terms[i].arr);
+        }
+    }
+    free(terms);
+
+    Poly res = PolyOwnMonos(k, monos);
+    if (!PolyIsCoeff(&res) && res.size < k) {
+        res.arr = safeRealloc(res.arr, res.size * sizeof(Mono));    // scalanie nie zmniejsza tablicy
+    }
+    return res;
+}
+
+static Poly LazyCompute(LazyNode *node, bool at)
+{
+    if (node->kind == LAZY_NEG) {
+        Poly res = LazyOperandTake(*GET_ITEM(LazyNode *, node->args, 0), at);
+        PolyNegateCoeffs(&res);
+        return res;
+    }
+    if (node->kind == LAZY_PRODUCT) {
+        LazyNode *a = *GET_ITEM(LazyNode *, node->args, 0);
+        LazyNode *b = *GET_ITEM(LazyNode *, node->args, 1);
+        return at ? PolyMul(&a->atValue, &b->atValue) : PolyMul(&a->value, &b->value);
+    }
+    return LazySum(node, at);
+}
+
+static void LazyBecomeLeaf(LazyNode *node, Poly res)
+{
+    vector_t *args = node->args;
+
+    node->kind = LAZY_LEAF;
+    node->value = res;
+    node->args = NULL;
+    for (size_t i = 0; i < args->size; i++) {
+        LazyRelease(*GET_ITEM(LazyNode *, args, i));
+    }
+    VectorDestroy(args);
+}
+
+static void LazyEvaluate(LazyNode *root, bool at, poly_coeff_t x, vector_t *visited)
+{
+    vector_t *stack = VectorNew(sizeof(LazyFrame), INIT_CAP);
+    CHECK_POINTER(stack);
+    LazyFrame frame = { .node = root, .next = 0 };
+    if (VectorPush(stack, &frame) != VECT_OK) {
+        exit(EXIT_FAILURE);
+    }
+
+    while (!VectorIsEmpty(stack)) {
+        LazyFrame *top = (LazyFrame *) VectorPeek(stack);
+
+        if (top->next < top->node->args->size) {
+            bool negate;
+            LazyNode *operand = LazyOperand(top->node, top->next++, &negate);
+
+            if (at && !operand->atReady && operand->kind == LAZY_LEAF) {
+                operand->atValue = PolyAt(&operand->value, x);
+                operand->atReady = true;
+                if (VectorPush(visited, &operand) != VECT_OK) {
+                    exit(EXIT_FAILURE);
+                }
+            }
+            else if (at ? !operand->atReady : operand->kind != LAZY_LEAF) {
+                LazyFrame child = { .node = operand, .next = 0 };
+                if (VectorPush(stack, &child) != VECT_OK) {
+                    exit(EXIT_FAILURE);
+                }
+            }
+        }
+        else {
+            LazyNode *node = top->node;    // wszystkie argumenty są już obliczone
+            VectorPop(stack);
+            Poly res = LazyCompute(node, at);
+
+            if (at) {
+                node->atValue = res;
+                node->atReady = true;
+                if (VectorPush(visited, &node) != VECT_OK) {
+                    exit(EXIT_FAILURE);
+                }
+            }
+            else {
+                LazyBecomeLeaf(node, res);
+            }
+        }
+    }
+    VectorDestroy(stack);
+}
+
+
+
+LazyNode *LazyLeaf(Poly p)
+{
+    LazyNode *node = LazyNew(LAZY_LEAF);
+
+    node->value = p;
+    return node;
+}
+
+LazyNode *LazyAdd(LazyNode *a, LazyNode *b)
+{
+    LazyNode *sum;
+
+    if (a->kind == LAZY_SUM && a->refs == 1) {
+        sum = a;
+    }
+    else if (b->kind == LAZY_SUM && b->refs == 1) {
+        sum = b;
+        b = a;
+    }
+    else {
+        sum = LazyNew(LAZY_SUM);
+        LazyAppendTerm(sum, a);
+    }
+    LazyAppendTerm(sum, b);
+    return sum;
+}
+
+LazyNode *LazyMul(LazyNode *a, LazyNode *b)
+{
+    LazyNode *prod = LazyNew(LAZY_PRODUCT);
+
+    LazyPushArg(prod, a);
+    LazyPushArg(prod, b);
+    return prod;
+}
+
+LazyNode *LazyNeg(LazyNode *a)
+{
+    if (a->kind == LAZY_NEG) {    // podwójna negacja
+        LazyNode *arg = LazyRetain(*GET_ITEM(LazyNode *, a->args, 0));
+        LazyRelease(a);
+        return arg;
+    }
+    LazyNode *neg = LazyNew(LAZY_NEG);
+
+    LazyPushArg(neg, a);
+    return neg;
+}
+
+LazyNode *LazyRetain(LazyNode *node)
+{
+    node->refs++;
+    return node;
+}
+
+void LazyRelease(LazyNode *node)
+{
+    vector_t *stack = NULL;
+
+    if (--node->refs > 0) {
+        return;
+    }
+    while (node != NULL) {    // jawny stos - wyrażenie może być dowolnie głębokie
+        if (node->kind == LAZY_LEAF) {
+            PolyDestroyDeferred(&node->value);
+        }
+        else {
+            for (size_t i = 0; i < node->args->size; i++) {
+                LazyNode *arg = *GET_ITEM(LazyNode *, node->args, i);
+
+                if (--arg->refs == 0) {
+                    if (stack == NULL) {
+                        stack = VectorNew(sizeof(LazyNode *), INIT_CAP);
+                        CHECK_POINTER(stack);
+                    }
+                    if (VectorPush(stack, &arg) != VECT_OK) {
+                        exit(EXIT_FAILURE);
+                    }
+                }
+            }
+            VectorDestroy(node->args);
+        }
+        free(node);
+        node = (stack != NULL && !VectorIsEmpty(stack)) ? *(LazyNode **) VectorPop(stack) : NULL;
+    }
+    if (stack != NULL) {
+        VectorDestroy(stack);
+    }
+}
+
+const Poly *LazyValue(LazyNode *node)
+{
+    if (node->kind != LAZY_LEAF) {
+        LazyEvaluate(node, false, 0, NULL);
+    }
+    return &node->value;
+}
+
+Poly LazyTake(LazyNode *node)
+{
+    Poly res;
+
+    LazyValue(node);
+    if (node->refs == 1) {
+        res = node->value;
+        node->value = PolyZero();
+    }
+    else {
+        res = PolyClone(&node->value);
+    }
+    LazyRelease(node);
+    return res;
+}
+
+Poly LazyAt(LazyNode *node, poly_coeff_t x)
+{
+    if (node->kind == LAZY_LEAF) {
+        return PolyAt(&node->value, x);
+    }
+    vector_t *visited = VectorNew(sizeof(LazyNode *), INIT_CAP);
+    CHECK_POINTER(visited);
+
+    LazyEvaluate(node, true, x, visited);
+    Poly res = node->atValue;
+    node->atValue = PolyZero();
+
+    for (size_t i = 0; i < visited->size; i++) {
+        LazyNode *v = *GET_ITEM(LazyNode *, visited, i);
+        PolyDestroy(&v->atValue);
+        v->atValue = PolyZero();
+        v->atReady = false;
+    }
+    VectorDestroy(visited);
+    return res;
+}
@@ -0,0 +1,138 @@
+/** @file
+  Interfejs leniwych wyrażeń na wielomianach rzadkich wielu zmiennych
+
+  W trybie leniwym komendy ADD, SUB, MUL i NEG nie obliczają wyniku, tylko
+  wstawiają na stos węzeł wyrażenia. Węzły tworzą acykliczny graf (CLONE
+  współdzieli węzeł), a wynik obliczany jest dopiero, gdy potrzebna jest
+  struktura wielomianu. Przy budowie i obliczaniu wyrażenia:
+  - kolejne dodawania łączone są w jedną sumę wielu składników, obliczaną
+    jednym scalaniem jednomianów wszystkich składników,
+  - negacja składnika sumy nie tworzy osobnego wielomianu, tylko zmienia
+    znaki współczynników w trakcie scalania (odejmowanie),
+  - podwójna negacja znika,
+  - wartość w punkcie (AT) obliczana jest od liści: dla iloczynu najpierw
+    wyznaczane są wartości czynników, a dopiero potem ich iloczyn.
+
+  Obliczony węzeł zastępowany jest liściem z wynikiem, więc wspólne
+  podwyrażenia obliczane są raz.
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#ifndef __LAZY_H__
+#define __LAZY_H__
+
+#include "../poly_core/poly.h"
+#include "../utils/vector.h"
+
+/**
+ * Rodzaj węzła wyrażenia.
+ */
+typedef enum LazyKind {
+    LAZY_LEAF,      ///< Obliczony wielomian
+    LAZY_SUM,       ///< Suma argumentów
+    LAZY_PRODUCT,   ///< Iloczyn dwóch argumentów
+    LAZY_NEG        ///< Wielomian przeciwny do argumentu
+} LazyKind;
+
+/**
+ * Węzeł wyrażenia. Węzły nie są współdzielone między wątkami,
+ * więc licznik referencji nie musi być atomowy.
+ */
+typedef struct LazyNode {
+    LazyKind kind;      ///< Rodzaj węzła
+    size_t refs;        ///< Liczba referencji (elementów stosu i węzłów-rodziców)
+    Poly value;         ///< Wielomian (dla LAZY_LEAF)
+    vector_t *args;     ///< Argumenty - wskaźniki na węzły (dla pozostałych rodzajów)
+    Poly atValue;       ///< Wartość w punkcie, pamiętana w trakcie LazyAt()
+    bool atReady;       ///< Czy @p atValue jest obliczone
+} LazyNode;
+
+/**
+ * Tworzy liść wyrażenia, przejmując wielomian na własność.
+ *
+ * @param[in] p : wielomian
+ *
+ * @return : węzeł z jedną referencją
+ */
+LazyNode *LazyLeaf(Poly p);
+
+/**
+ * Tworzy sumę wyrażeń, przejmując referencje na argumenty.
+ * Sumy bez innych referencji są łączone w jedną.
+ *
+ * @param[in] a : wyrażenie
+ * @param[in] b : wyrażenie
+ *
+ * @return : węzeł z jedną referencją
+ */
+LazyNode *LazyAdd(LazyNode *a, LazyNode *b);
+
+/**
+ * Tworzy iloczyn wyrażeń, przejmując referencje na argumenty.
+ *
+ * @param[in] a : wyrażenie
+ * @param[in] b : wyrażenie
+ *
+ * @return : węzeł z jedną referencją
+ */
+LazyNode *LazyMul(LazyNode *a, LazyNode *b);
+
+/**
+ * Tworzy wyrażenie przeciwne, przejmując referencję na argument.
+ *
+ * @param[in] a : wyrażenie
+ *
+ * @return : węzeł z jedną referencją
+ */
+LazyNode *LazyNeg(LazyNode *a);
+
+/**
+ * Dodaje referencję na węzeł.
+ *
+ * @param[in, out] node : węzeł
+ *
+ * @return : @p node
+ */
+LazyNode *LazyRetain(LazyNode *node);
+
+/**
+ * Usuwa referencję na węzeł, zwalniając go wraz z argumentami,
+ * do których nie ma innych referencji.
+ *
+ * @param[in, out] node : węzeł
+ */
+void LazyRelease(LazyNode *node);
+
+/**
+ * Oblicza wyrażenie, zastępując węzeł liściem z wynikiem.
+ *
+ * @param[in, out] node : węzeł
+ *
+ * @return : wynik, należący do węzła
+ */
+const Poly *LazyValue(LazyNode *node);
+
+/**
+ * Oblicza wyrażenie i usuwa referencję na węzeł.
+ *
+ * @param[in, out] node : węzeł
+ *
+ * @return : wynik (przeniesiony z węzła, jeśli była to ostatnia referencja)
+ */
+Poly LazyTake(LazyNode *node);
+
+/**
+ * Oblicza wartość wyrażenia w punkcie, tak jak PolyAt(), bez obliczania
+ * samego wyrażenia - wartości wyznaczane są od liści.
+ *
+ * @param[in, out] node : węzeł
+ * @param[in] x : wartość pierwszej zmiennej
+ *
+ * @return : @f$p(x, x_0, x_1, \ldots)@f$
+ */
+Poly LazyAt(LazyNode *node, poly_coeff_t x);
+
+#endif //__LAZY_H__
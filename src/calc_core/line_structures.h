@@ -11,14 +11,17 @@
 
 #include "calc_engine.h"
 #include "../poly_core/poly_structures.h"
+#include "../utils/str_view.h"
 
 /**
  * Enum informujący o typie linii.
  */
 typedef enum LineType {
-    IGNORED,   ///< Linia jest pusta/komentarzem lub z błędną zawartością
-    CMD_LINE,  ///< Linia zawiera komendę
-    POLY_LINE  ///< Linia zawiera wielomian
+    IGNORED,          ///< Linia jest pusta lub jest komentarzem
+    CMD_LINE,         ///< Linia zawiera komendę
+    POLY_LINE,        ///< Linia zawiera wielomian
+    WRONG_CMD_LINE,   ///< Linia zawiera błędną komendę
+    WRONG_POLY_LINE   ///< Linia zawiera błędny wielomian
 } LineType;
 
 /**
@@ -42,6 +45,20 @@ typedef enum CommandCode {
     PRINT,
     POP,
     COMPOSE,
+    SAVE,
+    LOAD,
+    SNAPSHOT,
+    MAP,
+    CHECKPOINT,
+    RESTORE,
+    EVAL,
+    EVAL_FILE,
+    COMPILE,
+    MUL_TRUNC,
+    COMPOSE_TRUNC,
+    POW,
+    FMA,
+    DOT,
 
     COMMAND_COUNT
 } CommandCode;
@@ -52,6 +69,7 @@ typedef enum CommandCode {
 typedef struct Line {
     size_t index;         ///< Indeks linii
     LineType type;        ///< Typ linii (wielomian bądź komenda)
+    StrView text;         ///< Treść linii bez znaku końca linii
     union {
         CommandCode cmd;  ///< Kod komendy zawartej w linii
         Poly poly;        ///< Wielomian zawarty w linii
@@ -0,0 +1,263 @@
+/** @file
+  Implementacja pamięci podręcznej wyników działań kalkulatora wielomianów
+  rzadkich wielu zmiennych
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#include "op_cache.h"
+
+/**
+ * Początkowa liczba kubełków tablicy mieszającej.
+ */
+#define OP_CACHE_INIT_BUCKETS 64
+
+
+
+/**
+ * Miesza bity liczby (funkcja kończąca splitmix64).
+ *
+ * @param[in] z : liczba
+ *
+ * @return : wymieszana liczba
+ */
+static uint64_t OpCacheMix(uint64_t z);
+
+/**
+ * Oblicza skrót klucza.
+ *
+ * @param[in] op : kod komendy
+ * @param[in] arg : argument komendy
+ * @param[in] count : liczba argumentów-wielomianów
+ * @param[in] fingerprints : odciski argumentów
+ *
+ * @return : skrót
+ */
+static uint64_t OpCacheHash(unsigned op, uint64_t arg, size_t count, const PolyFingerprint fingerprints[]);
+
+/**
+ * Wypina wpis z listy LRU.
+ *
+ * @param[in, out] cache : pamięć podręczna
+ * @param[in, out] entry : wpis
+ */
+static void OpCacheUnlink(OpCache *cache, OpCacheEntry *entry);
+
+/**
+ * Wpina wpis na początek listy LRU (jako najświeższy).
+ *
+ * @param[in, out] cache : pamięć podręczna
+ * @param[in, out] entry : wpis
+ */
+static void OpCacheLinkNewest(OpCache *cache, OpCacheEntry *entry);
+
+/**
+ * Usuwa najdawniej używany wpis.
+ *
+ * @param[in, out] cache : pamięć podręczna
+ */
+static void OpCacheEvict(OpCache *cache);
+
+/**
+ * Zwalnia wpis (nie wypinając go z żadnej struktury).
+ *
+ * @param[in, out] entry : wpis
+ */
+static void OpCacheEntryFree(OpCacheEntry *entry);
+
+/**
+ * Podwaja liczbę kubełków tablicy mieszającej.
+ *
+ * @param[in, out] cache : pamięć podręczna
+ */
+static void OpCacheGrow(OpCache *cache);
+
+
+
+static uint64_t OpCacheMix(uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9u;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebu;
+    return z ^ (z >> 31);
+}
+
+static uint64_t OpCacheHash(unsigned op, uint64_t arg, size_t count, const PolyFingerprint fingerprints[])
+{
+    uint64_t hash = OpCacheMix(op ^ OpCacheMix(arg + 0x9e3779b97f4a7c15u));
+
+    for (size_t i = 0; i < count; i++) {
+        for (size_t j = 0; j < POLY_FINGERPRINT_POINTS; j++) {
+            hash = OpCacheMix(hash ^ fingerprints[i].v[j]);
+        }
+    }
+    return hash;
+}
+
+static void OpCacheUnlink(OpCache *cache, OpCacheEntry *entry)
+{
+    if (entry->newer != NULL) {
+        entry->newer->older = entry->older;
+    }
+    else {
+        cache->newest = entry->older;
+    }
+    if (entry->older != NULL) {
+        entry->older->newer = entry->newer;
+    }
+    else {
+        cache->oldest = entry->newer;
+    }
+}
+
+static void OpCacheLinkNewest(OpCache *cache, OpCacheEntry *entry)
+{
+    entry->newer = NULL;
+    entry->older = cache->newest;
+    if (cache->newest != NULL) {
+        cache->newest->newer = entry;
+    }
+    else {
+        cache->oldest = entry;
+    }
+    cache->newest = entry;
+}
+
+static void OpCacheEvict(OpCache *cache)
+{
+    OpCacheEntry *victim = cache->oldest;
+    OpCacheEntry **link = &cache->buckets[victim->hash & (cache->bucketCount - 1)];
+
+    while (*link != victim) {
+        link = &(*link)->chain;
+    }
+    *link = victim->chain;
+    OpCacheUnlink(cache, victim);
+    cache->bytes -= victim->bytes;
+    cache->count--;
+    cache->evictions++;
+    OpCacheEntryFree(victim);
+}
+
+static void OpCacheEntryFree(OpCacheEntry *entry)
+{
+    for (size_t i = 0; i < entry->count; i++) {
+        PolyDestroy(&entry->operands[i]);
+    }
+    free(entry->operands);
+    PolyDestroy(&entry->result);
+    free(entry);
+}
+
+static void OpCacheGrow(OpCache *cache)
+{
+    size_t old_count = cache->bucketCount;
+    OpCacheEntry **old = cache->buckets;
+
+    cache->bucketCount *= 2;
+    cache->buckets = safeCalloc(cache->bucketCount, sizeof(OpCacheEntry *));
+    for (size_t i = 0; i < old_count; i++) {
+        while (old[i] != NULL) {
+            OpCacheEntry *entry = old[i];
+            OpCacheEntry **bucket = &cache->buckets[entry->hash & (cache->bucketCount - 1)];
+
+            old[i] = entry->chain;
+            entry->chain = *bucket;
+            *bucket = entry;
+        }
+    }
+    free(old);
+}
+
+
+
+OpCache *OpCacheNew(size_t budget)
+{
+    OpCache *cache = safeMalloc(sizeof(OpCache));
+
+    cache->bucketCount = OP_CACHE_INIT_BUCKETS;
+    cache->buckets = safeCalloc(cache->bucketCount, sizeof(OpCacheEntry *));
+    cache->count = 0;
+    cache->newest = NULL;
+    cache->oldest = NULL;
+    cache->bytes = 0;
+    cache->budget = budget;
+    cache->hits = 0;
+    cache->misses = 0;
+    cache->evictions = 0;
+    return cache;
+}
+
+void OpCacheDestroy(OpCache *cache)
+{
+    OpCacheEntry *entry = cache->newest;
+
+    while (entry != NULL) {
+        OpCacheEntry *older = entry->older;
+        OpCacheEntryFree(entry);
+        entry = older;
+    }
+    free(cache->buckets);
+    free(cache);
+}
+
+bool OpCacheLookup(OpCache *cache, unsigned op, uint64_t arg, size_t count,
+                   const Poly *const operands[], const PolyFingerprint fingerprints[], Poly *res)
+{
+    uint64_t hash = OpCacheHash(op, arg, count, fingerprints);
+
+    for (OpCacheEntry *entry = cache->buckets[hash & (cache->bucketCount - 1)]; entry != NULL; entry = entry->chain) {
+        if (entry->hash != hash || entry->op != op || entry->arg != arg || entry->count != count) {
+            continue;
+        }
+        bool eq = true;
+        for (size_t i = 0; eq && i < count; i++) {    // równe odciski nie gwarantują równości
+            eq = PolyIsEq(&entry->operands[i], operands[i]);
+        }
+        if (eq) {
+            OpCacheUnlink(cache, entry);
+            OpCacheLinkNewest(cache, entry);
+            cache->hits++;
+            *res = PolyClone(&entry->result);
+            return true;
+        }
+    }
+    cache->misses++;
+    return false;
+}
+
+void OpCacheStore(OpCache *cache, unsigned op, uint64_t arg, size_t count,
+                  const Poly *const operands[], const PolyFingerprint fingerprints[],
+                  const Poly *res, size_t bytes)
+{
+    bytes += sizeof(OpCacheEntry) + count * sizeof(Poly);
+    if (bytes > cache->budget) {
+        return;
+    }
+    while (cache->bytes + bytes > cache->budget) {
+        OpCacheEvict(cache);
+    }
+
+    OpCacheEntry *entry = safeMalloc(sizeof(OpCacheEntry));
+    entry->op = op;
+    entry->arg = arg;
+    entry->hash = OpCacheHash(op, arg, count, fingerprints);
+    entry->count = count;
+    entry->operands = safeMalloc(count * sizeof(Poly));
+    for (size_t i = 0; i < count; i++) {
+        entry->operands[i] = PolyClone(operands[i]);
+    }
+    entry->result = PolyClone(res);
+    entry->bytes = bytes;
+
+    if (cache->count >= cache->bucketCount) {
+        OpCacheGrow(cache);
+    }
+    OpCacheEntry **bucket = &cache->buckets[entry->hash & (cache->bucketCount - 1)];
+    entry->chain = *bucket;
+    *bucket = entry;
+    OpCacheLinkNewest(cache, entry);
+    cache->bytes += bytes;
+    cache->count++;
+}
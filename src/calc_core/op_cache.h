@@ -0,0 +1,106 @@
+/** @file
+  Interfejs pamięci podręcznej wyników działań kalkulatora wielomianów
+  rzadkich wielu zmiennych
+
+  Pamięć przechowuje wyniki czystych działań (np. MUL, AT, COMPOSE)
+  wraz z kopiami ich argumentów. Kluczem jest kod komendy, jej argument
+  i odciski argumentów-wielomianów; ponieważ różne wielomiany mogą mieć
+  równe odciski, trafienie wymaga jeszcze równości argumentów.
+  Gdy łączny rozmiar wpisów przekroczyłby budżet, usuwane są wpisy
+  najdawniej używane (LRU).
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#ifndef __OP_CACHE_H__
+#define __OP_CACHE_H__
+
+#include <stdint.h>
+#include "../poly_core/poly.h"
+#include "../poly_core/poly_fingerprint.h"
+
+/**
+ * Wpis pamięci podręcznej.
+ */
+typedef struct OpCacheEntry {
+    unsigned op;                    ///< Kod komendy
+    uint64_t arg;                   ///< Argument komendy
+    uint64_t hash;                  ///< Skrót klucza
+    size_t count;                   ///< Liczba argumentów-wielomianów
+    Poly *operands;                 ///< Kopie argumentów-wielomianów
+    Poly result;                    ///< Wynik działania
+    size_t bytes;                   ///< Pamięć zajmowana przez wpis
+    struct OpCacheEntry *chain;     ///< Następny wpis w tym samym kubełku
+    struct OpCacheEntry *newer;     ///< Wpis użyty później (NULL - najświeższy)
+    struct OpCacheEntry *older;     ///< Wpis użyty wcześniej (NULL - najstarszy)
+} OpCacheEntry;
+
+/**
+ * Pamięć podręczna wyników działań. Nie jest bezpieczna dla wielu wątków,
+ * więc każdy kalkulator ma własną.
+ */
+typedef struct OpCache {
+    OpCacheEntry **buckets;         ///< Kubełki tablicy mieszającej
+    size_t bucketCount;             ///< Liczba kubełków (potęga dwójki)
+    size_t count;                   ///< Liczba wpisów
+    OpCacheEntry *newest;           ///< Ostatnio użyty wpis
+    OpCacheEntry *oldest;           ///< Najdawniej użyty wpis
+    size_t bytes;                   ///< Pamięć zajmowana przez wpisy
+    size_t budget;                  ///< Największa dopuszczalna wartość @p bytes
+    size_t hits;                    ///< Liczba trafień
+    size_t misses;                  ///< Liczba chybień
+    size_t evictions;               ///< Liczba wpisów usuniętych z braku miejsca
+} OpCache;
+
+/**
+ * Tworzy pustą pamięć podręczną.
+ *
+ * @param[in] budget : największa łączna pamięć wpisów w bajtach
+ *
+ * @return : pamięć (do zwolnienia przez OpCacheDestroy())
+ */
+OpCache *OpCacheNew(size_t budget);
+
+/**
+ * Zwalnia pamięć podręczną wraz ze wszystkimi wpisami.
+ *
+ * @param[in, out] cache : pamięć podręczna
+ */
+void OpCacheDestroy(OpCache *cache);
+
+/**
+ * Szuka wyniku działania. Znaleziony wpis staje się najświeższy.
+ *
+ * @param[in, out] cache : pamięć podręczna
+ * @param[in] op : kod komendy (CommandCode)
+ * @param[in] arg : argument komendy
+ * @param[in] count : liczba argumentów-wielomianów
+ * @param[in] operands : argumenty-wielomiany
+ * @param[in] fingerprints : odciski argumentów
+ * @param[out] res : kopia wyniku (gdy został znaleziony)
+ *
+ * @return : czy wynik był w pamięci
+ */
+bool OpCacheLookup(OpCache *cache, unsigned op, uint64_t arg, size_t count,
+                   const Poly *const operands[], const PolyFingerprint fingerprints[], Poly *res);
+
+/**
+ * Zapamiętuje wynik działania, usuwając w razie potrzeby najdawniej
+ * używane wpisy. Wynik większy niż cały budżet nie jest zapamiętywany.
+ *
+ * @param[in, out] cache : pamięć podręczna
+ * @param[in] op : kod komendy (CommandCode)
+ * @param[in] arg : argument komendy
+ * @param[in] count : liczba argumentów-wielomianów
+ * @param[in] operands : argumenty-wielomiany (kopiowane)
+ * @param[in] fingerprints : odciski argumentów
+ * @param[in] res : wynik (kopiowany)
+ * @param[in] bytes : pamięć zajmowana przez argumenty i wynik
+ */
+void OpCacheStore(OpCache *cache, unsigned op, uint64_t arg, size_t count,
+                  const Poly *const operands[], const PolyFingerprint fingerprints[],
+                  const Poly *res, size_t bytes);
+
+#endif //__OP_CACHE_H__
@@ -8,9 +8,6 @@
 
 #include "parsing.h"
 
-/** Oznaczenie na system dziesiętny (dla konwersji) */
-#define DECIMAL 10
-
 /**
  * Sprawdza czy dany string reprezentuje wielomian.
  *
@@ -18,7 +15,7 @@
  *
  * @return : czy @p str jest wielomianem zapisanym w konwencji z zadania
  */
-static bool doesStringRepresentPoly(const char *str);
+static bool doesStringRepresentPoly(StrView str);
 
 /**
  * Sprawdza czy dany string reprezentuje wielomian (będący współczynnikiem).
@@ -27,7 +24,7 @@ static bool doesStringRepresentPoly(const char *str);
  *
  * @return : czy @p str jest wielomianem współczynnikowym zapisanym w konwencji z zadania
  */
-static bool doesStringRepresentCoeffPoly(const char *str);
+static bool doesStringRepresentCoeffPoly(StrView str);
 
 /**
  * Sprawdza czy dany string reprezentuje wielomian (niebędący współczynnikiem).
@@ -36,92 +33,77 @@ static bool doesStringRepresentCoeffPoly(const char *str);
  *
  * @return : czy @p str jest wielomianem niewspółczynnikowym zapisanym w konwencji z zadania
  */
-static bool doesStringRepresentNonCoeffPoly(const char *str);
+static bool doesStringRepresentNonCoeffPoly(StrView str);
 
 /**
- * Funkcja rekurencyjna, której parsePoly() jest wrapperem.
+ * Funkcja budująca wielomian, której parsePoly() jest wrapperem.
+ * Zakłada, że @p str jest poprawny składniowo. Zamiast rekurencji
+ * korzysta z jawnego stosu, więc głębokość zagnieżdżenia wielomianu
+ * ogranicza jedynie dostępna pamięć.
  * @see : parsePoly()
  *
  * @param[in, out] p : wielomian
  * @param[in] str : wielomian jako string
- * @param[in] start_idx : indeks, od którego rozpoczyna się wielomian w @p str
- * @param[in] end_idx : indeks, na którym kończy się wielomian w @p str
  *
- * @return : czy jednomiany/współczynnik wielomianu zostały zparsowane poprawnie
+ * @return : czy jednomiany/współczynniki wielomianu zostały sparsowane poprawnie
  */
-static poly_errcode_t parsePolyRecursive(Poly *p, const char *str, const size_t start_idx, const size_t end_idx);
+static poly_errcode_t parsePolyIterative(Poly *p, StrView str);
 
 /**
- * Funkcja konstruująca wielomian współczynnikowy.
- * @see : parsePolyRecursive()
+ * Parsuje współczynnik zaczynający się na pozycji @p *pos w @p str
+ * i przesuwa @p *pos za jego ostatnią cyfrę.
+ * @see : parsePolyIterative()
  *
- * @param[in, out] p : wielomian
+ * @param[out] p : wielomian współczynnikowy
  * @param[in] str : wielomian jako string
- * @param[in] start_idx : indeks, od którego rozpoczyna się wielomian w @p str
- * @param[in] end_idx : indeks, na którym kończy się wielomian w @p str
+ * @param[in, out] pos : pozycja w @p str
  *
- * @return : czy wielomian współczynnikowy został sparsowany poprawnie
+ * @return : czy współczynnik został sparsowany poprawnie
  */
-static poly_errcode_t parseCoeffPoly(Poly *p, const char *str, const size_t start_idx, const size_t end_idx);
+static poly_errcode_t parseCoeff(Poly *p, StrView str, size_t *pos);
 
 /**
- * Funkcja parsująca wielomian niewspółczynnikowy. Wypisuje na wyjście
- * diagnostyczne komunikaty błędu, jeśli konwersja się nie powiedzie.
- * @see : parsePolyRecursive()
+ * Parsuje wykładnik następujący po przecinku na pozycji @p *pos w @p str
+ * i przesuwa @p *pos za jego ostatnią cyfrę.
+ * @see : parsePolyIterative()
  *
- * @param[in, out] p : wielomian
+ * @param[out] exp : wykładnik
  * @param[in] str : wielomian jako string
- * @param[in] start_idx : indeks, od którego rozpoczyna się wielomian w @p str
- * @param[in] end_idx : indeks, na którym kończy się wielomian w @p str
- *
- * @return : czy wielomian niewspółczynnikowy został sparsowany poprawnie
- */
-static poly_errcode_t parseNonCoeffPoly(Poly *p, const char *str, const size_t start_idx, const size_t end_idx);
-
-/**
- * Konstruuje jednomian w oparciu o string.
- * @see : parsePoly()
- *
- * @param[in, out] m : jednomian
- * @param[in] str : string
- * @param[in] start_idx : indeks, od którego rozpoczyna się jednomian w @p str
- * @param[in] end_idx : indeks, na którym kończy się jednomian w @p str
+ * @param[in, out] pos : pozycja przecinka w @p str
  *
- * @return : czy wielomian i współczynnik jednomianu zostały zparsowane poprawnie
+ * @return : czy wykładnik został sparsowany poprawnie
  */
-static poly_errcode_t parseMonoRecursive(Mono *m, const char *str, const size_t start_idx, const size_t end_idx);
+static poly_errcode_t parseExp(poly_exp_t *exp, StrView str, size_t *pos);
 
 
 
-static bool doesStringRepresentPoly(const char *str)
+static bool doesStringRepresentPoly(StrView str)
 {
-    size_t str_len = strlen(str);
-
-    if (str_len == 0 || (str_len == 1 && !isdigit(str[0]))) {
+    if (str.len == 0 || (str.len == 1 && !isdigit(str.ptr[0]))) {
         return false;
     }
-    if (str[0] == '-' || isdigit(str[0])) {
+    if (str.ptr[0] == '-' || isdigit(str.ptr[0])) {
         return doesStringRepresentCoeffPoly(str);
     }
-    if (str[0] == '(') {
+    if (str.ptr[0] == '(') {
         return doesStringRepresentNonCoeffPoly(str);
     }
     return false;
 }
 
-static bool doesStringRepresentCoeffPoly(const char *str)
+static bool doesStringRepresentCoeffPoly(StrView str)
 {
-    if (str[0] == '-') {
-        for (size_t i = 1; i < strlen(str); i++) {
-            if (!isdigit(str[i])) {
+    if (str.ptr[0] == '-') {
+        for (size_t i = 1; i < str.len; i++) {
+            if (!isdigit(str.ptr[i])) {
                 return false;
             }
         }
         return true;
     }
-    if (isdigit(str[0])) {
-        for (size_t i = 0; i < strlen(str); i++) {
-            if (!isdigit(str[i])) {
+    if (isdigit(str.ptr[0])) {
+        for (size_t i = 0; i < str.len; i++) {
+            if (!isdigit(str.ptr[i])) {
                 return false;
             }
         }
@@ -130,10 +112,11 @@ static bool doesStringRepresentCoeffPoly(const char *str)
     return false;
 }
 
-static bool doesStringRepresentNonCoeffPoly(const char *str)
+static bool doesStringRepresentNonCoeffPoly(StrView str)
 {
-    size_t str_len = strlen(str);
-    if (str[0] != '(' || ((str[0] == '(') && str[str_len - 1] != ')')) {
+    const char *s = str.ptr;
+    size_t str_len = str.len;
+    if (s[0] != '(' || ((s[0] == '(') && s[str_len - 1] != ')')) {
         return false;
     }
     bool // flagi poprawności notacji
@@ -142,39 +125,39 @@ static bool doesStringRepresentNonCoeffPoly(const char *str)
     int pars = 0;
     size_t i = 0;
     while (i < str_len) {
-        if (str[i] == '-' && minus) {
+        if (s[i] == '-' && minus) {
             minus = false; open_par = false; plus = false; comma = false; close_par = false; digit = true; coeff = true;
             i++;
         }
-        else if (isdigit(str[i]) && digit) {
+        else if (isdigit(s[i]) && digit) {
             if (coeff) {
-                while (isdigit(str[i])) {
+                while (i < str_len && isdigit(s[i])) {
                     i++;
                 }
                 minus = false; digit = false; open_par = false; plus = false; close_par = false; comma = true; coeff = false;
             }
             else {
-                while (isdigit(str[i])) {
+                while (i < str_len && isdigit(s[i])) {
                     i++;
                 }
                 minus = false; digit = false; open_par = false; plus = false; comma = false;
                 close_par = true; coeff = true;
             }
         }
-        else if (str[i] == '(' && open_par) {
+        else if (s[i] == '(' && open_par) {
             pars++;
             plus = false; comma = false; close_par = false; minus = true; digit = true; open_par = true; coeff = true;
             i++;
         }
-        else if (str[i] == '+' && plus) {
+        else if (s[i] == '+' && plus) {
             minus = false; digit = false; plus = false; comma = false; close_par = false; open_par = true;
             i++;
         }
-        else if (str[i] == ',' && comma) {
+        else if (s[i] == ',' && comma) {
             minus = false;open_par = false;plus = false;comma = false; close_par = false; digit = true; coeff = false;
             i++;
         }
-        else if (str[i] == ')' && close_par) {
+        else if (s[i] == ')' && close_par) {
             pars--; // dopasowano nawias
             if (pars < 0) {
                 return false; // znaleziono zamykajacy bez otwierajacego na stosie
@@ -187,175 +170,134 @@ static bool doesStringRepresentNonCoeffPoly(const char *str)
     return (pars == 0);
 }
 
-static poly_errcode_t parseCoeffPoly(Poly *p, const char *str, const size_t start_idx, const size_t end_idx)
+static poly_errcode_t parseCoeff(Poly *p, StrView str, size_t *pos)
 {
     poly_coeff_t sign = 1;
-    size_t new_start = start_idx;
+    unsigned long long coeff;
 
-    if (str[start_idx] == '-') {
+    if (str.ptr[*pos] == '-') {
         sign = -1;
-        new_start++;
+        (*pos)++;
     }
-    if (isdigit(str[new_start])) {
-        size_t buff_len = 0;    // zliczenie długości buforu współczynnika
-        for (size_t i = 0; isdigit(str[new_start + i]) && i <= end_idx; i++) {
-            buff_len++;
-        }
-        char *preprocessedCoeff = safeCalloc(buff_len + 1, sizeof(char));
+    if (!StrViewParseDigits(str, pos, MAX_COEFF, &coeff)) {
+        return POLY_ERR;    // input nie reprezentuje liczby lub overflow/underflow
+    }
+    *p = PolyFromCoeff((poly_coeff_t)coeff * sign);
+    return POLY_OK;
+}
 
-        for (size_t i = 0; i < buff_len; i++) {
-            preprocessedCoeff[i] = str[new_start + i];    // zapisywanie cyfr do buforu współczynnika
-        }
-        char *endptr = NULL;    // konwersja i przypisanie współczynnika wielomianowi
-        errno = 0;
-        poly_coeff_t coeff = strtol(preprocessedCoeff, &endptr, DECIMAL);
-        free(preprocessedCoeff);
+static poly_errcode_t parseExp(poly_exp_t *exp, StrView str, size_t *pos)
+{
+    unsigned long long res;
 
-        if ((coeff == 0 && (errno != 0 || endptr == preprocessedCoeff)) || !IS_VALID_COEFF(coeff)) {
-            return POLY_ERR;    // input nie reprezentuje liczby lub overflow/underflow
-        }
-        else {
-            *p = PolyFromCoeff(coeff * sign);
-            return POLY_OK;
-        }
+    (*pos)++;    // pominięcie przecinka
+    if (!StrViewParseDigits(str, pos, MAX_EXP, &res)) {
+        return POLY_ERR;    // input nie reprezentuje liczby lub overflow
     }
-    return POLY_ERR;
+    *exp = (poly_exp_t)res;
+    return POLY_OK;
 }
 
-static poly_errcode_t parseNonCoeffPoly(Poly *p, const char *str, const size_t start_idx, const size_t end_idx)
+static poly_errcode_t parsePolyIterative(Poly *p, StrView str)
 {
-    size_t depth = 0, monos_count = 1;
+    vector_t *monos = VectorNew(sizeof(Mono), INIT_CAP);     // jednomiany wszystkich budowanych wielomianów
+    vector_t *levels = VectorNew(sizeof(size_t), INIT_CAP);  // indeksy w monos, od których zaczynają się kolejne poziomy
+    CHECK_POINTER(monos);
+    CHECK_POINTER(levels);
 
-    for (size_t i = start_idx; i <= end_idx; i++) {
-        if (str[i] == '+' && depth == 0) {    // zliczanie jaki jest rozmiar tablicy jednomianów
-            monos_count++;
-        }
-        else if (str[i] == '(') {
-            depth++;
+    Poly curr = PolyZero();    // ostatni w pełni zbudowany wielomian
+    poly_errcode_t res = POLY_OK;
+    size_t i = 0;
+
+    while (i < str.len && res == POLY_OK) {
+        char c = str.ptr[i];
+
+        if (c == '(') {
+            if (i == 0 || str.ptr[i - 1] == '(') {    // nawias otwiera pierwszy jednomian nowego wielomianu
+                if (VectorPush(levels, &monos->size) != VECT_OK) {
+                    exit(EXIT_FAILURE);
+                }
+            }
+            i++;
         }
-        else if (str[i] == ')') {
-            depth--;
+        else if (c == '-' || isdigit(c)) {
+            res = parseCoeff(&curr, str, &i);
         }
-    }
-    Mono *monosArr = safeMalloc(monos_count * sizeof(Mono));
-
-    // znajdowanie i parsowanie jednomianów oraz przypisywanie ich wielomianowi
-    size_t mono_start_idx = 0, mono_end_idx = 0, k = 0; depth = 0;
-    for (size_t i = start_idx; i <= end_idx; i++) {
-        if (str[i] == '(') {
-            if (depth == 0) {
-                mono_start_idx = i + 1;
+        else if (c == ',') {
+            Mono m = { .p = curr };
+            res = parseExp(&m.exp, str, &i);
+
+            if (res == POLY_OK) {
+                if (VectorPush(monos, &m) != VECT_OK) {
+                    exit(EXIT_FAILURE);
+                }
+                curr = PolyZero();    // współczynnik przeszedł na własność jednomianu
             }
-            depth++;
         }
-        else if (str[i] == ')') {
-            depth--;
-            if (depth == 0) {
-                mono_end_idx = i - 1;
-                if (parseMonoRecursive(monosArr + k, str, mono_start_idx, mono_end_idx) != POLY_OK) {
-                    free(monosArr);
-                    return POLY_ERR;
-                }
-                k++;
+        else if (c == ')') {
+            i++;
+            if (i == str.len || str.ptr[i] == ',') {    // koniec ostatniego jednomianu na danym poziomie
+                size_t base = *(size_t *) VectorPop(levels);
+                curr = PolyAddMonos(monos->size - base, (Mono *) VectorAt(monos, base));
+                monos->size = base;
             }
         }
+        else {
+            i++;    // '+' pomiędzy jednomianami
+        }
     }
-    *p = PolyAddMonos(monos_count, monosArr);
-    free(monosArr);
-    return POLY_OK;
-}
-
-static poly_errcode_t parsePolyRecursive(Poly *p, const char *str, const size_t start_idx, const size_t end_idx)
-{
-    if (str[start_idx] == '-' || isdigit(str[start_idx])) {
-        return parseCoeffPoly(p, str, start_idx, end_idx);
-    }
-    else if (str[start_idx] == '(') {
-        return parseNonCoeffPoly(p, str, start_idx, end_idx);
-    }
-    return POLY_ERR;
-}
-
-static poly_errcode_t parseMonoRecursive(Mono *m, const char *str, const size_t start_idx, const size_t end_idx)
-{
-    size_t comma_index = end_idx;
-    while (str[comma_index] != ',') {
-        comma_index--;        // wyszukanie ostatniego przecinka od końca
-    }
-
-    char *preprocessedExp = safeCalloc((end_idx - comma_index + 1), sizeof(char));
-    for (size_t k = 1; isdigit(str[comma_index + k]); k++) {
-        preprocessedExp[k - 1] = str[comma_index + k];    // zapisywanie zawartości stringa po przecinku do buforu wykładnika
-    }
-
-    char *endptr = NULL;    //konwersja i przypisanie wykładnika
-    errno = 0;
-    long exp = strtol(preprocessedExp, &endptr, DECIMAL);
-    free(preprocessedExp);
 
-    if ((exp == 0 && (errno != 0 || endptr == preprocessedExp))|| !IS_VALID_EXP(exp)) {
-        // input nie reprezentuje liczby lub overflow/underflow
-        return POLY_ERR;
+    if (res == POLY_OK) {
+        *p = curr;
     }
     else {
-        m->exp = (poly_exp_t)exp;
-    }
-
-    if (parsePolyRecursive(&m->p, str, start_idx, comma_index - 1) != POLY_OK) {
-        return POLY_ERR;    //konwersja i przypisanie jednomianu
+        PolyDestroy(&curr);
+        for (size_t k = 0; k < monos->size; k++) {
+            MonoDestroy((Mono *) VectorAt(monos, k));
+        }
     }
-    return POLY_OK;
+    VectorDestroy(monos);
+    VectorDestroy(levels);
+    return res;
 }
 
 
 
-void detectLineType(Line *line, const size_t index, char *str, const long long nread)
+void detectLineType(Line *line, const size_t index, StrView str)
 {
     line->index = index;
+    line->text = str;
 
-    if (str == NULL || strcmp(str, "\n") == 0 || str[0] == '#') {
+    if (str.len == 0 || StrViewEquals(str, "\n") || str.ptr[0] == '#') {
         line->type = IGNORED;
         return;
     }
-    if (isalpha(str[0])) {
-        if ((size_t)nread != strlen(str)) {
-            line->type = IGNORED;
-            fprintf(stderr, "ERROR %zu WRONG COMMAND\n", line->index);
-        }
-        else {
-            line->type = CMD_LINE;
-            str[strcspn(str, "\n")] = '\0';
-        }
+    bool has_nul = memchr(str.ptr, '\0', str.len) != NULL;    // wiersz zawiera znaki '\0'
+
+    if (isalpha(str.ptr[0])) {
+        line->type = has_nul ? WRONG_CMD_LINE : CMD_LINE;
     }
     else {
-        if ((size_t)nread != strlen(str)) {
-            line->type = IGNORED;    // wiersz zawiera za dużo znaków '\0'
-            fprintf(stderr, "ERROR %zu WRONG POLY\n", line->index);
-        }
-        else {
-            line->type = POLY_LINE;
-            str[strcspn(str, "\n")] = '\0';
-        }
+        line->type = has_nul ? WRONG_POLY_LINE : POLY_LINE;
+    }
+    if (str.ptr[str.len - 1] == '\n') {
+        line->text.len--;
     }
 }
 
-poly_errcode_t parsePoly(Poly *p, const char *str, const Line line)
+poly_errcode_t parsePoly(Poly *p, StrView str)
 {
     if (!doesStringRepresentPoly(str)) {
-        fprintf(stderr, "ERROR %zu WRONG POLY\n", line.index);
         return POLY_ERR;
     }
-    if (parsePolyRecursive(p, str, 0, strlen(str) - 1) == POLY_OK) {
-        if (!PolyIsCoeff(p)) {
-            Mono monoArr[p->size];
-            memcpy(monoArr, p->arr, p->size * sizeof(Mono));
-            free(p->arr);
-            *p = PolyAddMonos(p->size, monoArr);
-        }
-        return POLY_OK;
-    }
-    else {
-        fprintf(stderr, "ERROR %zu WRONG POLY\n", line.index);
-        return POLY_ERR;
+    return parsePolyIterative(p, str);
+}
+
+void parseLine(Line *line, const size_t index, StrView str)
+{
+    detectLineType(line, index, str);
+
+    if (line->type == POLY_LINE && parsePoly(&line->contents.poly, line->text) != POLY_OK) {
+        line->type = WRONG_POLY_LINE;
     }
 }
\ No newline at end of file
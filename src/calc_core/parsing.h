@@ -24,28 +24,39 @@ typedef enum poly_errcode_t
 } poly_errcode_t;
 
 /**
- * Wczytuje linię ze standardowego wejścia, odnotowuje czy zawiera ona
- * wielomian czy polecenie kalkulatora, indeksuje ją.
+ * Odnotowuje czy linia zawiera wielomian czy polecenie kalkulatora, indeksuje ją
+ * i zapisuje w @p line->text jej treść bez znaku końca linii.
+ * Nie wypisuje błędów - linie z niepoprawną zawartością oznacza typem
+ * WRONG_CMD_LINE lub WRONG_POLY_LINE.
  *
  * @param[in, out] line : struktura przechowująca informacje o linii
  * @param[in] index : indeks, który zostanie przypisany linii
- * @param[in] str : linia reprezentowana stringiem
- * @param[in] nread : ilość wczytanych znaków w linii (do '\n' albo EOF)
+ * @param[in] str : wczytana linia (do '\n' włącznie albo do EOF)
  */
-void detectLineType(Line *line, const size_t index, char *str, const long long nread);
+void detectLineType(Line *line, const size_t index, StrView str);
 
 /**
- * Konstruuje wielomian w oparciu o string @p str. Wypisuje na wyjście
- * diagnostyczne komunikaty błędu wraz z indeksem linii,
- * jeśli konwersja się nie powiodła i kasuje pamięć dotychczas zbudowanej struktury.
+ * Konstruuje wielomian w oparciu o tekst @p str. Jeśli konwersja
+ * się nie powiodła, kasuje pamięć dotychczas zbudowanej struktury.
  *
  * @param[in] p : wielomian
- * @param[in] str : string
- * @param[in] line : linia, przechowująca swój indeks
+ * @param[in] str : tekst wielomianu (niekoniecznie zakończony znakiem '\0')
  *
  * @return : czy udało się stworzyć wielomian
  */
-poly_errcode_t parsePoly(Poly *p, const char *str, const Line line);
+poly_errcode_t parsePoly(Poly *p, StrView str);
+
+/**
+ * Rozpoznaje typ linii, a jeśli zawiera ona wielomian, to go konstruuje
+ * i umieszcza w @p line->contents.poly. Nie wypisuje błędów ani nie modyfikuje
+ * tekstu linii, więc może być wywoływana równolegle dla różnych linii.
+ * @see detectLineType(), parsePoly()
+ *
+ * @param[in, out] line : struktura przechowująca informacje o linii
+ * @param[in] index : indeks, który zostanie przypisany linii
+ * @param[in] str : wczytana linia (do '\n' włącznie albo do EOF)
+ */
+void parseLine(Line *line, const size_t index, StrView str);
 
 
 #endif //__PARSING_H__
@@ -0,0 +1,203 @@
+/** @file
+  Implementacja potokowego przetwarzania wejścia kalkulatora wielomianów rzadkich wielu zmiennych
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#include "calc.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <time.h>
+
+/**
+ * Liczba linii, które mogą jednocześnie znajdować się w potoku.
+ * Musi być potęgą dwójki.
+ */
+#define PIPELINE_CAPACITY 1024u
+
+/**
+ * Liczba nieudanych prób, po których oczekujący wątek zaczyna usypiać.
+ */
+#define SPINS_BEFORE_SLEEP 64u
+
+/**
+ * Czas usypiania oczekującego wątku (w nanosekundach).
+ */
+#define BACKOFF_SLEEP_NS 20000L
+
+/**
+ * Wartość oznaczająca, że wejście nie zostało jeszcze wczytane do końca.
+ */
+#define NO_EOF ((size_t) -1)
+
+/**
+ * Stan miejsca w buforze cyklicznym potoku.
+ */
+typedef enum SlotState {
+    SLOT_FREE,    ///< Miejsce czeka na wczytanie linii
+    SLOT_READ,    ///< Linia wczytana, czeka na parsowanie
+    SLOT_PARSED   ///< Linia sparsowana, czeka na wykonanie
+} SlotState;
+
+/**
+ * Miejsce w buforze cyklicznym, przez które linia przechodzi
+ * kolejno przez wszystkie etapy potoku.
+ */
+typedef struct PipelineSlot {
+    atomic_int state;   ///< Stan miejsca (SlotState)
+    atomic_size_t seq;  ///< Numer kolejny (od zera) przechowywanej linii
+    char *buf;          ///< Bufor linii, używany ponownie przez kolejne linie
+    size_t cap;         ///< Rozmiar bufora
+    StrView text;       ///< Wczytana linia (w buforze lub w odwzorowanym pliku)
+    Line line;          ///< Linia po parsowaniu
+} PipelineSlot;
+
+/**
+ * Stan potoku współdzielony przez jego etapy.
+ */
+typedef struct Pipeline {
+    PipelineSlot slots[PIPELINE_CAPACITY];  ///< Bufor cykliczny linii
+    InputSource *input;                     ///< Źródło linii
+    size_t firstLine;                       ///< Indeks pierwszej linii wejścia
+    atomic_size_t parseCursor;              ///< Numer kolejnej linii do wzięcia przez wątek parsujący
+    atomic_size_t eofSeq;                   ///< Liczba wszystkich linii wejścia lub NO_EOF
+} Pipeline;
+
+
+
+/**
+ * Czeka chwilę przed ponownym sprawdzeniem warunku - najpierw
+ * oddając procesor, a po @ref SPINS_BEFORE_SLEEP próbach usypiając.
+ *
+ * @param[in, out] spins : licznik dotychczasowych prób
+ */
+static void backoff(unsigned *spins);
+
+/**
+ * Etap czytający: dzieli wejście na linie
+ * i umieszcza je w kolejnych miejscach bufora.
+ *
+ * @param[in, out] arg : potok
+ *
+ * @return : NULL
+ */
+static void *readerLoop(void *arg);
+
+/**
+ * Etap parsujący: bierze kolejne wczytane linie, rozpoznaje ich typ
+ * i konstruuje zawarte w nich wielomiany.
+ *
+ * @param[in, out] arg : potok
+ *
+ * @return : NULL
+ */
+static void *parserLoop(void *arg);
+
+
+
+static void backoff(unsigned *spins)
+{
+    if (++*spins < SPINS_BEFORE_SLEEP) {
+        sched_yield();
+    }
+    else {
+        struct timespec ts = { .tv_sec = 0, .tv_nsec = BACKOFF_SLEEP_NS };
+        nanosleep(&ts, NULL);
+    }
+}
+
+static void *readerLoop(void *arg)
+{
+    Pipeline *pipe = arg;
+
+    for (size_t seq = 0; ; seq++) {
+        PipelineSlot *slot = &pipe->slots[seq & (PIPELINE_CAPACITY - 1)];
+        unsigned spins = 0;
+
+        while (atomic_load_explicit(&slot->state, memory_order_acquire) != SLOT_FREE) {
+            backoff(&spins);    // wykonawca nie zwolnił jeszcze linii sprzed PIPELINE_CAPACITY miejsc
+        }
+        if (!InputNextLine(pipe->input, &slot->buf, &slot->cap, &slot->text)) {
+            atomic_store_explicit(&pipe->eofSeq, seq, memory_order_release);
+            return NULL;
+        }
+        atomic_store_explicit(&slot->seq, seq, memory_order_relaxed);
+        atomic_store_explicit(&slot->state, SLOT_READ, memory_order_release);
+    }
+}
+
+static void *parserLoop(void *arg)
+{
+    Pipeline *pipe = arg;
+
+    while (true) {
+        size_t seq = atomic_fetch_add_explicit(&pipe->parseCursor, 1, memory_order_relaxed);
+        PipelineSlot *slot = &pipe->slots[seq & (PIPELINE_CAPACITY - 1)];
+        unsigned spins = 0;
+
+        while (atomic_load_explicit(&slot->state, memory_order_acquire) != SLOT_READ
+               || atomic_load_explicit(&slot->seq, memory_order_relaxed) != seq) {
+            if (seq >= atomic_load_explicit(&pipe->eofSeq, memory_order_acquire)) {
+                PolyWorkspaceFree();
+                return NULL;
+            }
+            backoff(&spins);
+        }
+        parseLine(&slot->line, pipe->firstLine + seq, slot->text);
+        atomic_store_explicit(&slot->state, SLOT_PARSED, memory_order_release);
+    }
+}
+
+
+
+void runPipelined(Menu *menu, size_t workers)
+{
+    Pipeline *pipe = safeCalloc(1, sizeof(Pipeline));
+    pthread_t reader, parsers[workers];
+
+    pipe->input = &menu->input;
+    pipe->firstLine = menu->firstLine;
+    atomic_init(&pipe->parseCursor, 0);
+    atomic_init(&pipe->eofSeq, NO_EOF);
+    for (size_t i = 0; i < PIPELINE_CAPACITY; i++) {
+        atomic_init(&pipe->slots[i].state, SLOT_FREE);
+    }
+
+    if (pthread_create(&reader, NULL, readerLoop, pipe) != 0) {
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < workers; i++) {
+        if (pthread_create(&parsers[i], NULL, parserLoop, pipe) != 0) {
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    for (size_t seq = 0; ; seq++) {    // etap wykonujący, w kolejności wejścia
+        PipelineSlot *slot = &pipe->slots[seq & (PIPELINE_CAPACITY - 1)];
+        unsigned spins = 0;
+
+        while (atomic_load_explicit(&slot->state, memory_order_acquire) != SLOT_PARSED) {
+            if (seq >= atomic_load_explicit(&pipe->eofSeq, memory_order_acquire)) {
+                break;
+            }
+            backoff(&spins);
+        }
+        if (atomic_load_explicit(&slot->state, memory_order_acquire) != SLOT_PARSED) {
+            break;    // przetworzono wszystkie linie
+        }
+        processLine(menu, slot->line);
+        atomic_store_explicit(&slot->state, SLOT_FREE, memory_order_release);
+    }
+
+    pthread_join(reader, NULL);
+    for (size_t i = 0; i < workers; i++) {
+        pthread_join(parsers[i], NULL);
+    }
+    for (size_t i = 0; i < PIPELINE_CAPACITY; i++) {
+        free(pipe->slots[i].buf);
+    }
+    free(pipe);
+}
@@ -0,0 +1,532 @@
+/** @file
+  Implementacja trybu serwera kalkulatora wielomianów rzadkich wielu zmiennych
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#include "server.h"
+#include <pthread.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * Liczba bajtów wczytywanych z połączenia za jednym razem. Po ich
+ * wykonaniu sesja wraca do kolejki, więc długi skrypt jednej sesji
+ * nie blokuje pozostałych.
+ */
+#define SESSION_READ_CHUNK 65536
+
+/**
+ * Największa liczba zdarzeń odbieranych jednym wywołaniem epoll_wait().
+ */
+#define SERVER_MAX_EVENTS 64
+
+/**
+ * Długość znacznika strumienia poprzedzającego każdą odsyłaną linię.
+ */
+#define STREAM_TAG_LEN 2
+
+/**
+ * Stan sesji po jej obsłużeniu przez wątek puli.
+ */
+typedef enum SessionState {
+    SESSION_READ,     ///< Sesja czeka na kolejne dane od klienta
+    SESSION_WRITE,    ///< Sesja czeka, aż klient odbierze zaległe wyjście
+    SESSION_CLOSE     ///< Sesja zakończyła się
+} SessionState;
+
+struct Session;
+
+/**
+ * Strumień wyjściowy sesji, dopisujący wypisywane linie,
+ * poprzedzone znacznikiem, do bufora wyjścia sesji.
+ */
+typedef struct SessionStream {
+    struct Session *session;    ///< Sesja
+    const char *tag;            ///< Znacznik strumienia
+    bool lineStart;             ///< Czy kolejny bajt rozpoczyna linię
+} SessionStream;
+
+/**
+ * Sesja - jedno połączenie wraz z własnym kalkulatorem.
+ */
+typedef struct Session {
+    int fd;                     ///< Gniazdo połączenia
+    Menu menu;                  ///< Menu z kalkulatorem sesji
+    SessionStream streams[2];   ///< Strumienie wyników i błędów
+    char *in;                   ///< Wczytane, jeszcze niewykonane dane
+    size_t inLen;               ///< Liczba bajtów w @p in
+    size_t inCap;               ///< Pojemność @p in
+    char *out;                  ///< Wyjście do odesłania
+    size_t outLen;              ///< Liczba bajtów w @p out
+    size_t outCap;              ///< Pojemność @p out
+    size_t sent;                ///< Liczba odesłanych już bajtów @p out
+    size_t lineIndex;           ///< Indeks ostatniej wykonanej linii
+    bool eof;                   ///< Czy klient zakończył wysyłanie
+    struct Session *queueNext;  ///< Następna sesja w kolejce do obsłużenia
+    struct Session *prev;       ///< Poprzednia sesja na liście wszystkich sesji
+    struct Session *next;       ///< Następna sesja na liście wszystkich sesji
+} Session;
+
+/**
+ * Stan serwera współdzielony przez wątek nasłuchujący i pulę wątków.
+ */
+typedef struct Server {
+    int listenFd;               ///< Gniazdo nasłuchujące
+    int signalFd;               ///< Deskryptor sygnałów kończących pracę
+    int epollFd;                ///< Instancja epoll
+    pthread_mutex_t lock;       ///< Chroni kolejkę, listę sesji i @p stopping
+    pthread_cond_t ready;       ///< Sygnalizuje sesję w kolejce lub zakończenie
+    Session *queueHead;         ///< Początek kolejki sesji gotowych do obsłużenia
+    Session *queueTail;         ///< Koniec kolejki
+    Session *sessions;          ///< Lista wszystkich otwartych sesji
+    bool stopping;              ///< Czy serwer kończy pracę
+} Server;
+
+
+
+/**
+ * Zapewnia miejsce na co najmniej @p extra kolejnych bajtów w buforze.
+ *
+ * @param[in, out] buf : bufor
+ * @param[in] len : liczba bajtów w buforze
+ * @param[in, out] cap : pojemność bufora
+ * @param[in] extra : liczba bajtów
+ */
+static void BufferReserve(char **buf, size_t len, size_t *cap, size_t extra);
+
+/**
+ * Funkcja zapisu strumienia sesji (dla fopencookie()).
+ *
+ * @param[in, out] cookie : strumień sesji
+ * @param[in] buf : zapisywane dane
+ * @param[in] size : liczba bajtów
+ *
+ * @return : liczba zapisanych bajtów
+ */
+static ssize_t SessionStreamWrite(void *cookie, const char *buf, size_t size);
+
+/**
+ * Tworzy sesję dla nowego połączenia.
+ *
+ * @param[in] fd : gniazdo połączenia
+ *
+ * @return : sesja
+ */
+static Session *SessionNew(int fd);
+
+/**
+ * Zamyka połączenie i zwalnia sesję wraz z jej kalkulatorem.
+ *
+ * @param[in, out] s : sesja
+ */
+static void SessionDestroy(Session *s);
+
+/**
+ * Wykonuje wszystkie pełne linie wczytane przez sesję,
+ * a po zakończeniu wysyłania przez klienta - także niepełną ostatnią.
+ *
+ * @param[in, out] s : sesja
+ */
+static void SessionExecute(Session *s);
+
+/**
+ * Odsyła klientowi zaległe wyjście sesji, na ile pozwala gniazdo.
+ *
+ * @param[in, out] s : sesja
+ *
+ * @return : czy nie wystąpił błąd połączenia
+ */
+static bool SessionFlush(Session *s);
+
+/**
+ * Obsługuje sesję zgłoszoną przez epoll: odsyła zaległe wyjście,
+ * a gdy go nie ma - wczytuje i wykonuje kolejną porcję danych.
+ *
+ * @param[in, out] s : sesja
+ *
+ * @return : stan sesji po obsłużeniu
+ */
+static SessionState SessionServe(Session *s);
+
+/**
+ * Przyjmuje wszystkie oczekujące połączenia i rejestruje ich sesje.
+ *
+ * @param[in, out] server : serwer
+ */
+static void ServerAccept(Server *server);
+
+/**
+ * Wstawia sesję do kolejki i budzi jeden z wątków puli.
+ *
+ * @param[in, out] server : serwer
+ * @param[in] s : sesja
+ */
+static void ServerEnqueue(Server *server, Session *s);
+
+/**
+ * Pętla wątku puli: obsługuje kolejne sesje z kolejki i ponownie
+ * zgłasza je do epoll albo zamyka.
+ *
+ * @param[in, out] arg : serwer
+ *
+ * @return : NULL
+ */
+static void *ServerWorker(void *arg);
+
+/**
+ * Tworzy gniazdo nasłuchujące, deskryptor sygnałów i instancję epoll.
+ *
+ * @param[in, out] server : serwer
+ * @param[in] path : ścieżka gniazda
+ *
+ * @return : czy się udało
+ */
+static bool ServerOpen(Server *server, const char *path);
+
+
+
+static void BufferReserve(char **buf, size_t len, size_t *cap, size_t extra)
+{
+    if (*cap - len < extra) {
+        while (*cap - len < extra) {
+            *cap = (*cap == 0) ? extra : *cap * 2;
+        }
+        *buf = safeRealloc(*buf, *cap);
+    }
+}
+
+static ssize_t SessionStreamWrite(void *cookie, const char *buf, size_t size)
+{
+    SessionStream *stream = cookie;
+    Session *s = stream->session;
+
+    for (size_t i = 0; i < size; ) {
+        const char *newline = memchr(buf + i, '\n', size - i);
+        size_t len = (newline == NULL) ? size - i : (size_t)(newline - (buf + i)) + 1;
+
+        BufferReserve(&s->out, s->outLen, &s->outCap, len + STREAM_TAG_LEN);
+        if (stream->lineStart) {
+            memcpy(s->out + s->outLen, stream->tag, STREAM_TAG_LEN);
+            s->outLen += STREAM_TAG_LEN;
+        }
+        memcpy(s->out + s->outLen, buf + i, len);
+        s->outLen += len;
+        stream->lineStart = (newline != NULL);
+        i += len;
+    }
+    return (ssize_t) size;
+}
+
+static Session *SessionNew(int fd)
+{
+    Session *s = safeCalloc(1, sizeof(Session));
+    cookie_io_functions_t io = { .write = SessionStreamWrite };
+
+    s->fd = fd;
+    s->streams[0] = (SessionStream) { .session = s, .tag = "1 ", .lineStart = true };
+    s->streams[1] = (SessionStream) { .session = s, .tag = "2 ", .lineStart = true };
+
+    CalcInit(&s->menu.calc);
+    s->menu.calc.out = fopencookie(&s->streams[0], "w", io);
+    s->menu.calc.err = fopencookie(&s->streams[1], "w", io);
+    CHECK_POINTER(s->menu.calc.out);
+    CHECK_POINTER(s->menu.calc.err);
+    setvbuf(s->menu.calc.out, NULL, _IONBF, 0);    // zachowuje kolejność linii obu strumieni
+    setvbuf(s->menu.calc.err, NULL, _IONBF, 0);
+    InputOpenStream(&s->menu.input, NULL);
+    s->menu.firstLine = 1;
+    return s;
+}
+
+static void SessionDestroy(Session *s)
+{
+    CalcDestroy(&s->menu.calc);
+    fclose(s->menu.calc.out);
+    fclose(s->menu.calc.err);
+    close(s->fd);
+    free(s->in);
+    free(s->out);
+    free(s);
+}
+
+static void SessionExecute(Session *s)
+{
+    size_t start = 0;
+
+    while (start < s->inLen) {
+        const char *newline = memchr(s->in + start, '\n', s->inLen - start);
+
+        if (newline == NULL && !s->eof) {
+            break;    // linia nie została jeszcze przesłana do końca
+        }
+        size_t len = (newline == NULL) ? s->inLen - start : (size_t)(newline - (s->in + start)) + 1;
+        Line line;
+
+        parseLine(&line, ++s->lineIndex, StrViewMake(s->in + start, len));
+        processLine(&s->menu, line);
+        start += len;
+    }
+    memmove(s->in, s->in + start, s->inLen - start);
+    s->inLen -= start;
+}
+
+static bool SessionFlush(Session *s)
+{
+    while (s->sent < s->outLen) {
+        ssize_t n = send(s->fd, s->out + s->sent, s->outLen - s->sent, MSG_NOSIGNAL);
+
+        if (n >= 0) {
+            s->sent += (size_t) n;
+        }
+        else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return true;
+        }
+        else if (errno != EINTR) {
+            return false;
+        }
+    }
+    s->outLen = 0;
+    s->sent = 0;
+    return true;
+}
+
+static SessionState SessionServe(Session *s)
+{
+    if (!SessionFlush(s)) {
+        return SESSION_CLOSE;
+    }
+    if (s->outLen > 0) {
+        return SESSION_WRITE;    // nie czytamy dalej, dopóki klient nie odbierze wyjścia
+    }
+    if (s->eof) {
+        return SESSION_CLOSE;
+    }
+
+    BufferReserve(&s->in, s->inLen, &s->inCap, SESSION_READ_CHUNK);
+    ssize_t n = recv(s->fd, s->in + s->inLen, SESSION_READ_CHUNK, 0);
+
+    if (n == 0) {
+        s->eof = true;
+    }
+    else if (n < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? SESSION_READ : SESSION_CLOSE;
+    }
+    else {
+        s->inLen += (size_t) n;
+    }
+
+    SessionExecute(s);
+    if (!SessionFlush(s)) {
+        return SESSION_CLOSE;
+    }
+    if (s->outLen > 0) {
+        return SESSION_WRITE;
+    }
+    return s->eof ? SESSION_CLOSE : SESSION_READ;
+}
+
+static void ServerAccept(Server *server)
+{
+    while (true) {
+        int fd = accept4(server->listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        if (fd == -1) {
+            return;    // brak kolejnych połączeń (lub błąd pojedynczego połączenia)
+        }
+        Session *s = SessionNew(fd);
+        struct epoll_event ev = { .events = EPOLLIN | EPOLLONESHOT, .data.ptr = s };
+
+        pthread_mutex_lock(&server->lock);
+        s->next = server->sessions;
+        if (server->sessions != NULL) {
+            server->sessions->prev = s;
+        }
+        server->sessions = s;
+        pthread_mutex_unlock(&server->lock);
+
+        if (epoll_ctl(server->epollFd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+            ServerEnqueue(server, s);    // wątek puli wykryje błąd połączenia i zamknie sesję
+        }
+    }
+}
+
+static void ServerEnqueue(Server *server, Session *s)
+{
+    pthread_mutex_lock(&server->lock);
+    s->queueNext = NULL;
+    if (server->queueTail != NULL) {
+        server->queueTail->queueNext = s;
+    }
+    else {
+        server->queueHead = s;
+    }
+    server->queueTail = s;
+    pthread_cond_signal(&server->ready);
+    pthread_mutex_unlock(&server->lock);
+}
+
+static void *ServerWorker(void *arg)
+{
+    Server *server = arg;
+
+    while (true) {
+        pthread_mutex_lock(&server->lock);
+        while (!server->stopping && server->queueHead == NULL) {
+            pthread_cond_wait(&server->ready, &server->lock);
+        }
+        if (server->stopping) {
+            pthread_mutex_unlock(&server->lock);
+            break;
+        }
+        Session *s = server->queueHead;
+        server->queueHead = s->queueNext;
+        if (server->queueHead == NULL) {
+            server->queueTail = NULL;
+        }
+        pthread_mutex_unlock(&server->lock);
+
+        SessionState state = SessionServe(s);
+
+        pthread_mutex_lock(&server->lock);    // zmiany sesji widoczne dla wątku, który obsłuży ją następnie
+        if (state != SESSION_CLOSE) {    // EPOLLONESHOT - sesję obsługuje naraz tylko jeden wątek
+            struct epoll_event ev = {
+                .events = (state == SESSION_READ ? EPOLLIN : EPOLLOUT) | EPOLLONESHOT,
+                .data.ptr = s
+            };
+            if (epoll_ctl(server->epollFd, EPOLL_CTL_MOD, s->fd, &ev) == 0) {
+                pthread_mutex_unlock(&server->lock);
+                continue;
+            }
+        }
+        if (s->prev != NULL) {
+            s->prev->next = s->next;
+        }
+        else {
+            server->sessions = s->next;
+        }
+        if (s->next != NULL) {
+            s->next->prev = s->prev;
+        }
+        pthread_mutex_unlock(&server->lock);
+        SessionDestroy(s);
+    }
+
+    PolyWorkspaceFree();
+    return NULL;
+}
+
+static bool ServerOpen(Server *server, const char *path)
+{
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    sigset_t signals;
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        return false;
+    }
+    strcpy(addr.sun_path, path);
+
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);    // dziedziczone przez wątki puli
+
+    server->listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    server->signalFd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    server->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (server->listenFd == -1 || server->signalFd == -1 || server->epollFd == -1) {
+        return false;
+    }
+
+    mode_t mask = umask(S_IRWXG | S_IRWXO);    // gniazdo dostępne tylko dla właściciela
+    int res = bind(server->listenFd, (struct sockaddr *) &addr, sizeof(addr));
+    umask(mask);
+    if (res == -1) {
+        return false;
+    }
+    if (listen(server->listenFd, SOMAXCONN) == -1) {
+        unlink(path);
+        return false;
+    }
+
+    struct epoll_event listen_ev = { .events = EPOLLIN, .data.ptr = &server->listenFd };
+    struct epoll_event signal_ev = { .events = EPOLLIN, .data.ptr = &server->signalFd };
+    if (epoll_ctl(server->epollFd, EPOLL_CTL_ADD, server->listenFd, &listen_ev) == -1
+        || epoll_ctl(server->epollFd, EPOLL_CTL_ADD, server->signalFd, &signal_ev) == -1) {
+        unlink(path);
+        return false;
+    }
+    return true;
+}
+
+
+
+bool runServer(const char *path, size_t workers)
+{
+    Server server = { .listenFd = -1, .signalFd = -1, .epollFd = -1 };
+    pthread_t threads[workers];
+    bool ok = ServerOpen(&server, path);
+
+    if (!ok) {
+        int fds[] = { server.listenFd, server.signalFd, server.epollFd };
+        for (size_t i = 0; i < sizeof(fds) / sizeof(fds[0]); i++) {
+            if (fds[i] != -1) {
+                close(fds[i]);
+            }
+        }
+        return false;
+    }
+    pthread_mutex_init(&server.lock, NULL);
+    pthread_cond_init(&server.ready, NULL);
+    for (size_t i = 0; i < workers; i++) {
+        if (pthread_create(&threads[i], NULL, ServerWorker, &server) != 0) {
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    bool stop = false;
+    while (!stop) {
+        struct epoll_event events[SERVER_MAX_EVENTS];
+        int n = epoll_wait(server.epollFd, events, SERVER_MAX_EVENTS, -1);
+
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.ptr == &server.listenFd) {
+                ServerAccept(&server);
+            }
+            else if (events[i].data.ptr == &server.signalFd) {
+                stop = true;
+            }
+            else {
+                ServerEnqueue(&server, events[i].data.ptr);
+            }
+        }
+    }
+
+    pthread_mutex_lock(&server.lock);
+    server.stopping = true;
+    pthread_cond_broadcast(&server.ready);
+    pthread_mutex_unlock(&server.lock);
+    for (size_t i = 0; i < workers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    while (server.sessions != NULL) {    // sesje przerwane zakończeniem pracy serwera
+        Session *s = server.sessions;
+        server.sessions = s->next;
+        SessionDestroy(s);
+    }
+    close(server.listenFd);
+    close(server.signalFd);
+    close(server.epollFd);
+    unlink(path);
+    pthread_cond_destroy(&server.ready);
+    pthread_mutex_destroy(&server.lock);
+    return true;
+}
@@ -0,0 +1,44 @@
+/** @file
+  Interfejs trybu serwera kalkulatora wielomianów rzadkich wielu zmiennych
+
+  Serwer nasłuchuje na gnieździe domeny Uniksa. Każde połączenie to osobna
+  sesja z własnym kalkulatorem i stosem, a sesje obsługuje wspólna pula
+  wątków. Klient wysyła linie w zwykłym formacie wejścia kalkulatora,
+  a serwer odsyła każdą linię wyjścia poprzedzoną numerem strumienia,
+  na który trafiłaby przy pracy na standardowym wejściu: `1 ` dla wyników
+  i `2 ` dla błędów. Kolejność linii obu strumieni jest zachowana.
+  Zamknięcie połączenia przez klienta kończy sesję - serwer wykonuje
+  wtedy ewentualną niezakończoną ostatnią linię, odsyła wynik i zamyka
+  połączenie.
+
+  Komendy operujące na plikach działają w systemie plików serwera
+  i z jego uprawnieniami, dlatego gniazdo dostępne jest wyłącznie
+  dla właściciela procesu.
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#ifndef __SERVER_H__
+#define __SERVER_H__
+
+#include "calc.h"
+
+/**
+ * Największa liczba wątków obsługujących sesje.
+ */
+#define SERVER_MAX_WORKERS 256
+
+/**
+ * Uruchamia serwer na gnieździe @p path i obsługuje sesje aż do
+ * otrzymania sygnału SIGINT lub SIGTERM. Po zakończeniu usuwa gniazdo.
+ *
+ * @param[in] path : ścieżka gniazda (nie może jeszcze istnieć)
+ * @param[in] workers : liczba wątków obsługujących sesje
+ *
+ * @return : czy udało się utworzyć gniazdo i uruchomić serwer
+ */
+bool runServer(const char *path, size_t workers);
+
+#endif //__SERVER_H__
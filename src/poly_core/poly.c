@@ -8,6 +8,9 @@
 */
 
 #include "poly.h"
+#include "poly_mod.h"
+#include "poly_simd.h"
+#include "../utils/vector.h"
 
 /**
  * Konwencja przyjęta w treści zadania.
@@ -30,60 +33,132 @@
  */
 #define MAX(a,b) (a >= b)? a : b
 
+/**
+ * Początkowa pojemność stosu roboczego (w ramkach).
+ */
+#define WORK_STACK_INIT_CAP 64
 
+/**
+ * Największa liczba jednomianów, dla której PolyPower() rozwija potęgę
+ * wzorem wielomianowym (zob. PolyPowMultinomial()).
+ */
+#define POW_MULTINOMIAL_MAX_TERMS 3
 
 /**
- * Funkcja porównująca dla jednomianów, dokonuje porównania
- * wykładników jednomianów dla sortowania w kolejności malejącej.
- *
- * @param[in] a : jednomian
- * @param[in] b : jednomian
+ * Największy wykładnik rozwinięcia dwumianowego (dwa jednomiany) - wiersz
+ * trójkąta Pascala liczony jest w czasie kwadratowym względem wykładnika.
+ */
+#define POW_BINOMIAL_MAX_EXP 4096
+
+/**
+ * Największy wykładnik rozwinięcia wielomianowego dla trzech jednomianów -
+ * przechowywane są wszystkie potęgi reszty wielomianu.
+ */
+#define POW_MULTINOMIAL_MAX_EXP 64
+
+/**
+ * Największa szerokość okna potęgowania (zob. PolyPowWindow()).
+ */
+#define POW_MAX_WINDOW 4
+
+/**
+ * Najmniejszy wykładnik potęgowany metodą okna - dla mniejszych mnożenia
+ * przez (małą) podstawę w zwykłym potęgowaniu są tańsze niż mniej liczne
+ * mnożenia przez jej wyższe potęgi.
+ */
+#define POW_WINDOW_MIN_EXP 32
+
+/**
+ * Największy wykładnik, dla którego PolyPower() rozważa potęgowanie
+ * kolejnymi mnożeniami przez podstawę (zob. PolyPowByBaseIsCheaper()).
+ */
+#define POW_BY_BASE_MAX_EXP 1024
+
+/**
+ * Liczba jednomianów, powyżej której oszacowania rozmiaru potęg nie są
+ * dokładniej liczone - takie potęgi i tak nie zmieszczą się w pamięci.
+ */
+#define POW_ESTIMATE_CAP 1e18
+
+/**
+ * Ramka stosu roboczego, używanego przez iteracyjne przejścia
+ * po drzewie wielomianu w miejsce rekurencji.
+ */
+typedef struct PolyFrame {
+    const Poly *p;        ///< aktualnie przetwarzany wielomian
+    union {
+        const Poly *q;    ///< drugi z porównywanych wielomianów (PolyIsEq())
+        Poly *out;        ///< wielomian docelowy (PolyClone(), PolyNegateCoeffs())
+        size_t depth;     ///< głębokość wielomianu w drzewie (PolyDegBy())
+        poly_exp_t acc;   ///< suma wykładników na ścieżce od korzenia (PolyDeg())
+        Poly dead;        ///< wielomian do zwolnienia (PolyDestroy())
+        struct {
+            uint64_t value;   ///< wartość dotychczasowych jednomianów według schematu Hornera
+            size_t next;      ///< indeks kolejnego jednomianu
+        } eval;           ///< stan wartościowania (PolyEvalPoint())
+    };
+} PolyFrame;
+
+/**
+ * Stos roboczy zachowany do ponownego użycia przez bieżący wątek.
+ */
+static _Thread_local vector_t *cachedWorkStack = NULL;
+
+
+
+/**
+ * Pobiera stos roboczy - zachowany wcześniej przez bieżący wątek
+ * lub, jeśli jest on właśnie w użyciu, nowo zaalokowany.
  *
- * @return Porównanie wykładników
+ * @return : pusty stos ramek PolyFrame
  */
-static int MonoCompDescending(const void *a, const void *b);
+static vector_t *WorkStackAcquire(void);
 
 /**
- * Sprawdza, czy wielomian jest tożsamościowo równy jedynce.
+ * Oddaje stos roboczy pobrany przez WorkStackAcquire().
+ * @see WorkStackAcquire()
  *
- * @param[in] p : wielomian
+ * @param[in] stack : stos roboczy
+ */
+static void WorkStackRelease(vector_t *stack);
+
+/**
+ * Odkłada ramkę na stos roboczy.
+ * Zakańcza działanie programu przy braku pamięci.
  *
- * @return Czy wielomian jest równy jedynce?
+ * @param[in, out] stack : stos roboczy
+ * @param[in] frame : ramka
  */
-static inline bool PolyIsOne(const Poly *p);
+static inline void WorkStackPush(vector_t *stack, PolyFrame frame);
 
 /**
- * Zwraca stopień jednomianu ze względu na zadaną zmienną (-1 dla wielomianu
- * tożsamościowo równego zeru). Zmienne indeksowane są od 0.
- * Zmienna o indeksie 0 oznacza zmienną główną tego jednomianu.
- * Większe indeksy oznaczają zmienne wielomianów znajdujących się
- * we współczynnikach.
+ * Zdejmuje ramkę ze szczytu niepustego stosu roboczego.
  *
- * @param[in] m : jednomian
- * @param[in] var_idx : indeks zmiennej
+ * @param[in, out] stack : stos roboczy
  *
- * @return stopień wielomianu @p m z względu na zmienną o indeksie @p var_idx
+ * @return : zdjęta ramka
  */
-static poly_exp_t MonoDegBy(const Mono *m, size_t var_idx);
+static inline PolyFrame WorkStackPop(vector_t *stack);
 
 /**
- * Zwraca stopień jednomianu.
+ * Funkcja porównująca dla jednomianów, dokonuje porównania
+ * wykładników jednomianów dla sortowania w kolejności malejącej.
  *
- * @param[in] m : jednomian
+ * @param[in] a : jednomian
+ * @param[in] b : jednomian
  *
- * @return stopień jednomianu @p m
+ * @return Porównanie wykładników
  */
-static poly_exp_t MonoDeg(const Mono *m);
+static int MonoCompDescending(const void *a, const void *b);
 
 /**
- * Sprawdza równość dwóch jednomianów.
+ * Sprawdza, czy wielomian jest tożsamościowo równy jedynce.
  *
- * @param[in] m1 : jednomian
- * @param[in] m2 : jednomian
+ * @param[in] p : wielomian
  *
- * @return Czy m1 równa się m2
+ * @return Czy wielomian jest równy jedynce?
  */
-static bool MonoIsEq(const Mono *m1, const Mono *m2);
+static inline bool PolyIsOne(const Poly *p);
 
 /**
  * Sprawdza czy wielomian jest postaci x_0^0*c
@@ -96,7 +171,8 @@ static bool MonoIsEq(const Mono *m1, const Mono *m2);
 static inline bool PolyIsCoeffBetter(const Poly *p);
 
 /**
- * Funkcja potęgująca dla liczb całkowitych.
+ * Funkcja potęgująca dla liczb całkowitych (modulo moduł współczynników,
+ * jeśli go ustawiono).
  *
  * @param[in] base : podstawa
  * @param[in] exp : wykładnik
@@ -108,14 +184,17 @@ static poly_coeff_t ipow(poly_coeff_t base, poly_exp_t exp);
 /**
  * Lączy ze sobą wyrazy podobne obu wielomianów,
  * zwraca wielomian będący ich połączeniem. Zwalnia
- * pamięć obu argumentów.
+ * pamięć obu argumentów, a ich jednomiany przenosi do wyniku.
+ * Przy @p negate wynikiem jest różnica - znaki współczynników @p q
+ * zmieniane są w trakcie łączenia, bez tworzenia wielomianu przeciwnego.
  *
  * @param[in] p : wielomian
  * @param[in] q : wielomian
+ * @param[in] negate : czy odjąć @p q zamiast go dodać
  *
  * @return : wielomian stworzony w oparciu o dwa składowe
 */
-static Poly PolyMerge(Poly *p, Poly *q);
+static Poly PolyMerge(Poly *p, Poly *q, bool negate);
 
 /**
  * Tworzy posortowane połączenie dwóch wielomianów niebędących
@@ -124,10 +203,25 @@ static Poly PolyMerge(Poly *p, Poly *q);
  *
  * @param[in] p : wielomian
  * @param[in] q : wielomian
+ * @param[in] negate : czy odjąć @p q zamiast go dodać
  *
  * @return : wielomian stworzony w oparciu o dwa składowe
 */
-static Poly PolyMergingIntersect(Poly *p, Poly *q);
+static Poly PolyMergingIntersect(Poly *p, Poly *q, bool negate);
+
+/**
+ * Tworzy sumę lub różnicę dwóch wielomianów bez zmieniania ich,
+ * w jednym przejściu: wspólne wykładniki łączone są rekurencyjnie,
+ * a pozostałe poddrzewa kopiowane (z @p q - ze zmienionymi znakami).
+ * Alokuje wyłącznie pamięć wyniku.
+ *
+ * @param[in] p : wielomian
+ * @param[in] q : wielomian
+ * @param[in] negate : czy odjąć @p q zamiast go dodać
+ *
+ * @return : @f$p + q@f$ lub @f$p - q@f$
+*/
+static Poly PolyCombine(const Poly *p, const Poly *q, bool negate);
 
 /**
  * Funkcja pomocnicza dla PolyAt(), bierze @p m->p,
@@ -176,13 +270,16 @@ static void PolySimplifyByMerging(Poly *p, size_t count, Mono *sourceMonos);
 static void PolyCleanFromZeros(Poly *p);
 
 /**
- * Podnosi wielomian @p p do kwadratu.
+ * Podnosi wielomian @p p do kwadratu. Korzysta z symetrii iloczynu:
+ * dla @f$p = \sum_i a_i x^{e_i}@f$ liczy kwadraty @f$a_i^2@f$ (rekurencyjnie
+ * tą samą funkcją) oraz każdy iloczyn mieszany @f$2a_i a_j@f$, @f$i < j@f$,
+ * tylko raz - zamiast dwóch iloczynów @f$a_i a_j@f$ i @f$a_j a_i@f$.
  *
  * @param[in] p : wielomian
  *
  * @return : p^2
 */
-static inline Poly PolySquare(Poly *p);
+static Poly PolySquare(const Poly *p);
 
 /**
  * Podnosi wielomian @p base do potęgi @p exp.
@@ -195,6 +292,208 @@ static inline Poly PolySquare(Poly *p);
 */
 static Poly PolyPow(const Poly *base, poly_exp_t exp);
 
+/**
+ * Obcina wielomian do jednomianów stopnia (całkowitego) co najwyżej @p d.
+ *
+ * @param[in] p : wielomian
+ * @param[in] d : ograniczenie stopnia
+ *
+ * @return : nowy wielomian - jednomiany @p p stopnia co najwyżej @p d
+*/
+static Poly PolyTruncate(const Poly *p, long long d);
+
+/**
+ * Wylicza stopnie (całkowite) współczynników kolejnych jednomianów wielomianu.
+ *
+ * @param[in] p : wielomian niebędący współczynnikiem
+ *
+ * @return : tablica @p p->size stopni (do zwolnienia przez free())
+*/
+static poly_exp_t *MonoDegs(const Poly *p);
+
+/**
+ * Mnoży wielomiany, pomijając jednomiany stopnia większego niż @p d.
+ * Pary jednomianów, których iloczyn ma za duży wykładnik, są pomijane przed
+ * mnożeniem, a pary, których iloczyn w całości mieści się w ograniczeniu
+ * (według stopni współczynników), mnożone są zwykłym PolyMul().
+ *
+ * @param[in] p : wielomian
+ * @param[in] q : wielomian
+ * @param[in] d : ograniczenie stopnia (nieujemne)
+ *
+ * @return : @f$p * q@f$ obcięty do stopnia @p d
+*/
+static Poly PolyMulTruncBounded(const Poly *p, const Poly *q, long long d);
+
+/**
+ * Podnosi wielomian do kwadratu jak PolySquare(), pomijając jednomiany
+ * stopnia większego niż @p d.
+ *
+ * @param[in] p : wielomian
+ * @param[in] d : ograniczenie stopnia (nieujemne)
+ *
+ * @return : @f$p^2@f$ obcięty do stopnia @p d
+*/
+static Poly PolySquareTrunc(const Poly *p, long long d);
+
+/**
+ * Podnosi wielomian do potęgi jak PolyPow(), obcinając każdy wynik
+ * pośredni do stopnia @p d.
+ *
+ * @param[in] base : podstawa (wielomian)
+ * @param[in] exp : wykładnik
+ * @param[in] d : ograniczenie stopnia
+ *
+ * @return : @f$base^{exp}@f$ obcięty do stopnia @p d
+*/
+static Poly PolyPowTrunc(const Poly *base, poly_exp_t exp, long long d);
+
+/**
+ * Sprawdza, czy wielomian jest gęstym wielomianem jednej zmiennej - warstwą
+ * liści, w której występuje co najmniej połowa wykładników od 0 do stopnia.
+ * Dla takich wielomianów najszybsze jest potęgowanie przez PolyPow().
+ *
+ * @param[in] p : wielomian niebędący współczynnikiem
+ *
+ * @return : czy wielomian jest gęsty
+*/
+static bool PolyIsDense(const Poly *p);
+
+/**
+ * Liczy jednomiany wielomianu w postaci rozwiniętej (liście drzewa)
+ * oraz jego zmienne.
+ *
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @param[out] vars : liczba zmiennych (głębokość drzewa)
+ *
+ * @return : liczba jednomianów
+*/
+static size_t PolyTermCount(const Poly *p, size_t *vars);
+
+/**
+ * Oblicza @f$\binom{a + b}{b}@f$ w przybliżeniu zmiennoprzecinkowym,
+ * nie licząc dokładniej wartości większych niż @ref POW_ESTIMATE_CAP.
+ *
+ * @param[in] a : liczba
+ * @param[in] b : liczba
+ *
+ * @return : @f$\binom{a + b}{b}@f$
+*/
+static double BinomialEstimate(size_t a, size_t b);
+
+/**
+ * Szacuje z góry liczbę jednomianów potęgi wielomianu.
+ *
+ * @param[in] i : wykładnik
+ * @param[in] terms : liczba jednomianów wielomianu (zob. PolyTermCount())
+ * @param[in] vars : liczba zmiennych wielomianu
+ * @param[in] deg : stopień wielomianu
+ *
+ * @return : oszacowanie liczby jednomianów potęgi
+*/
+static double PowTermsEstimate(size_t i, size_t terms, size_t vars, size_t deg);
+
+/**
+ * Sprawdza, czy potęgę wielomianu taniej policzyć kolejnymi mnożeniami
+ * przez podstawę niż podnoszeniem do kwadratu. Liczbę jednomianów
+ * @f$p^i@f$ ogranicza z góry mniejsza z liczb: jednomianów stopnia
+ * co najwyżej @f$iD@f$ w @f$v@f$ zmiennych i iloczynów @f$i@f$ spośród
+ * @f$T@f$ jednomianów podstawy. Mnożenia przez podstawę kosztują
+ * @f$T \sum_{i<n} |p^i|@f$ mnożeń jednomianów, a samo ostatnie podniesienie
+ * do kwadratu - @f$|p^{n/2}|^2/2@f$. Potęgi gęstych wielomianów wielu
+ * zmiennych rosną wielomianowo względem wykładnika i wtedy wygrywają
+ * mnożenia przez podstawę; potęgi gęstych wielomianów jednej zmiennej
+ * nadal taniej liczyć przez PolyPow().
+ *
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @param[in] exp : wykładnik
+ *
+ * @return : czy wybrać PolyPowByBase()
+*/
+static bool PolyPowByBaseIsCheaper(const Poly *p, poly_exp_t exp);
+
+/**
+ * Podnosi wielomian do potęgi kolejnymi mnożeniami przez podstawę.
+ *
+ * @param[in] base : podstawa (wielomian)
+ * @param[in] exp : wykładnik (dodatni)
+ *
+ * @return : base^exp
+*/
+static Poly PolyPowByBase(const Poly *base, poly_exp_t exp);
+
+/**
+ * Podnosi jednomian (wielomian o jednym jednomianie) do potęgi:
+ * @f$(a x^u)^{exp} = a^{exp} x^{u \cdot exp}@f$.
+ *
+ * @param[in] base : wielomian o jednym jednomianie
+ * @param[in] exp : wykładnik
+ *
+ * @return : base^exp
+*/
+static Poly PolyPowMonomial(const Poly *base, poly_exp_t exp);
+
+/**
+ * Podnosi wielomian o kilku jednomianach do potęgi wzorem wielomianowym.
+ * Dla @f$base = a x^u + r@f$, gdzie @f$r@f$ to pozostałe jednomiany,
+ * @f$base^n = \sum_k \binom{n}{k} a^k x^{ku} r^{n-k}@f$ - potęgi @f$a@f$
+ * i @f$r@f$ liczone są kolejnymi mnożeniami przez mały czynnik, a dla dwóch
+ * jednomianów wszystkie wyrazy sumy mają różne wykładniki.
+ *
+ * @param[in] base : wielomian o co najmniej dwóch jednomianach
+ * @param[in] exp : wykładnik
+ *
+ * @return : base^exp
+*/
+static Poly PolyPowMultinomial(const Poly *base, poly_exp_t exp);
+
+/**
+ * Podnosi wielomian do potęgi metodą okna przesuwnego: wykładnik czytany
+ * jest od najstarszego bitu oknami kończącymi się jedynką, a każde okno
+ * to jedno mnożenie przez wcześniej policzoną nieparzystą potęgę podstawy.
+ * Liczone są tylko potęgi potrzebne dla danego wykładnika.
+ *
+ * @param[in] base : podstawa (wielomian)
+ * @param[in] exp : wykładnik (dodatni)
+ *
+ * @return : base^exp
+*/
+static Poly PolyPowWindow(const Poly *base, poly_exp_t exp);
+
+/**
+ * Tworzy ramkę wartościowania wielomianu w punkcie. Gdy zmienna ma
+ * wartość 0, liczy się tylko wyraz wolny, więc pozostałe jednomiany
+ * są od razu pomijane.
+ *
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @param[in] x : wartość zmiennej wielomianu @p p
+ *
+ * @return : ramka
+*/
+static PolyFrame EvalFrameMake(const Poly *p, uint64_t x);
+
+/**
+ * Dolicza do ramki wartościowania wartość kolejnego jednomianu
+ * (bez czynnika @f$x^{exp}@f$) według schematu Hornera:
+ * @f$acc \cdot x^{e_{i-1} - e_i} + v@f$.
+ *
+ * @param[in, out] frame : ramka
+ * @param[in] x : wartość zmiennej
+ * @param[in] v : wartość współczynnika jednomianu
+*/
+static void EvalFrameAccumulate(PolyFrame *frame, uint64_t x, uint64_t v);
+
+/**
+ * Zwraca wartość zmiennej o danym indeksie (0 dla zmiennych spoza punktu).
+ *
+ * @param[in] var_idx : indeks zmiennej
+ * @param[in] n : liczba współrzędnych punktu
+ * @param[in] x : współrzędne punktu
+ *
+ * @return : wartość zmiennej (reszta, gdy ustawiono moduł)
+*/
+static inline uint64_t EvalVariable(size_t var_idx, size_t n, const poly_coeff_t x[]);
+
 /**
  * Zwraca wyraz wolny wielomianu. W przypadku jego braku,
  * zwraca zero.
@@ -207,6 +506,43 @@ static Poly PolyReturnConstantTerm(const Poly *p);
 
 
 
+static vector_t *WorkStackAcquire(void)
+{
+    vector_t *stack = cachedWorkStack;
+
+    if (stack != NULL) {
+        cachedWorkStack = NULL;
+        return stack;
+    }
+    stack = VectorNew(sizeof(PolyFrame), WORK_STACK_INIT_CAP);
+    CHECK_POINTER(stack);
+    return stack;
+}
+
+static void WorkStackRelease(vector_t *stack)
+{
+    VectorClear(stack);
+
+    if (cachedWorkStack == NULL) {
+        cachedWorkStack = stack;
+    }
+    else {
+        VectorDestroy(stack);    // stos zagnieżdżonego wywołania
+    }
+}
+
+static inline void WorkStackPush(vector_t *stack, PolyFrame frame)
+{
+    if (VectorPush(stack, &frame) != VECT_OK) {
+        exit(EXIT_FAILURE);
+    }
+}
+
+static inline PolyFrame WorkStackPop(vector_t *stack)
+{
+    return *(PolyFrame *) VectorPop(stack);
+}
+
 static inline bool PolyIsCoeffBetter(const Poly *p)
 {
     return !PolyIsCoeff(p) && p->size == 1 && PolyIsCoeff(&p->arr[0].p) && (p->arr[0].exp == 0 || p->arr[0].p.coeff == 0);
@@ -231,49 +567,25 @@ static int MonoCompDescending(const void *a, const void *b)
     return 0;
 }
 
-static poly_exp_t MonoDegBy(const Mono *m, size_t var_idx)
-{
-    if (var_idx == 0) {
-        return MonoGetExp(m);    // nie zagłębia się dalej niż stopień szukanej zmiennej
-    }
-    else {
-        return PolyDegBy(&m->p, var_idx - 1);
-    }
-}
-
-static poly_exp_t MonoDeg(const Mono *m)
-{
-    return m->exp + PolyDeg(&m->p);
-}
-
 static poly_coeff_t ipow(poly_coeff_t base, poly_exp_t exp)
 {
     assert (exp >= 0);
 
-    if (exp == 0 || base == 1) {
-        return 1;
-    }
-    if (exp == 1) {
-        return base;
-    }
-
-    poly_coeff_t temp = ipow(base, exp / 2);
-
-    if (exp % 2 == 0) {
-        return temp * temp;
-    }
-    else {
-        return base * temp * temp;
-    }
+    return (poly_coeff_t) ModPow(ModReduce(base), (uint64_t) exp);
 }
 
-static Poly PolyMerge(Poly *p, Poly *q)
+static Poly PolyMerge(Poly *p, Poly *q, bool negate)
 {
     if (PolyIsCoeff(p) && PolyIsCoeff(q)) {
-        return PolyFromCoeff(p->coeff + q->coeff);
+        return PolyFromCoeff((poly_coeff_t) (negate ? ModSub((uint64_t) p->coeff, (uint64_t) q->coeff)
+                                                    : ModAdd((uint64_t) p->coeff, (uint64_t) q->coeff)));
+    }
+    if (negate && (PolyIsCoeff(p) || PolyIsCoeff(q))) {    // q i tak trafi do wyniku w całości
+        PolyNegateCoeffs(q);
+        negate = false;
     }
     if (PolyIsCoeff(q)) {
-        return PolyMerge(q, p);
+        return PolyMerge(q, p, false);
     }
 
     Poly res;
@@ -284,7 +596,7 @@ static Poly PolyMerge(Poly *p, Poly *q)
         res.size = q->size;
 
         if (MonoGetExp(&q->arr[q->size - 1]) == EXP_OF_COEFF) {
-            Poly temp = PolyMerge(&q->arr[q->size - 1].p, p);
+            Poly temp = PolyMerge(&q->arr[q->size - 1].p, p, false);
 
             if (!PolyIsZero(&temp)) {
                 res.arr = safeMalloc(res.size * sizeof(Mono));
@@ -305,12 +617,12 @@ static Poly PolyMerge(Poly *p, Poly *q)
         free(q->arr);
     }
     else {
-        res = PolyMergingIntersect(p, q);
+        res = PolyMergingIntersect(p, q, negate);
     }
     return PolyExtractContents(&res);
 }
 
-static Poly PolyMergingIntersect(Poly *p, Poly *q)
+static Poly PolyMergingIntersect(Poly *p, Poly *q, bool negate)
 {
     assert (!PolyIsCoeff(p) && !PolyIsCoeff(q));
 
@@ -322,6 +634,9 @@ static Poly PolyMergingIntersect(Poly *p, Poly *q)
     while (i < p->size || j < q->size) {
         if (i == p->size) {
             while (k < new_size && j < q->size) {   // dołączanie pozostałych jednomianów z q do res->arr
+                if (negate) {
+                    PolyNegateCoeffs(&q->arr[j].p);
+                }
                 res.arr[k++] = q->arr[j++];
             }
         }
@@ -334,11 +649,21 @@ static Poly PolyMergingIntersect(Poly *p, Poly *q)
             res.arr[k++] = p->arr[i++];
         }
         else if (MonoGetExp(&p->arr[i]) < MonoGetExp(&q->arr[j])){
+            if (negate) {
+                PolyNegateCoeffs(&q->arr[j].p);
+            }
             res.arr[k++] = q->arr[j++];
         }
         else {
             new_size -= 1;
-            Poly temp = PolyMerge(&p->arr[i].p, &q->arr[j].p);
+            Poly temp;
+            if (PolyIsCoeff(&p->arr[i].p) && PolyIsCoeff(&q->arr[j].p)) {    // liście sumowane bez wywołania PolyMerge()
+                uint64_t a = (uint64_t) p->arr[i].p.coeff, b = (uint64_t) q->arr[j].p.coeff;
+                temp = PolyFromCoeff((poly_coeff_t) (negate ? ModSub(a, b) : ModAdd(a, b)));
+            }
+            else {
+                temp = PolyMerge(&p->arr[i].p, &q->arr[j].p, negate);
+            }
 
             if (!PolyIsZero(&temp)) {
                 res.arr[k++] = MonoFromPoly(&temp, MonoGetExp(&p->arr[i]));
@@ -360,6 +685,60 @@ static Poly PolyMergingIntersect(Poly *p, Poly *q)
     return res;
 }
 
+static Poly PolyCombine(const Poly *p, const Poly *q, bool negate)
+{
+    if (PolyIsCoeff(p) && PolyIsCoeff(q)) {
+        return PolyFromCoeff((poly_coeff_t) (negate ? ModSub((uint64_t) p->coeff, (uint64_t) q->coeff)
+                                                    : ModAdd((uint64_t) p->coeff, (uint64_t) q->coeff)));
+    }
+    if (PolyIsZero(p) || PolyIsZero(q)) {
+        Poly res = PolyClone(PolyIsZero(p) ? q : p);
+        if (negate && PolyIsZero(p)) {
+            PolyNegateCoeffs(&res);
+        }
+        return res;
+    }
+    if (PolyIsCoeff(p) || PolyIsCoeff(q)) {    // współczynnik c traktowany jak wielomian (c, 0)
+        Mono wrapped = { .p = PolyIsCoeff(p) ? *p : *q, .exp = EXP_OF_COEFF };
+        Poly holder = { .size = 1, .arr = &wrapped };
+        return PolyIsCoeff(p) ? PolyCombine(&holder, q, negate) : PolyCombine(p, &holder, negate);
+    }
+
+    Poly res;
+    res.size = 0;
+    res.arr = safeMalloc((p->size + q->size) * sizeof(Mono));
+
+    size_t i = 0, j = 0;
+    while (i < p->size || j < q->size) {
+        if (j == q->size || (i < p->size && MonoGetExp(&p->arr[i]) > MonoGetExp(&q->arr[j]))) {
+            res.arr[res.size++] = MonoClone(&p->arr[i++]);
+        }
+        else if (i == p->size || MonoGetExp(&p->arr[i]) < MonoGetExp(&q->arr[j])) {
+            res.arr[res.size] = MonoClone(&q->arr[j++]);
+            if (negate) {
+                PolyNegateCoeffs(&res.arr[res.size].p);
+            }
+            res.size++;
+        }
+        else {
+            Poly temp = PolyCombine(&p->arr[i].p, &q->arr[j].p, negate);
+
+            if (!PolyIsZero(&temp)) {
+                res.arr[res.size++] = MonoFromPoly(&temp, MonoGetExp(&p->arr[i]));
+            }
+            i++; j++;
+        }
+    }
+    if (res.size == 0) {
+        free(res.arr);
+        return PolyZero();
+    }
+    if (res.size < p->size + q->size) {
+        res.arr = safeRealloc(res.arr, res.size * sizeof(Mono));
+    }
+    return PolyExtractContents(&res);
+}
+
 static Mono MonoAt(const Mono *m, poly_coeff_t x)
 {
     Poly c = PolyFromCoeff(ipow(x, m->exp));
@@ -393,7 +772,7 @@ static void PolySimplifyByMerging(Poly *p, size_t count, Mono *sourceMonos)
     for (size_t i = 1; i < count; i++) {    // łączenie wyrażeń o tych samych wykładnikach
         if (!PolyIsZero(&sourceMonos[i].p)) {
             if (MonoGetExp(&p->arr[size_after_merge - 1]) == MonoGetExp(&sourceMonos[i])) {
-                p->arr[size_after_merge - 1].p = PolyMerge(&p->arr[size_after_merge - 1].p, &sourceMonos[i].p);
+                p->arr[size_after_merge - 1].p = PolyMerge(&p->arr[size_after_merge - 1].p, &sourceMonos[i].p, false);
             }
             else {
                 p->arr[size_after_merge++] = sourceMonos[i];    // umieszczanie nowego wykładnika na nowy indeks
@@ -425,6 +804,29 @@ static void PolyCleanFromZeros(Poly *p)
     }
 }
 
+static PolyFrame EvalFrameMake(const Poly *p, uint64_t x)
+{
+    PolyFrame frame = { .p = p, .eval = { .value = 0, .next = 0 } };
+
+    if (x == 0) {
+        frame.eval.next = (MonoGetExp(&p->arr[p->size - 1]) == EXP_OF_COEFF) ? p->size - 1 : p->size;
+    }
+    return frame;
+}
+
+static void EvalFrameAccumulate(PolyFrame *frame, uint64_t x, uint64_t v)
+{
+    size_t i = frame->eval.next++;
+    poly_exp_t gap = (i > 0) ? frame->p->arr[i - 1].exp - frame->p->arr[i].exp : 0;
+
+    frame->eval.value = ModAdd(ModMul(frame->eval.value, ModPow(x, (uint64_t) gap)), v);
+}
+
+static inline uint64_t EvalVariable(size_t var_idx, size_t n, const poly_coeff_t x[])
+{
+    return (var_idx < n) ? ModReduce(x[var_idx]) : 0;
+}
+
 static Poly PolyReturnConstantTerm(const Poly *p)
 {
     if (p->arr[p->size - 1].exp == EXP_OF_COEFF && PolyIsCoeff(&p->arr[p->size - 1].p)) {
@@ -460,30 +862,61 @@ Mono MonoClone(const Mono *m)
 
 void PolyDestroy(Poly *p)
 {
-    if (!PolyIsCoeff(p)) {
-        for (size_t i = 0; i < p->size; i++) {
-            MonoDestroy(&p->arr[i]);
+    if (PolyIsCoeff(p)) {
+        return;
+    }
+    vector_t *stack = WorkStackAcquire();
+    WorkStackPush(stack, (PolyFrame) { .dead = *p });
+
+    while (!VectorIsEmpty(stack)) {
+        Poly dead = WorkStackPop(stack).dead;
+
+        for (size_t i = 0; i < dead.size; i++) {
+            if (!PolyIsCoeff(&dead.arr[i].p)) {
+                WorkStackPush(stack, (PolyFrame) { .dead = dead.arr[i].p });
+            }
         }
-        free(p->arr);
-        p->arr = NULL;
+        free(dead.arr);    // poddrzewa zostały już skopiowane na stos
     }
+    WorkStackRelease(stack);
+    p->arr = NULL;
 }
 
-Poly PolyClone(const Poly *p)
+void PolyWorkspaceFree(void)
 {
-    if (PolyIsCoeff(p)) {
+    VectorDestroy(cachedWorkStack);
+    cachedWorkStack = NULL;
+}
+
+Poly PolyClone(const Poly *p)
+{
+    if (PolyIsCoeff(p)) {
         return PolyFromCoeff(p->coeff);
     }
-    else {
-        Poly clone;
-        clone.size = p->size;
-        clone.arr = safeMalloc(clone.size * sizeof(Mono));
-
-        for (size_t i = 0; i < p->size; i++) {
-            clone.arr[i] = MonoClone(&p->arr[i]);
+    Poly clone;
+    vector_t *stack = WorkStackAcquire();
+    WorkStackPush(stack, (PolyFrame) { .p = p, .out = &clone });
+
+    while (!VectorIsEmpty(stack)) {
+        PolyFrame frame = WorkStackPop(stack);
+        frame.out->size = frame.p->size;
+        frame.out->arr = safeMalloc(frame.p->size * sizeof(Mono));
+
+        for (size_t i = 0; i < frame.p->size; i++) {
+            const Mono *src = &frame.p->arr[i];
+            Mono *dst = &frame.out->arr[i];
+
+            dst->exp = src->exp;
+            if (PolyIsCoeff(&src->p)) {
+                dst->p = PolyFromCoeff(src->p.coeff);
+            }
+            else {
+                WorkStackPush(stack, (PolyFrame) { .p = &src->p, .out = &dst->p });
+            }
         }
-        return clone;
     }
+    WorkStackRelease(stack);
+    return clone;
 }
 
 Poly PolyMul(const Poly *p, const Poly *q)
@@ -491,7 +924,7 @@ Poly PolyMul(const Poly *p, const Poly *q)
     Poly prod;
 
     if (PolyIsCoeff(p) && PolyIsCoeff(q)) {
-        return PolyFromCoeff(p->coeff * q->coeff);
+        return PolyFromCoeff((poly_coeff_t) ModMul((uint64_t) p->coeff, (uint64_t) q->coeff));
     }
     if (PolyIsCoeff(p)) {
         if (PolyIsZero(p)) { return PolyZero(); }
@@ -499,11 +932,23 @@ Poly PolyMul(const Poly *p, const Poly *q)
 
         prod.size = q->size;
         prod.arr = safeMalloc(q->size * sizeof(Mono));
+        ModScalar scale = ModScalarMake((uint64_t) p->coeff);
 
-        for (size_t i = 0; i < q->size; i++) {
-            prod.arr[i].p = PolyMul(p, &q->arr[i].p);
-            prod.arr[i].exp = q->arr[i].exp;
+        if (polyModulus.m == 0 && MonosAreCoeffs(q->arr, q->size)) {    // warstwa liści - mnożenie wektorowe
+            MonosScale(prod.arr, q->arr, q->size, p->coeff);
         }
+        else {
+            for (size_t i = 0; i < q->size; i++) {
+                if (PolyIsCoeff(&q->arr[i].p)) {    // liście mnożone przez przygotowany mnożnik
+                    prod.arr[i].p = PolyFromCoeff((poly_coeff_t) ModScalarMul(scale, (uint64_t) q->arr[i].p.coeff));
+                }
+                else {
+                    prod.arr[i].p = PolyMul(p, &q->arr[i].p);
+                }
+                prod.arr[i].exp = q->arr[i].exp;
+            }
+        }
+        PolyCleanFromZeros(&prod);    // iloczyn współczynników może się przekręcić do zera
     }
     else if (PolyIsCoeff(q)) {
         return PolyMul(q, p);
@@ -525,60 +970,94 @@ Poly PolyMul(const Poly *p, const Poly *q)
 
 Poly PolyNeg(const Poly *p)
 {
-    Poly c = PolyFromCoeff(-1);
+    Poly c = PolyFromCoeff((poly_coeff_t) ModNeg(1));
     return PolyMul(p, &c);
 }
 
 Poly PolyAdd(const Poly *p, const Poly *q)
 {
-    Poly p_copy = PolyClone(p);
-    Poly q_copy = PolyClone(q);
-    return PolyMerge(&p_copy, &q_copy);
+    return PolyCombine(p, q, false);
 }
 
 Poly PolySub(const Poly *p, const Poly *q)
 {
-    Poly p_copy = PolyClone(p);
-    Poly q_neg = PolyNeg(q);
-    return PolyMerge(&p_copy, &q_neg);
+    return PolyCombine(p, q, true);
+}
+
+Poly PolyAddOwned(Poly *p, Poly *q)
+{
+    Poly res = PolyMerge(p, q, false);
+
+    *p = PolyZero();
+    *q = PolyZero();
+    return res;
+}
+
+Poly PolySubOwned(Poly *p, Poly *q)
+{
+    Poly res = PolyMerge(p, q, true);
+
+    *p = PolyZero();
+    *q = PolyZero();
+    return res;
 }
 
 poly_exp_t PolyDegBy(const Poly *p, size_t var_idx)
 {
     if (PolyIsCoeff(p)) {
-        if (p->coeff == 0) {
-            return DEG_OF_ZERO;
-        }
-        else {
-            return EXP_OF_COEFF;
-        }
+        return (p->coeff == 0) ? DEG_OF_ZERO : EXP_OF_COEFF;
     }
-    else {
-        poly_exp_t deg_by_idx = 0;
-        for (size_t i = 0; i < p->size; i++) {
-            deg_by_idx = MAX(deg_by_idx, MonoDegBy(&(p->arr[i]), var_idx));
+    poly_exp_t deg_by_idx = 0;    // współczynniki głębiej w drzewie mają stopień co najwyżej 0
+    vector_t *stack = WorkStackAcquire();
+    WorkStackPush(stack, (PolyFrame) { .p = p, .depth = 0 });
+
+    while (!VectorIsEmpty(stack)) {
+        PolyFrame frame = WorkStackPop(stack);
+
+        for (size_t i = 0; i < frame.p->size; i++) {
+            const Mono *m = &frame.p->arr[i];
+
+            if (frame.depth == var_idx) {
+                deg_by_idx = MAX(deg_by_idx, MonoGetExp(m));    // nie zagłębia się dalej niż stopień szukanej zmiennej
+            }
+            else if (!PolyIsCoeff(&m->p)) {
+                WorkStackPush(stack, (PolyFrame) { .p = &m->p, .depth = frame.depth + 1 });
+            }
         }
-        return deg_by_idx;
     }
+    WorkStackRelease(stack);
+    return deg_by_idx;
 }
 
 poly_exp_t PolyDeg(const Poly *p)
 {
     if (PolyIsCoeff(p)) {
-        if (p->coeff == 0) {
-            return DEG_OF_ZERO;
-        }
-        else {
-            return EXP_OF_COEFF;
-        }
+        return (p->coeff == 0) ? DEG_OF_ZERO : EXP_OF_COEFF;
     }
-    else {
-        poly_exp_t deg = 0;
-        for (size_t i = 0; i < p->size; i++) {
-            deg = MAX(deg, MonoDeg(&p->arr[i]));
+    poly_exp_t deg = 0;
+    vector_t *stack = WorkStackAcquire();
+    WorkStackPush(stack, (PolyFrame) { .p = p, .acc = 0 });
+
+    while (!VectorIsEmpty(stack)) {
+        PolyFrame frame = WorkStackPop(stack);
+
+        for (size_t i = 0; i < frame.p->size; i++) {
+            const Mono *m = &frame.p->arr[i];
+            poly_exp_t mono_deg = frame.acc + MonoGetExp(m);
+
+            if (PolyIsCoeff(&m->p)) {
+                if (m->p.coeff == 0) {
+                    mono_deg += DEG_OF_ZERO;
+                }
+            }
+            else {
+                WorkStackPush(stack, (PolyFrame) { .p = &m->p, .acc = mono_deg });
+            }
+            deg = MAX(deg, mono_deg);
         }
-        return deg;
     }
+    WorkStackRelease(stack);
+    return deg;
 }
 
 bool PolyIsEq(const Poly *p, const Poly *q)
@@ -586,25 +1065,81 @@ bool PolyIsEq(const Poly *p, const Poly *q)
     if (PolyIsCoeff(p) && PolyIsCoeff(q)) {
         return p->coeff == q->coeff;
     }
-    else if (PolyIsCoeff(p) || PolyIsCoeff(q)) {
+    if (PolyIsCoeff(p) || PolyIsCoeff(q)) {
         return false;
     }
-    else {
-        if (p->size != q->size) {
-            return false;
+    bool eq = true;
+    vector_t *stack = WorkStackAcquire();
+    WorkStackPush(stack, (PolyFrame) { .p = p, .q = q });
+
+    while (eq && !VectorIsEmpty(stack)) {
+        PolyFrame frame = WorkStackPop(stack);
+        size_t same = 0;
+
+        if (frame.p->size != frame.q->size) {
+            eq = false;
         }
-        for (size_t i = 0; i < p->size; i++) {
-            if (!MonoIsEq(&p->arr[i], &q->arr[i])) {
-                return false;
+        else if (frame.p->arr == frame.q->arr) {
+            continue;    // współdzielone poddrzewo (zob. poly_intern.h)
+        }
+        else {
+            same = MonosMatchPrefix(frame.p->arr, frame.q->arr, frame.p->size);    // wektorowo pomija identyczne jednomiany
+        }
+        for (size_t i = same; eq && i < frame.p->size; i++) {
+            const Mono *m1 = &frame.p->arr[i], *m2 = &frame.q->arr[i];
+
+            if (m1->exp != m2->exp) {
+                eq = false;
+            }
+            else if (PolyIsCoeff(&m1->p) || PolyIsCoeff(&m2->p)) {
+                eq = PolyIsCoeff(&m1->p) && PolyIsCoeff(&m2->p) && m1->p.coeff == m2->p.coeff;
+            }
+            else {
+                WorkStackPush(stack, (PolyFrame) { .p = &m1->p, .q = &m2->p });
             }
         }
-        return true;
     }
+    WorkStackRelease(stack);
+    return eq;
 }
 
-bool MonoIsEq(const Mono *m1, const Mono *m2)
+poly_coeff_t PolyEvalPoint(const Poly *p, size_t n, const poly_coeff_t x[])
 {
-    return m1->exp == m2->exp && PolyIsEq(&m1->p, &m2->p);
+    if (PolyIsCoeff(p)) {
+        return p->coeff;
+    }
+    uint64_t res = 0;
+    vector_t *stack = WorkStackAcquire();    // stos odpowiada ścieżce od korzenia, więc jego rozmiar to indeks zmiennej
+    WorkStackPush(stack, EvalFrameMake(p, EvalVariable(0, n, x)));
+
+    while (true) {
+        PolyFrame *top = (PolyFrame *) VectorPeek(stack);
+        uint64_t var = EvalVariable(stack->size - 1, n, x);
+
+        if (top->eval.next < top->p->size) {
+            const Poly *coeff = &top->p->arr[top->eval.next].p;
+
+            if (PolyIsCoeff(coeff)) {
+                EvalFrameAccumulate(top, var, (uint64_t) coeff->coeff);
+            }
+            else {
+                WorkStackPush(stack, EvalFrameMake(coeff, EvalVariable(stack->size, n, x)));
+            }
+        }
+        else {
+            PolyFrame done = WorkStackPop(stack);
+            uint64_t value = ModMul(done.eval.value, ModPow(var, (uint64_t) done.p->arr[done.p->size - 1].exp));
+
+            if (VectorIsEmpty(stack)) {
+                res = value;
+                break;
+            }
+            PolyFrame *parent = (PolyFrame *) VectorPeek(stack);
+            EvalFrameAccumulate(parent, EvalVariable(stack->size - 1, n, x), value);
+        }
+    }
+    WorkStackRelease(stack);
+    return (poly_coeff_t) res;
 }
 
 Poly PolyAt(const Poly *p, poly_coeff_t x)
@@ -674,6 +1209,88 @@ Poly PolyCloneMonos(size_t count, const Mono monos[])
     return p;
 }
 
+Poly PolyMulTrunc(const Poly *p, const Poly *q, poly_exp_t d)
+{
+    if (d < 0 || PolyIsZero(p) || PolyIsZero(q)) {
+        return PolyZero();
+    }
+    if ((long long) PolyDeg(p) + PolyDeg(q) <= d) {    // nic nie zostanie obcięte
+        return PolyMul(p, q);
+    }
+    return PolyMulTruncBounded(p, q, d);
+}
+
+Poly PolyPower(const Poly *p, poly_exp_t exp)
+{
+    assert (exp >= 0);
+
+    if (exp == 0 || PolyIsOne(p)) {
+        return PolyFromCoeff(1);
+    }
+    if (PolyIsCoeff(p)) {
+        return PolyFromCoeff((poly_coeff_t) ModPow((uint64_t) p->coeff, (uint64_t) exp));
+    }
+    if (exp == 1) {
+        return PolyClone(p);
+    }
+    if (p->size == 1) {
+        return PolyPowMonomial(p, exp);
+    }
+    if ((p->size == 2 && exp <= POW_BINOMIAL_MAX_EXP)
+        || (p->size <= POW_MULTINOMIAL_MAX_TERMS && exp <= POW_MULTINOMIAL_MAX_EXP)) {
+        return PolyPowMultinomial(p, exp);
+    }
+    if (PolyPowByBaseIsCheaper(p, exp)) {
+        return PolyPowByBase(p, exp);
+    }
+    if (PolyIsDense(p) || exp < POW_WINDOW_MIN_EXP) {
+        return PolyPow(p, exp);
+    }
+    return PolyPowWindow(p, exp);
+}
+
+Poly PolyComposeTrunc(const Poly *p, size_t k, const Poly q[], poly_exp_t d)
+{
+    if (d < 0) {
+        return PolyZero();
+    }
+    if (PolyIsCoeff(p)) {
+        return *p;
+    }
+    if (k == 0) {
+        return PolyReturnConstantTerm(p);
+    }
+    Mono *resMonos = safeMalloc(p->size * sizeof(Mono));
+
+    for (size_t i = 0; i < p->size; i++) {
+        if (PolyIsCoeff(&p->arr[i].p) && p->arr[i].exp == 0) {
+            resMonos[i].p = p->arr[i].p;
+        }
+        else {
+            Poly pow = PolyPowTrunc(q, p->arr[i].exp, d);
+
+            if (PolyIsZero(&pow)) {    // całe podstawienie przekracza ograniczenie
+                resMonos[i].p = pow;
+            }
+            else {
+                Poly comp = PolyComposeTrunc(&p->arr[i].p, k - 1, q + 1, d);
+                resMonos[i].p = PolyMulTrunc(&pow, &comp, d);
+                PolyDestroy(&pow);
+                PolyDestroy(&comp);
+            }
+        }
+        resMonos[i].exp = -1;   // dummy value
+    }
+
+    Poly res = PolyOwnMonos(p->size, resMonos);
+    if (PolyIsCoeff(&res)) {
+        return res;
+    }
+    Poly temp = res.arr[0].p;
+    free(res.arr);
+    return temp;
+}
+
 Poly PolyCompose(const Poly *p, size_t k, const Poly q[])
 {
     if (PolyIsCoeff(p)) {
@@ -690,7 +1307,7 @@ Poly PolyCompose(const Poly *p, size_t k, const Poly q[])
             resMonos[i].exp = -1;   // dummy value
         }
         else {
-            Poly pow = PolyPow(q, p->arr[i].exp);    // "podstawienie" pod zmienną jednomianu
+            Poly pow = PolyPower(q, p->arr[i].exp);    // "podstawienie" pod zmienną jednomianu
             Poly comp = PolyCompose(&p->arr[i].p, k - 1, q + 1);
             Poly mul = PolyMul(&pow, &comp);
             PolyDestroy(&pow);
@@ -709,9 +1326,34 @@ Poly PolyCompose(const Poly *p, size_t k, const Poly q[])
     return temp;
 }
 
-static inline Poly PolySquare(Poly *p)
+static Poly PolySquare(const Poly *p)
 {
-    return PolyMul(p, p);
+    if (PolyIsCoeff(p)) {
+        return PolyFromCoeff((poly_coeff_t) ModMul((uint64_t) p->coeff, (uint64_t) p->coeff));
+    }
+
+    Poly two = PolyFromCoeff(2);
+    Poly *doubled = safeMalloc(p->size * sizeof(Poly));    // 2a_i, by nie podwajać każdego iloczynu osobno
+    for (size_t i = 0; i < p->size; i++) {
+        doubled[i] = PolyMul(&two, &p->arr[i].p);
+    }
+
+    size_t count = p->size + p->size * (p->size - 1) / 2;
+    Mono *squareMonos = safeMalloc(count * sizeof(Mono));
+    size_t k = 0;
+    for (size_t i = 0; i < p->size; i++) {
+        squareMonos[k].exp = p->arr[i].exp + p->arr[i].exp;
+        squareMonos[k++].p = PolySquare(&p->arr[i].p);
+        for (size_t j = i + 1; j < p->size; j++) {
+            squareMonos[k].exp = p->arr[i].exp + p->arr[j].exp;
+            squareMonos[k++].p = PolyMul(&doubled[i], &p->arr[j].p);
+        }
+        PolyDestroy(&doubled[i]);
+    }
+    free(doubled);
+
+    Poly square = PolyOwnMonos(count, squareMonos);
+    return PolyExtractContents(&square);
 }
 
 static Poly PolyPow(const Poly *base, poly_exp_t exp)
@@ -740,14 +1382,449 @@ static Poly PolyPow(const Poly *base, poly_exp_t exp)
     }
 }
 
+static Poly PolyTruncate(const Poly *p, long long d)
+{
+    if (d < 0) {
+        return PolyZero();
+    }
+    if (PolyIsCoeff(p) || PolyDeg(p) <= d) {
+        return PolyClone(p);
+    }
+    Poly res;
+    res.size = 0;
+    res.arr = safeMalloc(p->size * sizeof(Mono));
+
+    for (size_t i = 0; i < p->size; i++) {
+        if (p->arr[i].exp <= d) {
+            Poly coeff = PolyTruncate(&p->arr[i].p, d - p->arr[i].exp);
+
+            if (!PolyIsZero(&coeff)) {
+                res.arr[res.size++] = (Mono) { .exp = p->arr[i].exp, .p = coeff };
+            }
+        }
+    }
+    if (res.size == 0) {
+        free(res.arr);
+        return PolyZero();
+    }
+    return PolyExtractContents(&res);
+}
+
+static poly_exp_t *MonoDegs(const Poly *p)
+{
+    poly_exp_t *degs = safeMalloc(p->size * sizeof(poly_exp_t));
+
+    for (size_t i = 0; i < p->size; i++) {
+        degs[i] = PolyDeg(&p->arr[i].p);
+    }
+    return degs;
+}
+
+static Poly PolyMulTruncBounded(const Poly *p, const Poly *q, long long d)
+{
+    if (PolyIsCoeff(p)) {
+        Poly truncated = PolyTruncate(q, d);
+        Poly prod = PolyMul(p, &truncated);
+        PolyDestroy(&truncated);
+        return prod;
+    }
+    if (PolyIsCoeff(q)) {
+        return PolyMulTruncBounded(q, p, d);
+    }
+    poly_exp_t *pDegs = MonoDegs(p);
+    poly_exp_t *qDegs = MonoDegs(q);
+    Mono *mulMonos = safeMalloc(p->size * q->size * sizeof(Mono));
+    size_t count = 0;
+
+    for (size_t i = 0; i < p->size; i++) {
+        for (size_t j = q->size; j > 0; j--) {    // od najmniejszych wykładników - dalej są już tylko za duże
+            long long exp = (long long) p->arr[i].exp + q->arr[j - 1].exp;
+            long long rest = d - exp;
+
+            if (rest < 0) {
+                break;
+            }
+            Poly prod = ((long long) pDegs[i] + qDegs[j - 1] <= rest)
+                        ? PolyMul(&p->arr[i].p, &q->arr[j - 1].p)
+                        : PolyMulTruncBounded(&p->arr[i].p, &q->arr[j - 1].p, rest);
+
+            if (!PolyIsZero(&prod)) {
+                mulMonos[count++] = (Mono) { .exp = (poly_exp_t) exp, .p = prod };
+            }
+        }
+    }
+    free(pDegs);
+    free(qDegs);
+
+    return PolyOwnMonos(count, mulMonos);
+}
+
+static Poly PolySquareTrunc(const Poly *p, long long d)
+{
+    if (PolyIsCoeff(p) || 2LL * PolyDeg(p) <= d) {
+        return PolySquare(p);
+    }
+    Poly two = PolyFromCoeff(2);
+    poly_exp_t *degs = MonoDegs(p);
+    poly_exp_t minExp = p->arr[p->size - 1].exp;
+    Mono *squareMonos = safeMalloc((p->size + p->size * (p->size - 1) / 2) * sizeof(Mono));
+    size_t count = 0;
+
+    for (size_t i = 0; i < p->size; i++) {
+        if ((long long) p->arr[i].exp + minExp > d) {    // żadna para z tym jednomianem się nie mieści
+            continue;
+        }
+        Poly doubled = PolyMul(&two, &p->arr[i].p);
+
+        for (size_t j = i; j < p->size; j++) {
+            long long exp = (long long) p->arr[i].exp + p->arr[j].exp;
+            long long rest = d - exp;
+            Poly prod;
+
+            if (rest < 0) {
+                continue;
+            }
+            if (j == i) {
+                prod = PolySquareTrunc(&p->arr[i].p, rest);
+            }
+            else if ((long long) degs[i] + degs[j] <= rest) {
+                prod = PolyMul(&doubled, &p->arr[j].p);
+            }
+            else {
+                prod = PolyMulTruncBounded(&doubled, &p->arr[j].p, rest);
+            }
+            if (!PolyIsZero(&prod)) {
+                squareMonos[count++] = (Mono) { .exp = (poly_exp_t) exp, .p = prod };
+            }
+        }
+        PolyDestroy(&doubled);
+    }
+    free(degs);
+
+    return PolyOwnMonos(count, squareMonos);
+}
+
+static Poly PolyPowTrunc(const Poly *base, poly_exp_t exp, long long d)
+{
+    assert (exp >= 0);
+
+    if (d < 0) {
+        return PolyZero();
+    }
+    if (exp == 0 || PolyIsOne(base)) {
+        return PolyFromCoeff(1);
+    }
+    if (exp == 1) {
+        return PolyTruncate(base, d);
+    }
+    if ((long long) PolyDeg(base) * exp <= d) {    // nic nie zostanie obcięte
+        return PolyPower(base, exp);
+    }
+
+    Poly temp = PolyPowTrunc(base, exp / 2, d);
+    Poly square = PolySquareTrunc(&temp, d);
+    PolyDestroy(&temp);
+
+    if (exp % 2 == 0) {
+        return square;
+    }
+    Poly mul = PolyMulTrunc(base, &square, (poly_exp_t) d);
+    PolyDestroy(&square);
+    return mul;
+}
+
+static bool PolyIsDense(const Poly *p)
+{
+    return MonosAreCoeffs(p->arr, p->size) && 2 * (long long) p->size > (long long) p->arr[0].exp + 1;
+}
+
+static size_t PolyTermCount(const Poly *p, size_t *vars)
+{
+    size_t terms = 0;
+    vector_t *stack = WorkStackAcquire();
+    WorkStackPush(stack, (PolyFrame) { .p = p, .depth = 0 });
+    *vars = 0;
+
+    while (!VectorIsEmpty(stack)) {
+        PolyFrame frame = WorkStackPop(stack);
+
+        *vars = MAX(*vars, frame.depth + 1);
+        for (size_t i = 0; i < frame.p->size; i++) {
+            const Mono *m = &frame.p->arr[i];
+
+            if (PolyIsCoeff(&m->p)) {
+                terms++;
+            }
+            else {
+                WorkStackPush(stack, (PolyFrame) { .p = &m->p, .depth = frame.depth + 1 });
+            }
+        }
+    }
+    WorkStackRelease(stack);
+    return terms;
+}
+
+static double BinomialEstimate(size_t a, size_t b)
+{
+    size_t k = (a < b) ? a : b;
+    double res = 1;
+
+    for (size_t j = 1; j <= k && res < POW_ESTIMATE_CAP; j++) {
+        res = res * (double) (a + b - k + j) / (double) j;
+    }
+    return res;
+}
+
+static double PowTermsEstimate(size_t i, size_t terms, size_t vars, size_t deg)
+{
+    double byDeg = BinomialEstimate(i * deg, vars);    // jednomiany stopnia co najwyżej i * deg
+    double byTerms = BinomialEstimate(i, terms - 1);    // iloczyny i jednomianów podstawy
+
+    return (byDeg < byTerms) ? byDeg : byTerms;
+}
+
+static bool PolyPowByBaseIsCheaper(const Poly *p, poly_exp_t exp)
+{
+    if (exp > POW_BY_BASE_MAX_EXP) {
+        return false;
+    }
+    size_t vars;
+    size_t terms = PolyTermCount(p, &vars);
+    size_t deg = (size_t) PolyDeg(p);
+    double half = PowTermsEstimate((size_t) exp / 2, terms, vars, deg);
+    double squaring = half * half / 2;
+    double byBase = 0;
+
+    for (size_t i = 1; i < (size_t) exp && byBase < squaring; i++) {
+        byBase += (double) terms * PowTermsEstimate(i, terms, vars, deg);
+    }
+    return byBase < squaring;
+}
+
+static Poly PolyPowByBase(const Poly *base, poly_exp_t exp)
+{
+    Poly res = PolyClone(base);
+
+    for (poly_exp_t i = 1; i < exp; i++) {
+        Poly mul = PolyMul(&res, base);
+        PolyDestroy(&res);
+        res = mul;
+    }
+    return res;
+}
+
+static Poly PolyPowMonomial(const Poly *base, poly_exp_t exp)
+{
+    Poly coeff = PolyPower(&base->arr[0].p, exp);
+
+    if (PolyIsZero(&coeff)) {    // współczynnik może się przekręcić do zera
+        return coeff;
+    }
+    Poly res;
+    res.size = 1;
+    res.arr = safeMalloc(sizeof(Mono));
+    res.arr[0] = (Mono) { .exp = base->arr[0].exp * exp, .p = coeff };
+    return PolyExtractContents(&res);
+}
+
+static Poly PolyPowMultinomial(const Poly *base, poly_exp_t exp)
+{
+    size_t n = (size_t) exp;
+    Poly rest = PolyCloneMonos(base->size - 1, base->arr + 1);
+    Poly *restPow = safeMalloc((n + 1) * sizeof(Poly));
+    uint64_t *binom = safeCalloc(n + 1, sizeof(uint64_t));
+    size_t count = 0;
+
+    restPow[0] = PolyFromCoeff(1);
+    for (size_t j = 1; j <= n; j++) {
+        restPow[j] = PolyMul(&restPow[j - 1], &rest);
+    }
+    for (size_t j = 0; j <= n; j++) {
+        count += PolyIsCoeff(&restPow[j]) ? 1 : restPow[j].size;
+    }
+    binom[0] = 1;
+    for (size_t i = 1; i <= n; i++) {    // kolejne wiersze trójkąta Pascala w bieżącej arytmetyce
+        for (size_t k = i; k > 0; k--) {
+            binom[k] = ModAdd(binom[k], binom[k - 1]);
+        }
+    }
+
+    Mono *monos = safeMalloc(count * sizeof(Mono));
+    Poly aPow = PolyFromCoeff(1);
+    count = 0;
+    for (size_t k = 0; k <= n; k++) {
+        Poly c = PolyFromCoeff((poly_coeff_t) binom[k]);
+        Poly scaled = PolyMul(&c, &aPow);
+        const Poly *r = &restPow[n - k];
+        poly_exp_t exp_a = base->arr[0].exp * (poly_exp_t) k;
+
+        if (PolyIsCoeff(r)) {
+            monos[count++] = (Mono) { .exp = exp_a, .p = PolyMul(&scaled, r) };
+        }
+        else {
+            for (size_t i = 0; i < r->size; i++) {
+                monos[count++] = (Mono) { .exp = exp_a + r->arr[i].exp, .p = PolyMul(&scaled, &r->arr[i].p) };
+            }
+        }
+        PolyDestroy(&scaled);
+        if (k < n) {
+            Poly next = PolyMul(&aPow, &base->arr[0].p);
+            PolyDestroy(&aPow);
+            aPow = next;
+        }
+    }
+    PolyDestroy(&aPow);
+    for (size_t j = 0; j <= n; j++) {
+        PolyDestroy(&restPow[j]);
+    }
+    free(restPow);
+    free(binom);
+    PolyDestroy(&rest);
+
+    return PolyOwnMonos(count, monos);
+}
+
+static Poly PolyPowWindow(const Poly *base, poly_exp_t exp)
+{
+    int bits = 0;
+    while (bits < 31 && (exp >> bits) > 0) {
+        bits++;
+    }
+    int width = (bits <= 7) ? 2 : (bits <= 24) ? 3 : POW_MAX_WINDOW;
+    size_t needed = 0;    // liczba potrzebnych nieparzystych potęg
+
+    for (int i = bits - 1; i >= 0; ) {
+        if (((exp >> i) & 1) == 0) {
+            i--;
+            continue;
+        }
+        int j = (i - width + 1 > 0) ? i - width + 1 : 0;
+        while (((exp >> j) & 1) == 0) {
+            j++;
+        }
+        size_t idx = (size_t) ((exp >> j) & ((1 << (i - j + 1)) - 1)) / 2;
+        needed = (idx + 1 > needed) ? idx + 1 : needed;
+        i = j - 1;
+    }
+
+    Poly odd[1 << (POW_MAX_WINDOW - 1)];    // odd[i] = base^(2i + 1)
+    odd[0] = PolyClone(base);
+    if (needed > 1) {
+        Poly square = PolySquare(base);
+        for (size_t i = 1; i < needed; i++) {
+            odd[i] = PolyMul(&odd[i - 1], &square);
+        }
+        PolyDestroy(&square);
+    }
+
+    Poly res = PolyZero();
+    bool started = false;
+    for (int i = bits - 1; i >= 0; ) {
+        if (((exp >> i) & 1) == 0) {
+            Poly square = PolySquare(&res);
+            PolyDestroy(&res);
+            res = square;
+            i--;
+            continue;
+        }
+        int j = (i - width + 1 > 0) ? i - width + 1 : 0;
+        while (((exp >> j) & 1) == 0) {
+            j++;
+        }
+        size_t idx = (size_t) ((exp >> j) & ((1 << (i - j + 1)) - 1)) / 2;
+
+        if (!started) {
+            res = PolyClone(&odd[idx]);
+            started = true;
+        }
+        else {
+            for (int s = 0; s < i - j + 1; s++) {
+                Poly square = PolySquare(&res);
+                PolyDestroy(&res);
+                res = square;
+            }
+            Poly mul = PolyMul(&res, &odd[idx]);
+            PolyDestroy(&res);
+            res = mul;
+        }
+        i = j - 1;
+    }
+    for (size_t i = 0; i < needed; i++) {
+        PolyDestroy(&odd[i]);
+    }
+    return res;
+}
+
 void PolyNegateCoeffs(Poly *p)
 {
     if (PolyIsCoeff(p)) {
-        p->coeff *= -1;
+        p->coeff = (poly_coeff_t) ModNeg((uint64_t) p->coeff);
+        return;
     }
-    else {
-        for (size_t i = 0; i < p->size; i++) {
-            PolyNegateCoeffs(&p->arr[i].p);
+    vector_t *stack = WorkStackAcquire();
+    WorkStackPush(stack, (PolyFrame) { .out = p });
+
+    while (!VectorIsEmpty(stack)) {
+        Poly *curr = WorkStackPop(stack).out;
+
+        if (polyModulus.m == 0 && MonosAreCoeffs(curr->arr, curr->size)) {    // warstwa liści - negacja wektorowa
+            MonosScale(curr->arr, curr->arr, curr->size, -1);
+            continue;
+        }
+        for (size_t i = 0; i < curr->size; i++) {
+            Poly *coeff = &curr->arr[i].p;
+
+            if (PolyIsCoeff(coeff)) {
+                coeff->coeff = (poly_coeff_t) ModNeg((uint64_t) coeff->coeff);
+            }
+            else {
+                WorkStackPush(stack, (PolyFrame) { .out = coeff });
+            }
         }
     }
-}
\ No newline at end of file
+    WorkStackRelease(stack);
+}
+
+void PolyReduceCoeffs(Poly *p)
+{
+    if (polyModulus.m == 0) {
+        return;
+    }
+    if (PolyIsCoeff(p)) {
+        p->coeff = (poly_coeff_t) ModReduce(p->coeff);
+        return;
+    }
+    vector_t *order = VectorNew(sizeof(Poly *), INIT_CAP);    // wielomiany w kolejności prefiksowej
+    CHECK_POINTER(order);
+    vector_t *stack = WorkStackAcquire();
+    WorkStackPush(stack, (PolyFrame) { .out = p });
+
+    while (!VectorIsEmpty(stack)) {
+        Poly *curr = WorkStackPop(stack).out;
+
+        if (VectorPush(order, &curr) != VECT_OK) {
+            exit(EXIT_FAILURE);
+        }
+        for (size_t i = 0; i < curr->size; i++) {
+            if (!PolyIsCoeff(&curr->arr[i].p)) {
+                WorkStackPush(stack, (PolyFrame) { .out = &curr->arr[i].p });
+            }
+        }
+    }
+    WorkStackRelease(stack);
+
+    while (!VectorIsEmpty(order)) {    // dzieci przed rodzicami - wyzerowane poddrzewa znikają
+        Poly *curr = *(Poly **) VectorPop(order);
+
+        for (size_t i = 0; i < curr->size; i++) {
+            if (PolyIsCoeff(&curr->arr[i].p)) {
+                curr->arr[i].p.coeff = (poly_coeff_t) ModReduce(curr->arr[i].p.coeff);
+            }
+        }
+        PolyCleanFromZeros(curr);
+        if (!PolyIsCoeff(curr)) {
+            *curr = PolyExtractContents(curr);
+        }
+    }
+    VectorDestroy(order);
+}
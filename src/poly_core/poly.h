@@ -106,6 +106,13 @@ Mono MonoClone(const Mono *m);
  */
 void PolyDestroy(Poly *p);
 
+/**
+ * Zwalnia stos roboczy, który iteracyjne operacje na wielomianach
+ * zachowują do ponownego użycia przez bieżący wątek. Należy ją wywołać
+ * przed zakończeniem wątku korzystającego z biblioteki.
+ */
+void PolyWorkspaceFree(void);
+
 /**
  * Robi pełną, głęboką kopię wielomianu.
  *
@@ -135,6 +142,32 @@ Poly PolyAdd(const Poly *p, const Poly *q);
  */
 Poly PolyMul(const Poly *p, const Poly *q);
 
+/**
+ * Mnoży dwa wielomiany, pomijając jednomiany iloczynu stopnia (całkowitego)
+ * większego niż @p d. Pary jednomianów dające takie wyrazy nie są mnożone.
+ *
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @param[in] d : ograniczenie stopnia
+ *
+ * @return @f$p * q@f$ bez jednomianów stopnia większego niż @p d
+ */
+Poly PolyMulTrunc(const Poly *p, const Poly *q, poly_exp_t d);
+
+/**
+ * Podnosi wielomian do potęgi. Sposób potęgowania dobierany jest do postaci
+ * wielomianu: jednomian potęgowany jest bezpośrednio, wielomian o kilku
+ * jednomianach - wzorem dwumianowym/wielomianowym, gęsty wielomian jednej
+ * zmiennej - przez podnoszenie do kwadratu (z symetrycznym mnożeniem),
+ * a pozostałe - metodą okna przesuwnego.
+ *
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] exp : wykładnik (nieujemny)
+ *
+ * @return @f$p^{exp}@f$
+ */
+Poly PolyPower(const Poly *p, poly_exp_t exp);
+
 /**
  * Zwraca przeciwny wielomian.
  *
@@ -154,6 +187,30 @@ Poly PolyNeg(const Poly *p);
  */
 Poly PolySub(const Poly *p, const Poly *q);
 
+/**
+ * Dodaje dwa wielomiany, przejmując je na własność: jednomiany
+ * argumentów przenoszone są do wyniku zamiast kopiowania.
+ * Po wywołaniu oba argumenty są zerami.
+ *
+ * @param[in, out] p : wielomian @f$p@f$
+ * @param[in, out] q : wielomian @f$q@f$
+ *
+ * @return @f$p + q@f$
+ */
+Poly PolyAddOwned(Poly *p, Poly *q);
+
+/**
+ * Odejmuje wielomian od wielomianu, przejmując oba na własność.
+ * Znaki współczynników @p q zmieniane są w trakcie łączenia.
+ * Po wywołaniu oba argumenty są zerami.
+ *
+ * @param[in, out] p : wielomian @f$p@f$
+ * @param[in, out] q : wielomian @f$q@f$
+ *
+ * @return @f$p - q@f$
+ */
+Poly PolySubOwned(Poly *p, Poly *q);
+
 /**
  * Zwraca stopień wielomianu ze względu na zadaną zmienną (-1 dla wielomianu
  * tożsamościowo równego zeru). Zmienne indeksowane są od 0.
@@ -209,6 +266,31 @@ Poly PolyAt(const Poly *p, poly_coeff_t x);
  */
 void PolyNegateCoeffs(Poly *p);
 
+/**
+ * Wylicza wartość wielomianu w punkcie @f$(x_0, \ldots, x_{n-1})@f$,
+ * przechodząc jego drzewo raz, schematem Hornera, bez tworzenia
+ * wielomianów pośrednich. Zmienne o indeksach co najmniej @p n mają
+ * wartość 0. Działania są przekręcane tak jak w PolyAt() (lub liczone
+ * modulo moduł z poly_mod.h).
+ *
+ * @param[in] p : wielomian
+ * @param[in] n : liczba współrzędnych punktu
+ * @param[in] x : współrzędne punktu
+ *
+ * @return : @f$p(x_0, \ldots, x_{n-1}, 0, 0, \ldots)@f$
+ */
+poly_coeff_t PolyEvalPoint(const Poly *p, size_t n, const poly_coeff_t x[]);
+
+/**
+ * Sprowadza współczynniki wielomianu do reszt modulo moduł ustawiony
+ * przez PolySetModulus() i przywraca postać kanoniczną (współczynniki
+ * mogą się wyzerować). Bez ustawionego modułu nie robi nic.
+ * @see poly_mod.h
+ *
+ * @param[in, out] p : wielomian
+ */
+void PolyReduceCoeffs(Poly *p);
+
 /**
  * Sumuje listę jednomianów i tworzy z nich wielomian.
  * Przejmuje na własność zawartość tablicy @p monos.
@@ -266,4 +348,19 @@ Poly PolyCloneMonos(size_t count, const Mono monos[]);
  */
 Poly PolyCompose(const Poly *p, size_t k, const Poly q[]);
 
+/**
+ * Dokonuje złożenia jak PolyCompose(), pomijając jednomiany wyniku stopnia
+ * (całkowitego) większego niż @p d. Potęgi i iloczyny pośrednie obcinane
+ * są na bieżąco (zob. PolyMulTrunc()), więc wyrazy wysokich stopni nie są
+ * w ogóle liczone.
+ *
+ * @param[in] p : wielomian
+ * @param[in] k : liczba wielomianów/podstawianych zmiennych
+ * @param[in] q : tablica wielomianów (zmienne nowego wielomianu)
+ * @param[in] d : ograniczenie stopnia
+ *
+ * @return @f$p(q_0,q_1,...,q_{min(k,l)-1)}@f$ bez jednomianów stopnia większego niż @p d
+ */
+Poly PolyComposeTrunc(const Poly *p, size_t k, const Poly q[], poly_exp_t d);
+
 #endif //__POLY_H__
@@ -0,0 +1,211 @@
+/** @file
+  Implementacja sum iloczynów wielomianów rzadkich wielu zmiennych
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#include <limits.h>
+#include "poly_dot.h"
+#include "poly_mod.h"
+
+/**
+ * Pary grupowane są sortowaniem przez zliczanie, gdy rozpiętość ich
+ * wykładników jest co najwyżej tyle razy większa od liczby par,
+ * a w przeciwnym razie - przez qsort().
+ */
+#define DOT_COUNTING_SORT_FACTOR 4
+
+/**
+ * Para czynników jednego z iloczynów sumy, wraz z wykładnikiem
+ * (sumą wykładników jednomianów, z których pochodzą czynniki).
+ * Iloczyn dwóch liczb liczony jest od razu i para przechowuje już
+ * tylko jego wartość.
+ */
+typedef struct DotPair {
+    poly_exp_t exp;         ///< wykładnik iloczynu czynników
+    const Poly *x;          ///< pierwszy czynnik lub NULL, gdy para to policzony iloczyn liczb
+    union {
+        const Poly *y;      ///< drugi czynnik
+        uint64_t value;     ///< iloczyn liczb (gdy @p x to NULL)
+    } factor;               ///< drugi czynnik lub iloczyn
+} DotPair;
+
+
+
+/**
+ * Porównuje pary według wykładników (malejąco).
+ *
+ * @param[in] a : wskaźnik na pierwszą parę
+ * @param[in] b : wskaźnik na drugą parę
+ *
+ * @return : wynik porównania dla qsort()
+ */
+static int DotPairCompDescending(const void *a, const void *b);
+
+/**
+ * Liczy sumę iloczynów par czynników. Iloczyny liczb sumowane są od razu,
+ * a pozostałe pary rozkładane na pary współczynników jednomianów
+ * (liczba to jednomian o wykładniku 0), grupowane według sumy wykładników
+ * i sumowane rekurencyjnie - po jednym wywołaniu na wykładnik wyniku.
+ *
+ * @param[in] pairs : pary czynników (wykładniki nie są używane)
+ * @param[in] count : liczba par
+ *
+ * @return : suma iloczynów
+ */
+static Poly DotPairsSum(const DotPair *pairs, size_t count);
+
+/**
+ * Sortuje pary malejąco według wykładników.
+ *
+ * @param[in, out] terms : pary
+ * @param[in] count : liczba par
+ * @param[in] min_exp : najmniejszy wykładnik pary
+ * @param[in] max_exp : największy wykładnik pary
+ */
+static void DotPairsSort(DotPair *terms, size_t count, poly_exp_t min_exp, poly_exp_t max_exp);
+
+
+
+static int DotPairCompDescending(const void *a, const void *b)
+{
+    poly_exp_t exp_a = ((const DotPair *) a)->exp;
+    poly_exp_t exp_b = ((const DotPair *) b)->exp;
+
+    return (exp_a < exp_b) - (exp_a > exp_b);
+}
+
+static void DotPairsSort(DotPair *terms, size_t count, poly_exp_t min_exp, poly_exp_t max_exp)
+{
+    size_t range = (size_t) ((long long) max_exp - min_exp) + 1;
+
+    if (range > DOT_COUNTING_SORT_FACTOR * count) {
+        qsort(terms, count, sizeof(DotPair), DotPairCompDescending);
+        return;
+    }
+    size_t *starts = safeCalloc(range + 1, sizeof(size_t));    // indeks kubełka to max_exp - wykładnik
+    DotPair *sorted = safeMalloc(count * sizeof(DotPair));
+
+    for (size_t i = 0; i < count; i++) {
+        starts[max_exp - terms[i].exp + 1]++;
+    }
+    for (size_t b = 1; b <= range; b++) {
+        starts[b] += starts[b - 1];
+    }
+    for (size_t i = 0; i < count; i++) {
+        sorted[starts[max_exp - terms[i].exp]++] = terms[i];
+    }
+    memcpy(terms, sorted, count * sizeof(DotPair));
+    free(sorted);
+    free(starts);
+}
+
+static Poly DotPairsSum(const DotPair *pairs, size_t count)
+{
+    uint64_t scalar = 0;
+    size_t expanded = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        const Poly *x = pairs[i].x, *y = pairs[i].factor.y;
+
+        if (x == NULL) {
+            scalar = ModAdd(scalar, pairs[i].factor.value);
+        }
+        else if (PolyIsCoeff(x) && PolyIsCoeff(y)) {
+            scalar = ModAdd(scalar, ModMul((uint64_t) x->coeff, (uint64_t) y->coeff));
+        }
+        else {
+            expanded += (PolyIsCoeff(x) ? 1 : x->size) * (PolyIsCoeff(y) ? 1 : y->size);
+        }
+    }
+    if (expanded == 0) {
+        return PolyFromCoeff((poly_coeff_t) scalar);
+    }
+
+    DotPair *terms = safeMalloc(expanded * sizeof(DotPair));
+    poly_exp_t min_exp = INT_MAX, max_exp = 0;
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++) {
+        const Poly *x = pairs[i].x, *y = pairs[i].factor.y;
+
+        if (x == NULL || (PolyIsCoeff(x) && PolyIsCoeff(y))) {
+            continue;
+        }
+        size_t x_size = PolyIsCoeff(x) ? 1 : x->size;
+        size_t y_size = PolyIsCoeff(y) ? 1 : y->size;
+        for (size_t j = 0; j < x_size; j++) {
+            const Poly *x_coeff = PolyIsCoeff(x) ? x : &x->arr[j].p;
+            poly_exp_t x_exp = PolyIsCoeff(x) ? 0 : x->arr[j].exp;
+
+            for (size_t l = 0; l < y_size; l++) {
+                const Poly *y_coeff = PolyIsCoeff(y) ? y : &y->arr[l].p;
+                DotPair *term = &terms[n++];
+
+                term->exp = x_exp + (PolyIsCoeff(y) ? 0 : y->arr[l].exp);
+                min_exp = (term->exp < min_exp) ? term->exp : min_exp;
+                max_exp = (term->exp > max_exp) ? term->exp : max_exp;
+                if (PolyIsCoeff(x_coeff) && PolyIsCoeff(y_coeff)) {
+                    term->x = NULL;
+                    term->factor.value = ModMul((uint64_t) x_coeff->coeff, (uint64_t) y_coeff->coeff);
+                }
+                else {
+                    term->x = x_coeff;
+                    term->factor.y = y_coeff;
+                }
+            }
+        }
+    }
+    DotPairsSort(terms, expanded, min_exp, max_exp);
+
+    Mono *monos = safeMalloc((expanded + 1) * sizeof(Mono));
+    size_t monos_count = 0;
+    for (size_t first = 0, end; first < expanded; first = end) {
+        bool values = true;    // czy grupa to same policzone iloczyny liczb
+        uint64_t sum = 0;
+
+        for (end = first; end < expanded && terms[end].exp == terms[first].exp; end++) {
+            values = values && terms[end].x == NULL;
+            sum = ModAdd(sum, terms[end].x == NULL ? terms[end].factor.value : 0);
+        }
+        Poly coeff = values ? PolyFromCoeff((poly_coeff_t) sum) : DotPairsSum(terms + first, end - first);
+        if (!PolyIsZero(&coeff)) {
+            monos[monos_count++] = (Mono) { .exp = terms[first].exp, .p = coeff };
+        }
+    }
+    if (scalar != 0) {    // iloczyny liczb to wyraz wolny
+        monos[monos_count++] = (Mono) { .exp = 0, .p = PolyFromCoeff((poly_coeff_t) scalar) };
+    }
+    free(terms);
+
+    return PolyOwnMonos(monos_count, monos);
+}
+
+
+
+Poly PolyDot(size_t k, const Poly a[], const Poly b[])
+{
+    if (k == 0) {
+        return PolyZero();
+    }
+    DotPair *pairs = safeMalloc(k * sizeof(DotPair));
+
+    for (size_t i = 0; i < k; i++) {
+        pairs[i] = (DotPair) { .exp = 0, .x = &a[i], .factor.y = &b[i] };
+    }
+    Poly res = DotPairsSum(pairs, k);
+    free(pairs);
+    return res;
+}
+
+Poly PolyFma(const Poly *a, const Poly *b, const Poly *c)
+{
+    Poly one = PolyFromCoeff(1);
+    DotPair pairs[] = {
+        { .exp = 0, .x = a, .factor.y = b },
+        { .exp = 0, .x = c, .factor.y = &one }
+    };
+
+    return DotPairsSum(pairs, 2);
+}
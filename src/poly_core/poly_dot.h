@@ -0,0 +1,43 @@
+/** @file
+  Interfejs sum iloczynów wielomianów rzadkich wielu zmiennych
+
+  Suma @f$\sum_i a_i b_i@f$ liczona jest bez tworzenia iloczynów
+  @f$a_i b_i@f$: wszystkie pary jednomianów ze wszystkich iloczynów
+  grupowane są według sumy wykładników, a współczynnik każdej grupy to
+  znów suma iloczynów (współczynników), liczona tak samo poziom niżej.
+  Na poziomie liczb iloczyny trafiają do jednego akumulatora.
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#ifndef __POLY_DOT_H__
+#define __POLY_DOT_H__
+
+#include "poly.h"
+
+/**
+ * Liczy iloczyn skalarny wektorów wielomianów: @f$\sum_{i<k} a_i b_i@f$.
+ *
+ * @param[in] k : długość wektorów
+ * @param[in] a : wielomiany @f$a_0, \ldots, a_{k-1}@f$
+ * @param[in] b : wielomiany @f$b_0, \ldots, b_{k-1}@f$
+ *
+ * @return : @f$\sum_{i<k} a_i b_i@f$
+ */
+Poly PolyDot(size_t k, const Poly a[], const Poly b[]);
+
+/**
+ * Mnoży dwa wielomiany i dodaje trzeci, bez tworzenia iloczynu
+ * (zob. PolyDot()).
+ *
+ * @param[in] a : wielomian @f$a@f$
+ * @param[in] b : wielomian @f$b@f$
+ * @param[in] c : wielomian @f$c@f$
+ *
+ * @return : @f$a * b + c@f$
+ */
+Poly PolyFma(const Poly *a, const Poly *b, const Poly *c);
+
+#endif //__POLY_DOT_H__
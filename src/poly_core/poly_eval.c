@@ -0,0 +1,242 @@
+/** @file
+  Implementacja wartościowania wielomianów rzadkich wielu zmiennych
+  w wielu punktach naraz
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#include <pthread.h>
+#include "poly_eval.h"
+#include "poly_mod.h"
+#include "poly_simd.h"
+#include "../utils/vector.h"
+
+/**
+ * Najmniejsza liczba bloków punktów przypadająca na wątek - dla mniejszych
+ * zadań koszt utworzenia wątku przewyższa zysk.
+ */
+#define EVAL_MIN_BLOCKS_PER_THREAD 64
+
+/**
+ * Ramka stosu używanego przy wartościowaniu bloku punktów.
+ */
+typedef struct EvalBlockFrame {
+    const Poly *p;                      ///< wartościowany wielomian
+    size_t next;                        ///< indeks kolejnego jednomianu
+    uint64_t acc[POLY_SIMD_LANES];      ///< wartości dotychczasowych jednomianów według schematu Hornera
+} EvalBlockFrame;
+
+/**
+ * Zakres bloków punktów wartościowany przez jeden wątek.
+ */
+typedef struct EvalBatchTask {
+    const Poly *p;                  ///< wielomian
+    size_t nvars;                   ///< liczba współrzędnych punktu
+    size_t npoints;                 ///< liczba wszystkich punktów
+    const poly_coeff_t *points;     ///< współrzędne wszystkich punktów
+    poly_coeff_t *out;              ///< wartości we wszystkich punktach
+    size_t firstBlock;              ///< indeks pierwszego bloku zakresu
+    size_t endBlock;                ///< indeks bloku za zakresem
+} EvalBatchTask;
+
+/**
+ * Największa liczba wątków używanych przez PolyEvalBatch().
+ */
+static size_t evalThreads = 1;
+
+
+
+/**
+ * Wykonuje krok schematu Hornera dla bloku punktów w bieżącej arytmetyce
+ * współczynników - przy ustawionym module bez instrukcji wektorowych.
+ *
+ * @param[in, out] acc : wartości dotychczasowych jednomianów
+ * @param[in] x : wartości zmiennej w punktach
+ * @param[in] gap : różnica wykładników
+ * @param[in] v : wartości współczynnika
+ */
+static void EvalLanesHorner(uint64_t acc[], const uint64_t x[], uint64_t gap, const uint64_t v[]);
+
+/**
+ * Dolicza do ramki wartości kolejnego jednomianu (bez czynnika
+ * @f$x^{exp}@f$).
+ *
+ * @param[in, out] frame : ramka
+ * @param[in] x : wartości zmiennej w punktach
+ * @param[in] v : wartości współczynnika jednomianu
+ */
+static void EvalBlockAccumulate(EvalBlockFrame *frame, const uint64_t x[], const uint64_t v[]);
+
+/**
+ * Wartościuje wielomian w bloku punktów, przechodząc drzewo raz.
+ * Poddrzewa zmiennych spoza punktów wartościowane są przez PolyEvalPoint()
+ * (tylko wyrazy wolne).
+ *
+ * @param[in] p : wielomian
+ * @param[in] nvars : liczba współrzędnych punktu
+ * @param[in] xs : wartości zmiennych, @ref POLY_SIMD_LANES kolejnych dla każdej zmiennej
+ * @param[in, out] stack : pusty stos ramek EvalBlockFrame (pusty również po zakończeniu)
+ * @param[out] res : wartości w punktach bloku
+ */
+static void EvalBlock(const Poly *p, size_t nvars, const uint64_t *xs, vector_t *stack, uint64_t res[]);
+
+/**
+ * Wartościuje wielomian w punktach z zakresu bloków zadania.
+ *
+ * @param[in] task : zadanie
+ */
+static void EvalBatchRange(const EvalBatchTask *task);
+
+/**
+ * Funkcja wątku wartościującego zakres bloków.
+ *
+ * @param[in] arg : zadanie (EvalBatchTask)
+ *
+ * @return : NULL
+ */
+static void *EvalBatchWorker(void *arg);
+
+
+
+static void EvalLanesHorner(uint64_t acc[], const uint64_t x[], uint64_t gap, const uint64_t v[])
+{
+    if (polyModulus.m == 0) {
+        LanesHorner(acc, x, gap, v);
+        return;
+    }
+    for (size_t l = 0; l < POLY_SIMD_LANES; l++) {
+        acc[l] = ModAdd(ModMul(acc[l], ModPow(x[l], gap)), v[l]);
+    }
+}
+
+static void EvalBlockAccumulate(EvalBlockFrame *frame, const uint64_t x[], const uint64_t v[])
+{
+    size_t i = frame->next++;
+    poly_exp_t gap = (i > 0) ? frame->p->arr[i - 1].exp - frame->p->arr[i].exp : 0;
+
+    EvalLanesHorner(frame->acc, x, (uint64_t) gap, v);
+}
+
+static void EvalBlock(const Poly *p, size_t nvars, const uint64_t *xs, vector_t *stack, uint64_t res[])
+{
+    if (PolyIsCoeff(p) || nvars == 0) {
+        uint64_t value = (uint64_t) PolyEvalPoint(p, 0, NULL);
+
+        for (size_t l = 0; l < POLY_SIMD_LANES; l++) {
+            res[l] = value;
+        }
+        return;
+    }
+    const uint64_t zero[POLY_SIMD_LANES] = { 0 };
+    EvalBlockFrame root = { .p = p, .next = 0, .acc = { 0 } };
+    if (VectorPush(stack, &root) != VECT_OK) {
+        exit(EXIT_FAILURE);
+    }
+
+    while (true) {
+        EvalBlockFrame *top = (EvalBlockFrame *) VectorPeek(stack);
+        const uint64_t *x = xs + (stack->size - 1) * POLY_SIMD_LANES;
+
+        if (top->next < top->p->size) {
+            const Poly *coeff = &top->p->arr[top->next].p;
+
+            if (PolyIsCoeff(coeff) || stack->size >= nvars) {    // wartość jest wspólna dla całego bloku
+                uint64_t value = (uint64_t) PolyEvalPoint(coeff, 0, NULL);
+                uint64_t v[POLY_SIMD_LANES];
+
+                for (size_t l = 0; l < POLY_SIMD_LANES; l++) {
+                    v[l] = value;
+                }
+                EvalBlockAccumulate(top, x, v);
+            }
+            else {
+                EvalBlockFrame child = { .p = coeff, .next = 0, .acc = { 0 } };
+                if (VectorPush(stack, &child) != VECT_OK) {
+                    exit(EXIT_FAILURE);
+                }
+            }
+        }
+        else {
+            EvalBlockFrame done = *(EvalBlockFrame *) VectorPop(stack);
+
+            EvalLanesHorner(done.acc, x, (uint64_t) done.p->arr[done.p->size - 1].exp, zero);
+            if (VectorIsEmpty(stack)) {
+                memcpy(res, done.acc, sizeof(done.acc));
+                break;
+            }
+            EvalBlockAccumulate((EvalBlockFrame *) VectorPeek(stack), x - POLY_SIMD_LANES, done.acc);
+        }
+    }
+}
+
+static void EvalBatchRange(const EvalBatchTask *task)
+{
+    vector_t *stack = VectorNew(sizeof(EvalBlockFrame), INIT_CAP);
+    uint64_t *xs = safeMalloc((task->nvars > 0 ? task->nvars : 1) * POLY_SIMD_LANES * sizeof(uint64_t));
+    uint64_t res[POLY_SIMD_LANES];
+
+    CHECK_POINTER(stack);
+    for (size_t b = task->firstBlock; b < task->endBlock; b++) {
+        size_t first = b * POLY_SIMD_LANES;
+        size_t count = (task->npoints - first < POLY_SIMD_LANES) ? task->npoints - first : POLY_SIMD_LANES;
+
+        for (size_t l = 0; l < POLY_SIMD_LANES; l++) {    // transpozycja: punkt w kolumnie, zmienna w wierszu
+            for (size_t v = 0; v < task->nvars; v++) {
+                xs[v * POLY_SIMD_LANES + l] = (l < count) ? ModReduce(task->points[(first + l) * task->nvars + v]) : 0;
+            }
+        }
+        EvalBlock(task->p, task->nvars, xs, stack, res);
+        for (size_t l = 0; l < count; l++) {
+            task->out[first + l] = (poly_coeff_t) res[l];
+        }
+    }
+    free(xs);
+    VectorDestroy(stack);
+}
+
+static void *EvalBatchWorker(void *arg)
+{
+    EvalBatchRange((const EvalBatchTask *) arg);
+    PolyWorkspaceFree();    // stos roboczy PolyEvalPoint() tego wątku
+    return NULL;
+}
+
+
+
+void PolyEvalSetThreads(size_t threads)
+{
+    evalThreads = (threads > 0) ? threads : 1;
+}
+
+void PolyEvalBatch(const Poly *p, size_t nvars, size_t npoints, const poly_coeff_t *points, poly_coeff_t *out)
+{
+    size_t blocks = (npoints + POLY_SIMD_LANES - 1) / POLY_SIMD_LANES;
+    size_t threads_count = blocks / EVAL_MIN_BLOCKS_PER_THREAD;
+
+    if (threads_count > evalThreads) {
+        threads_count = evalThreads;
+    }
+    if (threads_count <= 1) {
+        EvalBatchTask task = { p, nvars, npoints, points, out, 0, blocks };
+        EvalBatchRange(&task);
+        return;
+    }
+    EvalBatchTask tasks[threads_count];
+    pthread_t threads[threads_count];
+
+    for (size_t i = 0; i < threads_count; i++) {
+        tasks[i] = (EvalBatchTask) { p, nvars, npoints, points, out,
+                                     blocks * i / threads_count, blocks * (i + 1) / threads_count };
+    }
+    for (size_t i = 1; i < threads_count; i++) {
+        if (pthread_create(&threads[i], NULL, EvalBatchWorker, &tasks[i]) != 0) {
+            exit(EXIT_FAILURE);
+        }
+    }
+    EvalBatchRange(&tasks[0]);    // pierwszy zakres wartościuje wątek wywołujący
+    for (size_t i = 1; i < threads_count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+}
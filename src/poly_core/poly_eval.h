@@ -0,0 +1,45 @@
+/** @file
+  Interfejs wartościowania wielomianów rzadkich wielu zmiennych
+  w wielu punktach naraz
+
+  Punkty dzielone są na bloki po @ref POLY_SIMD_LANES i drzewo wielomianu
+  przechodzone jest raz na blok - każdy krok schematu Hornera wykonywany
+  jest jednocześnie dla wszystkich punktów bloku (zob. LanesHorner()).
+  Bloki rozdzielane są równo między wątki ustawione przez
+  PolyEvalSetThreads(). Wyniki są takie same jak PolyEvalPoint() dla
+  każdego punktu z osobna.
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#ifndef __POLY_EVAL_H__
+#define __POLY_EVAL_H__
+
+#include "poly.h"
+
+/**
+ * Ustawia największą liczbę wątków używanych przez PolyEvalBatch()
+ * (domyślnie 1).
+ *
+ * @param[in] threads : liczba wątków (dodatnia)
+ */
+void PolyEvalSetThreads(size_t threads);
+
+/**
+ * Wartościuje wielomian w @p npoints punktach. Punkt @f$i@f$ to
+ * współrzędne `points[i * nvars]` ... `points[i * nvars + nvars - 1]`
+ * (dla zmiennych @f$x_0, \ldots, x_{nvars-1}@f$), pozostałe zmienne
+ * mają wartość 0. Wielomian nie jest modyfikowany, więc może być
+ * współdzielony przez wątki.
+ *
+ * @param[in] p : wielomian
+ * @param[in] nvars : liczba współrzędnych punktu
+ * @param[in] npoints : liczba punktów
+ * @param[in] points : współrzędne kolejnych punktów
+ * @param[out] out : wartości w kolejnych punktach
+ */
+void PolyEvalBatch(const Poly *p, size_t nvars, size_t npoints, const poly_coeff_t *points, poly_coeff_t *out);
+
+#endif //__POLY_EVAL_H__
@@ -0,0 +1,230 @@
+/** @file
+  Implementacja odcisków wielomianów rzadkich wielu zmiennych
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#include "poly_fingerprint.h"
+#include "poly_mod.h"
+#include "../utils/vector.h"
+
+/**
+ * Ziarna punktów - po jednym dla każdego punktu.
+ */
+static const uint64_t fingerprintSeeds[POLY_FINGERPRINT_POINTS] = {
+        0x243f6a8885a308d3u,
+        0x13198a2e03707344u,
+    };
+
+/**
+ * Ramka stosu używanego przy obliczaniu odcisku.
+ */
+typedef struct FingerprintFrame {
+    const Poly *p;                              ///< wartościowany wielomian
+    size_t next;                                ///< indeks kolejnego jednomianu
+    uint64_t point[POLY_FINGERPRINT_POINTS];    ///< wartości zmiennej wielomianu @p p
+    uint64_t acc[POLY_FINGERPRINT_POINTS];      ///< suma wartości dotychczasowych jednomianów
+} FingerprintFrame;
+
+
+
+/**
+ * Zwraca współrzędną punktu dla zmiennej o danym indeksie (funkcja
+ * mieszająca splitmix64). Współrzędne są nieparzyste, bo wartościowanie
+ * w parzystym punkcie gubi informację o najmłodszych bitach; przy
+ * ustawionym module są niezerowymi resztami.
+ *
+ * @param[in] seed : ziarno punktu
+ * @param[in] var_idx : indeks zmiennej
+ *
+ * @return : współrzędna
+ */
+static uint64_t FingerprintCoordinate(uint64_t seed, size_t var_idx);
+
+/**
+ * Tworzy ramkę dla wielomianu, którego zmienna ma dany indeks.
+ *
+ * @param[in] p : wielomian
+ * @param[in] var_idx : indeks zmiennej
+ * @param[in] k : liczba zmiennych o wartościach z @p q
+ * @param[in] q : wartości zmiennych (NULL - punkty odcisku)
+ *
+ * @return : ramka
+ */
+static FingerprintFrame FingerprintFrameMake(const Poly *p, size_t var_idx, size_t k, const PolyFingerprint q[]);
+
+/**
+ * Wartościuje wielomian w punktach odcisku albo w punktach, których
+ * współrzędnymi są wartości z @p q (dalsze współrzędne są zerami),
+ * przechodząc jego drzewo przy pomocy jawnego stosu.
+ *
+ * @param[in] p : wielomian
+ * @param[in] k : liczba zmiennych o wartościach z @p q
+ * @param[in] q : wartości zmiennych (NULL - punkty odcisku)
+ *
+ * @return : wartości @p p w kolejnych punktach
+ */
+static PolyFingerprint FingerprintEval(const Poly *p, size_t k, const PolyFingerprint q[]);
+
+
+
+static uint64_t FingerprintCoordinate(uint64_t seed, size_t var_idx)
+{
+    uint64_t z = seed + (uint64_t) var_idx * 0x9e3779b97f4a7c15u;
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9u;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebu;
+    z = (z ^ (z >> 31)) | 1;
+    if (polyModulus.m != 0) {
+        z %= polyModulus.m;
+    }
+    return (z == 0) ? 1 : z;
+}
+
+static FingerprintFrame FingerprintFrameMake(const Poly *p, size_t var_idx, size_t k, const PolyFingerprint q[])
+{
+    FingerprintFrame frame = { .p = p, .next = 0 };
+
+    for (size_t j = 0; j < POLY_FINGERPRINT_POINTS; j++) {
+        if (q == NULL) {
+            frame.point[j] = FingerprintCoordinate(fingerprintSeeds[j], var_idx);
+        }
+        else {
+            frame.point[j] = (var_idx < k) ? q[var_idx].v[j] : 0;
+        }
+        frame.acc[j] = 0;
+    }
+    return frame;
+}
+
+static PolyFingerprint FingerprintEval(const Poly *p, size_t k, const PolyFingerprint q[])
+{
+    PolyFingerprint res;
+
+    if (PolyIsCoeff(p)) {
+        for (size_t j = 0; j < POLY_FINGERPRINT_POINTS; j++) {
+            res.v[j] = (uint64_t) p->coeff;
+        }
+        return res;
+    }
+    vector_t *stack = VectorNew(sizeof(FingerprintFrame), INIT_CAP);
+    CHECK_POINTER(stack);
+    FingerprintFrame root = FingerprintFrameMake(p, 0, k, q);
+    if (VectorPush(stack, &root) != VECT_OK) {
+        exit(EXIT_FAILURE);
+    }
+
+    while (true) {
+        FingerprintFrame *top = (FingerprintFrame *) VectorPeek(stack);
+
+        if (top->next < top->p->size) {
+            const Mono *m = &top->p->arr[top->next];
+
+            if (PolyIsCoeff(&m->p)) {
+                for (size_t j = 0; j < POLY_FINGERPRINT_POINTS; j++) {
+                    top->acc[j] = ModAdd(top->acc[j], ModMul((uint64_t) m->p.coeff, ModPow(top->point[j], (uint64_t) m->exp)));
+                }
+                top->next++;
+            }
+            else {    // jednomian zostanie doliczony po obliczeniu współczynnika
+                FingerprintFrame child = FingerprintFrameMake(&m->p, stack->size, k, q);
+                if (VectorPush(stack, &child) != VECT_OK) {
+                    exit(EXIT_FAILURE);
+                }
+            }
+        }
+        else {
+            FingerprintFrame done = *(FingerprintFrame *) VectorPop(stack);
+
+            if (VectorIsEmpty(stack)) {
+                for (size_t j = 0; j < POLY_FINGERPRINT_POINTS; j++) {
+                    res.v[j] = done.acc[j];
+                }
+                break;
+            }
+            FingerprintFrame *parent = (FingerprintFrame *) VectorPeek(stack);
+            const Mono *m = &parent->p->arr[parent->next++];
+            for (size_t j = 0; j < POLY_FINGERPRINT_POINTS; j++) {
+                parent->acc[j] = ModAdd(parent->acc[j], ModMul(done.acc[j], ModPow(parent->point[j], (uint64_t) m->exp)));
+            }
+        }
+    }
+    VectorDestroy(stack);
+    return res;
+}
+
+
+
+PolyFingerprint PolyFingerprintOf(const Poly *p)
+{
+    return FingerprintEval(p, 0, NULL);
+}
+
+PolyFingerprint PolyFingerprintCompose(const Poly *p, size_t k, const PolyFingerprint q[])
+{
+    PolyFingerprint zero = { .v = { 0 } };
+
+    return FingerprintEval(p, k, (k > 0) ? q : &zero);    // NULL oznaczałby punkty odcisku
+}
+
+PolyFingerprint PolyFingerprintAdd(PolyFingerprint a, PolyFingerprint b)
+{
+    for (size_t j = 0; j < POLY_FINGERPRINT_POINTS; j++) {
+        a.v[j] = ModAdd(a.v[j], b.v[j]);
+    }
+    return a;
+}
+
+PolyFingerprint PolyFingerprintSub(PolyFingerprint a, PolyFingerprint b)
+{
+    for (size_t j = 0; j < POLY_FINGERPRINT_POINTS; j++) {
+        a.v[j] = ModSub(a.v[j], b.v[j]);
+    }
+    return a;
+}
+
+PolyFingerprint PolyFingerprintMul(PolyFingerprint a, PolyFingerprint b)
+{
+    for (size_t j = 0; j < POLY_FINGERPRINT_POINTS; j++) {
+        a.v[j] = ModMul(a.v[j], b.v[j]);
+    }
+    return a;
+}
+
+PolyFingerprint PolyFingerprintNeg(PolyFingerprint a)
+{
+    for (size_t j = 0; j < POLY_FINGERPRINT_POINTS; j++) {
+        a.v[j] = ModNeg(a.v[j]);
+    }
+    return a;
+}
+
+PolyFingerprint PolyFingerprintPow(PolyFingerprint a, poly_exp_t exp)
+{
+    for (size_t j = 0; j < POLY_FINGERPRINT_POINTS; j++) {
+        a.v[j] = ModPow(a.v[j], (uint64_t) exp);
+    }
+    return a;
+}
+
+bool PolyFingerprintEq(PolyFingerprint a, PolyFingerprint b)
+{
+    for (size_t j = 0; j < POLY_FINGERPRINT_POINTS; j++) {
+        if (a.v[j] != b.v[j]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PolyFingerprintIsZero(PolyFingerprint a)
+{
+    for (size_t j = 0; j < POLY_FINGERPRINT_POINTS; j++) {
+        if (a.v[j] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
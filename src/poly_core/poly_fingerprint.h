@@ -0,0 +1,130 @@
+/** @file
+  Interfejs odcisków wielomianów rzadkich wielu zmiennych
+
+  Odcisk wielomianu to jego wartości w @ref POLY_FINGERPRINT_POINTS
+  ustalonych pseudolosowych punktach, obliczone w tej samej arytmetyce,
+  w której liczone są współczynniki - modulo @f$2^{64}@f$ (z przekręcaniem
+  się) albo modulo @f$P@f$ ustawionym przez PolySetModulus(). Wartościowanie
+  w punkcie jest wtedy homomorfizmem, więc odcisk sumy, różnicy, iloczynu,
+  potęgi i wielomianu przeciwnego wyznacza się w czasie stałym z odcisków
+  argumentów, a odcisk złożenia - w czasie liniowym względem rozmiaru
+  składanego wielomianu; jest on zawsze równy odciskowi obliczonemu wprost
+  z wyniku. Różne odciski oznaczają różne wielomiany; równe odciski
+  wymagają sprawdzenia strukturalnego.
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#ifndef __POLY_FINGERPRINT_H__
+#define __POLY_FINGERPRINT_H__
+
+#include <stdint.h>
+#include "poly.h"
+
+/**
+ * Liczba punktów, w których wartościowany jest wielomian.
+ */
+#define POLY_FINGERPRINT_POINTS 2
+
+/**
+ * Odcisk wielomianu.
+ */
+typedef struct PolyFingerprint {
+    uint64_t v[POLY_FINGERPRINT_POINTS]; ///< Wartości wielomianu w kolejnych punktach
+} PolyFingerprint;
+
+/**
+ * Oblicza odcisk wielomianu, przechodząc jego drzewo przy pomocy
+ * jawnego stosu.
+ *
+ * @param[in] p : wielomian
+ *
+ * @return : odcisk @p p
+ */
+PolyFingerprint PolyFingerprintOf(const Poly *p);
+
+/**
+ * Zwraca odcisk sumy wielomianów.
+ *
+ * @param[in] a : odcisk @f$p@f$
+ * @param[in] b : odcisk @f$q@f$
+ *
+ * @return : odcisk @f$p + q@f$
+ */
+PolyFingerprint PolyFingerprintAdd(PolyFingerprint a, PolyFingerprint b);
+
+/**
+ * Zwraca odcisk różnicy wielomianów.
+ *
+ * @param[in] a : odcisk @f$p@f$
+ * @param[in] b : odcisk @f$q@f$
+ *
+ * @return : odcisk @f$p - q@f$
+ */
+PolyFingerprint PolyFingerprintSub(PolyFingerprint a, PolyFingerprint b);
+
+/**
+ * Zwraca odcisk iloczynu wielomianów.
+ *
+ * @param[in] a : odcisk @f$p@f$
+ * @param[in] b : odcisk @f$q@f$
+ *
+ * @return : odcisk @f$p \cdot q@f$
+ */
+PolyFingerprint PolyFingerprintMul(PolyFingerprint a, PolyFingerprint b);
+
+/**
+ * Zwraca odcisk wielomianu przeciwnego.
+ *
+ * @param[in] a : odcisk @f$p@f$
+ *
+ * @return : odcisk @f$-p@f$
+ */
+PolyFingerprint PolyFingerprintNeg(PolyFingerprint a);
+
+/**
+ * Zwraca odcisk potęgi wielomianu.
+ *
+ * @param[in] a : odcisk @f$p@f$
+ * @param[in] exp : wykładnik @f$n@f$
+ *
+ * @return : odcisk @f$p^n@f$
+ */
+PolyFingerprint PolyFingerprintPow(PolyFingerprint a, poly_exp_t exp);
+
+/**
+ * Zwraca odcisk złożenia wielomianów (zob. PolyCompose()), wartościując
+ * wielomian @p p w punktach wyznaczonych przez odciski podstawianych
+ * wielomianów - bez przechodzenia drzewa wyniku, które zwykle jest
+ * znacznie większe od @p p.
+ *
+ * @param[in] p : wielomian
+ * @param[in] k : liczba podstawianych wielomianów
+ * @param[in] q : odciski podstawianych wielomianów
+ *
+ * @return : odcisk @f$p(q_0,q_1,...,q_{k-1},0,...)@f$
+ */
+PolyFingerprint PolyFingerprintCompose(const Poly *p, size_t k, const PolyFingerprint q[]);
+
+/**
+ * Sprawdza równość odcisków.
+ *
+ * @param[in] a : odcisk
+ * @param[in] b : odcisk
+ *
+ * @return : czy odciski są równe (różne oznaczają różne wielomiany)
+ */
+bool PolyFingerprintEq(PolyFingerprint a, PolyFingerprint b);
+
+/**
+ * Sprawdza, czy odcisk jest odciskiem wielomianu zerowego.
+ *
+ * @param[in] a : odcisk
+ *
+ * @return : czy wszystkie wartości są zerami (jeśli nie, wielomian jest niezerowy)
+ */
+bool PolyFingerprintIsZero(PolyFingerprint a);
+
+#endif //__POLY_FINGERPRINT_H__
@@ -0,0 +1,378 @@
+/** @file
+  Implementacja tablicy współdzielonych (hash-consing) poddrzew wielomianów
+  rzadkich wielu zmiennych
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#include <stddef.h>
+#include <string.h>
+#include "poly_intern.h"
+#include "../utils/vector.h"
+
+/**
+ * Początkowa liczba kubełków tablicy.
+ */
+#define INTERN_INIT_CAPACITY 64
+
+/**
+ * Ramka stosu używanego przy umieszczaniu wielomianu w tablicy.
+ */
+typedef struct InternFrame {
+    Poly *p;        ///< wielomian, którego poddrzewa są umieszczane w tablicy
+    size_t next;    ///< indeks kolejnego jednomianu
+} InternFrame;
+
+
+
+/**
+ * Zwraca nagłówek współdzielonej tablicy jednomianów.
+ *
+ * @param[in] p : wielomian z tablicy, niebędący współczynnikiem
+ *
+ * @return : nagłówek
+ */
+static PolyInternEntry *InternEntryOf(const Poly *p);
+
+/**
+ * Miesza bity liczby (funkcja kończąca splitmix64).
+ *
+ * @param[in] z : liczba
+ *
+ * @return : wymieszana liczba
+ */
+static uint64_t InternMix(uint64_t z);
+
+/**
+ * Oblicza skrót tablicy jednomianów, których współczynniki
+ * są już w tablicy.
+ *
+ * @param[in] monos : jednomiany
+ * @param[in] size : liczba jednomianów
+ *
+ * @return : skrót
+ */
+static uint64_t InternHash(const Mono *monos, size_t size);
+
+/**
+ * Sprawdza, czy tablica jednomianów jest identyczna z poddrzewem z tablicy.
+ * Współczynniki z tablicy porównywane są przez wskaźniki.
+ *
+ * @param[in] entry : poddrzewo z tablicy
+ * @param[in] monos : jednomiany, których współczynniki są w tablicy
+ * @param[in] size : liczba jednomianów
+ *
+ * @return : czy poddrzewa są identyczne
+ */
+static bool InternSame(const PolyInternEntry *entry, const Mono *monos, size_t size);
+
+/**
+ * Wstawia poddrzewo do pierwszego wolnego kubełka, nie zmieniając licznika.
+ *
+ * @param[in, out] table : tablica
+ * @param[in] entry : poddrzewo
+ */
+static void InternInsertSlot(PolyInternTable *table, PolyInternEntry *entry);
+
+/**
+ * Podwaja liczbę kubełków tablicy.
+ *
+ * @param[in, out] table : tablica
+ */
+static void InternGrow(PolyInternTable *table);
+
+/**
+ * Usuwa poddrzewo z kubełków, przesuwając wstecz dalsze elementy
+ * tego samego ciągu próbkowania.
+ *
+ * @param[in, out] table : tablica
+ * @param[in] entry : poddrzewo
+ */
+static void InternRemoveSlot(PolyInternTable *table, const PolyInternEntry *entry);
+
+/**
+ * Zastępuje tablicę jednomianów wielomianu, których współczynniki są
+ * już w tablicy, współdzielonym poddrzewem - istniejącym lub nowym.
+ *
+ * @param[in, out] table : tablica
+ * @param[in, out] p : wielomian niebędący współczynnikiem
+ */
+static void InternMonos(PolyInternTable *table, Poly *p);
+
+/**
+ * Zlicza tablice jednomianów w drzewie wielomianu.
+ *
+ * @param[in] p : wielomian
+ *
+ * @return : liczba wielomianów w drzewie, które nie są współczynnikami
+ */
+static size_t InternCountNodes(const Poly *p);
+
+
+
+static PolyInternEntry *InternEntryOf(const Poly *p)
+{
+    return (PolyInternEntry *) ((char *) p->arr - offsetof(PolyInternEntry, monos));
+}
+
+static uint64_t InternMix(uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9u;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebu;
+    return z ^ (z >> 31);
+}
+
+static uint64_t InternHash(const Mono *monos, size_t size)
+{
+    uint64_t hash = size;
+
+    for (size_t i = 0; i < size; i++) {
+        uint64_t child = PolyIsCoeff(&monos[i].p) ? (uint64_t) monos[i].p.coeff
+                                                  : InternEntryOf(&monos[i].p)->hash ^ 0x9e3779b97f4a7c15u;
+        hash = InternMix(hash ^ (uint64_t) monos[i].exp);
+        hash = InternMix(hash ^ child);
+    }
+    return hash;
+}
+
+static bool InternSame(const PolyInternEntry *entry, const Mono *monos, size_t size)
+{
+    if (entry->size != size) {
+        return false;
+    }
+    for (size_t i = 0; i < size; i++) {
+        const Poly *a = &entry->monos[i].p, *b = &monos[i].p;
+
+        if (entry->monos[i].exp != monos[i].exp || PolyIsCoeff(a) != PolyIsCoeff(b)
+            || (PolyIsCoeff(a) ? a->coeff != b->coeff : a->arr != b->arr)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void InternInsertSlot(PolyInternTable *table, PolyInternEntry *entry)
+{
+    size_t mask = table->capacity - 1;
+    size_t i = entry->hash & mask;
+
+    while (table->slots[i] != NULL) {
+        i = (i + 1) & mask;
+    }
+    table->slots[i] = entry;
+}
+
+static void InternGrow(PolyInternTable *table)
+{
+    PolyInternEntry **old = table->slots;
+    size_t old_capacity = table->capacity;
+
+    table->capacity *= 2;
+    table->slots = safeCalloc(table->capacity, sizeof(PolyInternEntry *));
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old[i] != NULL) {
+            InternInsertSlot(table, old[i]);
+        }
+    }
+    free(old);
+}
+
+static void InternRemoveSlot(PolyInternTable *table, const PolyInternEntry *entry)
+{
+    size_t mask = table->capacity - 1;
+    size_t hole = entry->hash & mask;
+
+    while (table->slots[hole] != entry) {
+        hole = (hole + 1) & mask;
+    }
+    table->slots[hole] = NULL;
+
+    for (size_t i = (hole + 1) & mask; table->slots[i] != NULL; i = (i + 1) & mask) {
+        size_t home = table->slots[i]->hash & mask;
+
+        if (((i - home) & mask) >= ((i - hole) & mask)) {    // element może zająć dziurę
+            table->slots[hole] = table->slots[i];
+            table->slots[i] = NULL;
+            hole = i;
+        }
+    }
+}
+
+static void InternMonos(PolyInternTable *table, Poly *p)
+{
+    uint64_t hash = InternHash(p->arr, p->size);
+    size_t mask = table->capacity - 1;
+
+    for (size_t i = hash & mask; table->slots[i] != NULL; i = (i + 1) & mask) {
+        PolyInternEntry *entry = table->slots[i];
+
+        if (entry->hash == hash && InternSame(entry, p->arr, p->size)) {
+            entry->refs++;
+            for (size_t j = 0; j < p->size; j++) {
+                if (!PolyIsCoeff(&p->arr[j].p)) {
+                    InternEntryOf(&p->arr[j].p)->refs--;    // poddrzewo ma też referencję z entry
+                }
+            }
+            free(p->arr);
+            p->arr = entry->monos;
+            return;
+        }
+    }
+
+    size_t bytes = sizeof(PolyInternEntry) + p->size * sizeof(Mono);
+    PolyInternEntry *entry = safeMalloc(bytes);
+    entry->refs = 1;
+    entry->hash = hash;
+    entry->size = p->size;
+    memcpy(entry->monos, p->arr, p->size * sizeof(Mono));
+    free(p->arr);
+    p->arr = entry->monos;
+
+    table->count++;
+    table->bytes += bytes;
+    if (2 * table->count > table->capacity) {
+        InternGrow(table);
+    }
+    InternInsertSlot(table, entry);
+}
+
+static size_t InternCountNodes(const Poly *p)
+{
+    size_t count = 0;
+
+    if (PolyIsCoeff(p)) {
+        return 0;
+    }
+    vector_t *stack = VectorNew(sizeof(const Poly *), INIT_CAP);
+    CHECK_POINTER(stack);
+    if (VectorPush(stack, &p) != VECT_OK) {
+        exit(EXIT_FAILURE);
+    }
+
+    while (!VectorIsEmpty(stack)) {
+        const Poly *top = *(const Poly **) VectorPop(stack);
+
+        count++;
+        for (size_t i = 0; i < top->size; i++) {
+            const Poly *child = &top->arr[i].p;
+            if (!PolyIsCoeff(child) && VectorPush(stack, &child) != VECT_OK) {
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+    VectorDestroy(stack);
+    return count;
+}
+
+
+
+PolyInternTable *PolyInternTableNew(size_t limit)
+{
+    PolyInternTable *table = safeMalloc(sizeof(PolyInternTable));
+
+    table->capacity = INTERN_INIT_CAPACITY;
+    table->slots = safeCalloc(table->capacity, sizeof(PolyInternEntry *));
+    table->count = 0;
+    table->limit = limit;
+    table->bytes = 0;
+    return table;
+}
+
+void PolyInternTableDestroy(PolyInternTable *table)
+{
+    for (size_t i = 0; i < table->capacity; i++) {
+        free(table->slots[i]);
+    }
+    free(table->slots);
+    free(table);
+}
+
+bool PolyIntern(PolyInternTable *table, Poly *p)
+{
+    if (PolyIsCoeff(p)) {
+        return true;
+    }
+    if (InternCountNodes(p) > table->limit - table->count) {
+        return false;    // w najgorszym razie każde poddrzewo byłoby nowe
+    }
+    vector_t *stack = VectorNew(sizeof(InternFrame), INIT_CAP);
+    CHECK_POINTER(stack);
+    InternFrame root = { .p = p, .next = 0 };
+    if (VectorPush(stack, &root) != VECT_OK) {
+        exit(EXIT_FAILURE);
+    }
+
+    while (!VectorIsEmpty(stack)) {
+        InternFrame *top = (InternFrame *) VectorPeek(stack);
+
+        if (top->next < top->p->size) {    // najpierw współczynniki, potem ich rodzic
+            Poly *child = &top->p->arr[top->next++].p;
+
+            if (!PolyIsCoeff(child)) {
+                InternFrame frame = { .p = child, .next = 0 };
+                if (VectorPush(stack, &frame) != VECT_OK) {
+                    exit(EXIT_FAILURE);
+                }
+            }
+        }
+        else {
+            InternMonos(table, top->p);
+            VectorPop(stack);
+        }
+    }
+    VectorDestroy(stack);
+    return true;
+}
+
+Poly PolyInternRetain(const Poly *p)
+{
+    if (!PolyIsCoeff(p)) {
+        InternEntryOf(p)->refs++;
+    }
+    return *p;
+}
+
+void PolyInternRelease(PolyInternTable *table, Poly *p)
+{
+    if (PolyIsCoeff(p)) {
+        return;
+    }
+    vector_t *stack = VectorNew(sizeof(PolyInternEntry *), INIT_CAP);
+    CHECK_POINTER(stack);
+    PolyInternEntry *root = InternEntryOf(p);
+    if (VectorPush(stack, &root) != VECT_OK) {
+        exit(EXIT_FAILURE);
+    }
+
+    while (!VectorIsEmpty(stack)) {
+        PolyInternEntry *entry = *(PolyInternEntry **) VectorPop(stack);
+
+        if (--entry->refs > 0) {
+            continue;
+        }
+        for (size_t i = 0; i < entry->size; i++) {
+            if (!PolyIsCoeff(&entry->monos[i].p)) {
+                PolyInternEntry *child = InternEntryOf(&entry->monos[i].p);
+                if (VectorPush(stack, &child) != VECT_OK) {
+                    exit(EXIT_FAILURE);
+                }
+            }
+        }
+        InternRemoveSlot(table, entry);
+        table->count--;
+        table->bytes -= sizeof(PolyInternEntry) + entry->size * sizeof(Mono);
+        free(entry);
+    }
+    VectorDestroy(stack);
+    p->arr = NULL;
+}
+
+bool PolyInternIsEq(const Poly *p, const Poly *q)
+{
+    if (PolyIsCoeff(p) || PolyIsCoeff(q)) {
+        return PolyIsCoeff(p) && PolyIsCoeff(q) && p->coeff == q->coeff;
+    }
+    return p->arr == q->arr;
+}
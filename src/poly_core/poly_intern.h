@@ -0,0 +1,108 @@
+/** @file
+  Interfejs tablicy współdzielonych (hash-consing) poddrzew wielomianów
+  rzadkich wielu zmiennych
+
+  Wielomian umieszczony w tablicy jest niemodyfikowalny, a każda jego
+  tablica jednomianów występuje w tablicy dokładnie raz: identyczne
+  poddrzewa różnych wielomianów (i tego samego wielomianu) są współdzielone
+  i zliczane referencjami. Dwa wielomiany z tej samej tablicy są więc równe
+  wtedy i tylko wtedy, gdy mają te same współczynniki lub wskaźniki na
+  tablice jednomianów.
+
+  Wielomian z tablicy można przekazywać do funkcji przyjmujących
+  `const Poly *`, ale nie wolno go modyfikować ani zwalniać przez
+  PolyDestroy() - zamiast tego należy użyć PolyInternRelease().
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#ifndef __POLY_INTERN_H__
+#define __POLY_INTERN_H__
+
+#include <stdint.h>
+#include "poly.h"
+
+/**
+ * Współdzielona tablica jednomianów wraz z nagłówkiem.
+ * Wielomiany z tablicy wskazują na pole @p monos.
+ */
+typedef struct PolyInternEntry {
+    size_t refs;        ///< liczba referencji (wielomianów i jednomianów-rodziców)
+    uint64_t hash;      ///< skrót struktury poddrzewa
+    size_t size;        ///< liczba jednomianów
+    Mono monos[];       ///< jednomiany, których współczynniki również są współdzielone
+} PolyInternEntry;
+
+/**
+ * Tablica współdzielonych poddrzew (adresowanie otwarte z liniowym
+ * próbkowaniem). Nie jest bezpieczna dla wielu wątków.
+ */
+typedef struct PolyInternTable {
+    PolyInternEntry **slots;    ///< kubełki (NULL - pusty)
+    size_t capacity;            ///< liczba kubełków (potęga dwójki)
+    size_t count;               ///< liczba poddrzew w tablicy
+    size_t limit;               ///< największa dopuszczalna liczba poddrzew
+    size_t bytes;               ///< pamięć zajmowana przez poddrzewa
+} PolyInternTable;
+
+/**
+ * Tworzy pustą tablicę.
+ *
+ * @param[in] limit : największa liczba przechowywanych poddrzew
+ *
+ * @return : tablica (do zwolnienia przez PolyInternTableDestroy())
+ */
+PolyInternTable *PolyInternTableNew(size_t limit);
+
+/**
+ * Zwalnia tablicę wraz ze wszystkimi poddrzewami. Wielomiany z tablicy
+ * przestają być poprawne.
+ *
+ * @param[in, out] table : tablica
+ */
+void PolyInternTableDestroy(PolyInternTable *table);
+
+/**
+ * Umieszcza wielomian w tablicy, przejmując go na własność. Poddrzewa,
+ * które już są w tablicy, zastępowane są współdzielonymi, a ich kopie
+ * zwalniane. Jeśli nowe poddrzewa mogłyby przekroczyć limit tablicy,
+ * wielomian pozostaje niezmieniony.
+ *
+ * @param[in, out] table : tablica
+ * @param[in, out] p : wielomian, zastępowany wielomianem z tablicy
+ *
+ * @return : czy wielomian umieszczono w tablicy
+ */
+bool PolyIntern(PolyInternTable *table, Poly *p);
+
+/**
+ * Dodaje referencję na wielomian z tablicy.
+ *
+ * @param[in] p : wielomian z tablicy
+ *
+ * @return : kopia @p p, zwalniana niezależnie od @p p
+ */
+Poly PolyInternRetain(const Poly *p);
+
+/**
+ * Usuwa referencję na wielomian z tablicy, zwalniając poddrzewa,
+ * do których nie ma już innych referencji.
+ *
+ * @param[in, out] table : tablica
+ * @param[in, out] p : wielomian z tablicy
+ */
+void PolyInternRelease(PolyInternTable *table, Poly *p);
+
+/**
+ * Sprawdza równość wielomianów z tej samej tablicy w czasie stałym.
+ *
+ * @param[in] p : wielomian z tablicy
+ * @param[in] q : wielomian z tablicy
+ *
+ * @return : czy wielomiany są równe
+ */
+bool PolyInternIsEq(const Poly *p, const Poly *q);
+
+#endif //__POLY_INTERN_H__
@@ -0,0 +1,53 @@
+/** @file
+  Implementacja arytmetyki współczynników wielomianów rzadkich wielu zmiennych
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#include "poly_mod.h"
+
+PolyModulus polyModulus = { .m = 0, .ninv = 0, .r2 = 0 };
+
+bool PolySetModulus(uint64_t m)
+{
+    if (m < 3 || m % 2 == 0 || m >= (UINT64_C(1) << 63)) {
+        return false;    // redukcja wymaga nieparzystego modułu, a suma dwóch reszt musi się zmieścić
+    }
+    uint64_t inv = m;    // m * m = 1 (mod 8), każda iteracja Newtona podwaja liczbę poprawnych bitów
+
+    for (int i = 0; i < 5; i++) {
+        inv *= 2 - m * inv;
+    }
+    uint64_t r = (0 - m) % m;    // 2^64 mod m
+
+    polyModulus.m = m;
+    polyModulus.ninv = 0 - inv;
+    polyModulus.r2 = (uint64_t) ((unsigned __int128) r * r % m);
+    return true;
+}
+
+uint64_t ModReduce(int64_t c)
+{
+    if (polyModulus.m == 0) {
+        return (uint64_t) c;
+    }
+    int64_t res = c % (int64_t) polyModulus.m;
+
+    return (res < 0) ? (uint64_t) (res + (int64_t) polyModulus.m) : (uint64_t) res;
+}
+
+uint64_t ModPow(uint64_t base, uint64_t exp)
+{
+    uint64_t res = 1;
+
+    while (exp > 0) {
+        if (exp & 1) {
+            res = ModMul(res, base);
+        }
+        base = ModMul(base, base);
+        exp >>= 1;
+    }
+    return res;
+}
@@ -0,0 +1,177 @@
+/** @file
+  Interfejs arytmetyki współczynników wielomianów rzadkich wielu zmiennych
+
+  Domyślnie współczynniki są liczbami całkowitymi, a działania na nich
+  przekręcają się modulo @f$2^{64}@f$. Po ustawieniu modułu @f$P@f$
+  przez PolySetModulus() współczynniki są resztami z przedziału
+  @f$[0, P)@f$, a wszystkie działania w poly.c wykonywane są modulo
+  @f$P@f$ - mnożenie przy pomocy redukcji Montgomery'ego, bez dzielenia.
+  Moduł ustawia się raz, przed utworzeniem jakichkolwiek wielomianów
+  i wątków.
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#ifndef __POLY_MOD_H__
+#define __POLY_MOD_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Moduł współczynników wraz ze stałymi redukcji Montgomery'ego
+ * (@f$R = 2^{64}@f$).
+ */
+typedef struct PolyModulus {
+    uint64_t m;     ///< Moduł (0 - arytmetyka modulo @f$2^{64}@f$)
+    uint64_t ninv;  ///< @f$-m^{-1} \bmod R@f$
+    uint64_t r2;    ///< @f$R^2 \bmod m@f$
+} PolyModulus;
+
+/**
+ * Mnożnik przygotowany do wielokrotnego mnożenia przez niego
+ * kolejnych współczynników (np. w pętli po liściach wielomianu).
+ */
+typedef struct ModScalar {
+    uint64_t c;     ///< Mnożnik
+    uint64_t mont;  ///< Mnożnik w postaci Montgomery'ego (@f$cR \bmod m@f$)
+} ModScalar;
+
+/**
+ * Bieżący moduł współczynników. Zmieniany wyłącznie przez PolySetModulus().
+ */
+extern PolyModulus polyModulus;
+
+/**
+ * Ustawia moduł współczynników.
+ *
+ * @param[in] m : nieparzysty moduł z przedziału @f$[3, 2^{63})@f$
+ *
+ * @return : czy moduł jest poprawny (niepoprawny nie zmienia arytmetyki)
+ */
+bool PolySetModulus(uint64_t m);
+
+/**
+ * Sprowadza liczbę całkowitą do reszty modulo bieżący moduł.
+ *
+ * @param[in] c : liczba
+ *
+ * @return : reszta z przedziału @f$[0, m)@f$ (lub @p c bez modułu)
+ */
+uint64_t ModReduce(int64_t c);
+
+/**
+ * Podnosi współczynnik do potęgi.
+ *
+ * @param[in] base : podstawa (reszta, gdy ustawiono moduł)
+ * @param[in] exp : wykładnik
+ *
+ * @return : @f$base^{exp}@f$
+ */
+uint64_t ModPow(uint64_t base, uint64_t exp);
+
+/**
+ * Redukcja Montgomery'ego: dla @f$t < mR@f$ zwraca @f$tR^{-1} \bmod m@f$.
+ *
+ * @param[in] t : liczba
+ *
+ * @return : reszta z przedziału @f$[0, m)@f$
+ */
+static inline uint64_t ModRedc(unsigned __int128 t)
+{
+    uint64_t u = (uint64_t) t * polyModulus.ninv;
+    uint64_t res = (uint64_t) ((t + (unsigned __int128) u * polyModulus.m) >> 64);
+
+    return (res >= polyModulus.m) ? res - polyModulus.m : res;
+}
+
+/**
+ * Dodaje współczynniki.
+ *
+ * @param[in] a : współczynnik
+ * @param[in] b : współczynnik
+ *
+ * @return : @f$a + b@f$
+ */
+static inline uint64_t ModAdd(uint64_t a, uint64_t b)
+{
+    uint64_t sum = a + b;
+
+    return (polyModulus.m != 0 && sum >= polyModulus.m) ? sum - polyModulus.m : sum;
+}
+
+/**
+ * Odejmuje współczynniki.
+ *
+ * @param[in] a : współczynnik
+ * @param[in] b : współczynnik
+ *
+ * @return : @f$a - b@f$
+ */
+static inline uint64_t ModSub(uint64_t a, uint64_t b)
+{
+    return (polyModulus.m != 0 && a < b) ? a + (polyModulus.m - b) : a - b;
+}
+
+/**
+ * Zwraca współczynnik przeciwny.
+ *
+ * @param[in] a : współczynnik
+ *
+ * @return : @f$-a@f$
+ */
+static inline uint64_t ModNeg(uint64_t a)
+{
+    return (polyModulus.m != 0 && a != 0) ? polyModulus.m - a : 0 - a;
+}
+
+/**
+ * Mnoży współczynniki.
+ *
+ * @param[in] a : współczynnik
+ * @param[in] b : współczynnik
+ *
+ * @return : @f$a \cdot b@f$
+ */
+static inline uint64_t ModMul(uint64_t a, uint64_t b)
+{
+    if (polyModulus.m == 0) {
+        return a * b;
+    }
+    return ModRedc((unsigned __int128) ModRedc((unsigned __int128) a * b) * polyModulus.r2);
+}
+
+/**
+ * Przygotowuje mnożnik dla ModScalarMul().
+ *
+ * @param[in] c : współczynnik
+ *
+ * @return : mnożnik
+ */
+static inline ModScalar ModScalarMake(uint64_t c)
+{
+    ModScalar s = { .c = c, .mont = 0 };
+
+    if (polyModulus.m != 0) {
+        s.mont = ModRedc((unsigned __int128) c * polyModulus.r2);
+    }
+    return s;
+}
+
+/**
+ * Mnoży współczynnik przez przygotowany mnożnik - przy ustawionym
+ * module jedną redukcją zamiast dwóch.
+ *
+ * @param[in] s : mnożnik
+ * @param[in] a : współczynnik
+ *
+ * @return : @f$a \cdot c@f$
+ */
+static inline uint64_t ModScalarMul(ModScalar s, uint64_t a)
+{
+    return (polyModulus.m == 0) ? a * s.c : ModRedc((unsigned __int128) a * s.mont);
+}
+
+#endif //__POLY_MOD_H__
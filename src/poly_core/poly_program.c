@@ -0,0 +1,414 @@
+/** @file
+  Implementacja programów wartościujących wielomiany rzadkie wielu zmiennych
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#include "poly_program.h"
+#include "poly_mod.h"
+#include "../utils/vector.h"
+
+/**
+ * Początkowa liczba miejsc tablicy mieszającej kompilatora.
+ */
+#define COMPILE_INIT_SLOTS 64
+
+/**
+ * Liczba rejestrów, dla których PolyProgramEval() nie alokuje pamięci.
+ */
+#define PROGRAM_STACK_REGS 256
+
+/**
+ * Wyraz wielomianu przygotowany do kompilacji: jednomian, którego
+ * współczynnik jest stałą lub został już skompilowany do rejestru.
+ */
+typedef struct ProgramTerm {
+    uint64_t value;     ///< stała lub indeks rejestru
+    poly_exp_t exp;     ///< wykładnik jednomianu
+    uint32_t isReg;     ///< czy @p value jest indeksem rejestru
+} ProgramTerm;
+
+/**
+ * Wpis tablicy mieszającej kompilatora: skompilowana potęga zmiennej
+ * (@p count == 0) albo skompilowany wielomian.
+ */
+typedef struct CompileEntry {
+    uint64_t hash;      ///< skrót klucza (0 - wolne miejsce)
+    size_t depth;       ///< indeks zmiennej
+    size_t start;       ///< wykładnik potęgi lub początek wyrazów wielomianu w archiwum
+    size_t count;       ///< liczba wyrazów wielomianu
+    uint32_t reg;       ///< rejestr z wartością
+} CompileEntry;
+
+/**
+ * Ramka stosu używanego przy kompilacji.
+ */
+typedef struct CompileFrame {
+    const Poly *p;      ///< kompilowany wielomian
+    size_t next;        ///< indeks kolejnego jednomianu
+    size_t termStart;   ///< początek wyrazów @p p na stosie wyrazów
+} CompileFrame;
+
+/**
+ * Stan kompilatora.
+ */
+typedef struct Compiler {
+    vector_t *code;         ///< wygenerowane instrukcje (ProgramInstr)
+    vector_t *terms;        ///< wyrazy kompilowanych wielomianów (ProgramTerm)
+    vector_t *archive;      ///< wyrazy skompilowanych wielomianów (ProgramTerm)
+    CompileEntry *slots;    ///< tablica mieszająca z adresowaniem otwartym
+    size_t slotCount;       ///< liczba miejsc tablicy (potęga dwójki)
+    size_t used;            ///< liczba zajętych miejsc
+} Compiler;
+
+
+
+/**
+ * Miesza bity liczby (funkcja kończąca splitmix64).
+ *
+ * @param[in] z : liczba
+ *
+ * @return : wymieszana liczba
+ */
+static uint64_t CompileMix(uint64_t z);
+
+/**
+ * Dopisuje instrukcję do programu.
+ * Zakańcza działanie programu przy braku pamięci lub rejestrów.
+ *
+ * @param[in, out] c : kompilator
+ * @param[in] instr : instrukcja
+ *
+ * @return : rejestr z wynikiem instrukcji
+ */
+static uint32_t CompileEmit(Compiler *c, ProgramInstr instr);
+
+/**
+ * Szuka wpisu o danym kluczu w tablicy mieszającej.
+ *
+ * @param[in] c : kompilator
+ * @param[in] hash : skrót klucza (niezerowy)
+ * @param[in] depth : indeks zmiennej
+ * @param[in] start : wykładnik (dla potęgi)
+ * @param[in] terms : wyrazy wielomianu (dla wielomianu)
+ * @param[in] count : liczba wyrazów (0 dla potęgi)
+ *
+ * @return : znaleziony wpis lub wolne miejsce, w którym powinien się znaleźć
+ */
+static CompileEntry *CompileFind(const Compiler *c, uint64_t hash, size_t depth, size_t start,
+                                 const ProgramTerm *terms, size_t count);
+
+/**
+ * Wstawia wpis do tablicy mieszającej, w razie potrzeby ją powiększając.
+ *
+ * @param[in, out] c : kompilator
+ * @param[in] entry : wpis, którego klucza nie ma w tablicy
+ */
+static void CompileInsert(Compiler *c, CompileEntry entry);
+
+/**
+ * Zwraca rejestr z potęgą zmiennej, generując brakujące instrukcje
+ * (kolejne potęgi przez podnoszenie do kwadratu, wspólne dla całego programu).
+ *
+ * @param[in, out] c : kompilator
+ * @param[in] var : indeks zmiennej
+ * @param[in] exp : wykładnik (dodatni)
+ *
+ * @return : rejestr z @f$x_{var}^{exp}@f$
+ */
+static uint32_t CompilePower(Compiler *c, size_t var, poly_exp_t exp);
+
+/**
+ * Kompiluje wielomian, którego wyrazy leżą na szczycie stosu wyrazów
+ * od pozycji @p start, i zdejmuje je. Identyczny wielomian skompilowany
+ * wcześniej nie jest kompilowany ponownie.
+ *
+ * @param[in, out] c : kompilator
+ * @param[in] depth : indeks zmiennej wielomianu
+ * @param[in] start : pozycja pierwszego wyrazu
+ *
+ * @return : rejestr z wartością wielomianu
+ */
+static uint32_t CompileNode(Compiler *c, size_t depth, size_t start);
+
+
+
+static uint64_t CompileMix(uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9u;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebu;
+    return z ^ (z >> 31);
+}
+
+static uint32_t CompileEmit(Compiler *c, ProgramInstr instr)
+{
+    if (c->code->size >= UINT32_MAX || VectorPush(c->code, &instr) != VECT_OK) {
+        exit(EXIT_FAILURE);
+    }
+    return (uint32_t) (c->code->size - 1);
+}
+
+static CompileEntry *CompileFind(const Compiler *c, uint64_t hash, size_t depth, size_t start,
+                                 const ProgramTerm *terms, size_t count)
+{
+    size_t mask = c->slotCount - 1;
+
+    for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+        CompileEntry *e = &c->slots[i];
+
+        if (e->hash == 0) {
+            return e;
+        }
+        if (e->hash == hash && e->depth == depth && e->count == count
+            && (count == 0 ? e->start == start
+                           : memcmp(VectorAt(c->archive, e->start), terms, count * sizeof(ProgramTerm)) == 0)) {
+            return e;
+        }
+    }
+}
+
+static void CompileInsert(Compiler *c, CompileEntry entry)
+{
+    if (2 * (c->used + 1) > c->slotCount) {
+        CompileEntry *old = c->slots;
+        size_t old_count = c->slotCount;
+
+        c->slotCount *= 2;
+        c->slots = safeCalloc(c->slotCount, sizeof(CompileEntry));
+        for (size_t i = 0; i < old_count; i++) {
+            if (old[i].hash != 0) {
+                size_t j = old[i].hash & (c->slotCount - 1);
+
+                while (c->slots[j].hash != 0) {
+                    j = (j + 1) & (c->slotCount - 1);
+                }
+                c->slots[j] = old[i];
+            }
+        }
+        free(old);
+    }
+    const ProgramTerm *terms = (entry.count > 0) ? VectorAt(c->archive, entry.start) : NULL;
+
+    *CompileFind(c, entry.hash, entry.depth, entry.start, terms, entry.count) = entry;
+    c->used++;
+}
+
+static uint32_t CompilePower(Compiler *c, size_t var, poly_exp_t exp)
+{
+    uint64_t hash = CompileMix((uint64_t) var * 0x9e3779b97f4a7c15u ^ (uint64_t) exp) | 1;
+    CompileEntry *found = CompileFind(c, hash, var, (size_t) exp, NULL, 0);
+
+    if (found->hash != 0) {
+        return found->reg;
+    }
+    uint32_t reg;
+
+    if (exp == 1) {
+        reg = CompileEmit(c, (ProgramInstr) { .op = PROG_VAR, .imm = var });
+    }
+    else if (exp % 2 == 0) {
+        uint32_t half = CompilePower(c, var, exp / 2);
+        reg = CompileEmit(c, (ProgramInstr) { .op = PROG_MUL, .a = half, .b = half });
+    }
+    else {
+        uint32_t prev = CompilePower(c, var, exp - 1);
+        reg = CompileEmit(c, (ProgramInstr) { .op = PROG_MUL, .a = prev, .b = CompilePower(c, var, 1) });
+    }
+    CompileInsert(c, (CompileEntry) { .hash = hash, .depth = var, .start = (size_t) exp, .count = 0, .reg = reg });
+    return reg;
+}
+
+static uint32_t CompileNode(Compiler *c, size_t depth, size_t start)
+{
+    size_t count = c->terms->size - start;
+    const ProgramTerm *terms = VectorAt(c->terms, start);
+    uint64_t hash = CompileMix(depth ^ ((uint64_t) count << 32));
+
+    for (size_t i = 0; i < count; i++) {
+        hash = CompileMix(hash ^ terms[i].value);
+        hash = CompileMix(hash ^ ((uint64_t) terms[i].exp << 1 | terms[i].isReg));
+    }
+    hash |= 1;
+    CompileEntry *found = CompileFind(c, hash, depth, 0, terms, count);
+
+    if (found->hash != 0) {
+        c->terms->size = start;
+        return found->reg;
+    }
+    bool has_acc = false;
+    uint32_t acc = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        ProgramTerm t = *(const ProgramTerm *) VectorAt(c->terms, start + i);
+        ProgramInstr instr = { .c = acc };
+
+        if (t.exp == 0) {
+            if (t.isReg && !has_acc) {
+                acc = (uint32_t) t.value;    // wartość jest już w rejestrze
+                has_acc = true;
+                continue;
+            }
+            instr.op = t.isReg ? PROG_ADD : (has_acc ? PROG_ADD_CONST : PROG_CONST);
+            instr.a = (uint32_t) t.value;
+            instr.imm = t.value;
+        }
+        else {
+            uint32_t pw = CompilePower(c, depth, t.exp);
+
+            if (!t.isReg && t.value == 1 && !has_acc) {
+                acc = pw;
+                has_acc = true;
+                continue;
+            }
+            if (t.isReg) {
+                instr.op = has_acc ? PROG_MUL_ADD : PROG_MUL;
+                instr.a = (uint32_t) t.value;
+                instr.b = pw;
+            }
+            else {
+                instr.op = has_acc ? PROG_SCALE_ADD : PROG_SCALE;
+                instr.a = pw;
+                instr.imm = t.value;
+            }
+        }
+        acc = CompileEmit(c, instr);
+        has_acc = true;
+    }
+
+    size_t archived = c->archive->size;
+    for (size_t i = 0; i < count; i++) {
+        if (VectorPush(c->archive, VectorAt(c->terms, start + i)) != VECT_OK) {
+            exit(EXIT_FAILURE);
+        }
+    }
+    c->terms->size = start;
+    CompileInsert(c, (CompileEntry) { .hash = hash, .depth = depth, .start = archived, .count = count, .reg = acc });
+    return acc;
+}
+
+
+
+PolyProgram *PolyCompile(const Poly *p)
+{
+    PolyProgram *prog = safeMalloc(sizeof(PolyProgram));
+    Compiler c = {
+            .code = VectorNew(sizeof(ProgramInstr), INIT_CAP),
+            .terms = VectorNew(sizeof(ProgramTerm), INIT_CAP),
+            .archive = VectorNew(sizeof(ProgramTerm), INIT_CAP),
+            .slots = safeCalloc(COMPILE_INIT_SLOTS, sizeof(CompileEntry)),
+            .slotCount = COMPILE_INIT_SLOTS,
+            .used = 0
+        };
+    vector_t *stack = VectorNew(sizeof(CompileFrame), INIT_CAP);
+
+    CHECK_POINTER(c.code);
+    CHECK_POINTER(c.terms);
+    CHECK_POINTER(c.archive);
+    CHECK_POINTER(stack);
+    if (PolyIsCoeff(p)) {
+        prog->result = CompileEmit(&c, (ProgramInstr) { .op = PROG_CONST, .imm = (uint64_t) p->coeff });
+    }
+    else {
+        CompileFrame root = { .p = p, .next = 0, .termStart = 0 };
+        if (VectorPush(stack, &root) != VECT_OK) {
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    while (!VectorIsEmpty(stack)) {
+        CompileFrame *top = (CompileFrame *) VectorPeek(stack);
+
+        if (top->next < top->p->size) {
+            const Mono *m = &top->p->arr[top->next];
+
+            if (PolyIsCoeff(&m->p)) {
+                ProgramTerm t = { .value = (uint64_t) m->p.coeff, .exp = m->exp, .isReg = 0 };
+                if (VectorPush(c.terms, &t) != VECT_OK) {
+                    exit(EXIT_FAILURE);
+                }
+                top->next++;
+            }
+            else {    // jednomian zostanie dopisany po skompilowaniu współczynnika
+                CompileFrame child = { .p = &m->p, .next = 0, .termStart = c.terms->size };
+                if (VectorPush(stack, &child) != VECT_OK) {
+                    exit(EXIT_FAILURE);
+                }
+            }
+        }
+        else {
+            CompileFrame done = *(CompileFrame *) VectorPop(stack);
+            uint32_t reg = CompileNode(&c, stack->size, done.termStart);
+
+            if (VectorIsEmpty(stack)) {
+                prog->result = reg;
+                break;
+            }
+            CompileFrame *parent = (CompileFrame *) VectorPeek(stack);
+            ProgramTerm t = { .value = reg, .exp = parent->p->arr[parent->next++].exp, .isReg = 1 };
+            if (VectorPush(c.terms, &t) != VECT_OK) {
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+    VectorDestroy(stack);
+    VectorDestroy(c.terms);
+    VectorDestroy(c.archive);
+    free(c.slots);
+
+    prog->refs = 1;
+    prog->length = c.code->size;
+    prog->code = safeMalloc(prog->length * sizeof(ProgramInstr));
+    memcpy(prog->code, VectorAt(c.code, 0), prog->length * sizeof(ProgramInstr));
+    VectorDestroy(c.code);
+    return prog;
+}
+
+PolyProgram *PolyProgramRetain(PolyProgram *prog)
+{
+    if (prog != NULL) {
+        prog->refs++;
+    }
+    return prog;
+}
+
+void PolyProgramRelease(PolyProgram *prog)
+{
+    if (prog != NULL && --prog->refs == 0) {
+        free(prog->code);
+        free(prog);
+    }
+}
+
+size_t PolyProgramBytes(const PolyProgram *prog)
+{
+    return sizeof(PolyProgram) + prog->length * sizeof(ProgramInstr);
+}
+
+poly_coeff_t PolyProgramEval(const PolyProgram *prog, size_t n, const poly_coeff_t x[])
+{
+    uint64_t stack_regs[PROGRAM_STACK_REGS];
+    uint64_t *r = (prog->length <= PROGRAM_STACK_REGS) ? stack_regs : safeMalloc(prog->length * sizeof(uint64_t));
+
+    for (size_t i = 0; i < prog->length; i++) {
+        const ProgramInstr *in = &prog->code[i];
+
+        switch ((ProgramOp) in->op) {
+            case PROG_CONST: r[i] = in->imm; break;
+            case PROG_VAR: r[i] = (in->imm < n) ? ModReduce(x[in->imm]) : 0; break;
+            case PROG_MUL: r[i] = ModMul(r[in->a], r[in->b]); break;
+            case PROG_MUL_ADD: r[i] = ModAdd(ModMul(r[in->a], r[in->b]), r[in->c]); break;
+            case PROG_SCALE: r[i] = ModMul(in->imm, r[in->a]); break;
+            case PROG_SCALE_ADD: r[i] = ModAdd(ModMul(in->imm, r[in->a]), r[in->c]); break;
+            case PROG_ADD: r[i] = ModAdd(r[in->a], r[in->c]); break;
+            case PROG_ADD_CONST: r[i] = ModAdd(in->imm, r[in->c]); break;
+        }
+    }
+    uint64_t res = (prog->result < prog->length) ? r[prog->result] : 0;    // zawsze spełnione (dla -Wmaybe-uninitialized)
+
+    if (r != stack_regs) {
+        free(r);
+    }
+    return (poly_coeff_t) res;
+}
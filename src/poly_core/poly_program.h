@@ -0,0 +1,111 @@
+/** @file
+  Interfejs programów wartościujących wielomiany rzadkie wielu zmiennych
+
+  Program to płaski ciąg instrukcji (bez skoków), z których każda zapisuje
+  wynik do nowego rejestru - mnożeń, mnożeń z dodawaniem i wczytań zmiennych
+  lub stałych. Przy kompilacji przez PolyCompile() potęgi zmiennych liczone
+  są raz dla całego programu (przez podnoszenie do kwadratu, wspólne dla
+  wszystkich jednomianów), a identyczne poddrzewa wielomianu (o tych samych
+  zmiennych) - raz, bez względu na to, ile razy w nim występują. Wykonanie
+  programu przez PolyProgramEval() to jedna pętla po instrukcjach,
+  bez przechodzenia drzewa i bez potęgowania.
+
+  Program liczy w arytmetyce współczynników ustawionej w chwili kompilacji
+  (zob. poly_mod.h).
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#ifndef __POLY_PROGRAM_H__
+#define __POLY_PROGRAM_H__
+
+#include <stdint.h>
+#include "poly.h"
+
+/**
+ * Kod instrukcji programu. Instrukcja o indeksie @f$i@f$ zapisuje
+ * wynik do rejestru @f$r_i@f$.
+ */
+typedef enum ProgramOp {
+    PROG_CONST,         ///< @f$r_i = imm@f$
+    PROG_VAR,           ///< @f$r_i = x_{imm}@f$ (0 dla zmiennych spoza punktu)
+    PROG_MUL,           ///< @f$r_i = r_a \cdot r_b@f$
+    PROG_MUL_ADD,       ///< @f$r_i = r_a \cdot r_b + r_c@f$
+    PROG_SCALE,         ///< @f$r_i = imm \cdot r_a@f$
+    PROG_SCALE_ADD,     ///< @f$r_i = imm \cdot r_a + r_c@f$
+    PROG_ADD,           ///< @f$r_i = r_a + r_c@f$
+    PROG_ADD_CONST      ///< @f$r_i = imm + r_c@f$
+} ProgramOp;
+
+/**
+ * Instrukcja programu.
+ */
+typedef struct ProgramInstr {
+    uint32_t op;    ///< kod instrukcji (ProgramOp)
+    uint32_t a;     ///< indeks rejestru pierwszego argumentu
+    uint32_t b;     ///< indeks rejestru drugiego argumentu
+    uint32_t c;     ///< indeks rejestru dodawanego
+    uint64_t imm;   ///< stała lub indeks zmiennej
+} ProgramInstr;
+
+/**
+ * Program wartościujący wielomian. Program się nie zmienia, więc może mieć
+ * wielu właścicieli, zliczanych w @p refs.
+ */
+typedef struct PolyProgram {
+    ProgramInstr *code;     ///< instrukcje
+    size_t length;          ///< liczba instrukcji (i rejestrów), dodatnia
+    size_t result;          ///< rejestr z wartością wielomianu
+    size_t refs;            ///< liczba właścicieli
+} PolyProgram;
+
+/**
+ * Kompiluje wielomian do programu. Drzewo wielomianu przechodzone jest
+ * iteracyjnie.
+ *
+ * @param[in] p : wielomian
+ *
+ * @return : program z jednym właścicielem (do zwolnienia przez PolyProgramRelease())
+ */
+PolyProgram *PolyCompile(const Poly *p);
+
+/**
+ * Dodaje właściciela programu.
+ *
+ * @param[in, out] prog : program (lub NULL)
+ *
+ * @return : @p prog
+ */
+PolyProgram *PolyProgramRetain(PolyProgram *prog);
+
+/**
+ * Usuwa właściciela programu, a gdy był on ostatnim - zwalnia program.
+ *
+ * @param[in, out] prog : program (lub NULL)
+ */
+void PolyProgramRelease(PolyProgram *prog);
+
+/**
+ * Zwraca pamięć zajmowaną przez program w bajtach.
+ *
+ * @param[in] prog : program
+ *
+ * @return : liczba bajtów
+ */
+size_t PolyProgramBytes(const PolyProgram *prog);
+
+/**
+ * Wykonuje program w punkcie, dając ten sam wynik co PolyEvalPoint()
+ * dla skompilowanego wielomianu.
+ *
+ * @param[in] prog : program
+ * @param[in] n : liczba współrzędnych punktu
+ * @param[in] x : współrzędne punktu (zmienne @f$x_0, \ldots, x_{n-1}@f$)
+ *
+ * @return : wartość wielomianu w punkcie
+ */
+poly_coeff_t PolyProgramEval(const PolyProgram *prog, size_t n, const poly_coeff_t x[]);
+
+#endif //__POLY_PROGRAM_H__
@@ -0,0 +1,143 @@
+/** @file
+  Implementacja wątku zwalniającego w tle pamięć wielomianów
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+/** Makro zdefiniowane, aby korzystać z wątków i semaforów POSIX. */
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include "poly_reclaimer.h"
+
+/**
+ * Węzeł kolejki wielomianów oczekujących na zwolnienie.
+ */
+typedef struct ReclaimNode {
+    Poly poly;                 ///< wielomian do zwolnienia
+    struct ReclaimNode *next;  ///< następny węzeł
+} ReclaimNode;
+
+/**
+ * Stan wątku zwalniającego.
+ */
+typedef struct Reclaimer {
+    _Atomic(ReclaimNode *) head;  ///< szczyt nieblokującego stosu Treibera z oczekującymi wielomianami
+    atomic_bool stop;             ///< żądanie zakończenia pracy wątku
+    sem_t pending;                ///< licznik zgłoszeń, na którym wątek czeka gdy nie ma pracy
+    pthread_t thread;             ///< wątek zwalniający
+    bool running;                 ///< czy wątek jest uruchomiony
+} Reclaimer;
+
+/**
+ * Jedyna instancja wątku zwalniającego.
+ */
+static Reclaimer reclaimer = { .head = NULL, .running = false };
+
+
+
+/**
+ * Zwalnia wszystkie wielomiany z listy zaczynającej się w @p node.
+ *
+ * @param[in] node : pierwszy węzeł listy
+ */
+static void ReclaimList(ReclaimNode *node);
+
+/**
+ * Pętla główna wątku zwalniającego. Zabiera naraz całą zawartość
+ * kolejki i zwalnia ją, dopóki nie otrzyma żądania zakończenia.
+ *
+ * @param[in] arg : nieużywany
+ *
+ * @return : NULL
+ */
+static void *ReclaimerLoop(void *arg);
+
+
+
+static void ReclaimList(ReclaimNode *node)
+{
+    while (node != NULL) {
+        ReclaimNode *next = node->next;
+        PolyDestroy(&node->poly);
+        free(node);
+        node = next;
+    }
+}
+
+static void *ReclaimerLoop(void *arg)
+{
+    (void)arg;
+    bool stop = false;
+
+    while (!stop) {
+        while (sem_wait(&reclaimer.pending) != 0) {
+            // przerwane przez sygnał
+        }
+        stop = atomic_load_explicit(&reclaimer.stop, memory_order_acquire);
+        ReclaimList(atomic_exchange_explicit(&reclaimer.head, NULL, memory_order_acquire));
+    }
+    PolyWorkspaceFree();
+    return NULL;
+}
+
+
+
+void PolyReclaimerStart(void)
+{
+    if (reclaimer.running) {
+        return;
+    }
+    atomic_store(&reclaimer.head, NULL);
+    atomic_store(&reclaimer.stop, false);
+
+    if (sem_init(&reclaimer.pending, 0, 0) != 0) {
+        exit(EXIT_FAILURE);
+    }
+    if (pthread_create(&reclaimer.thread, NULL, ReclaimerLoop, NULL) != 0) {
+        exit(EXIT_FAILURE);
+    }
+    reclaimer.running = true;
+}
+
+void PolyReclaimerStop(void)
+{
+    if (!reclaimer.running) {
+        return;
+    }
+    atomic_store_explicit(&reclaimer.stop, true, memory_order_release);
+    sem_post(&reclaimer.pending);
+    pthread_join(reclaimer.thread, NULL);
+    sem_destroy(&reclaimer.pending);
+    reclaimer.running = false;
+}
+
+bool PolyReclaimerIsRunning(void)
+{
+    return reclaimer.running;
+}
+
+void PolyDestroyDeferred(Poly *p)
+{
+    if (PolyIsCoeff(p)) {
+        return;
+    }
+    if (!reclaimer.running) {
+        PolyDestroy(p);
+        return;
+    }
+    ReclaimNode *node = safeMalloc(sizeof(ReclaimNode));
+    node->poly = *p;
+    node->next = atomic_load_explicit(&reclaimer.head, memory_order_relaxed);
+
+    while (!atomic_compare_exchange_weak_explicit(&reclaimer.head, &node->next, node,
+                                                  memory_order_release, memory_order_relaxed)) {
+        // node->next zaktualizowano bieżącym szczytem
+    }
+    sem_post(&reclaimer.pending);
+    p->arr = NULL;
+}
@@ -0,0 +1,45 @@
+/** @file
+  Interfejs wątku zwalniającego w tle pamięć wielomianów
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#ifndef __POLY_RECLAIMER_H__
+#define __POLY_RECLAIMER_H__
+
+#include "poly.h"
+
+/**
+ * Uruchamia wątek zwalniający w tle wielomiany przekazane
+ * przez PolyDestroyDeferred(). Ponowne wywołanie nic nie robi.
+ * @see PolyDestroyDeferred()
+ */
+void PolyReclaimerStart(void);
+
+/**
+ * Zatrzymuje wątek zwalniający, czekając aż zwolni on
+ * wszystkie przekazane mu dotąd wielomiany.
+ */
+void PolyReclaimerStop(void);
+
+/**
+ * Sprawdza, czy wątek zwalniający jest uruchomiony.
+ *
+ * @return : czy wielomiany są zwalniane w tle
+ */
+bool PolyReclaimerIsRunning(void);
+
+/**
+ * Usuwa wielomian z pamięci. Jeśli wątek zwalniający jest uruchomiony,
+ * przekazuje mu drzewo wielomianu przez nieblokującą kolejkę i wraca
+ * natychmiast, w przeciwnym wypadku działa jak PolyDestroy().
+ * Przejmuje na własność zawartość struktury wskazywanej przez @p p.
+ * @see PolyDestroy()
+ *
+ * @param[in, out] p : wielomian
+ */
+void PolyDestroyDeferred(Poly *p);
+
+#endif //__POLY_RECLAIMER_H__
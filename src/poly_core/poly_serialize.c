@@ -0,0 +1,316 @@
+/** @file
+  Implementacja binarnej serializacji wielomianów rzadkich wielu zmiennych
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#include <limits.h>
+#include "poly_serialize.h"
+#include "../utils/vector.h"
+
+/**
+ * Początkowa pojemność bufora serializacji (w bajtach).
+ */
+#define SERIAL_INIT_CAP 256
+
+/**
+ * Największa długość liczby 64-bitowej zapisanej jako varint.
+ */
+#define VARINT_MAX_LEN 10
+
+/**
+ * Najmniejsza liczba bajtów, jaką zajmuje zapis jednego jednomianu
+ * (wykładnik, nagłówek współczynnika i co najmniej jeden bajt dalej).
+ * Pozwala odrzucić nagłówek o liczbie jednomianów większej, niż zmieści
+ * się w buforze, zanim zaalokuje się dla nich pamięć.
+ */
+#define MIN_MONO_LEN 3
+
+/**
+ * Rosnący bufor bajtów, do którego zapisywany jest wielomian.
+ */
+typedef struct ByteBuffer {
+    uint8_t *data;  ///< zawartość bufora
+    size_t size;    ///< liczba zapisanych bajtów
+    size_t cap;     ///< pojemność bufora
+} ByteBuffer;
+
+/**
+ * Ramka stosu przy serializacji.
+ */
+typedef struct SerialFrame {
+    const Poly *p;  ///< zapisywany wielomian
+    size_t next;    ///< indeks pierwszego niezapisanego jednomianu @p p
+} SerialFrame;
+
+/**
+ * Ramka stosu przy deserializacji. Pole `out->size` to liczba
+ * już odtworzonych jednomianów, dzięki czemu częściowo odtworzony
+ * wielomian można w każdej chwili zwolnić przez PolyDestroy().
+ */
+typedef struct DeserialFrame {
+    Poly *out;      ///< odtwarzany wielomian
+    size_t count;   ///< docelowa liczba jednomianów @p out
+} DeserialFrame;
+
+
+
+/**
+ * Zapewnia miejsce na co najmniej @p extra kolejnych bajtów w buforze.
+ *
+ * @param[in, out] buf : bufor
+ * @param[in] extra : liczba bajtów
+ */
+static void BufferReserve(ByteBuffer *buf, size_t extra);
+
+/**
+ * Dopisuje do bufora liczbę w kodowaniu varint.
+ *
+ * @param[in, out] buf : bufor
+ * @param[in] val : liczba
+ */
+static void BufferPutVarint(ByteBuffer *buf, uint64_t val);
+
+/**
+ * Dopisuje do bufora nagłówek wielomianu: liczbę jednomianów
+ * lub, dla współczynnika, zero i współczynnik w kodowaniu zigzag.
+ *
+ * @param[in, out] buf : bufor
+ * @param[in] p : wielomian
+ */
+static void BufferPutPolyHead(ByteBuffer *buf, const Poly *p);
+
+/**
+ * Wczytuje liczbę w kodowaniu varint.
+ *
+ * @param[in] data : bufor
+ * @param[in] size : długość bufora
+ * @param[in, out] pos : pozycja w buforze
+ * @param[out] val : wczytana liczba
+ *
+ * @return : czy liczba mieści się w buforze i w 64 bitach
+ */
+static bool ReadVarint(const uint8_t *data, size_t size, size_t *pos, uint64_t *val);
+
+/**
+ * Wczytuje nagłówek wielomianu. Dla wielomianu niebędącego
+ * współczynnikiem alokuje tablicę jednomianów i ustawia jego rozmiar na 0.
+ *
+ * @param[in] data : bufor
+ * @param[in] size : długość bufora
+ * @param[in, out] pos : pozycja w buforze
+ * @param[out] out : wielomian
+ * @param[out] count : liczba jednomianów do wczytania
+ *
+ * @return : czy nagłówek jest poprawny
+ */
+static bool ReadPolyHead(const uint8_t *data, size_t size, size_t *pos, Poly *out, size_t *count);
+
+
+
+static void BufferReserve(ByteBuffer *buf, size_t extra)
+{
+    if (buf->cap - buf->size < extra) {
+        while (buf->cap - buf->size < extra) {
+            buf->cap *= 2;
+        }
+        buf->data = safeRealloc(buf->data, buf->cap);
+    }
+}
+
+static void BufferPutVarint(ByteBuffer *buf, uint64_t val)
+{
+    BufferReserve(buf, VARINT_MAX_LEN);
+
+    while (val >= 0x80) {
+        buf->data[buf->size++] = (uint8_t) (val | 0x80);
+        val >>= 7;
+    }
+    buf->data[buf->size++] = (uint8_t) val;
+}
+
+static void BufferPutPolyHead(ByteBuffer *buf, const Poly *p)
+{
+    if (PolyIsCoeff(p)) {
+        uint64_t c = (uint64_t) (int64_t) p->coeff;
+
+        BufferPutVarint(buf, 0);
+        BufferPutVarint(buf, (c << 1) ^ (0 - (c >> 63)));    // zigzag: 0, -1, 1, -2, ...
+    }
+    else {
+        BufferPutVarint(buf, p->size);
+    }
+}
+
+static bool ReadVarint(const uint8_t *data, size_t size, size_t *pos, uint64_t *val)
+{
+    uint64_t res = 0;
+
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (*pos >= size) {
+            return false;
+        }
+        uint8_t byte = data[(*pos)++];
+
+        if (shift == 63 && byte > 1) {
+            return false;    // liczba nie mieści się w 64 bitach
+        }
+        res |= (uint64_t) (byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            *val = res;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool ReadPolyHead(const uint8_t *data, size_t size, size_t *pos, Poly *out, size_t *count)
+{
+    uint64_t head;
+
+    if (!ReadVarint(data, size, pos, &head)) {
+        return false;
+    }
+    if (head == 0) {
+        uint64_t zigzag;
+        if (!ReadVarint(data, size, pos, &zigzag)) {
+            return false;
+        }
+        int64_t c = (int64_t) ((zigzag >> 1) ^ (0 - (zigzag & 1)));
+        if (c < LONG_MIN || c > LONG_MAX) {
+            return false;
+        }
+        *out = PolyFromCoeff((poly_coeff_t) c);
+        *count = 0;
+        return true;
+    }
+    if (head > (size - *pos) / MIN_MONO_LEN) {
+        return false;    // jednomiany nie zmieszczą się w buforze
+    }
+    out->arr = safeMalloc(head * sizeof(Mono));
+    out->size = 0;
+    *count = head;
+    return true;
+}
+
+
+
+uint8_t *PolySerialize(const Poly *p, size_t *size)
+{
+    ByteBuffer buf = { .data = safeMalloc(SERIAL_INIT_CAP), .size = POLY_SERIAL_HEADER_LEN, .cap = SERIAL_INIT_CAP };
+
+    memcpy(buf.data, POLY_SERIAL_MAGIC, POLY_SERIAL_MAGIC_LEN);
+    buf.data[POLY_SERIAL_MAGIC_LEN] = POLY_SERIAL_VERSION;
+    BufferPutPolyHead(&buf, p);
+
+    if (!PolyIsCoeff(p)) {
+        vector_t *stack = VectorNew(sizeof(SerialFrame), INIT_CAP);
+        CHECK_POINTER(stack);
+        SerialFrame root = { .p = p, .next = 0 };
+        if (VectorPush(stack, &root) != VECT_OK) {
+            exit(EXIT_FAILURE);
+        }
+
+        while (!VectorIsEmpty(stack)) {
+            SerialFrame *top = (SerialFrame *) VectorPeek(stack);
+
+            if (top->next == top->p->size) {
+                VectorPop(stack);
+                continue;
+            }
+            const Mono *m = &top->p->arr[top->next];
+            if (top->next == 0) {
+                BufferPutVarint(&buf, (uint64_t) m->exp);
+            }
+            else {
+                BufferPutVarint(&buf, (uint64_t) (top->p->arr[top->next - 1].exp - m->exp - 1));
+            }
+            top->next++;
+            BufferPutPolyHead(&buf, &m->p);
+
+            if (!PolyIsCoeff(&m->p)) {
+                SerialFrame child = { .p = &m->p, .next = 0 };
+                if (VectorPush(stack, &child) != VECT_OK) {
+                    exit(EXIT_FAILURE);
+                }
+            }
+        }
+        VectorDestroy(stack);
+    }
+
+    *size = buf.size;
+    return buf.data;
+}
+
+bool PolyDeserialize(Poly *p, const uint8_t *data, size_t size)
+{
+    size_t pos = POLY_SERIAL_HEADER_LEN, count;
+    Poly root;
+
+    if (size < POLY_SERIAL_HEADER_LEN || memcmp(data, POLY_SERIAL_MAGIC, POLY_SERIAL_MAGIC_LEN) != 0
+        || data[POLY_SERIAL_MAGIC_LEN] != POLY_SERIAL_VERSION) {
+        return false;
+    }
+    if (!ReadPolyHead(data, size, &pos, &root, &count)) {
+        return false;
+    }
+
+    bool ok = true;
+    if (!PolyIsCoeff(&root)) {
+        vector_t *stack = VectorNew(sizeof(DeserialFrame), INIT_CAP);
+        CHECK_POINTER(stack);
+        DeserialFrame frame = { .out = &root, .count = count };
+        if (VectorPush(stack, &frame) != VECT_OK) {
+            exit(EXIT_FAILURE);
+        }
+
+        while (ok && !VectorIsEmpty(stack)) {
+            DeserialFrame *top = (DeserialFrame *) VectorPeek(stack);
+            Poly *out = top->out;
+
+            if (out->size == top->count) {    // wielomian postaci (c,0) powinien być współczynnikiem
+                ok = !(out->size == 1 && out->arr[0].exp == 0 && PolyIsCoeff(&out->arr[0].p));
+                VectorPop(stack);
+                continue;
+            }
+            uint64_t delta;
+            Mono *m = &out->arr[out->size];
+
+            if (!ReadVarint(data, size, &pos, &delta)) {
+                ok = false;
+            }
+            else if (out->size == 0) {
+                ok = delta <= INT_MAX;
+                m->exp = (poly_exp_t) delta;
+            }
+            else {
+                poly_exp_t prev = out->arr[out->size - 1].exp;
+                ok = delta < (uint64_t) prev;    // wykładniki muszą ściśle maleć
+                m->exp = prev - 1 - (poly_exp_t) delta;
+            }
+
+            if (ok && (ok = ReadPolyHead(data, size, &pos, &m->p, &count))) {
+                out->size++;
+                if (PolyIsCoeff(&m->p)) {
+                    ok = !PolyIsZero(&m->p);
+                }
+                else {
+                    frame = (DeserialFrame) { .out = &m->p, .count = count };
+                    if (VectorPush(stack, &frame) != VECT_OK) {
+                        exit(EXIT_FAILURE);
+                    }
+                }
+            }
+        }
+        VectorDestroy(stack);
+    }
+
+    if (!ok || pos != size) {
+        PolyDestroy(&root);
+        return false;
+    }
+    *p = root;
+    return true;
+}
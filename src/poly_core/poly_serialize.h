@@ -0,0 +1,73 @@
+/** @file
+  Interfejs binarnej serializacji wielomianów rzadkich wielu zmiennych
+
+  Format (wersja @ref POLY_SERIAL_VERSION) składa się z nagłówka
+  (@ref POLY_SERIAL_MAGIC i bajt wersji) oraz zapisu drzewa wielomianu
+  w porządku preorder. Każdy wielomian zaczyna się liczbą `n`:
+  - `n == 0` - wielomian jest współczynnikiem, zapisanym dalej w kodowaniu zigzag,
+  - `n > 0` - wielomian ma `n` jednomianów, po których kolei następują
+    wykładnik i współczynnik (wielomian zapisany w ten sam sposób).
+    Wykładnik pierwszego jednomianu zapisany jest wprost, a każdego
+    kolejnego jako różnica `poprzedni - obecny - 1`.
+
+  Wszystkie liczby zapisane są jako varint (po 7 bitów na bajt,
+  zaczynając od najmłodszych; najstarszy bit oznacza kontynuację).
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#ifndef __POLY_SERIALIZE_H__
+#define __POLY_SERIALIZE_H__
+
+#include <stdint.h>
+#include "poly.h"
+
+/**
+ * Sygnatura rozpoczynająca zserializowany wielomian.
+ */
+#define POLY_SERIAL_MAGIC "PLYB"
+
+/**
+ * Długość sygnatury @ref POLY_SERIAL_MAGIC.
+ */
+#define POLY_SERIAL_MAGIC_LEN 4
+
+/**
+ * Wersja formatu zapisywana w nagłówku.
+ */
+#define POLY_SERIAL_VERSION 1
+
+/**
+ * Długość nagłówka: sygnatura i bajt wersji.
+ */
+#define POLY_SERIAL_HEADER_LEN (POLY_SERIAL_MAGIC_LEN + 1)
+
+/**
+ * Serializuje wielomian do nowo zaalokowanego bufora.
+ * Drzewo wielomianu przechodzone jest iteracyjnie.
+ *
+ * @param[in] p : wielomian
+ * @param[out] size : długość wyniku w bajtach
+ *
+ * @return : bufor z nagłówkiem i zapisem wielomianu (do zwolnienia przez free())
+ */
+uint8_t *PolySerialize(const Poly *p, size_t *size);
+
+/**
+ * Odtwarza wielomian z bufora utworzonego przez PolySerialize().
+ * Sprawdza nagłówek, zakres liczb oraz to, czy wielomian jest
+ * w postaci kanonicznej (malejące wykładniki, brak zerowych
+ * współczynników i jednomianów postaci @f$c x^0@f$ jako jedynej
+ * zawartości wielomianu) i zajmuje cały bufor.
+ *
+ * @param[out] p : odtworzony wielomian (tylko w przypadku sukcesu)
+ * @param[in] data : bufor
+ * @param[in] size : długość bufora w bajtach
+ *
+ * @return : czy bufor zawiera poprawnie zapisany wielomian
+ */
+bool PolyDeserialize(Poly *p, const uint8_t *data, size_t size);
+
+#endif //__POLY_SERIALIZE_H__
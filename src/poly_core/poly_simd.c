@@ -0,0 +1,458 @@
+/** @file
+  Implementacja wektorowych operacji na warstwach jednomianów wielomianów
+  rzadkich wielu zmiennych
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#include <stdint.h>
+#include "poly_simd.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define POLY_SIMD_X86 ///< Kompilacja wariantów AVX2 i AVX-512
+#include <immintrin.h>
+
+_Static_assert(sizeof(Mono) == 3 * sizeof(uint64_t), "jednomian musi zajmować trzy słowa");
+#endif
+
+/**
+ * Najmniejsza liczba jednomianów, dla której opłaca się wariant wektorowy.
+ */
+#define SIMD_MIN_COUNT 4
+
+/**
+ * Najwyższy dopuszczalny poziom instrukcji (zob. PolySimdLimit()).
+ */
+static PolySimdLevel simdLimit = POLY_SIMD_AVX512;
+
+
+
+/**
+ * Skalarny wariant MonosAreCoeffs().
+ *
+ * @param[in] monos : jednomiany
+ * @param[in] count : liczba jednomianów
+ *
+ * @return : czy warstwa składa się z samych współczynników
+ */
+static bool MonosAreCoeffsScalar(const Mono *monos, size_t count);
+
+/**
+ * Skalarny wariant MonosScale().
+ *
+ * @param[out] dst : jednomiany docelowe
+ * @param[in] src : jednomiany źródłowe
+ * @param[in] count : liczba jednomianów
+ * @param[in] c : mnożnik
+ */
+static void MonosScaleScalar(Mono *dst, const Mono *src, size_t count, poly_coeff_t c);
+
+/**
+ * Skalarny wariant MonosMatchPrefix().
+ *
+ * @param[in] a : jednomiany
+ * @param[in] b : jednomiany
+ * @param[in] count : liczba jednomianów
+ *
+ * @return : liczba identycznych jednomianów na początku tablic
+ */
+static size_t MonosMatchPrefixScalar(const Mono *a, const Mono *b, size_t count);
+
+/**
+ * Skalarny wariant LanesHorner().
+ *
+ * @param[in, out] acc : wartości dotychczasowych jednomianów
+ * @param[in] x : wartości zmiennej w punktach
+ * @param[in] gap : różnica wykładników
+ * @param[in] v : wartości współczynnika
+ */
+static void LanesHornerScalar(uint64_t acc[], const uint64_t x[], uint64_t gap, const uint64_t v[]);
+
+#ifdef POLY_SIMD_X86
+/**
+ * Mnoży 64-bitowe liczby w rejestrze AVX2 (z przekręcaniem się),
+ * składając iloczyn z mnożeń 32-bitowych.
+ *
+ * @param[in] a : czynnik
+ * @param[in] b : czynnik
+ *
+ * @return : iloczyn
+ */
+static inline __m256i Mul64Avx2(__m256i a, __m256i b) __attribute__((target("avx2")));
+
+/**
+ * Wariant AVX2 funkcji MonosAreCoeffs() - cztery jednomiany
+ * (trzy rejestry) na iterację.
+ *
+ * @param[in] monos : jednomiany
+ * @param[in] count : liczba jednomianów
+ *
+ * @return : czy warstwa składa się z samych współczynników
+ */
+static bool MonosAreCoeffsAvx2(const Mono *monos, size_t count) __attribute__((target("avx2")));
+
+/**
+ * Wariant AVX2 funkcji MonosScale().
+ *
+ * @param[out] dst : jednomiany docelowe
+ * @param[in] src : jednomiany źródłowe
+ * @param[in] count : liczba jednomianów
+ * @param[in] c : mnożnik
+ */
+static void MonosScaleAvx2(Mono *dst, const Mono *src, size_t count, poly_coeff_t c) __attribute__((target("avx2")));
+
+/**
+ * Wariant AVX2 funkcji MonosMatchPrefix().
+ *
+ * @param[in] a : jednomiany
+ * @param[in] b : jednomiany
+ * @param[in] count : liczba jednomianów
+ *
+ * @return : liczba identycznych jednomianów na początku tablic
+ */
+static size_t MonosMatchPrefixAvx2(const Mono *a, const Mono *b, size_t count) __attribute__((target("avx2")));
+
+/**
+ * Wariant AVX-512 funkcji MonosAreCoeffs() - osiem jednomianów
+ * (trzy rejestry) na iterację.
+ *
+ * @param[in] monos : jednomiany
+ * @param[in] count : liczba jednomianów
+ *
+ * @return : czy warstwa składa się z samych współczynników
+ */
+static bool MonosAreCoeffsAvx512(const Mono *monos, size_t count) __attribute__((target("avx512f,avx512dq")));
+
+/**
+ * Wariant AVX-512 funkcji MonosScale().
+ *
+ * @param[out] dst : jednomiany docelowe
+ * @param[in] src : jednomiany źródłowe
+ * @param[in] count : liczba jednomianów
+ * @param[in] c : mnożnik
+ */
+static void MonosScaleAvx512(Mono *dst, const Mono *src, size_t count, poly_coeff_t c)
+    __attribute__((target("avx512f,avx512dq")));
+
+/**
+ * Wariant AVX-512 funkcji MonosMatchPrefix().
+ *
+ * @param[in] a : jednomiany
+ * @param[in] b : jednomiany
+ * @param[in] count : liczba jednomianów
+ *
+ * @return : liczba identycznych jednomianów na początku tablic
+ */
+static size_t MonosMatchPrefixAvx512(const Mono *a, const Mono *b, size_t count)
+    __attribute__((target("avx512f,avx512dq")));
+
+/**
+ * Wariant AVX2 funkcji LanesHorner() - punkty w dwóch rejestrach.
+ *
+ * @param[in, out] acc : wartości dotychczasowych jednomianów
+ * @param[in] x : wartości zmiennej w punktach
+ * @param[in] gap : różnica wykładników
+ * @param[in] v : wartości współczynnika
+ */
+static void LanesHornerAvx2(uint64_t acc[], const uint64_t x[], uint64_t gap, const uint64_t v[])
+    __attribute__((target("avx2")));
+
+/**
+ * Wariant AVX-512 funkcji LanesHorner() - punkty w jednym rejestrze.
+ *
+ * @param[in, out] acc : wartości dotychczasowych jednomianów
+ * @param[in] x : wartości zmiennej w punktach
+ * @param[in] gap : różnica wykładników
+ * @param[in] v : wartości współczynnika
+ */
+static void LanesHornerAvx512(uint64_t acc[], const uint64_t x[], uint64_t gap, const uint64_t v[])
+    __attribute__((target("avx512f,avx512dq")));
+#endif
+
+
+
+static bool MonosAreCoeffsScalar(const Mono *monos, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (!PolyIsCoeff(&monos[i].p)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void MonosScaleScalar(Mono *dst, const Mono *src, size_t count, poly_coeff_t c)
+{
+    for (size_t i = 0; i < count; i++) {
+        dst[i].p = PolyFromCoeff((poly_coeff_t) ((uint64_t) src[i].p.coeff * (uint64_t) c));
+        dst[i].exp = src[i].exp;
+    }
+}
+
+static size_t MonosMatchPrefixScalar(const Mono *a, const Mono *b, size_t count)
+{
+    size_t i = 0;
+
+    while (i < count && a[i].exp == b[i].exp && a[i].p.arr == b[i].p.arr && a[i].p.size == b[i].p.size) {
+        i++;
+    }
+    return i;
+}
+
+static void LanesHornerScalar(uint64_t acc[], const uint64_t x[], uint64_t gap, const uint64_t v[])
+{
+    for (size_t l = 0; l < POLY_SIMD_LANES; l++) {
+        uint64_t base = x[l], pw = 1;
+
+        for (uint64_t e = gap; e > 0; e >>= 1) {
+            if (e & 1) {
+                pw *= base;
+            }
+            base *= base;
+        }
+        acc[l] = acc[l] * pw + v[l];
+    }
+}
+
+#ifdef POLY_SIMD_X86
+/*
+ * Cztery jednomiany to słowa 0-11: współczynniki w słowach 0, 3, 6, 9,
+ * wskaźniki w 1, 4, 7, 10, wykładniki w 2, 5, 8, 11. Osiem jednomianów
+ * (słowa 0-23) rozkłada się analogicznie na trzy rejestry AVX-512.
+ */
+
+static inline __m256i Mul64Avx2(__m256i a, __m256i b)
+{
+    __m256i lo = _mm256_mul_epu32(a, b);
+    __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+                                     _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+
+    return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+}
+
+static bool MonosAreCoeffsAvx2(const Mono *monos, size_t count)
+{
+    const __m256i ptr0 = _mm256_setr_epi64x(0, -1, 0, 0);
+    const __m256i ptr1 = _mm256_setr_epi64x(-1, 0, 0, -1);
+    const __m256i ptr2 = _mm256_setr_epi64x(0, 0, -1, 0);
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        const __m256i *words = (const __m256i *) &monos[i];
+        acc = _mm256_or_si256(acc, _mm256_and_si256(_mm256_loadu_si256(words), ptr0));
+        acc = _mm256_or_si256(acc, _mm256_and_si256(_mm256_loadu_si256(words + 1), ptr1));
+        acc = _mm256_or_si256(acc, _mm256_and_si256(_mm256_loadu_si256(words + 2), ptr2));
+    }
+    return _mm256_testz_si256(acc, acc) && MonosAreCoeffsScalar(monos + i, count - i);
+}
+
+static void MonosScaleAvx2(Mono *dst, const Mono *src, size_t count, poly_coeff_t c)
+{
+    const __m256i mul0 = _mm256_setr_epi64x(c, 1, 1, c);    // wskaźniki (NULL) i wykładniki mnożone przez 1
+    const __m256i mul1 = _mm256_setr_epi64x(1, 1, c, 1);
+    const __m256i mul2 = _mm256_setr_epi64x(1, c, 1, 1);
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        const __m256i *in = (const __m256i *) &src[i];
+        __m256i *out = (__m256i *) &dst[i];
+        __m256i v0 = _mm256_loadu_si256(in), v1 = _mm256_loadu_si256(in + 1), v2 = _mm256_loadu_si256(in + 2);
+
+        _mm256_storeu_si256(out, Mul64Avx2(v0, mul0));
+        _mm256_storeu_si256(out + 1, Mul64Avx2(v1, mul1));
+        _mm256_storeu_si256(out + 2, Mul64Avx2(v2, mul2));
+    }
+    MonosScaleScalar(dst + i, src + i, count - i, c);
+}
+
+static size_t MonosMatchPrefixAvx2(const Mono *a, const Mono *b, size_t count)
+{
+    const __m256i low = _mm256_set1_epi64x(0xffffffff);    // wyrównanie po wykładniku nie jest porównywane
+    const __m256i keep0 = _mm256_blend_epi32(_mm256_set1_epi64x(-1), low, 0x30);
+    const __m256i keep1 = _mm256_blend_epi32(_mm256_set1_epi64x(-1), low, 0x0c);
+    const __m256i keep2 = _mm256_blend_epi32(_mm256_set1_epi64x(-1), low, 0xc3);
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        const __m256i *wa = (const __m256i *) &a[i], *wb = (const __m256i *) &b[i];
+        __m256i diff = _mm256_and_si256(_mm256_xor_si256(_mm256_loadu_si256(wa), _mm256_loadu_si256(wb)), keep0);
+        diff = _mm256_or_si256(diff, _mm256_and_si256(_mm256_xor_si256(_mm256_loadu_si256(wa + 1),
+                                                                        _mm256_loadu_si256(wb + 1)), keep1));
+        diff = _mm256_or_si256(diff, _mm256_and_si256(_mm256_xor_si256(_mm256_loadu_si256(wa + 2),
+                                                                        _mm256_loadu_si256(wb + 2)), keep2));
+        if (!_mm256_testz_si256(diff, diff)) {
+            break;    // różnicę w tej czwórce wskaże pętla skalarna
+        }
+    }
+    return i + MonosMatchPrefixScalar(a + i, b + i, count - i);
+}
+
+static bool MonosAreCoeffsAvx512(const Mono *monos, size_t count)
+{
+    __m512i acc = _mm512_setzero_si512();
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        const __m512i *words = (const __m512i *) &monos[i];
+        acc = _mm512_mask_or_epi64(acc, 0x92, acc, _mm512_loadu_si512(words));
+        acc = _mm512_mask_or_epi64(acc, 0x24, acc, _mm512_loadu_si512(words + 1));
+        acc = _mm512_mask_or_epi64(acc, 0x49, acc, _mm512_loadu_si512(words + 2));
+    }
+    return _mm512_test_epi64_mask(acc, acc) == 0 && MonosAreCoeffsAvx2(monos + i, count - i);
+}
+
+static void MonosScaleAvx512(Mono *dst, const Mono *src, size_t count, poly_coeff_t c)
+{
+    const __m512i mul = _mm512_set1_epi64(c);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        const __m512i *in = (const __m512i *) &src[i];
+        __m512i *out = (__m512i *) &dst[i];
+        __m512i v0 = _mm512_loadu_si512(in), v1 = _mm512_loadu_si512(in + 1), v2 = _mm512_loadu_si512(in + 2);
+
+        _mm512_storeu_si512(out, _mm512_mask_mullo_epi64(v0, 0x49, v0, mul));
+        _mm512_storeu_si512(out + 1, _mm512_mask_mullo_epi64(v1, 0x92, v1, mul));
+        _mm512_storeu_si512(out + 2, _mm512_mask_mullo_epi64(v2, 0x24, v2, mul));
+    }
+    MonosScaleAvx2(dst + i, src + i, count - i, c);
+}
+
+static size_t MonosMatchPrefixAvx512(const Mono *a, const Mono *b, size_t count)
+{
+    const __m512i low = _mm512_set1_epi64(0xffffffff);
+    const __m512i keep0 = _mm512_mask_blend_epi64(0x24, _mm512_set1_epi64(-1), low);
+    const __m512i keep1 = _mm512_mask_blend_epi64(0x49, _mm512_set1_epi64(-1), low);
+    const __m512i keep2 = _mm512_mask_blend_epi64(0x92, _mm512_set1_epi64(-1), low);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        const __m512i *wa = (const __m512i *) &a[i], *wb = (const __m512i *) &b[i];
+        __m512i diff = _mm512_and_si512(_mm512_xor_si512(_mm512_loadu_si512(wa), _mm512_loadu_si512(wb)), keep0);
+        diff = _mm512_ternarylogic_epi64(diff, _mm512_xor_si512(_mm512_loadu_si512(wa + 1), _mm512_loadu_si512(wb + 1)),
+                                         keep1, 0xf8);    // diff | (x & keep)
+        diff = _mm512_ternarylogic_epi64(diff, _mm512_xor_si512(_mm512_loadu_si512(wa + 2), _mm512_loadu_si512(wb + 2)),
+                                         keep2, 0xf8);
+        if (_mm512_test_epi64_mask(diff, diff) != 0) {
+            break;
+        }
+    }
+    return i + MonosMatchPrefixAvx2(a + i, b + i, count - i);
+}
+
+static void LanesHornerAvx2(uint64_t acc[], const uint64_t x[], uint64_t gap, const uint64_t v[])
+{
+    __m256i base0 = _mm256_loadu_si256((const __m256i *) x), base1 = _mm256_loadu_si256((const __m256i *) x + 1);
+    __m256i pw0 = _mm256_set1_epi64x(1), pw1 = pw0;
+
+    for (uint64_t e = gap; e > 0; e >>= 1) {    // potęgi liczone wspólnie, bo wykładnik jest ten sam we wszystkich punktach
+        if (e & 1) {
+            pw0 = Mul64Avx2(pw0, base0);
+            pw1 = Mul64Avx2(pw1, base1);
+        }
+        if (e > 1) {
+            base0 = Mul64Avx2(base0, base0);
+            base1 = Mul64Avx2(base1, base1);
+        }
+    }
+    __m256i *out = (__m256i *) acc;
+    const __m256i *add = (const __m256i *) v;
+
+    _mm256_storeu_si256(out, _mm256_add_epi64(Mul64Avx2(_mm256_loadu_si256(out), pw0), _mm256_loadu_si256(add)));
+    _mm256_storeu_si256(out + 1, _mm256_add_epi64(Mul64Avx2(_mm256_loadu_si256(out + 1), pw1),
+                                                  _mm256_loadu_si256(add + 1)));
+}
+
+static void LanesHornerAvx512(uint64_t acc[], const uint64_t x[], uint64_t gap, const uint64_t v[])
+{
+    __m512i base = _mm512_loadu_si512(x), pw = _mm512_set1_epi64(1);
+
+    for (uint64_t e = gap; e > 0; e >>= 1) {
+        if (e & 1) {
+            pw = _mm512_mullo_epi64(pw, base);
+        }
+        if (e > 1) {
+            base = _mm512_mullo_epi64(base, base);
+        }
+    }
+    _mm512_storeu_si512(acc, _mm512_add_epi64(_mm512_mullo_epi64(_mm512_loadu_si512(acc), pw), _mm512_loadu_si512(v)));
+}
+#endif
+
+
+
+void PolySimdLimit(PolySimdLevel max)
+{
+    simdLimit = max;
+}
+
+PolySimdLevel PolySimdGetLevel(void)
+{
+#ifdef POLY_SIMD_X86
+    if (simdLimit >= POLY_SIMD_AVX512 && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq")) {
+        return POLY_SIMD_AVX512;
+    }
+    if (simdLimit >= POLY_SIMD_AVX2 && __builtin_cpu_supports("avx2")) {
+        return POLY_SIMD_AVX2;
+    }
+#endif
+    return POLY_SIMD_SCALAR;
+}
+
+bool MonosAreCoeffs(const Mono *monos, size_t count)
+{
+#ifdef POLY_SIMD_X86
+    if (count >= SIMD_MIN_COUNT) {
+        switch (PolySimdGetLevel()) {
+            case POLY_SIMD_AVX512: return MonosAreCoeffsAvx512(monos, count);
+            case POLY_SIMD_AVX2: return MonosAreCoeffsAvx2(monos, count);
+            default: break;
+        }
+    }
+#endif
+    return MonosAreCoeffsScalar(monos, count);
+}
+
+void MonosScale(Mono *dst, const Mono *src, size_t count, poly_coeff_t c)
+{
+#ifdef POLY_SIMD_X86
+    if (count >= SIMD_MIN_COUNT) {
+        switch (PolySimdGetLevel()) {
+            case POLY_SIMD_AVX512: MonosScaleAvx512(dst, src, count, c); return;
+            case POLY_SIMD_AVX2: MonosScaleAvx2(dst, src, count, c); return;
+            default: break;
+        }
+    }
+#endif
+    MonosScaleScalar(dst, src, count, c);
+}
+
+size_t MonosMatchPrefix(const Mono *a, const Mono *b, size_t count)
+{
+#ifdef POLY_SIMD_X86
+    if (count >= SIMD_MIN_COUNT) {
+        switch (PolySimdGetLevel()) {
+            case POLY_SIMD_AVX512: return MonosMatchPrefixAvx512(a, b, count);
+            case POLY_SIMD_AVX2: return MonosMatchPrefixAvx2(a, b, count);
+            default: break;
+        }
+    }
+#endif
+    return MonosMatchPrefixScalar(a, b, count);
+}
+
+void LanesHorner(uint64_t acc[POLY_SIMD_LANES], const uint64_t x[POLY_SIMD_LANES], uint64_t gap,
+                 const uint64_t v[POLY_SIMD_LANES])
+{
+#ifdef POLY_SIMD_X86
+    switch (PolySimdGetLevel()) {
+        case POLY_SIMD_AVX512: LanesHornerAvx512(acc, x, gap, v); return;
+        case POLY_SIMD_AVX2: LanesHornerAvx2(acc, x, gap, v); return;
+        default: break;
+    }
+#endif
+    LanesHornerScalar(acc, x, gap, v);
+}
@@ -0,0 +1,103 @@
+/** @file
+  Interfejs wektorowych operacji na warstwach jednomianów wielomianów
+  rzadkich wielu zmiennych
+
+  Operacje działają na tablicach jednomianów w miejscu, bez rekurencji,
+  i korzystają z instrukcji AVX-512 lub AVX2, jeśli procesor je obsługuje
+  (wybór następuje w czasie działania programu), a w przeciwnym razie
+  z pętli skalarnych. Jednomian zajmuje trzy słowa 64-bitowe (współczynnik
+  lub rozmiar, wskaźnik na tablicę, wykładnik z wyrównaniem), więc jeden
+  rejestr obejmuje kilka jednomianów naraz, a współczynniki wybierane są
+  stałymi maskami. Wartościowanie w wielu punktach naraz korzysta z kroku
+  schematu Hornera wykonywanego dla @ref POLY_SIMD_LANES punktów w jednym
+  rejestrze AVX-512 (lub dwóch AVX2).
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#ifndef __POLY_SIMD_H__
+#define __POLY_SIMD_H__
+
+#include <stdint.h>
+#include "poly.h"
+
+/**
+ * Liczba punktów, dla których LanesHorner() wykonuje krok jednocześnie.
+ */
+#define POLY_SIMD_LANES 8
+
+/**
+ * Poziom wykorzystywanych instrukcji wektorowych.
+ */
+typedef enum PolySimdLevel {
+    POLY_SIMD_SCALAR,   ///< wyłącznie pętle skalarne
+    POLY_SIMD_AVX2,     ///< AVX2
+    POLY_SIMD_AVX512    ///< AVX-512 (F i DQ)
+} PolySimdLevel;
+
+/**
+ * Ogranicza poziom wykorzystywanych instrukcji (np. na potrzeby testów
+ * i pomiarów). Poziom nieobsługiwany przez procesor nie zostanie użyty.
+ *
+ * @param[in] max : najwyższy dopuszczalny poziom
+ */
+void PolySimdLimit(PolySimdLevel max);
+
+/**
+ * Zwraca poziom instrukcji, z którego korzystają operacje.
+ *
+ * @return : poziom
+ */
+PolySimdLevel PolySimdGetLevel(void);
+
+/**
+ * Sprawdza, czy wszystkie jednomiany mają współczynniki będące liczbami.
+ *
+ * @param[in] monos : jednomiany
+ * @param[in] count : liczba jednomianów
+ *
+ * @return : czy warstwa składa się z samych współczynników
+ */
+bool MonosAreCoeffs(const Mono *monos, size_t count);
+
+/**
+ * Kopiuje jednomiany, mnożąc ich współczynniki przez @p c
+ * (z przekręcaniem się modulo @f$2^{64}@f$). Wynik może zawierać
+ * zerowe współczynniki.
+ *
+ * @param[out] dst : jednomiany docelowe (mogą być tymi samymi co @p src)
+ * @param[in] src : jednomiany o współczynnikach będących liczbami
+ * @param[in] count : liczba jednomianów
+ * @param[in] c : mnożnik
+ */
+void MonosScale(Mono *dst, const Mono *src, size_t count, poly_coeff_t c);
+
+/**
+ * Zwraca długość najdłuższego wspólnego prefiksu dwóch tablic jednomianów,
+ * w którym odpowiadające sobie jednomiany mają ten sam wykładnik i ten sam
+ * współczynnik lub tę samą (współdzieloną) tablicę jednomianów.
+ *
+ * @param[in] a : jednomiany
+ * @param[in] b : jednomiany
+ * @param[in] count : liczba jednomianów w każdej z tablic
+ *
+ * @return : liczba identycznych jednomianów na początku tablic
+ */
+size_t MonosMatchPrefix(const Mono *a, const Mono *b, size_t count);
+
+/**
+ * Wykonuje krok schematu Hornera jednocześnie dla @ref POLY_SIMD_LANES
+ * punktów: @f$acc_l \leftarrow acc_l \cdot x_l^{gap} + v_l@f$
+ * (z przekręcaniem się modulo @f$2^{64}@f$).
+ *
+ * @param[in, out] acc : wartości dotychczasowych jednomianów
+ * @param[in] x : wartości zmiennej w punktach
+ * @param[in] gap : różnica wykładników kolejnych jednomianów
+ * @param[in] v : wartości współczynnika kolejnego jednomianu
+ */
+void LanesHorner(uint64_t acc[POLY_SIMD_LANES], const uint64_t x[POLY_SIMD_LANES], uint64_t gap,
+                 const uint64_t v[POLY_SIMD_LANES]);
+
+#endif //__POLY_SIMD_H__
@@ -0,0 +1,430 @@
+/** @file
+  Implementacja odwzorowywanych w pamięci snapshotów wielomianów rzadkich wielu zmiennych
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+/** Makro zdefiniowane, aby korzystać z mmap(). */
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "poly_snapshot.h"
+#include "../utils/vector.h"
+
+/**
+ * Konwencja przyjęta w treści zadania.
+ */
+#define DEG_OF_ZERO -1
+
+/**
+ * Początkowa pojemność bufora snapshotu (w bajtach).
+ */
+#define SNAPSHOT_INIT_CAP 256
+
+/**
+ * Generyczne maksimum.
+ *
+ * @param[in] a : obiekt do porównania
+ * @param[in] b : obiekt do porównania
+ *
+ * @return : maksimum z dwóch obiektów
+ */
+#define MAX(a,b) (a >= b)? a : b
+
+/**
+ * Ramka stosu przy zapisywaniu snapshotu.
+ */
+typedef struct EncodeFrame {
+    const Poly *p;      ///< zapisywany wielomian
+    size_t nodePos;     ///< pozycja w buforze węzła, którego przesunięcie trzeba uzupełnić
+} EncodeFrame;
+
+/**
+ * Ramka stosu przy przechodzeniu drzewa w snapshocie.
+ */
+typedef struct SnapFrame {
+    const PolySnapNode *node;  ///< aktualnie przetwarzany wielomian
+    union {
+        Poly *out;             ///< wielomian docelowy (SnapNodeToPoly())
+        const Poly *q;         ///< porównywany wielomian (PolySnapshotIsEqPoly())
+        size_t depth;          ///< głębokość wielomianu w drzewie (PolySnapshotDegBy())
+        poly_exp_t acc;        ///< suma wykładników na ścieżce od korzenia (PolySnapshotDeg())
+    };
+} SnapFrame;
+
+
+
+/**
+ * Wstawia ramkę na stos, kończąc program przy braku pamięci.
+ *
+ * @param[in, out] stack : stos
+ * @param[in] frame : ramka
+ */
+static void SnapPush(vector_t *stack, const void *frame);
+
+/**
+ * Sprawdza poprawność odwzorowanego pliku snapshotu.
+ * @see PolySnapshotOpen()
+ *
+ * @param[in] base : początek pliku
+ * @param[in] length : długość pliku
+ *
+ * @return : czy plik jest poprawnym snapshotem
+ */
+static bool SnapshotValidate(const uint8_t *base, size_t length);
+
+/**
+ * Odtwarza w pamięci wielomian @p node ze snapshotu.
+ *
+ * @param[in] snap : snapshot
+ * @param[in] node : wielomian w snapshocie
+ *
+ * @return : wielomian
+ */
+static Poly SnapNodeToPoly(const PolySnapshot *snap, const PolySnapNode *node);
+
+
+
+static void SnapPush(vector_t *stack, const void *frame)
+{
+    if (VectorPush(stack, frame) != VECT_OK) {
+        exit(EXIT_FAILURE);
+    }
+}
+
+static bool SnapshotValidate(const uint8_t *base, size_t length)
+{
+    const PolySnapHeader *header = (const PolySnapHeader *) base;
+
+    if (memcmp(header->magic, POLY_SNAPSHOT_MAGIC, sizeof(header->magic)) != 0
+        || header->version != POLY_SNAPSHOT_VERSION || header->length != length) {
+        return false;
+    }
+    if (header->root.size == 0) {
+        return length == sizeof(PolySnapHeader) && header->root.coeff >= LONG_MIN && header->root.coeff <= LONG_MAX;
+    }
+
+    size_t cursor = sizeof(PolySnapHeader);
+    bool ok = true;
+    vector_t *stack = VectorNew(sizeof(const PolySnapNode *), INIT_CAP);
+    CHECK_POINTER(stack);
+    const PolySnapNode *root = &header->root;
+    SnapPush(stack, &root);
+
+    while (ok && !VectorIsEmpty(stack)) {
+        const PolySnapNode *node = *(const PolySnapNode **) VectorPop(stack);
+
+        if (node->offset != cursor || node->size > (length - cursor) / sizeof(PolySnapMono)) {
+            ok = false;    // tablice muszą leżeć kolejno w porządku preorder
+            break;
+        }
+        const PolySnapMono *monos = (const PolySnapMono *) (base + cursor);
+        cursor += node->size * sizeof(PolySnapMono);
+        ok = !(node->size == 1 && monos[0].exp == 0 && monos[0].p.size == 0);
+
+        for (size_t i = node->size; ok && i-- > 0; ) {    // od końca, aby pierwszy jednomian zdjąć jako pierwszy
+            const PolySnapMono *m = &monos[i];
+
+            ok = m->exp >= 0 && m->exp <= INT_MAX && (i == 0 || monos[i - 1].exp > m->exp);
+            if (ok && m->p.size == 0) {
+                ok = m->p.coeff != 0 && m->p.coeff >= LONG_MIN && m->p.coeff <= LONG_MAX;
+            }
+            else if (ok) {
+                const PolySnapNode *child = &m->p;
+                SnapPush(stack, &child);
+            }
+        }
+    }
+    VectorDestroy(stack);
+    return ok && cursor == length;
+}
+
+static Poly SnapNodeToPoly(const PolySnapshot *snap, const PolySnapNode *node)
+{
+    if (node->size == 0) {
+        return PolyFromCoeff((poly_coeff_t) node->coeff);
+    }
+    Poly res;
+    vector_t *stack = VectorNew(sizeof(SnapFrame), INIT_CAP);
+    CHECK_POINTER(stack);
+    SnapFrame root = { .node = node, .out = &res };
+    SnapPush(stack, &root);
+
+    while (!VectorIsEmpty(stack)) {
+        SnapFrame frame = *(SnapFrame *) VectorPop(stack);
+        const PolySnapMono *monos = PolySnapshotMonos(snap, frame.node);
+
+        frame.out->size = frame.node->size;
+        frame.out->arr = safeMalloc(frame.node->size * sizeof(Mono));
+
+        for (size_t i = 0; i < frame.node->size; i++) {
+            Mono *dst = &frame.out->arr[i];
+
+            dst->exp = (poly_exp_t) monos[i].exp;
+            if (monos[i].p.size == 0) {
+                dst->p = PolyFromCoeff((poly_coeff_t) monos[i].p.coeff);
+            }
+            else {
+                SnapFrame child = { .node = &monos[i].p, .out = &dst->p };
+                SnapPush(stack, &child);
+            }
+        }
+    }
+    VectorDestroy(stack);
+    return res;
+}
+
+
+
+uint8_t *PolySnapshotEncode(const Poly *p, size_t *size)
+{
+    size_t len = sizeof(PolySnapHeader), cap = SNAPSHOT_INIT_CAP;
+    uint8_t *buf = safeCalloc(cap, 1);
+    PolySnapHeader *header = (PolySnapHeader *) buf;
+
+    memcpy(header->magic, POLY_SNAPSHOT_MAGIC, sizeof(header->magic));
+    header->version = POLY_SNAPSHOT_VERSION;
+    if (PolyIsCoeff(p)) {
+        header->root.size = 0;
+        header->root.coeff = p->coeff;
+    }
+    else {
+        header->root.size = p->size;
+        vector_t *stack = VectorNew(sizeof(EncodeFrame), INIT_CAP);
+        CHECK_POINTER(stack);
+        EncodeFrame root = { .p = p, .nodePos = offsetof(PolySnapHeader, root) };
+        SnapPush(stack, &root);
+
+        while (!VectorIsEmpty(stack)) {
+            EncodeFrame frame = *(EncodeFrame *) VectorPop(stack);
+            size_t arrLen = frame.p->size * sizeof(PolySnapMono);
+
+            if (cap - len < arrLen) {
+                while (cap - len < arrLen) {
+                    cap *= 2;
+                }
+                buf = safeRealloc(buf, cap);
+            }
+            ((PolySnapNode *) (buf + frame.nodePos))->offset = len;
+            PolySnapMono *monos = (PolySnapMono *) (buf + len);
+
+            for (size_t i = frame.p->size; i-- > 0; ) {    // od końca, aby pierwszy jednomian zdjąć jako pierwszy
+                const Mono *m = &frame.p->arr[i];
+
+                monos[i].exp = m->exp;
+                if (PolyIsCoeff(&m->p)) {
+                    monos[i].p.size = 0;
+                    monos[i].p.coeff = m->p.coeff;
+                }
+                else {
+                    monos[i].p.size = m->p.size;
+                    EncodeFrame child = { .p = &m->p, .nodePos = len + i * sizeof(PolySnapMono) };
+                    SnapPush(stack, &child);
+                }
+            }
+            len += arrLen;
+        }
+        VectorDestroy(stack);
+    }
+
+    ((PolySnapHeader *) buf)->length = len;
+    *size = len;
+    return buf;
+}
+
+PolySnapStatus PolySnapshotOpen(PolySnapshot **snap, const char *path)
+{
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+
+    if (fd == -1) {
+        return SNAPSHOT_FILE_ERROR;
+    }
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        return SNAPSHOT_FILE_ERROR;
+    }
+    size_t length = (size_t) st.st_size;
+    if (length < sizeof(PolySnapHeader)) {
+        close(fd);
+        return SNAPSHOT_FORMAT_ERROR;
+    }
+    void *map = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED) {
+        return SNAPSHOT_FILE_ERROR;
+    }
+    if (!SnapshotValidate(map, length)) {
+        munmap(map, length);
+        return SNAPSHOT_FORMAT_ERROR;
+    }
+    *snap = safeMalloc(sizeof(PolySnapshot));
+    (*snap)->base = map;
+    (*snap)->length = length;
+    (*snap)->refs = 1;
+    return SNAPSHOT_OK;
+}
+
+PolySnapshot *PolySnapshotRetain(PolySnapshot *snap)
+{
+    snap->refs++;
+    return snap;
+}
+
+void PolySnapshotRelease(PolySnapshot *snap)
+{
+    if (--snap->refs == 0) {
+        munmap((void *) snap->base, snap->length);
+        free(snap);
+    }
+}
+
+const PolySnapNode *PolySnapshotRoot(const PolySnapshot *snap)
+{
+    return &((const PolySnapHeader *) snap->base)->root;
+}
+
+const PolySnapMono *PolySnapshotMonos(const PolySnapshot *snap, const PolySnapNode *node)
+{
+    assert(node->size > 0);
+
+    return (const PolySnapMono *) (snap->base + node->offset);
+}
+
+Poly PolySnapshotToPoly(const PolySnapshot *snap)
+{
+    return SnapNodeToPoly(snap, PolySnapshotRoot(snap));
+}
+
+bool PolySnapshotIsCoeff(const PolySnapshot *snap)
+{
+    return PolySnapshotRoot(snap)->size == 0;
+}
+
+bool PolySnapshotIsZero(const PolySnapshot *snap)
+{
+    return PolySnapshotIsCoeff(snap) && PolySnapshotRoot(snap)->coeff == 0;
+}
+
+poly_exp_t PolySnapshotDeg(const PolySnapshot *snap)
+{
+    const PolySnapNode *root = PolySnapshotRoot(snap);
+
+    if (root->size == 0) {
+        return (root->coeff == 0) ? DEG_OF_ZERO : 0;
+    }
+    poly_exp_t deg = 0;
+    vector_t *stack = VectorNew(sizeof(SnapFrame), INIT_CAP);
+    CHECK_POINTER(stack);
+    SnapFrame frame = { .node = root, .acc = 0 };
+    SnapPush(stack, &frame);
+
+    while (!VectorIsEmpty(stack)) {
+        frame = *(SnapFrame *) VectorPop(stack);
+        const PolySnapMono *monos = PolySnapshotMonos(snap, frame.node);
+
+        for (size_t i = 0; i < frame.node->size; i++) {
+            poly_exp_t mono_deg = frame.acc + (poly_exp_t) monos[i].exp;    // współczynniki są niezerowe
+
+            if (monos[i].p.size > 0) {
+                SnapFrame child = { .node = &monos[i].p, .acc = mono_deg };
+                SnapPush(stack, &child);
+            }
+            deg = MAX(deg, mono_deg);
+        }
+    }
+    VectorDestroy(stack);
+    return deg;
+}
+
+poly_exp_t PolySnapshotDegBy(const PolySnapshot *snap, size_t var_idx)
+{
+    const PolySnapNode *root = PolySnapshotRoot(snap);
+
+    if (root->size == 0) {
+        return (root->coeff == 0) ? DEG_OF_ZERO : 0;
+    }
+    poly_exp_t deg_by_idx = 0;
+    vector_t *stack = VectorNew(sizeof(SnapFrame), INIT_CAP);
+    CHECK_POINTER(stack);
+    SnapFrame frame = { .node = root, .depth = 0 };
+    SnapPush(stack, &frame);
+
+    while (!VectorIsEmpty(stack)) {
+        frame = *(SnapFrame *) VectorPop(stack);
+        const PolySnapMono *monos = PolySnapshotMonos(snap, frame.node);
+
+        if (frame.depth == var_idx) {    // wykładniki są malejące
+            deg_by_idx = MAX(deg_by_idx, (poly_exp_t) monos[0].exp);
+            continue;
+        }
+        for (size_t i = 0; i < frame.node->size; i++) {
+            if (monos[i].p.size > 0) {
+                SnapFrame child = { .node = &monos[i].p, .depth = frame.depth + 1 };
+                SnapPush(stack, &child);
+            }
+        }
+    }
+    VectorDestroy(stack);
+    return deg_by_idx;
+}
+
+bool PolySnapshotIsEqPoly(const PolySnapshot *snap, const Poly *q)
+{
+    bool eq = true;
+    vector_t *stack = VectorNew(sizeof(SnapFrame), INIT_CAP);
+    CHECK_POINTER(stack);
+    SnapFrame frame = { .node = PolySnapshotRoot(snap), .q = q };
+    SnapPush(stack, &frame);
+
+    while (eq && !VectorIsEmpty(stack)) {
+        frame = *(SnapFrame *) VectorPop(stack);
+
+        if (frame.node->size == 0) {
+            eq = PolyIsCoeff(frame.q) && frame.q->coeff == frame.node->coeff;
+            continue;
+        }
+        if (PolyIsCoeff(frame.q) || frame.q->size != frame.node->size) {
+            eq = false;
+            break;
+        }
+        const PolySnapMono *monos = PolySnapshotMonos(snap, frame.node);
+
+        for (size_t i = 0; eq && i < frame.node->size; i++) {
+            eq = monos[i].exp == frame.q->arr[i].exp;
+            SnapFrame child = { .node = &monos[i].p, .q = &frame.q->arr[i].p };
+            SnapPush(stack, &child);
+        }
+    }
+    VectorDestroy(stack);
+    return eq;
+}
+
+bool PolySnapshotIsEq(const PolySnapshot *a, const PolySnapshot *b)
+{
+    return a->length == b->length && memcmp(a->base, b->base, a->length) == 0;
+}
+
+Poly PolySnapshotAt(const PolySnapshot *snap, poly_coeff_t x)
+{
+    const PolySnapNode *root = PolySnapshotRoot(snap);
+
+    if (root->size == 0) {
+        return PolyFromCoeff((poly_coeff_t) root->coeff);
+    }
+    if (x == 0) {    // zostaje jedynie wyraz wolny, czyli ostatni jednomian
+        const PolySnapMono *last = &PolySnapshotMonos(snap, root)[root->size - 1];
+        return (last->exp == 0) ? SnapNodeToPoly(snap, &last->p) : PolyZero();
+    }
+    Poly p = PolySnapshotToPoly(snap);
+    Poly res = PolyAt(&p, x);
+    PolyDestroy(&p);
+    return res;
+}
@@ -0,0 +1,226 @@
+/** @file
+  Interfejs odwzorowywanych w pamięci snapshotów wielomianów rzadkich wielu zmiennych
+
+  Snapshot to plik o układzie odpowiadającym drzewu wielomianu w pamięci,
+  w którym wskaźniki na tablice jednomianów zastąpiono przesunięciami
+  względem początku pliku. Po nagłówku (@ref PolySnapHeader) następują
+  tablice jednomianów (@ref PolySnapMono) w kolejności preorder przejścia
+  drzewa. Liczby zapisane są w kolejności bajtów bieżącej maszyny.
+
+  Otwarty snapshot jest odwzorowany w pamięci tylko do odczytu,
+  więc wiele procesów współdzieli te same strony, a zapytania
+  (stopień, porównanie, wypisanie) działają na nim bez deserializacji.
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#ifndef __POLY_SNAPSHOT_H__
+#define __POLY_SNAPSHOT_H__
+
+#include <stdint.h>
+#include "poly.h"
+
+/**
+ * Sygnatura rozpoczynająca plik snapshotu.
+ */
+#define POLY_SNAPSHOT_MAGIC "PLYS"
+
+/**
+ * Wersja formatu zapisywana w nagłówku.
+ */
+#define POLY_SNAPSHOT_VERSION 1
+
+/**
+ * Wielomian w snapshocie - odpowiednik struktury Poly.
+ */
+typedef struct PolySnapNode {
+    uint64_t size;        ///< liczba jednomianów (0 - wielomian jest współczynnikiem)
+    union {
+        int64_t coeff;    ///< współczynnik (gdy `size == 0`)
+        uint64_t offset;  ///< przesunięcie tablicy jednomianów od początku pliku (gdy `size > 0`)
+    };
+} PolySnapNode;
+
+/**
+ * Jednomian w snapshocie - odpowiednik struktury Mono.
+ */
+typedef struct PolySnapMono {
+    PolySnapNode p;       ///< współczynnik
+    int64_t exp;          ///< wykładnik
+} PolySnapMono;
+
+/**
+ * Nagłówek pliku snapshotu.
+ */
+typedef struct PolySnapHeader {
+    char magic[4];        ///< sygnatura @ref POLY_SNAPSHOT_MAGIC
+    uint32_t version;     ///< wersja formatu
+    uint64_t length;      ///< długość całego pliku w bajtach
+    PolySnapNode root;    ///< korzeń drzewa wielomianu
+} PolySnapHeader;
+
+/**
+ * Otwarty snapshot. Może być współdzielony przez kilka właścicieli,
+ * zliczanych w @p refs.
+ */
+typedef struct PolySnapshot {
+    const uint8_t *base;  ///< początek odwzorowanego pliku
+    size_t length;        ///< długość pliku
+    size_t refs;          ///< liczba właścicieli
+} PolySnapshot;
+
+/**
+ * Wynik otwierania snapshotu.
+ */
+typedef enum PolySnapStatus {
+    SNAPSHOT_OK,          ///< Snapshot otwarty
+    SNAPSHOT_FILE_ERROR,  ///< Nie udało się otworzyć lub odwzorować pliku
+    SNAPSHOT_FORMAT_ERROR ///< Plik nie jest poprawnym snapshotem
+} PolySnapStatus;
+
+/**
+ * Zapisuje wielomian w formacie snapshotu do nowo zaalokowanego bufora.
+ *
+ * @param[in] p : wielomian
+ * @param[out] size : długość wyniku w bajtach
+ *
+ * @return : bufor z zawartością pliku (do zwolnienia przez free())
+ */
+uint8_t *PolySnapshotEncode(const Poly *p, size_t *size);
+
+/**
+ * Otwiera plik snapshotu i odwzorowuje go w pamięci. Sprawdza jednokrotnie
+ * cały plik: nagłówek, to, czy tablice leżą kolejno w porządku preorder
+ * i mieszczą się w pliku, oraz czy wielomian jest w postaci kanonicznej.
+ * Dalsze operacje na snapshocie nie muszą już sprawdzać poprawności.
+ *
+ * @param[out] snap : otwarty snapshot (jedyny właściciel)
+ * @param[in] path : ścieżka pliku
+ *
+ * @return : wynik otwierania
+ */
+PolySnapStatus PolySnapshotOpen(PolySnapshot **snap, const char *path);
+
+/**
+ * Dodaje właściciela snapshotu.
+ *
+ * @param[in, out] snap : snapshot
+ *
+ * @return : @p snap
+ */
+PolySnapshot *PolySnapshotRetain(PolySnapshot *snap);
+
+/**
+ * Usuwa właściciela snapshotu, a gdy był on ostatnim - zamyka go.
+ *
+ * @param[in, out] snap : snapshot
+ */
+void PolySnapshotRelease(PolySnapshot *snap);
+
+/**
+ * Zwraca korzeń drzewa wielomianu zapisanego w snapshocie.
+ *
+ * @param[in] snap : snapshot
+ *
+ * @return : korzeń
+ */
+const PolySnapNode *PolySnapshotRoot(const PolySnapshot *snap);
+
+/**
+ * Zwraca tablicę jednomianów wielomianu @p node ze snapshotu @p snap.
+ *
+ * @param[in] snap : snapshot
+ * @param[in] node : wielomian niebędący współczynnikiem
+ *
+ * @return : tablica `node->size` jednomianów
+ */
+const PolySnapMono *PolySnapshotMonos(const PolySnapshot *snap, const PolySnapNode *node);
+
+/**
+ * Odtwarza w pamięci wielomian zapisany w snapshocie.
+ *
+ * @param[in] snap : snapshot
+ *
+ * @return : wielomian
+ */
+Poly PolySnapshotToPoly(const PolySnapshot *snap);
+
+/**
+ * Sprawdza, czy wielomian ze snapshotu jest współczynnikiem.
+ * @see PolyIsCoeff()
+ *
+ * @param[in] snap : snapshot
+ *
+ * @return : czy wielomian jest współczynnikiem
+ */
+bool PolySnapshotIsCoeff(const PolySnapshot *snap);
+
+/**
+ * Sprawdza, czy wielomian ze snapshotu jest tożsamościowo równy zeru.
+ * @see PolyIsZero()
+ *
+ * @param[in] snap : snapshot
+ *
+ * @return : czy wielomian jest równy zeru
+ */
+bool PolySnapshotIsZero(const PolySnapshot *snap);
+
+/**
+ * Zwraca stopień wielomianu ze snapshotu.
+ * @see PolyDeg()
+ *
+ * @param[in] snap : snapshot
+ *
+ * @return : stopień wielomianu
+ */
+poly_exp_t PolySnapshotDeg(const PolySnapshot *snap);
+
+/**
+ * Zwraca stopień wielomianu ze snapshotu ze względu na zadaną zmienną.
+ * @see PolyDegBy()
+ *
+ * @param[in] snap : snapshot
+ * @param[in] var_idx : indeks zmiennej
+ *
+ * @return : stopień wielomianu ze względu na zmienną o indeksie @p var_idx
+ */
+poly_exp_t PolySnapshotDegBy(const PolySnapshot *snap, size_t var_idx);
+
+/**
+ * Sprawdza równość wielomianu ze snapshotu i wielomianu w pamięci.
+ * @see PolyIsEq()
+ *
+ * @param[in] snap : snapshot
+ * @param[in] q : wielomian
+ *
+ * @return : czy wielomiany są równe
+ */
+bool PolySnapshotIsEqPoly(const PolySnapshot *snap, const Poly *q);
+
+/**
+ * Sprawdza równość wielomianów z dwóch snapshotów. Układ snapshotu
+ * wielomianu kanonicznego jest jednoznaczny, więc wystarcza porównać
+ * zawartość plików.
+ *
+ * @param[in] a : snapshot
+ * @param[in] b : snapshot
+ *
+ * @return : czy wielomiany są równe
+ */
+bool PolySnapshotIsEq(const PolySnapshot *a, const PolySnapshot *b);
+
+/**
+ * Wylicza wartość wielomianu ze snapshotu w punkcie @p x.
+ * Przy @p x równym zeru odtwarza jedynie wyraz wolny.
+ * @see PolyAt()
+ *
+ * @param[in] snap : snapshot
+ * @param[in] x : wartość argumentu
+ *
+ * @return : @f$p(x, x_0, x_1, \ldots)@f$
+ */
+Poly PolySnapshotAt(const PolySnapshot *snap, poly_coeff_t x);
+
+#endif //__POLY_SNAPSHOT_H__
@@ -3,6 +3,16 @@
 #endif
 
 #include "poly.h"
+#include "poly_dot.h"
+#include "poly_eval.h"
+#include "poly_fingerprint.h"
+#include "poly_intern.h"
+#include "poly_mod.h"
+#include "poly_program.h"
+#include "poly_serialize.h"
+#include "poly_simd.h"
+#include "poly_snapshot.h"
+#include "../calc_core/op_cache.h"
 #include <assert.h>
 #include <limits.h>
 #include <stdbool.h>
@@ -3137,6 +3147,7 @@ static bool SimpleAtTest(void) {
 static bool OverflowTest(void) {
   bool res = true;
   res &= TestMul(P(C(1L << 32), 1), C(1L << 32), C(0));
+  res &= TestMul(P(C(1L << 32), 1, C(1), 2), C(1L << 32), P(C(1L << 32), 2));
   res &= TestAt(P(C(1), 64), 2, C(0));
   res &= TestAt(P(C(1), 0, C(1), 64), 2, C(1));
   res &= TestAt(P(P(C(1), 1), 64), 2, C(0));
@@ -4140,6 +4151,884 @@ static bool PolyFromMonosFinalTest(void) {
   return res;
 }
 
+/** TESTY DODATKOWE **/
+
+/**
+ * Sprawdza operacje na bardzo głęboko zagnieżdżonym wielomianie
+ * (x_0 x_1 ... x_{depth-1}), które nie powinny przepełnić stosu wywołań.
+ */
+static bool DeepPolynomialTest(void) {
+  const size_t depth = 200000;
+  bool res = true;
+  Poly p = C(1);
+  for (size_t i = 0; i < depth; ++i)
+    p = P(p, 1);
+  res &= PolyDeg(&p) == (poly_exp_t)depth;
+  res &= PolyDegBy(&p, depth - 1) == 1;
+  res &= PolyDegBy(&p, depth) == 0;
+  Poly q = PolyClone(&p);
+  res &= PolyIsEq(&p, &q);
+  PolyNegateCoeffs(&q);
+  res &= !PolyIsEq(&p, &q);
+  PolyNegateCoeffs(&q);
+  res &= PolyIsEq(&p, &q);
+  PolyDestroy(&p);
+  PolyDestroy(&q);
+  PolyWorkspaceFree();
+  return res;
+}
+
+/**
+ * Serializuje wielomian, sprawdza, czy po odczytaniu jest mu równy,
+ * oraz czy każdy obcięty zapis zostaje odrzucony. Zwalnia wielomian.
+ */
+static bool TestSerialize(Poly p) {
+  size_t size;
+  Poly q;
+  uint8_t *data = PolySerialize(&p, &size);
+  bool res = PolyDeserialize(&q, data, size);
+  if (res) {
+    res = PolyIsEq(&p, &q);
+    PolyDestroy(&q);
+  }
+  for (size_t len = 0; len < size && res; ++len) {
+    if (PolyDeserialize(&q, data, len)) {
+      PolyDestroy(&q);
+      res = false;
+    }
+  }
+  free(data);
+  PolyDestroy(&p);
+  return res;
+}
+
+static bool SerializeTest(void) {
+  bool res = true;
+  res &= TestSerialize(C(0));
+  res &= TestSerialize(C(LONG_MIN));
+  res &= TestSerialize(C(LONG_MAX));
+  res &= TestSerialize(P(C(-1), 0, C(1), INT_MAX));
+  res &= TestSerialize(P(P(C(1), 1, C(-7), 3), 0, C(5), 2,
+                         P(C(3), 0, P(C(1), 5), 1), 9));
+  Poly p = C(-3);
+  for (size_t i = 0; i < 1000; ++i)
+    p = P(C(1), 0, p, i % 3 + 1);
+  res &= TestSerialize(p);
+
+  Poly q;
+  const uint8_t constTerm[] = {'P', 'L', 'Y', 'B', 1, 1, 0, 0, 2};
+  const uint8_t zeroCoeff[] = {'P', 'L', 'Y', 'B', 1, 1, 3, 0, 0};
+  const uint8_t ascending[] = {'P', 'L', 'Y', 'B', 1, 2, 1, 0, 2, 1, 0, 2};
+  const uint8_t wrongVersion[] = {'P', 'L', 'Y', 'B', 2, 0, 2};
+  const uint8_t trailing[] = {'P', 'L', 'Y', 'B', 1, 0, 2, 0};
+  const uint8_t overflow[] = {'P', 'L', 'Y', 'B', 1, 0,
+                              0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f};
+  res &= !PolyDeserialize(&q, constTerm, sizeof(constTerm));
+  res &= !PolyDeserialize(&q, zeroCoeff, sizeof(zeroCoeff));
+  res &= !PolyDeserialize(&q, ascending, sizeof(ascending));
+  res &= !PolyDeserialize(&q, wrongVersion, sizeof(wrongVersion));
+  res &= !PolyDeserialize(&q, trailing, sizeof(trailing));
+  res &= !PolyDeserialize(&q, overflow, sizeof(overflow));
+  PolyWorkspaceFree();
+  return res;
+}
+
+/**
+ * Zapisuje bufor do pliku tymczasowego i próbuje otworzyć go jako snapshot.
+ */
+static PolySnapStatus OpenSnapshotFrom(const uint8_t *data, size_t size,
+                                       PolySnapshot **snap) {
+  const char *path = "poly_snapshot_test.tmp";
+  FILE *file = fopen(path, "wb");
+  if (file == NULL)
+    return SNAPSHOT_FILE_ERROR;
+  fwrite(data, 1, size, file);
+  fclose(file);
+  PolySnapStatus status = PolySnapshotOpen(snap, path);
+  remove(path);
+  return status;
+}
+
+/**
+ * Sprawdza, czy zapytania na snapshocie wielomianu dają te same wyniki,
+ * co na wielomianie w pamięci, oraz czy obcięty snapshot jest odrzucany.
+ * Zwalnia wielomian.
+ */
+static bool TestSnapshot(Poly p) {
+  size_t size;
+  PolySnapshot *snap, *other;
+  uint8_t *data = PolySnapshotEncode(&p, &size);
+  bool res = OpenSnapshotFrom(data, size, &snap) == SNAPSHOT_OK;
+  if (res) {
+    Poly q = PolySnapshotToPoly(snap);
+    res &= PolyIsEq(&p, &q);
+    res &= PolySnapshotIsEqPoly(snap, &p);
+    res &= PolySnapshotIsCoeff(snap) == PolyIsCoeff(&p);
+    res &= PolySnapshotIsZero(snap) == PolyIsZero(&p);
+    res &= PolySnapshotDeg(snap) == PolyDeg(&p);
+    for (size_t i = 0; i < 4; ++i)
+      res &= PolySnapshotDegBy(snap, i) == PolyDegBy(&p, i);
+    for (poly_coeff_t x = -2; x <= 2; ++x) {
+      Poly at = PolyAt(&p, x), snapAt = PolySnapshotAt(snap, x);
+      res &= PolyIsEq(&at, &snapAt);
+      PolyDestroy(&at);
+      PolyDestroy(&snapAt);
+    }
+    PolyNegateCoeffs(&q);
+    res &= PolyIsCoeff(&p) || !PolySnapshotIsEqPoly(snap, &q);
+    PolyDestroy(&q);
+    res &= PolySnapshotIsEq(snap, PolySnapshotRetain(snap));
+    PolySnapshotRelease(snap);
+    PolySnapshotRelease(snap);
+  }
+  for (size_t len = 0; len < size && res; ++len) {
+    if (OpenSnapshotFrom(data, len, &other) != SNAPSHOT_FORMAT_ERROR) {
+      PolySnapshotRelease(other);
+      res = false;
+    }
+  }
+  free(data);
+  PolyDestroy(&p);
+  return res;
+}
+
+static bool SnapshotTest(void) {
+  bool res = true;
+  res &= TestSnapshot(C(0));
+  res &= TestSnapshot(C(LONG_MIN));
+  res &= TestSnapshot(P(C(-1), 0, C(1), INT_MAX));
+  res &= TestSnapshot(P(P(C(1), 1, C(-7), 3), 0, C(5), 2,
+                        P(C(3), 0, P(C(1), 5), 1), 9));
+  Poly p = C(-3);
+  for (size_t i = 0; i < 200; ++i)
+    p = P(C(1), 0, p, i % 3 + 1);
+  res &= TestSnapshot(p);
+
+  PolySnapshot *snap;
+  size_t size;
+  Poly q = P(P(C(1), 1), 2);
+  uint8_t *data = PolySnapshotEncode(&q, &size);
+  ((PolySnapHeader *)data)->root.offset += sizeof(PolySnapMono);
+  res &= OpenSnapshotFrom(data, size, &snap) == SNAPSHOT_FORMAT_ERROR;
+  ((PolySnapHeader *)data)->root.offset -= sizeof(PolySnapMono);
+  ((PolySnapMono *)(data + sizeof(PolySnapHeader)))->exp = -1;
+  res &= OpenSnapshotFrom(data, size, &snap) == SNAPSHOT_FORMAT_ERROR;
+  free(data);
+  PolyDestroy(&q);
+  res &= PolySnapshotOpen(&snap, "/nonexistent/poly.snap") == SNAPSHOT_FILE_ERROR;
+  return res;
+}
+
+/**
+ * Sprawdza, czy odciski wyników dodawania, odejmowania, mnożenia
+ * i negacji wyznaczone z odcisków argumentów są równe odciskom
+ * obliczonym wprost. Zwalnia wielomiany.
+ */
+static bool TestFingerprint(Poly p, Poly q) {
+  PolyFingerprint fp = PolyFingerprintOf(&p), fq = PolyFingerprintOf(&q);
+  Poly sum = PolyAdd(&p, &q), diff = PolySub(&p, &q), prod = PolyMul(&p, &q);
+  Poly neg = PolyNeg(&p);
+  PolyFingerprint fsum = PolyFingerprintOf(&sum), fdiff = PolyFingerprintOf(&diff);
+  PolyFingerprint fprod = PolyFingerprintOf(&prod), fneg = PolyFingerprintOf(&neg);
+  bool res = PolyFingerprintEq(fsum, PolyFingerprintAdd(fp, fq));
+  res &= PolyFingerprintEq(fdiff, PolyFingerprintSub(fp, fq));
+  res &= PolyFingerprintEq(fprod, PolyFingerprintMul(fp, fq));
+  res &= PolyFingerprintEq(fneg, PolyFingerprintNeg(fp));
+  res &= PolyFingerprintIsZero(fdiff) == PolyIsZero(&diff);
+  res &= PolyFingerprintEq(fp, fq) == PolyIsEq(&p, &q);
+  PolyDestroy(&sum);
+  PolyDestroy(&diff);
+  PolyDestroy(&prod);
+  PolyDestroy(&neg);
+  PolyDestroy(&p);
+  PolyDestroy(&q);
+  return res;
+}
+
+/**
+ * Sprawdza, czy odciski potęgi @p q i złożeń @p p z (@p q, @p p)
+ * wyznaczone z odcisków argumentów są równe odciskom obliczonym wprost.
+ * Zwalnia wielomiany.
+ */
+static bool TestFingerprintCompose(Poly p, Poly q) {
+  Poly args[] = { q, p };
+  PolyFingerprint fargs[] = { PolyFingerprintOf(&q), PolyFingerprintOf(&p) };
+  Poly pow = PolyPower(&q, 3);
+  PolyFingerprint fpow = PolyFingerprintOf(&pow);
+  bool res = PolyFingerprintEq(fpow, PolyFingerprintPow(fargs[0], 3));
+  for (size_t k = 0; k <= 2; ++k) {
+    Poly comp = PolyCompose(&p, k, args);
+    PolyFingerprint fcomp = PolyFingerprintOf(&comp);
+    res &= PolyFingerprintEq(fcomp, PolyFingerprintCompose(&p, k, fargs));
+    PolyDestroy(&comp);
+  }
+  PolyDestroy(&pow);
+  PolyDestroy(&p);
+  PolyDestroy(&q);
+  return res;
+}
+
+static bool FingerprintTest(void) {
+  bool res = true;
+  res &= TestFingerprint(C(0), C(0));
+  res &= TestFingerprint(C(5), C(-5));
+  res &= TestFingerprint(P(C(1), 1), P(C(1), 1));
+  res &= TestFingerprint(P(C(1), 1), P(C(1), 2));
+  res &= TestFingerprint(P(P(C(1), 1, C(-7), 3), 0, C(5), 2),
+                         P(C(2), 0, P(C(3), 0, P(C(1), 5), 1), 9));
+  res &= TestFingerprint(P(C(LONG_MAX), 1, C(1), 2), P(C(LONG_MAX), 1, C(-1), 2));
+  res &= TestFingerprint(P(C(1L << 32), 1, C(1), 2), C(1L << 32));
+  res &= TestFingerprint(P(P(C(1), INT_MAX), 0, C(3), 1), P(C(-1), 0, C(2), 7));
+  Poly p = C(-3);
+  for (size_t i = 0; i < 200; ++i)
+    p = P(C(1), 0, p, i % 3 + 1);
+  res &= TestFingerprint(PolyClone(&p), p);
+  res &= TestFingerprintCompose(C(7), C(-2));
+  res &= TestFingerprintCompose(P(C(1), 0, C(3), 2), C(0));
+  res &= TestFingerprintCompose(P(P(C(1), 1, C(-7), 3), 0, C(5), 2, P(C(1), 4), 3),
+                                P(C(2), 0, P(C(3), 0, P(C(1), 5), 1), 9));
+  res &= TestFingerprintCompose(P(P(C(LONG_MAX), 1), 1, P(C(1), 0, P(C(1), 2), 1), 2),
+                                P(C(LONG_MAX), 1, C(1), 2));
+  return res;
+}
+
+static bool InternTest(void) {
+  bool res = true;
+  PolyInternTable *table = PolyInternTableNew(100);
+  Poly p = P(P(C(1), 1, C(2), 3), 0, P(C(1), 1, C(2), 3), 2, C(5), 4);
+  Poly q = PolyClone(&p);
+  Poly r = P(P(C(1), 1, C(2), 3), 0, C(5), 4);
+  Poly expected = PolyClone(&p);
+  res &= PolyIntern(table, &p) && PolyIntern(table, &q) && PolyIntern(table, &r);
+  res &= table->count == 3;    // wspólne poddrzewo, p (równe q) oraz r
+  res &= PolyIsEq(&p, &expected) && PolyIsEq(&q, &expected);
+  res &= p.arr == q.arr && p.arr[1].p.arr == p.arr[2].p.arr && r.arr[1].p.arr == p.arr[1].p.arr;
+  res &= PolyInternIsEq(&p, &q) && !PolyInternIsEq(&p, &r);
+  Poly s = PolyInternRetain(&p);
+  PolyInternRelease(table, &p);
+  PolyInternRelease(table, &q);
+  res &= table->count == 3 && PolyIsEq(&s, &expected);
+  PolyInternRelease(table, &s);
+  res &= table->count == 2;    // wspólne poddrzewo należy też do r
+  PolyInternRelease(table, &r);
+  res &= table->count == 0 && table->bytes == 0;
+
+  Poly deep = C(-3);
+  for (size_t i = 0; i < 200; ++i)
+    deep = P(C(1), 0, deep, i % 3 + 1);
+  res &= !PolyIntern(table, &deep);    // 200 nowych poddrzew przekracza limit
+  res &= table->count == 0;
+  PolyInternTableDestroy(table);
+  table = PolyInternTableNew(1000);
+  Poly deep_copy = PolyClone(&deep);
+  res &= PolyIntern(table, &deep) && table->count == 200 && PolyIsEq(&deep, &deep_copy);
+  PolyInternRelease(table, &deep);
+  res &= table->count == 0;
+  PolyDestroy(&deep_copy);
+  PolyDestroy(&expected);
+  PolyInternTableDestroy(table);
+  return res;
+}
+
+/**
+ * Zwraca współczynnik przy @f$x_0^0@f$ wielomianu, który ma tylko
+ * taki jednomian lub jest współczynnikiem. Zwalnia wielomian.
+ */
+static Poly Unwrap(Poly p) {
+  if (PolyIsCoeff(&p))
+    return p;
+  assert(p.size == 1 && p.arr[0].exp == 0);
+  Poly res = p.arr[0].p;
+  free(p.arr);
+  return res;
+}
+
+/**
+ * Sprawdza, czy PolySub(), PolyAdd() i ich wersje przejmujące argumenty
+ * na własność dają te same wyniki co dodawanie wielomianu przeciwnego.
+ * Zwalnia wielomiany.
+ */
+static bool TestFusedSub(Poly p, Poly q) {
+  Poly neg = PolyNeg(&q);
+  Poly p_sub = PolyClone(&p), p_add = PolyClone(&p), q_add = PolyClone(&q);
+  Mono sub_monos[] = { MonoFromPoly(&p_sub, 0), MonoFromPoly(&neg, 0) };
+  Mono add_monos[] = { MonoFromPoly(&p_add, 0), MonoFromPoly(&q_add, 0) };
+  Poly expected_sub = Unwrap(PolyAddMonos(2, sub_monos));    // dodawanie przez PolyMerge()
+  Poly expected_add = Unwrap(PolyAddMonos(2, add_monos));
+  Poly sub = PolySub(&p, &q), add = PolyAdd(&p, &q);
+  Poly p_copy = PolyClone(&p), q_copy = PolyClone(&q);
+  Poly owned_sub = PolySubOwned(&p_copy, &q_copy);
+  bool res = PolyIsZero(&p_copy) && PolyIsZero(&q_copy);
+  p_copy = PolyClone(&p);
+  q_copy = PolyClone(&q);
+  Poly owned_add = PolyAddOwned(&p_copy, &q_copy);
+  res &= PolyIsEq(&sub, &expected_sub) && PolyIsEq(&owned_sub, &expected_sub);
+  res &= PolyIsEq(&add, &expected_add) && PolyIsEq(&owned_add, &expected_add);
+  PolyDestroy(&sub);
+  PolyDestroy(&add);
+  PolyDestroy(&owned_sub);
+  PolyDestroy(&owned_add);
+  PolyDestroy(&expected_sub);
+  PolyDestroy(&expected_add);
+  PolyDestroy(&p);
+  PolyDestroy(&q);
+  return res;
+}
+
+static bool FusedSubTest(void) {
+  bool res = true;
+  res &= TestFusedSub(C(3), C(5));
+  res &= TestFusedSub(C(0), P(C(1), 1, C(2), 3));
+  res &= TestFusedSub(P(C(1), 1, C(2), 3), C(0));
+  res &= TestFusedSub(C(4), P(C(1), 0, C(2), 3));
+  res &= TestFusedSub(P(C(4), 0, C(2), 3), C(4));
+  res &= TestFusedSub(P(C(1), 1, C(2), 3), P(C(1), 1, C(2), 3));
+  res &= TestFusedSub(P(P(C(1), 1, C(-7), 3), 0, C(5), 2, P(C(3), 0, P(C(1), 5), 1), 9),
+                      P(P(C(1), 1, C(-7), 3), 0, C(2), 4, P(C(3), 0, P(C(1), 5), 1), 9));
+  res &= TestFusedSub(P(P(C(1), 1), 0, C(1), 1), P(P(C(1), 1), 0, C(-1), 1));
+  res &= TestFusedSub(P(C(LONG_MIN), 2), P(C(LONG_MAX), 1, C(LONG_MIN), 2));
+  Poly p = C(-3), q = C(-3);
+  for (size_t i = 0; i < 200; ++i) {
+    p = P(C(1), 0, p, i % 3 + 1);
+    q = P(C(1 + i % 2), 0, q, i % 3 + 1 + (i == 150));
+  }
+  res &= TestFusedSub(p, q);
+  return res;
+}
+
+/**
+ * Sprawdza operacje z poly_simd.h dla warstw o rozmiarach od 0 do 40
+ * przy bieżącym ograniczeniu poziomu instrukcji. Wyrównanie po
+ * wykładnikach jest w obu tablicach różne.
+ */
+static bool TestSimdLayers(void) {
+  bool res = true;
+  for (size_t n = 0; n <= 40; ++n) {
+    Mono *a = malloc((n + 1) * sizeof(Mono)), *b = malloc((n + 1) * sizeof(Mono));
+    Mono *scaled = malloc((n + 1) * sizeof(Mono));
+    memset(a, 0xab, (n + 1) * sizeof(Mono));
+    memset(b, 0xcd, (n + 1) * sizeof(Mono));
+    for (size_t i = 0; i < n; ++i) {
+      a[i].p = b[i].p = PolyFromCoeff((poly_coeff_t)(i * 0x9e3779b97f4a7c15u));
+      a[i].exp = b[i].exp = (poly_exp_t)(3 * i + 1);
+    }
+    res &= MonosAreCoeffs(a, n) && MonosMatchPrefix(a, b, n) == n;
+    MonosScale(scaled, a, n, -7);
+    for (size_t i = 0; i < n; ++i)
+      res &= PolyIsCoeff(&scaled[i].p) && scaled[i].exp == a[i].exp &&
+             scaled[i].p.coeff == (poly_coeff_t)((uint64_t)a[i].p.coeff * (uint64_t)-7);
+    MonosScale(a, a, n, 1);
+    res &= MonosMatchPrefix(a, b, n) == n;
+    for (size_t i = 0; i < n; ++i) {
+      b[i].p.coeff++;
+      res &= MonosMatchPrefix(a, b, n) == i;
+      b[i].p.coeff--;
+      b[i].exp++;
+      res &= MonosMatchPrefix(a, b, n) == i;
+      b[i].exp--;
+      b[i].p.arr = &a[i];
+      res &= MonosMatchPrefix(a, b, n) == i && !MonosAreCoeffs(b, n);
+      b[i].p.arr = NULL;
+    }
+    free(a);
+    free(b);
+    free(scaled);
+  }
+  return res;
+}
+
+static bool SimdTest(void) {
+  bool res = true;
+  for (int level = POLY_SIMD_AVX512; level >= POLY_SIMD_SCALAR; --level) {
+    PolySimdLimit((PolySimdLevel)level);
+    res &= PolySimdGetLevel() <= (PolySimdLevel)level;
+    res &= TestSimdLayers();
+    Poly p = P(C(1), 0, C(-2), 1, C(3), 2, C(-4), 3, C(5), 4, C(6), 5, C(7), 6,
+               C(8), 7, C(9), 8, C(LONG_MIN), 9);
+    Poly neg = PolyNeg(&p);
+    res &= TestEq(neg, P(C(-1), 0, C(2), 1, C(-3), 2, C(4), 3, C(-5), 4, C(-6), 5,
+                         C(-7), 6, C(-8), 7, C(-9), 8, C(LONG_MIN), 9), true);
+    Poly q = PolyClone(&p);
+    q.arr[8].p.coeff = 0;
+    res &= !PolyIsEq(&p, &q);
+    PolyDestroy(&q);
+    PolyDestroy(&p);
+  }
+  return res;
+}
+
+/**
+ * Sprawdza, czy złożenie @f$x_0^k@f$ z @p q (liczone przez szybkie
+ * potęgowanie z podnoszeniem do kwadratu) jest równe @p k -krotnemu
+ * iloczynowi @p q. Zwalnia wielomian.
+ */
+static bool TestComposePow(Poly q, poly_exp_t k) {
+  Poly p = P(C(1), k);
+  Poly composed = PolyCompose(&p, 1, &q);
+  Poly prod = C(1);
+  for (poly_exp_t i = 0; i < k; ++i) {
+    Poly next = PolyMul(&prod, &q);
+    PolyDestroy(&prod);
+    prod = next;
+  }
+  PolyDestroy(&p);
+  PolyDestroy(&q);
+  return TestEq(composed, prod, true);
+}
+
+static bool SquareTest(void) {
+  bool res = true;
+  res &= TestComposePow(C(-3), 5);
+  res &= TestComposePow(P(C(1), 0, C(-1), 1), 2);
+  res &= TestComposePow(P(C(1), 0, C(2), 3, C(-5), 4), 7);
+  res &= TestComposePow(P(P(C(1), 1, C(-7), 3), 0, C(5), 2,
+                          P(C(3), 0, P(C(1), 5), 1), 9), 6);
+  res &= TestComposePow(P(C(1L << 32), 0, C(1L << 31), 1), 4);    // iloczyny mieszane przekręcają się do zera
+  res &= TestComposePow(P(C(LONG_MAX), 1, C(LONG_MIN), 2), 3);
+  return res;
+}
+
+/**
+ * Sprowadza współczynniki wielomianu do reszt modulo bieżący moduł.
+ */
+static Poly Reduced(Poly p) {
+  PolyReduceCoeffs(&p);
+  return p;
+}
+
+static bool ModTest(void) {
+  const uint64_t m = 1000003;
+  bool res = !PolySetModulus(4) && !PolySetModulus(1) && !PolySetModulus((UINT64_C(1) << 63) + 1);
+  res &= polyModulus.m == 0 && PolySetModulus(m);
+  res &= ModMul(123456, 654321) == UINT64_C(123456) * 654321 % m;
+  res &= ModMul(m - 1, m - 1) == 1 && ModAdd(m - 1, 5) == 4 && ModSub(3, 5) == m - 2;
+  res &= ModPow(2, 20) == (1 << 20) % m && ModReduce(-1) == m - 1;
+
+  Poly p = Reduced(P(C(m + 2), 0, P(C(m), 1), 2));    // wyzerowane poddrzewo znika
+  res &= TestEq(p, C(2), true);
+  p = Reduced(P(C(-1), 1));
+  Poly sq = PolyMul(&p, &p);
+  res &= TestEq(sq, P(C(1), 2), true);
+  Poly one = C(1), sum = PolyAdd(&p, &one);
+  res &= TestEq(sum, P(C(1), 0, C(m - 1), 1), true);
+  Poly neg = PolyNeg(&p);
+  res &= TestEq(neg, P(C(1), 1), true);
+  Poly at = PolyAt(&p, -2);
+  res &= TestEq(at, C(2), true);
+  PolyDestroy(&p);
+  p = P(C(1), 20);
+  at = PolyAt(&p, 2);
+  res &= TestEq(at, C((1 << 20) % m), true);
+  PolyDestroy(&p);
+
+  res &= TestFingerprint(Reduced(P(C(-5), 0, C(7), 3)), Reduced(P(C(5), 0, P(C(m - 1), 2), 1)));
+  res &= TestFingerprint(Reduced(P(P(C(1), 1, C(-7), 3), 0, C(5), 2)),
+                         Reduced(P(C(2), 0, P(C(3), 0, P(C(1), 5), 1), 9)));
+  Poly deep = C(-3);
+  for (size_t i = 0; i < 200; ++i)
+    deep = P(C(-1), 0, deep, i % 3 + 1);
+  deep = Reduced(deep);
+  res &= TestFingerprint(PolyClone(&deep), deep);
+  polyModulus.m = 0;
+  return res;
+}
+
+/**
+ * Sprawdza, czy PolyEvalPoint() daje ten sam wynik co kolejne
+ * wywołania PolyAt() (zmienne spoza punktu przyjmują wartość 0).
+ * Zwalnia wielomian.
+ */
+static bool TestEvalPoint(Poly p, size_t n, const poly_coeff_t x[], size_t depth) {
+  Poly expected = PolyClone(&p);
+  for (size_t i = 0; i < depth; ++i) {
+    Poly next = PolyAt(&expected, i < n ? x[i] : 0);
+    PolyDestroy(&expected);
+    expected = next;
+  }
+  bool res = PolyIsCoeff(&expected) && PolyEvalPoint(&p, n, x) == expected.coeff;
+  PolyDestroy(&expected);
+  PolyDestroy(&p);
+  return res;
+}
+
+static bool EvalTest(void) {
+  const poly_coeff_t x[] = { 3, -2, 0, 7, LONG_MIN };
+  bool res = true;
+  res &= TestEvalPoint(C(5), 0, NULL, 0);
+  res &= TestEvalPoint(C(-4), 2, x, 0);
+  res &= TestEvalPoint(P(C(1), 0, C(2), 3), 1, x, 1);
+  res &= TestEvalPoint(P(C(1), 0, C(2), 3), 0, NULL, 1);
+  res &= TestEvalPoint(P(C(1), 1, C(2), 3), 3, x + 2, 1);
+  res &= TestEvalPoint(P(P(C(1), 1, C(-7), 3), 0, C(5), 2, P(C(3), 0, P(C(1), 5), 1), 9), 3, x, 3);
+  res &= TestEvalPoint(P(P(C(1), 1, C(-7), 3), 0, C(5), 2, P(C(3), 0, P(C(1), 5), 1), 9), 1, x, 3);
+  res &= TestEvalPoint(P(C(LONG_MAX), 1, C(LONG_MIN), 2, C(1), 63), 5, x + 4, 1);
+  Poly p = C(-3);
+  for (size_t i = 0; i < 200; ++i)
+    p = P(C((poly_coeff_t)i), 0, p, i % 3 + 1, C(1), 4);
+  res &= TestEvalPoint(PolyClone(&p), 5, x, 200);
+  res &= TestEvalPoint(PolyClone(&p), 2, x, 200);
+  res &= PolySetModulus(1000000007);
+  res &= TestEvalPoint(Reduced(p), 5, x, 200);
+  polyModulus.m = 0;
+  return res;
+}
+
+/**
+ * Sprawdza, czy PolyEvalBatch() daje w każdym z @p npoints pseudolosowych
+ * punktów ten sam wynik co PolyEvalPoint().
+ */
+static bool TestEvalBatch(const Poly *p, size_t nvars, size_t npoints) {
+  poly_coeff_t *points = malloc((npoints * nvars + 1) * sizeof(poly_coeff_t));
+  poly_coeff_t *out = malloc((npoints + 1) * sizeof(poly_coeff_t));
+  uint64_t z = 0x9e3779b97f4a7c15u;
+  for (size_t i = 0; i < npoints * nvars; ++i) {
+    z = z * 6364136223846793005u + 1442695040888963407u;
+    points[i] = (i % 3 == 0) ? (poly_coeff_t)z : (poly_coeff_t)(z >> 61) - 3;
+  }
+  PolyEvalBatch(p, nvars, npoints, points, out);
+  bool res = true;
+  for (size_t i = 0; i < npoints; ++i)
+    res &= out[i] == PolyEvalPoint(p, nvars, points + i * nvars);
+  free(points);
+  free(out);
+  return res;
+}
+
+static bool EvalBatchTest(void) {
+  Poly p = P(P(C(1), 1, C(-7), 3), 0, C(5), 2, P(C(3), 0, P(C(1), 5, C(2), 40), 1), 9);
+  Poly deep = C(-3);
+  for (size_t i = 0; i < 100; ++i)
+    deep = P(C((poly_coeff_t)i), 0, deep, i % 3 + 1, C(1), 4);
+  Poly c = C(42);
+  bool res = true;
+  for (int level = POLY_SIMD_AVX512; level >= POLY_SIMD_SCALAR; --level) {
+    PolySimdLimit((PolySimdLevel)level);
+    for (size_t n = 0; n <= 20; ++n)
+      res &= TestEvalBatch(&p, 3, n);
+    res &= TestEvalBatch(&p, 1, 17) && TestEvalBatch(&p, 5, 9) && TestEvalBatch(&c, 2, 9);
+    res &= TestEvalBatch(&deep, 100, 33) && TestEvalBatch(&deep, 7, 33);
+  }
+  PolyEvalSetThreads(4);
+  res &= TestEvalBatch(&p, 3, 10001) && TestEvalBatch(&deep, 60, 2000);
+  PolyEvalSetThreads(1);
+  PolyDestroy(&p);
+  PolyDestroy(&deep);
+  res &= PolySetModulus(1000000007);
+  p = Reduced(P(P(C(1), 1, C(-7), 3), 0, C(5), 2, P(C(3), 0, P(C(-1), 5), 1), 9));
+  res &= TestEvalBatch(&p, 3, 1001);
+  PolyDestroy(&p);
+  polyModulus.m = 0;
+  return res;
+}
+
+/**
+ * Sprawdza, czy program skompilowany z wielomianu daje w punktach
+ * te same wyniki co PolyEvalPoint(). Zwraca długość programu przez
+ * @p length. Zwalnia wielomian.
+ */
+static bool TestCompile(Poly p, size_t *length) {
+  const poly_coeff_t x[] = { 3, -2, 0, 7, LONG_MIN, 1, -1, 5 };
+  PolyProgram *prog = PolyCompile(&p);
+  bool res = true;
+  for (size_t n = 0; n <= 8; ++n)
+    for (size_t shift = 0; shift + n <= 8; shift += 3)
+      res &= PolyProgramEval(prog, n, x + shift) == PolyEvalPoint(&p, n, x + shift);
+  if (length != NULL)
+    *length = prog->length;
+  PolyProgramRelease(prog);
+  PolyDestroy(&p);
+  return res;
+}
+
+static bool CompileTest(void) {
+  bool res = true;
+  res &= TestCompile(C(5), NULL) && TestCompile(C(0), NULL);
+  res &= TestCompile(P(C(1), 0, C(2), 3), NULL);
+  res &= TestCompile(P(C(1), 1, C(-1), 30, C(7), 31), NULL);
+  res &= TestCompile(P(P(C(1), 1, C(-7), 3), 0, C(5), 2, P(C(3), 0, P(C(1), 5), 1), 9), NULL);
+  res &= TestCompile(P(P(C(1), 0, C(1), 1), 2), NULL);
+  res &= TestCompile(P(C(LONG_MAX), 1, C(LONG_MIN), 2, C(1), INT_MAX), NULL);
+  Poly deep = C(-3);
+  for (size_t i = 0; i < 200; ++i)
+    deep = P(C((poly_coeff_t)i), 0, deep, i % 3 + 1, C(1), 4);
+  res &= TestCompile(PolyClone(&deep), NULL);
+
+  size_t single, repeated;    // identyczne poddrzewa kompilowane są raz
+  Poly q = P(P(C(1), 1, C(-7), 3), 0, C(5), 2, P(C(3), 0, P(C(1), 5), 1), 9);
+  res &= TestCompile(P(PolyClone(&q), 1), &single);
+  res &= TestCompile(P(PolyClone(&q), 1, PolyClone(&q), 4, PolyClone(&q), 6), &repeated);
+  res &= repeated <= single + 6;    // potęgi x^2, x^3, x^4, x^6 i dwa mnożenia z dodawaniem
+  PolyDestroy(&q);
+
+  res &= PolySetModulus(1000000007);
+  res &= TestCompile(Reduced(deep), NULL);
+  res &= TestCompile(Reduced(P(P(C(-1), 1, C(-7), 3), 0, C(5), 2)), NULL);
+  polyModulus.m = 0;
+  return res;
+}
+
+/**
+ * Obcina wielomian do jednomianów stopnia co najwyżej @p d (wzorzec dla
+ * PolyMulTrunc() i PolyComposeTrunc()).
+ */
+static Poly Truncated(const Poly *p, long d) {
+  if (d < 0)
+    return PolyZero();
+  if (PolyIsCoeff(p))
+    return PolyClone(p);
+  Mono *monos = malloc(p->size * sizeof(Mono));
+  assert(monos != NULL);
+  size_t count = 0;
+  for (size_t i = 0; i < p->size; ++i) {
+    Poly coeff = Truncated(&p->arr[i].p, d - p->arr[i].exp);
+    if (!PolyIsZero(&coeff))
+      monos[count++] = M(coeff, p->arr[i].exp);
+  }
+  Poly res = PolyAddMonos(count, monos);
+  free(monos);
+  return res;
+}
+
+static bool TestMulTrunc(Poly p, Poly q) {
+  bool res = true;
+  Poly prod = PolyMul(&p, &q);
+  for (poly_exp_t d = -1; d <= PolyDeg(&prod) + 1; ++d)
+    res &= TestEq(PolyMulTrunc(&p, &q, d), Truncated(&prod, d), true);
+  PolyDestroy(&prod);
+  PolyDestroy(&p);
+  PolyDestroy(&q);
+  return res;
+}
+
+static bool TestComposeTrunc(Poly p, size_t k, Poly q[]) {
+  bool res = true;
+  Poly composed = PolyCompose(&p, k, q);
+  for (poly_exp_t d = -1; d <= PolyDeg(&composed) + 1; ++d)
+    res &= TestEq(PolyComposeTrunc(&p, k, q, d), Truncated(&composed, d), true);
+  PolyDestroy(&composed);
+  PolyDestroy(&p);
+  for (size_t i = 0; i < k; ++i)
+    PolyDestroy(&q[i]);
+  return res;
+}
+
+static bool TruncTest(void) {
+  bool res = true;
+  res &= TestMulTrunc(C(3), C(-4)) && TestMulTrunc(C(0), P(C(1), 2));
+  res &= TestMulTrunc(C(2), P(P(C(1), 1, C(-7), 3), 0, C(5), 2));
+  res &= TestMulTrunc(P(C(1), 0, C(-1), 1), P(C(1), 0, C(1), 1));
+  res &= TestMulTrunc(P(P(C(1), 1, C(-7), 3), 0, C(5), 2, P(C(3), 0, P(C(1), 5), 1), 9),
+                      P(C(1), 0, P(C(2), 0, C(1), 2), 1, C(-3), 4));
+  res &= TestMulTrunc(P(C(1L << 32), 0, C(1L << 31), 1), P(C(1L << 32), 1, C(3), 2));    // iloczyny przekręcają się do zera
+
+  Poly q[3];
+  q[0] = P(C(1), 0, C(1), 1);
+  res &= TestComposeTrunc(P(C(1), 7), 1, q);
+  q[0] = P(P(C(2), 1), 1, C(-1), 2);
+  q[1] = P(C(3), 0, P(C(1), 1), 2);
+  res &= TestComposeTrunc(P(P(C(1), 1, C(-7), 3), 0, C(5), 2, P(C(3), 0, P(C(1), 5), 1), 9), 2, q);
+  q[0] = P(P(C(1), 1), 0, C(1), 1);
+  q[1] = C(-2);
+  q[2] = P(C(1), 3);
+  res &= TestComposeTrunc(P(P(P(C(1), 1), 2, C(4), 3), 0, C(5), 1, C(-1), 4), 3, q);
+  res &= TestComposeTrunc(P(C(2), 0, C(1), 3), 0, q);
+
+  res &= PolySetModulus(1000000007);
+  q[0] = Reduced(P(C(-1), 0, C(1), 1));
+  q[1] = Reduced(P(P(C(-5), 1), 1));
+  res &= TestComposeTrunc(Reduced(P(P(C(-1), 1, C(-7), 3), 0, C(5), 2)), 2, q);
+  res &= TestMulTrunc(Reduced(P(C(-1), 0, C(1), 3)), Reduced(P(P(C(-1), 2), 0, C(1), 1)));
+  polyModulus.m = 0;
+  return res;
+}
+
+static bool TestPower(Poly p, poly_exp_t e) {
+  Poly prod = C(1);
+  for (poly_exp_t i = 0; i < e; ++i) {
+    Poly next = PolyMul(&prod, &p);
+    PolyDestroy(&prod);
+    prod = next;
+  }
+  Poly power = PolyPower(&p, e);
+  PolyDestroy(&p);
+  return TestEq(power, prod, true);
+}
+
+static bool PowerTest(void) {
+  bool res = true;
+  for (poly_exp_t e = 0; e <= 9; ++e) {
+    res &= TestPower(C(-3), e) && TestPower(C(0), e);
+    res &= TestPower(P(P(C(2), 1, C(-1), 3), 4), e);                                    // jednomian
+    res &= TestPower(P(C(1), 0, C(-1), 1), e);                                          // dwumian
+    res &= TestPower(P(P(C(1), 1, C(-7), 3), 0, C(5), 2, P(C(3), 0, P(C(1), 5), 1), 9), e);
+    res &= TestPower(P(C(1), 0, C(2), 1, C(-5), 2, C(3), 3), e);                       // gęsty
+    res &= TestPower(P(C(1), 0, P(C(1), 1), 2, C(3), 7, P(C(-1), 2), 20), e);
+  }
+  res &= TestPower(P(C(1), 0, C(1), 1), 300);
+  res &= TestPower(P(P(C(1), 1), 2, C(3), 7, P(C(1), 2), 20), 66);
+  res &= TestPower(P(C(1), 0, P(C(1), 1), 2, C(3), 7, P(C(-1), 2), 20), 33);    // mnożenia przez podstawę
+  res &= TestPower(P(C(1), 0, C(1), 3, C(-2), 7, C(1), 10), 40);                  // okno przesuwne
+  Poly row = P(C(1), 0, C(1), 1, C(1), 2, C(1), 3);
+  res &= TestPower(P(PolyClone(&row), 0, PolyClone(&row), 1, PolyClone(&row), 2, row, 3), 12);    // gęsty, dwie zmienne
+  res &= TestPower(P(C(1), 0, C(2), 1, C(1), 3), 45);
+  res &= TestPower(P(C(1L << 32), 0, C(1L << 31), 1), 4);    // iloczyny przekręcają się do zera
+  res &= TestPower(P(C(1L << 32), 5), 2);
+
+  res &= PolySetModulus(1009);
+  Poly binomial = Reduced(P(C(-1), 0, C(1), 1));
+  res &= TestEq(PolyPower(&binomial, 1009), Reduced(P(C(-1), 0, C(1), 1009)), true);    // (x - 1)^m = x^m - 1 (mod m)
+  res &= TestEq(PolyPower(&binomial, 3 * 1009), Reduced(P(C(-1), 0, C(1), 3 * 1009)), false);
+  PolyDestroy(&binomial);
+  res &= TestPower(Reduced(P(C(-1), 0, C(1), 1)), 1010);
+  res &= PolySetModulus(1000003);
+  res &= TestPower(Reduced(P(P(C(1), 1, C(-7), 3), 0, C(5), 2, P(C(3), 0, P(C(1), 5), 1), 9)), 11);
+  res &= TestPower(Reduced(P(C(-2), 0, C(2), 1, C(-5), 2, C(3), 3, C(1), 4)), 23);
+  polyModulus.m = 0;
+  return res;
+}
+
+static bool TestDot(size_t k, Poly a[], Poly b[]) {
+  Poly sum = PolyZero();
+  for (size_t i = 0; i < k; ++i) {
+    Poly prod = PolyMul(&a[i], &b[i]);
+    sum = PolyAddOwned(&sum, &prod);
+  }
+  bool res = TestEq(PolyDot(k, a, b), PolyClone(&sum), true);
+  if (k > 0) {
+    Poly prod = PolyMul(&a[0], &b[0]);
+    Poly rest = PolySub(&sum, &prod);
+    res &= TestEq(PolyFma(&a[0], &b[0], &rest), PolyClone(&sum), true);
+    res &= TestEq(PolyFma(&b[0], &a[0], &rest), PolyClone(&sum), true);
+    PolyDestroy(&prod);
+    PolyDestroy(&rest);
+  }
+  PolyDestroy(&sum);
+  for (size_t i = 0; i < k; ++i) {
+    PolyDestroy(&a[i]);
+    PolyDestroy(&b[i]);
+  }
+  return res;
+}
+
+static bool DotTest(void) {
+  bool res = TestDot(0, NULL, NULL);
+  Poly a[4], b[4];
+  a[0] = C(3); b[0] = C(-4);
+  res &= TestDot(1, a, b);
+  a[0] = C(3); b[0] = P(C(1), 0, C(2), 3);
+  a[1] = P(C(1), 1); b[1] = P(C(-2), 2);
+  res &= TestDot(2, a, b);
+  a[0] = P(P(C(1), 1, C(-7), 3), 0, C(5), 2, P(C(3), 0, P(C(1), 5), 1), 9);
+  b[0] = P(C(1), 0, P(C(2), 0, C(1), 2), 1, C(-3), 4);
+  a[1] = P(C(1), 0, C(-1), 1); b[1] = P(C(1), 0, C(1), 1);
+  a[2] = C(0); b[2] = P(C(7), 3);
+  a[3] = P(P(C(-1), 1, C(7), 3), 0, C(-5), 2); b[3] = P(C(1), 0, P(C(2), 0, C(1), 2), 1, C(-3), 4);
+  res &= TestDot(4, a, b);
+  a[0] = P(C(1), 0, C(1), 1); b[0] = P(C(-1), 0, C(1), 1);    // wyrazy się znoszą
+  a[1] = P(C(1), 2); b[1] = C(-1);
+  a[2] = C(1); b[2] = C(1);
+  res &= TestDot(3, a, b);
+  a[0] = P(C(1), 0, C(2), 1000); b[0] = P(C(1), 0, P(C(1), 0, C(3), 700), 500);    // rzadkie wykładniki
+  a[1] = P(C(-1), 1500); b[1] = C(2);
+  res &= TestDot(2, a, b);
+  a[0] = P(C(1L << 32), 0, C(1L << 31), 1); b[0] = P(C(1L << 32), 1, C(3), 2);
+  a[1] = P(C(LONG_MAX), 1, C(LONG_MIN), 2); b[1] = P(C(LONG_MAX), 1, C(-1), 5);
+  res &= TestDot(2, a, b);
+
+  res &= PolySetModulus(1000003);
+  a[0] = Reduced(P(C(-1), 0, C(1), 3)); b[0] = Reduced(P(P(C(-1), 2), 0, C(1), 1));
+  a[1] = Reduced(P(C(1), 0, C(1), 1)); b[1] = Reduced(P(C(1000002), 0, C(1000002), 1));
+  res &= TestDot(2, a, b);
+  polyModulus.m = 0;
+  return res;
+}
+
+/**
+ * Szuka w pamięci podręcznej wyniku działania o jednym argumencie
+ * i zapisuje go w @p value (wyniki w testach są współczynnikami).
+ */
+static bool CacheLookup(OpCache *cache, unsigned op, uint64_t arg,
+                        const Poly *operand, PolyFingerprint fp, poly_coeff_t *value) {
+  Poly res;
+  if (!OpCacheLookup(cache, op, arg, 1, &operand, &fp, &res))
+    return false;
+  assert(PolyIsCoeff(&res));
+  *value = res.coeff;
+  PolyDestroy(&res);
+  return true;
+}
+
+/**
+ * Zapamiętuje wynik działania o jednym argumencie, zajmujący @p bytes bajtów.
+ */
+static void CacheStore(OpCache *cache, unsigned op, uint64_t arg, const Poly *operand,
+                       PolyFingerprint fp, poly_coeff_t value, size_t bytes) {
+  Poly res = C(value);
+  OpCacheStore(cache, op, arg, 1, &operand, &fp, &res, bytes);
+}
+
+static bool OpCacheTest(void) {
+  bool res = true;
+  const size_t entry = sizeof(OpCacheEntry) + sizeof(Poly) + 100;    // wpis zgłaszający 100 bajtów
+  Poly a[4];
+  PolyFingerprint fp[4];
+  poly_coeff_t value;
+  for (size_t i = 0; i < 4; ++i) {
+    a[i] = P(C(i + 1), 1, C(-1), 2);
+    fp[i] = PolyFingerprintOf(&a[i]);
+  }
+
+  OpCache *cache = OpCacheNew(3 * entry);
+  for (size_t i = 0; i < 3; ++i)
+    CacheStore(cache, 1, 0, &a[i], fp[i], 10 + i, 100);
+  res &= cache->count == 3 && cache->bytes == 3 * entry && cache->evictions == 0;
+  res &= CacheLookup(cache, 1, 0, &a[1], fp[1], &value) && value == 11;
+  res &= !CacheLookup(cache, 2, 0, &a[1], fp[1], &value);    // inna komenda
+  res &= !CacheLookup(cache, 1, 5, &a[1], fp[1], &value);    // inny argument komendy
+  res &= !CacheLookup(cache, 1, 0, &a[3], fp[3], &value);
+
+  // Równe odciski, różne argumenty: trafienie wymaga równości argumentów.
+  res &= !CacheLookup(cache, 1, 0, &a[3], fp[2], &value);
+  res &= cache->hits == 1 && cache->misses == 4;
+
+  // LRU: po użyciu a[0] najdawniej używany jest wpis dla a[2].
+  res &= CacheLookup(cache, 1, 0, &a[0], fp[0], &value) && value == 10;
+  CacheStore(cache, 1, 0, &a[3], fp[3], 13, 100);
+  res &= cache->count == 3 && cache->bytes == 3 * entry && cache->evictions == 1;
+  res &= !CacheLookup(cache, 1, 0, &a[2], fp[2], &value);
+  res &= CacheLookup(cache, 1, 0, &a[1], fp[1], &value) && value == 11;
+  res &= CacheLookup(cache, 1, 0, &a[3], fp[3], &value) && value == 13;
+  res &= CacheLookup(cache, 1, 0, &a[0], fp[0], &value) && value == 10;
+
+  // Wpis większy niż cały budżet jest pomijany bez usuwania innych.
+  CacheStore(cache, 2, 0, &a[0], fp[0], 20, 3 * entry);
+  res &= cache->count == 3 && cache->evictions == 1;
+  res &= !CacheLookup(cache, 2, 0, &a[0], fp[0], &value);
+
+  // Wpis zajmujący dwa zwykłe miejsca usuwa dwa najdawniej używane.
+  CacheStore(cache, 2, 0, &a[0], fp[0], 20, entry + 100);
+  res &= cache->count == 2 && cache->bytes == 3 * entry && cache->evictions == 3;
+  res &= !CacheLookup(cache, 1, 0, &a[1], fp[1], &value);
+  res &= !CacheLookup(cache, 1, 0, &a[3], fp[3], &value);
+  res &= CacheLookup(cache, 1, 0, &a[0], fp[0], &value) && value == 10;
+  res &= CacheLookup(cache, 2, 0, &a[0], fp[0], &value) && value == 20;
+  OpCacheDestroy(cache);
+
+  // Wpisy o równych odciskach współistnieją w jednym kubełku.
+  cache = OpCacheNew(100 * entry);
+  CacheStore(cache, 1, 0, &a[0], fp[0], 10, 100);
+  CacheStore(cache, 1, 0, &a[1], fp[0], 11, 100);
+  res &= cache->count == 2;
+  res &= CacheLookup(cache, 1, 0, &a[0], fp[0], &value) && value == 10;
+  res &= CacheLookup(cache, 1, 0, &a[1], fp[0], &value) && value == 11;
+  res &= !CacheLookup(cache, 1, 0, &a[2], fp[0], &value);
+  OpCacheDestroy(cache);
+
+  for (size_t i = 0; i < 4; ++i)
+    PolyDestroy(&a[i]);
+  return res;
+}
+
 /** GRUPY TESTÓW **/
 
 static bool SimpleNegGroup(void) {
@@ -4226,7 +5115,23 @@ static const test_list_t test_list[] = {
   TEST(PolyFromMonosMainTest),
   TEST(PolyFromMonosZeroTest),
   TEST(PolyFromMonosExampleGroup),
-  TEST(PolyFromMonosFinalTest)
+  TEST(PolyFromMonosFinalTest),
+  TEST(DeepPolynomialTest),
+  TEST(SerializeTest),
+  TEST(SnapshotTest),
+  TEST(FingerprintTest),
+  TEST(InternTest),
+  TEST(ModTest),
+  TEST(SquareTest),
+  TEST(SimdTest),
+  TEST(FusedSubTest),
+  TEST(EvalTest),
+  TEST(EvalBatchTest),
+  TEST(CompileTest),
+  TEST(TruncTest),
+  TEST(PowerTest),
+  TEST(DotTest),
+  TEST(OpCacheTest)
 };
 
 int main(int argc, char *argv[]) {
@@ -0,0 +1,231 @@
+#!/bin/bash
+# Testy trybów wykonania kalkulatora. Każdy test z katalogów poly_tests_2
+# i poly_examples_2 uruchamiany jest w kolejnych trybach, a jego wyjście
+# porównywane jest z oczekiwanym (pliki .out i .err). Tryby, które nie
+# czytają pojedynczego wejścia (wsadowy i serwer), sprawdzane są osobno.
+#
+# Użycie: test_calc.sh ŚCIEŻKA_DO_POLY
+
+if [ $# -ne 1 ] || [ ! -x "$1" ]; then
+    echo "Użycie: $0 ŚCIEŻKA_DO_POLY" >&2
+    exit 2
+fi
+
+POLY=$(realpath "$1")
+TESTS=$(dirname "$(realpath "$0")")
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+cd "$TMP" || exit 2    # testy mogą tworzyć pliki w katalogu bieżącym
+failed=0
+
+# Porównuje wyjście ostatniego uruchomienia ($TMP/out, $TMP/err)
+# z oczekiwanym wyjściem testu.
+# $1 - test (ścieżka bez rozszerzenia), $2 - opis trybu,
+# $3 - opcjonalny przyrostek wariantu oczekiwanego wyjścia (np. 7 dla .out7)
+check() {
+    if ! cmp -s "$TMP/out" "$1.out$3" || { [ -f "$1.err$3" ] && ! cmp -s "$TMP/err" "$1.err$3"; }; then
+        echo "FAIL [$2] ${1#$TESTS/}"
+        failed=1
+    fi
+}
+
+for t in "$TESTS"/poly_tests_2/*.in "$TESTS"/poly_examples_2/*.in; do
+    t=${t%.in}
+
+    # Zwalnianie zdejmowanych wielomianów w osobnym wątku.
+    "$POLY" --deferred-free < "$t.in" > "$TMP/out" 2> "$TMP/err"
+    check "$t" "--deferred-free"
+
+    # Wczytywanie i parsowanie linii w osobnych wątkach.
+    for workers in 1 3; do
+        "$POLY" --pipeline $workers < "$t.in" > "$TMP/out" 2> "$TMP/err"
+        check "$t" "--pipeline $workers"
+    done
+
+    # Wejście odwzorowane w pamięci zamiast standardowego wejścia.
+    for opts in "" "--pipeline 2"; do
+        "$POLY" --input "$t.in" $opts < /dev/null > "$TMP/out" 2> "$TMP/err"
+        check "$t" "--input $opts"
+    done
+
+    # Wyniki MUL, AT i COMPOSE z pamięci podręcznej (duży budżet oraz
+    # budżet wymuszający usuwanie wpisów) muszą być takie same jak liczone.
+    for budget in 100000000 600; do
+        "$POLY" --memo $budget < "$t.in" > "$TMP/out" 2> "$TMP/err"
+        check "$t" "--memo $budget"
+    done
+
+    # Współdzielenie poddrzew: mały limit tablicy wymusza wstawianie
+    # wielomianów bez współdzielenia, duży - współdzielenie wszystkich.
+    for opts in "--intern 3" "--intern 1000000" "--intern 1000000 --deferred-free"; do
+        "$POLY" $opts < "$t.in" > "$TMP/out" 2> "$TMP/err"
+        check "$t" "$opts"
+    done
+
+    # Leniwe wyrażenia, także ze współdzieleniem poddrzew i pamięcią podręczną.
+    for opts in "--lazy" "--lazy --intern 1000 --memo 100000"; do
+        "$POLY" $opts < "$t.in" > "$TMP/out" 2> "$TMP/err"
+        check "$t" "$opts"
+    done
+
+    # Skrypt skompilowany do kodu bajtowego i wykonany z pliku programu.
+    if "$POLY" --compile "$TMP/prog.pbc" < "$t.in" 2> /dev/null; then
+        "$POLY" --exec "$TMP/prog.pbc" > "$TMP/out" 2> "$TMP/err"
+        check "$t" "--compile/--exec"
+    else
+        echo "FAIL [--compile] ${t#$TESTS/}"
+        failed=1
+    fi
+done
+
+# Wznowienie pracy: przerwane po linii zapisu punktu kontrolnego wykonanie
+# wraz z wykonaniem wznowionym od tego punktu (pomijającym przetworzone linie
+# i zachowującym numerację linii w błędach) daje takie samo wyjście jak
+# wykonanie bez przerwy. Po zapisie nie zostaje plik tymczasowy.
+for t in "$TESTS/poly_examples_2/example_others" "$TESTS/poly_tests_2/error_command"; do
+    for cut in $(seq 4 4 "$(wc -l < "$t.in")"); do
+        rm -f "$TMP/ck"
+        head -n "$cut" "$t.in" | "$POLY" --checkpoint "$TMP/ck" --checkpoint-every 4 > "$TMP/out" 2> "$TMP/err"
+        "$POLY" --restore "$TMP/ck" --checkpoint "$TMP/ck" --checkpoint-every 4 < "$t.in" >> "$TMP/out" 2>> "$TMP/err"
+        check "$t" "--checkpoint/--restore after line $cut"
+        if [ -e "$TMP/ck.tmp" ]; then
+            echo "FAIL [--checkpoint] temporary file left after line $cut"
+            failed=1
+        fi
+    done
+done
+
+# Współczynniki modulo 7 (oczekiwane wyjście w plikach .out7 i .err7).
+# Stałe programu skompilowanego bez modułu są redukowane przy wykonaniu.
+t=$TESTS/poly_tests_2/mod
+for opts in "" "--lazy" "--intern 3" "--memo 600" "--pipeline 2"; do
+    "$POLY" --mod 7 $opts < "$t.in" > "$TMP/out" 2> "$TMP/err"
+    check "$t" "--mod 7 $opts" 7
+done
+"$POLY" --compile "$TMP/prog.pbc" < "$t.in"
+"$POLY" --mod 7 --exec "$TMP/prog.pbc" > "$TMP/out" 2> "$TMP/err"
+check "$t" "--mod 7 --exec" 7
+
+# Pliki zapisane bez modułu wczytywane są z współczynnikami sprowadzonymi
+# do reszt modulo 7.
+printf '(100,0)+((-1,0)+(9,2),1)\nSAVE mod.bin\nSNAPSHOT mod.snap\nCHECKPOINT mod.chk\n' | "$POLY"
+printf 'RESTORE mod.chk\nPRINT\nLOAD mod.bin\nIS_EQ\nPOP\nMAP mod.snap\nPRINT\n' |
+    "$POLY" --mod 7 > "$TMP/out" 2> "$TMP/err"
+cat > "$TMP/expected" <<'EOF'
+(2,0)+((6,0)+(2,2),1)
+1
+(2,0)+((6,0)+(2,2),1)
+EOF
+if ! cmp -s "$TMP/out" "$TMP/expected" || [ -s "$TMP/err" ]; then
+    echo "FAIL [--mod 7] LOAD/MAP/RESTORE"
+    failed=1
+fi
+
+# Moduł parzysty, mniejszy od 3 lub nie mniejszy od 2^63 jest odrzucany.
+for m in 8 1 9223372036854775809; do
+    if "$POLY" --mod $m < /dev/null > "$TMP/out" 2> "$TMP/err" || [ -s "$TMP/out" ] ||
+       [ "$(cat "$TMP/err")" != "$POLY: wrong modulus" ]; then
+        echo "FAIL [--mod $m] modulus not rejected"
+        failed=1
+    fi
+done
+
+# Uszkodzony plik programu: --exec kończy się komunikatem o błędzie
+# bez wykonania żadnej instrukcji. $1 - plik, $2 - opis uszkodzenia
+check_bad_program() {
+    if "$POLY" --exec "$1" > "$TMP/out" 2> "$TMP/err" || [ -s "$TMP/out" ] ||
+       [ "$(cat "$TMP/err")" != "$POLY: cannot load program $1" ]; then
+        echo "FAIL [--exec] $2"
+        failed=1
+    fi
+}
+
+"$POLY" --compile "$TMP/prog.pbc" < "$TESTS/poly_tests_2/compile.in"
+size=$(stat -c %s "$TMP/prog.pbc")
+{ printf 'XLYP'; tail -c +5 "$TMP/prog.pbc"; } > "$TMP/bad.pbc"
+check_bad_program "$TMP/bad.pbc" "bad magic"
+{ head -c 4 "$TMP/prog.pbc"; printf '\377'; tail -c +6 "$TMP/prog.pbc"; } > "$TMP/bad.pbc"
+check_bad_program "$TMP/bad.pbc" "bad version"
+for len in $(seq 0 $((size - 1))); do
+    head -c "$len" "$TMP/prog.pbc" > "$TMP/bad.pbc"
+    check_bad_program "$TMP/bad.pbc" "truncated to $len bytes"
+done
+{ cat "$TMP/prog.pbc"; printf '\0'; } > "$TMP/bad.pbc"
+check_bad_program "$TMP/bad.pbc" "trailing byte"
+
+# Tryb wsadowy: wszystkie testy wykonywane są naraz, a wyjście każdego
+# z nich musi być takie samo jak przy zwykłym wykonaniu pojedynczego pliku.
+for dir in poly_tests_2 poly_examples_2; do
+    mkdir -p "$TMP/batch/$dir"
+    cp "$TESTS/$dir"/*.in "$TMP/batch/$dir"
+    if ! "$POLY" --batch "$TMP/batch/$dir" -j 3 > /dev/null; then
+        echo "FAIL [--batch] $dir"
+        failed=1
+    fi
+    for t in "$TMP/batch/$dir"/*.in; do
+        t=${t%.in}
+        "$POLY" < "$t.in" > "$TMP/out" 2> "$TMP/err"
+        if ! cmp -s "$TMP/out" "$t.out" || ! cmp -s "$TMP/err" "$t.err"; then
+            echo "FAIL [--batch] ${t#$TMP/batch/}"
+            failed=1
+        fi
+    done
+done
+
+# Tryb serwera: dwie jednocześnie otwarte sesje mają osobne stosy, a każda
+# linia odpowiedzi poprzedzona jest numerem strumienia (1 - wynik, 2 - błąd).
+if command -v python3 > /dev/null; then
+    "$POLY" --server "$TMP/sock" -j 2 &
+    server=$!
+    for _ in $(seq 50); do
+        [ -S "$TMP/sock" ] && break
+        sleep 0.1
+    done
+    python3 - "$TMP/sock" > "$TMP/out" 2> "$TMP/err" <<'EOF'
+import socket, sys
+
+def connect():
+    s = socket.socket(socket.AF_UNIX)
+    s.connect(sys.argv[1])
+    return s
+
+def finish(s, rest):
+    s.sendall(rest)
+    s.shutdown(socket.SHUT_WR)
+    data = b''
+    while True:
+        chunk = s.recv(4096)
+        if not chunk:
+            break
+        data += chunk
+    s.close()
+    return data.decode()
+
+a, b = connect(), connect()
+a.sendall(b'(1,2)\nPRINT\n')
+b.sendall(b'PRINT\n(3,0)+(1,1)\n')
+a.sendall(b'CLONE\nADD\n')
+sys.stdout.write(finish(b, b'PRINT\nWRONG\nDEG'))    # ostatnia linia bez znaku nowej linii
+sys.stdout.write(finish(a, b'PRINT\nPOP\nPOP\n'))
+EOF
+    kill "$server"
+    wait "$server"
+    cat > "$TMP/expected" <<'EOF'
+2 ERROR 1 STACK UNDERFLOW
+1 (3,0)+(1,1)
+2 ERROR 4 WRONG COMMAND
+1 1
+1 (1,2)
+1 (2,2)
+2 ERROR 7 STACK UNDERFLOW
+EOF
+    if ! cmp -s "$TMP/out" "$TMP/expected" || [ -s "$TMP/err" ]; then
+        echo "FAIL [--server] two concurrent sessions"
+        failed=1
+    fi
+fi
+
+if [ $failed -eq 0 ]; then
+    echo "OK"
+fi
+exit $failed
@@ -0,0 +1,106 @@
+/** @file
+  Widoki na fragmenty tekstu, przetwarzane bez kopiowania
+
+  @authors Kacper Kramarz-Fernandez <k.kramarzfer@student.uw.edu.pl>
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#ifndef __STR_VIEW_H__
+#define __STR_VIEW_H__
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+/**
+ * Widok na fragment tekstu. Fragment nie musi być zakończony znakiem '\0'
+ * i nie jest własnością widoku.
+ */
+typedef struct StrView {
+    const char *ptr;  ///< Początek fragmentu (NULL dla braku fragmentu)
+    size_t len;       ///< Długość fragmentu
+} StrView;
+
+/**
+ * Tworzy widok na fragment tekstu.
+ *
+ * @param[in] ptr : początek fragmentu
+ * @param[in] len : długość fragmentu
+ *
+ * @return : widok
+ */
+static inline StrView StrViewMake(const char *ptr, size_t len)
+{
+    return (StrView) { .ptr = ptr, .len = len };
+}
+
+/**
+ * Tworzy widok oznaczający brak fragmentu.
+ *
+ * @return : pusty widok z `ptr == NULL`
+ */
+static inline StrView StrViewNone(void)
+{
+    return StrViewMake(NULL, 0);
+}
+
+/**
+ * Sprawdza, czy widok jest równy napisowi zakończonemu znakiem '\0'.
+ *
+ * @param[in] s : widok
+ * @param[in] str : napis
+ *
+ * @return : czy treść widoku jest równa @p str
+ */
+static inline bool StrViewEquals(StrView s, const char *str)
+{
+    size_t len = strlen(str);
+    return s.len == len && memcmp(s.ptr, str, len) == 0;
+}
+
+/**
+ * Sprawdza, czy znak jest cyfrą dziesiętną.
+ *
+ * @param[in] c : znak
+ *
+ * @return : czy @p c jest cyfrą
+ */
+static inline bool IsDecimalDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+/**
+ * Wczytuje liczbę nieujemną zapisaną cyframi dziesiętnymi w @p s,
+ * zaczynając od pozycji @p *pos, i przesuwa @p *pos za ostatnią cyfrę.
+ * Nie wychodzi poza widok, więc nie wymaga znaku '\0' na jego końcu.
+ *
+ * @param[in] s : widok
+ * @param[in, out] pos : pozycja w widoku
+ * @param[in] max : największa dopuszczalna wartość
+ * @param[out] res : wczytana liczba
+ *
+ * @return : czy wczytano co najmniej jedną cyfrę, a liczba nie przekracza @p max
+ */
+static inline bool StrViewParseDigits(StrView s, size_t *pos, unsigned long long max, unsigned long long *res)
+{
+    size_t start = *pos;
+    unsigned long long val = 0;
+    bool in_range = true;
+
+    for (; *pos < s.len && IsDecimalDigit(s.ptr[*pos]); (*pos)++) {
+        unsigned digit = s.ptr[*pos] - '0';
+
+        if (val > (max - digit) / 10) {
+            in_range = false;    // dalsze cyfry są pomijane
+        }
+        else {
+            val = 10 * val + digit;
+        }
+    }
+    *res = val;
+    return in_range && *pos > start;
+}
+
+#endif //__STR_VIEW_H__